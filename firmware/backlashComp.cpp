@@ -0,0 +1,170 @@
+#include "backlashComp.h"
+
+float BacklashComp::apply(float referenceDeg, float drivePct, float dt) {
+    if (!active()) return referenceDeg;
+    if (dt <= 0.0f) return referenceDeg + offsetDeg;
+
+    trackDirection(referenceDeg);
+
+    // Slew toward the new side of the gap instead of stepping
+    float target = direction * params.widthDeg * 0.5f;
+    float step = params.slewDegPerS * dt;
+    offsetDeg += constrain(target - offsetDeg, -step, step);
+
+    filteredDrive += (drivePct - filteredDrive) * dt / (DRIVE_TAU_S + dt);
+    float deflection = constrain(params.complianceDegPerPct * filteredDrive,
+                                 -params.maxDeflectionDeg, params.maxDeflectionDeg);
+
+    return referenceDeg + offsetDeg + deflection;
+}
+
+// Direction flips only once the reference has backed off its last extreme
+// by more than the deadband, so noise around a hold does not toggle it
+void BacklashComp::trackDirection(float referenceDeg) {
+    if (!tracking) {
+        peakDeg = referenceDeg;
+        tracking = true;
+    }
+    float deadband = params.reversalDeadbandDeg;
+
+    if (direction == 0) {
+        // The first move away from the start picks the side of the gap
+        if (fabsf(referenceDeg - peakDeg) > deadband) {
+            direction = referenceDeg > peakDeg ? 1 : -1;
+            peakDeg = referenceDeg;
+        }
+    } else if (direction > 0) {
+        if (referenceDeg > peakDeg) {
+            peakDeg = referenceDeg;
+        } else if (referenceDeg < peakDeg - deadband) {
+            direction = -1;
+            peakDeg = referenceDeg;
+        }
+    } else {
+        if (referenceDeg < peakDeg) {
+            peakDeg = referenceDeg;
+        } else if (referenceDeg > peakDeg + deadband) {
+            direction = 1;
+            peakDeg = referenceDeg;
+        }
+    }
+}
+
+bool BacklashComp::startCalibration(float origin, float amplitude, float speed,
+                                    float minDeg, float maxDeg) {
+    if (calibrating() || amplitude <= 0.0f || speed <= 0.0f) return false;
+    if (origin - amplitude < minDeg || origin + amplitude > maxDeg) {
+        // Report the refusal so the requester is not left waiting for a BKL line
+        lastResult = {params.widthDeg, 0.0f, 0.0f, false};
+        reportPending.store(true, std::memory_order_release);
+        return false;
+    }
+
+    // Measure the bare gearbox: compensation off until the sweep ends
+    saved = params;
+    params.widthDeg = 0.0f;
+    params.complianceDegPerPct = 0.0f;
+    offsetDeg = 0.0f;
+
+    originDeg = origin;
+    amplitudeDeg = amplitude;
+    speedDegPerS = speed;
+    sweepDeg = origin;
+    calDrive = 0.0f;
+    loadedSum = 0.0f;
+    loadedCount = 0;
+    engaged = false;
+    phase = Phase::Out;
+    return true;
+}
+
+void BacklashComp::cancelCalibration() {
+    if (calibrating()) finish(false);
+}
+
+float BacklashComp::calibrationStep(float positionDeg, float drivePct, float dt) {
+    if (dt <= 0.0f) return sweepDeg;
+    float step = speedDegPerS * dt;
+    calDrive += (drivePct - calDrive) * dt / (CAL_DRIVE_TAU_S + dt);
+    drivePct = calDrive;
+
+    switch (phase) {
+        case Phase::Out:
+            sweepDeg = min(sweepDeg + step, originDeg + amplitudeDeg);
+            if (sweepDeg > originDeg + amplitudeDeg * 0.5f) {
+                loadedSum += fabsf(drivePct);
+                loadedCount++;
+            }
+            if (sweepDeg >= originDeg + amplitudeDeg) reverse(positionDeg);
+            break;
+
+        case Phase::Back:
+            sweepDeg = max(sweepDeg - step, originDeg - amplitudeDeg);
+            if (!engaged) {
+                reversalPosDeg = max(reversalPosDeg, positionDeg);  // Overshoot past the turn
+            }
+            if (!engaged && drivePct <= -engageDrive) {
+                gapDeg[0] = reversalPosDeg - positionDeg;
+                engaged = true;
+            }
+            if (sweepDeg < originDeg) {
+                loadedSum += fabsf(drivePct);
+                loadedCount++;
+            }
+            if (sweepDeg <= originDeg - amplitudeDeg) {
+                if (!engaged) {
+                    finish(false);
+                    break;
+                }
+                reverse(positionDeg);
+            }
+            break;
+
+        case Phase::Return:
+            sweepDeg = min(sweepDeg + step, originDeg);
+            if (!engaged) {
+                reversalPosDeg = min(reversalPosDeg, positionDeg);
+            }
+            if (!engaged && drivePct >= engageDrive) {
+                gapDeg[1] = positionDeg - reversalPosDeg;
+                engaged = true;
+            }
+            if (sweepDeg >= originDeg) finish(engaged);
+            break;
+
+        case Phase::Idle:
+            break;
+    }
+    return sweepDeg;
+}
+
+// Turn around at the end of a leg; the engagement level comes from the leg just run
+void BacklashComp::reverse(float positionDeg) {
+    float loaded = loadedCount ? loadedSum / loadedCount : 0.0f;
+    engageDrive = max(MIN_ENGAGE_DRIVE, loaded * ENGAGE_FRACTION);
+    reversalPosDeg = positionDeg;
+    loadedSum = 0.0f;
+    loadedCount = 0;
+    engaged = false;
+    phase = (phase == Phase::Out) ? Phase::Back : Phase::Return;
+}
+
+void BacklashComp::finish(bool ok) {
+    params = saved;
+    lastResult = {0.0f, gapDeg[0], gapDeg[1], ok};
+    if (ok) {
+        lastResult.widthDeg = max(0.0f, 0.5f * (gapDeg[0] + gapDeg[1]));
+        params.widthDeg = lastResult.widthDeg;
+    }
+    direction = 0;
+    tracking = false;
+    offsetDeg = 0.0f;
+    phase = Phase::Idle;
+    reportPending.store(true, std::memory_order_release);
+}
+
+void BacklashComp::report(Print& out, size_t joint) const {
+    out.printf("BKL j%u width=%.3f fwd=%.3f rev=%.3f ok=%d compliance=%.4f\n",
+               (unsigned)(joint + 1), params.widthDeg, lastResult.forwardDeg,
+               lastResult.reverseDeg, lastResult.ok ? 1 : 0, params.complianceDegPerPct);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// Gearbox backlash and compliance compensation for one joint. The encoder
+// sits on the motor, so the output shaft trails it by half the backlash in
+// the direction of travel plus an elastic wind-up proportional to torque.
+// apply() turns an output-side reference into the motor-side setpoint that
+// puts the output there: +/- width/2 depending on the reference direction,
+// slewed across a reversal so the jump never kicks the PID, plus the
+// deflection predicted from the filtered drive.
+//
+// Calibration sweeps the joint slowly out and back around its current
+// position. After each reversal the motor crosses the gap on friction alone;
+// the gap ends where the filtered drive climbs back to half the loaded level,
+// so the width found includes the wind-up at that load. Needs friction on the
+// output side to see the engagement; a gravity-loaded joint rests on one side
+// of the gap whatever the direction and gains little from this model. A sweep
+// that would leave the joint limits is refused with an ok=0 report.
+// tools/backlash_sim.py runs the same logic against a simulated gearbox, and
+// host/test/backlashCompTest.cpp against the rig with a gap in Sim::JointPlant.
+class BacklashComp {
+public:
+    struct Params {
+        float widthDeg = 0.0f;            // Output-side backlash, 0 disables
+        float complianceDegPerPct = 0.0f; // Wind-up per % drive, 0 disables
+        float reversalDeadbandDeg = 0.05f;
+        float slewDegPerS = 90.0f;        // Offset rate across a reversal
+        float maxDeflectionDeg = 2.0f;
+    };
+
+    struct Result {
+        float widthDeg;
+        float forwardDeg, reverseDeg;  // Gap crossed after each reversal
+        bool ok;
+    };
+
+    Params params;
+
+    bool active() const { return params.widthDeg > 0.0f || params.complianceDegPerPct != 0.0f; }
+
+    // Control task only; reference and return value in degrees
+    float apply(float referenceDeg, float drivePct, float dt);
+
+    bool startCalibration(float originDeg, float amplitudeDeg, float speedDegPerS,
+                          float minDeg, float maxDeg);
+    void cancelCalibration();
+    bool calibrating() const { return phase != Phase::Idle; }
+    // Reference to track during calibration, from motor-side position and drive
+    float calibrationStep(float positionDeg, float drivePct, float dt);
+
+    // Comms side: true once per finished or cancelled calibration
+    bool takeReport() { return reportPending.exchange(false, std::memory_order_acq_rel); }
+    Result result() const { return lastResult; }
+    // Format: BKL j<n> width=<deg> fwd=<deg> rev=<deg> ok=<0|1> compliance=<deg/%>
+    void report(Print& out, size_t joint) const;
+
+private:
+    enum class Phase : uint8_t { Idle, Out, Back, Return };
+
+    static constexpr float DRIVE_TAU_S = 0.2f;      // Torque estimate for the wind-up
+    static constexpr float CAL_DRIVE_TAU_S = 0.1f;  // PID output is too noisy to threshold raw
+    static constexpr float ENGAGE_FRACTION = 0.5f;  // Of the loaded drive level
+    static constexpr float MIN_ENGAGE_DRIVE = 5.0f; // %, floor for unloaded joints
+
+    // Reference direction tracking
+    bool tracking = false;
+    int8_t direction = 0;
+    float peakDeg = 0.0f;
+    float offsetDeg = 0.0f;
+    float filteredDrive = 0.0f;
+
+    // Calibration sweep
+    Phase phase = Phase::Idle;
+    float originDeg = 0.0f, amplitudeDeg = 0.0f, speedDegPerS = 0.0f;
+    float sweepDeg = 0.0f;
+    float reversalPosDeg = 0.0f;
+    float calDrive = 0.0f;
+    float loadedSum = 0.0f;
+    uint32_t loadedCount = 0;
+    float engageDrive = 0.0f;
+    bool engaged = false;
+    float gapDeg[2] = {};
+    Params saved;
+
+    Result lastResult = {};
+    std::atomic<bool> reportPending{false};
+
+    void trackDirection(float referenceDeg);
+    void reverse(float positionDeg);
+    void finish(bool ok);
+};
@@ -0,0 +1,276 @@
+#include "bench.h"
+#include "boardConfig.h"
+#include "motorConfig.h"
+#include "telemetry.h"
+#include "pidBatch.h"
+#include "kinematics.h"
+#include "eventLog.h"
+#include "biquad.h"
+#include <Preferences.h>
+#include <algorithm>
+
+bool Bench::firstResult = true;
+
+// Spare controller, so benchmarking never touches a live joint
+static MotorPID benchMotor;
+
+// Counts bytes and drops them, so formatting cost is measured without the UART
+class NullPrint : public Print {
+public:
+    size_t write(uint8_t) override { bytes++; return 1; }
+    size_t write(const uint8_t*, size_t size) override { bytes += size; return size; }
+    size_t bytes = 0;
+};
+
+static NullPrint sink;
+static Telemetry benchTelemetry(sink);
+
+// Batched kernel against one QuickPID per joint, as MotorPID runs them
+static constexpr size_t BATCH_JOINTS = 8;
+static PidBatch<4> batch4;
+static PidBatch<BATCH_JOINTS> batch8;
+static QuickPID scalarPids[BATCH_JOINTS];
+static float scalarInput[BATCH_JOINTS], scalarOutput[BATCH_JOINTS], scalarSetpoint[BATCH_JOINTS];
+
+template <size_t LANES>
+static void setUpBatch(PidBatch<LANES>& batch) {
+    for (size_t i = 0; i < LANES; i++) {
+        batch.setTunings(i, 1.32f + 0.1f * i, 10.28f, 0.10f, Board::CONTROL_PERIOD_US);
+        batch.setpoint[i] = 500.0f + 37.0f * i;
+        batch.input[i] = 0.0f;
+        batch.output[i] = 0.0f;
+        batch.initialize(i);
+    }
+}
+
+static void setUpScalar() {
+    for (size_t i = 0; i < BATCH_JOINTS; i++) {
+        scalarPids[i] = QuickPID(&scalarInput[i], &scalarOutput[i], &scalarSetpoint[i],
+                                 1.32f + 0.1f * i, 10.28f, 0.10f,
+                                 QuickPID::pMode::pOnError, QuickPID::dMode::dOnMeas,
+                                 QuickPID::iAwMode::iAwClamp, QuickPID::Action::direct);
+        scalarPids[i].SetOutputLimits(-100, 100);
+        scalarPids[i].SetSampleTimeUs(Board::CONTROL_PERIOD_US);
+        scalarPids[i].SetTunings(1.32f + 0.1f * i, 10.28f, 0.10f);
+        scalarSetpoint[i] = 500.0f + 37.0f * i;
+        scalarInput[i] = scalarOutput[i] = 0.0f;
+        scalarPids[i].SetMode(QuickPID::Control::timer);
+        scalarPids[i].Initialize();
+    }
+}
+
+// Body shape for longer chains than this board drives
+static ChainKinematics<8> chain8(Board::SEGMENT_LENGTH_MM);
+static ChainKinematics<16> chain16(Board::SEGMENT_LENGTH_MM);
+static ChainKinematics<32> chain32(Board::SEGMENT_LENGTH_MM);
+static float chainAngles[32];
+
+// Largest segment position error of the table against libm, mm, on a serpenoid
+static float chainError() {
+    float* angles = chainAngles;
+    for (size_t k = 0; k < 32; k++) {
+        angles[k] = 30.0f * sinf(0.85f + 0.7f * k);
+    }
+    chain32.update(angles);
+    float heading = 0.0f, x = 0.0f, y = 0.0f, worst = 0.0f;
+    for (size_t k = 0; k <= 32; k++) {
+        if (k > 0) heading += radians(angles[k - 1]);
+        worst = max(worst, max(fabsf(chain32.shape().xMm[k] - x), fabsf(chain32.shape().yMm[k] - y)));
+        x += cosf(heading) * Board::SEGMENT_LENGTH_MM;
+        y += sinf(heading) * Board::SEGMENT_LENGTH_MM;
+    }
+    return worst;
+}
+
+// Same input sequence through both, largest output difference in %
+static float batchDisagreement(uint32_t steps) {
+    setUpBatch(batch8);
+    setUpScalar();
+    float worst = 0.0f;
+    for (uint32_t s = 0; s < steps; s++) {
+        for (size_t i = 0; i < BATCH_JOINTS; i++) {
+            float in = (float)((s * (i + 3)) & 1023);
+            batch8.input[i] = scalarInput[i] = in;
+            scalarPids[i].Compute();
+        }
+        batch8.compute();
+        for (size_t i = 0; i < BATCH_JOINTS; i++) {
+            worst = max(worst, fabsf(batch8.output[i] - scalarOutput[i]));
+        }
+    }
+    return worst;
+}
+
+template <typename Op>
+void Bench::measure(Print& out, const char* name, uint32_t iterations, Op&& op) {
+    uint32_t perOp[BATCHES];
+    for (int b = 0; b < BATCHES; b++) {
+        uint32_t start = ESP.getCycleCount();
+        for (uint32_t i = 0; i < iterations; i++) {
+            op(i);
+        }
+        perOp[b] = (ESP.getCycleCount() - start) / iterations;
+    }
+    std::sort(perOp, perOp + BATCHES);
+
+    uint32_t mhz = getCpuFrequencyMhz();
+    out.printf("%s{\"name\":\"%s\",\"iters\":%u,\"cycles_min\":%u,\"cycles_median\":%u,\"ns_median\":%u}",
+               firstResult ? "" : ",", name, (unsigned)iterations, (unsigned)perOp[0],
+               (unsigned)perOp[BATCHES / 2], (unsigned)(perOp[BATCHES / 2] * 1000 / mhz));
+    firstResult = false;
+}
+
+void Bench::run(Print& out) {
+    firstResult = true;
+    out.printf("{\"bench\":1,\"cpu_mhz\":%u,\"results\":[", (unsigned)getCpuFrequencyMhz());
+
+    // Controller math: encoder input moving every tick, gains fixed
+    benchMotor.init(motorConfigFor<0>());
+    MotorPID::Checkpoint start = benchMotor.checkpoint();
+    start.setpoint = 500.0f;
+    start.sampleUs = 1;
+    benchMotor.restore(start);
+    TrackEncoder::Snapshot snap = {};
+    measure(out, "pid_compute", 2000, [&](uint32_t i) {
+        snap.counts[benchMotor.config().encoderIndex] = i & 1023;
+        snap.timestampUs += Board::CONTROL_PERIOD_US;
+        benchMotor.compute(snap, false);
+    });
+
+    // Same sample with a 4x4 error/velocity gain schedule blended in
+    GainSchedule::Axis errorAxis, velocityAxis;
+    errorAxis.key = GainSchedule::Key::Error;
+    errorAxis.invStep = 1.0f / 5.0f;
+    errorAxis.count = 4;
+    velocityAxis.key = GainSchedule::Key::Velocity;
+    velocityAxis.invStep = 1.0f / 50.0f;
+    velocityAxis.count = 4;
+    benchMotor.stagingSchedule().configure(errorAxis, velocityAxis);
+    for (uint8_t p = 0; p < 16; p++) {
+        benchMotor.stagingSchedule().setPoint(p, {1.0f + 0.05f * p, 8.0f, 0.1f});
+    }
+    benchMotor.commitSchedule();
+    measure(out, "pid_compute_scheduled", 2000, [&](uint32_t i) {
+        snap.counts[benchMotor.config().encoderIndex] = i & 1023;
+        snap.timestampUs += Board::CONTROL_PERIOD_US;
+        benchMotor.compute(snap, false);
+    });
+    benchMotor.disableSchedule();
+
+    // One event as the control tick logs it; a scratch ring keeps the post-mortem log intact
+    static volatile EventLog::Event scratchEvents[EventLog::CAPACITY];
+    static std::atomic<uint32_t> scratchHead{0};
+    measure(out, "event_log", 2000, [&](uint32_t i) {
+        EventLog::append(scratchEvents, EventLog::CAPACITY, scratchHead, EventLog::COMMAND, 0, 1, i);
+    });
+
+    // Biquad cost: one section, and a full chain as MotorPID runs it (per section is ns / 4)
+    static BiquadChain<MotorPID::FILTER_SECTIONS> benchChain;
+    benchChain.clear();
+    benchChain.set(0, Biquad::NOTCH, 12.5f, 4.0f, 100.0f, 0.0f);
+    Biquad section = benchChain.section(0);
+    volatile float filterSink;
+    measure(out, "biquad_section", 2000, [&](uint32_t i) {
+        filterSink = section.process((float)(i & 1023));
+    });
+    benchChain.set(1, Biquad::NOTCH, 23.0f, 3.0f, 100.0f, 0.0f);
+    benchChain.set(2, Biquad::LOWPASS, 30.0f, 0.707f, 100.0f, 0.0f);
+    benchChain.set(3, Biquad::LEAD_LAG, 2.0f, 8.0f, 100.0f, 0.0f);
+    measure(out, "biquad_chain_4", 2000, [&](uint32_t i) {
+        filterSink = benchChain.process((float)(i & 1023));
+    });
+
+    // Same sample through the state feedback path instead of QuickPID
+    benchMotor.lqrGains[0][0] = 4.0f;
+    benchMotor.lqrGains[0][1] = 0.12f;
+    benchMotor.lqrGains[0][2] = 20.0f;
+    benchMotor.setController(MotorPID::Controller::Lqr);
+    measure(out, "lqr_compute", 2000, [&](uint32_t i) {
+        snap.counts[benchMotor.config().encoderIndex] = i & 1023;
+        snap.timestampUs += Board::CONTROL_PERIOD_US;
+        benchMotor.compute(snap, false);
+    });
+    benchMotor.setController(MotorPID::Controller::Pid);
+
+    // Eight joints: one QuickPID each against the batched kernel; per joint is ns / lanes
+    setUpScalar();
+    measure(out, "pid_scalar_x8", 500, [&](uint32_t i) {
+        for (size_t j = 0; j < BATCH_JOINTS; j++) {
+            scalarInput[j] = (float)((i + j) & 1023);
+            scalarPids[j].Compute();
+        }
+    });
+    setUpBatch(batch4);
+    measure(out, "pid_batch_x4", 500, [&](uint32_t i) {
+        for (size_t j = 0; j < batch4.lanes(); j++) batch4.input[j] = (float)((i + j) & 1023);
+        batch4.compute();
+    });
+    setUpBatch(batch8);
+    measure(out, "pid_batch_x8", 500, [&](uint32_t i) {
+        for (size_t j = 0; j < batch8.lanes(); j++) batch8.input[j] = (float)((i + j) & 1023);
+        batch8.compute();
+    });
+
+    // Forward kinematics, centre of mass and curvature per chain length
+    measure(out, "kinematics_8", 500, [&](uint32_t i) {
+        chainAngles[i & 7] = (float)(i & 63) - 32.0f;
+        chain8.update(chainAngles);
+    });
+    measure(out, "kinematics_16", 500, [&](uint32_t i) {
+        chainAngles[i & 15] = (float)(i & 63) - 32.0f;
+        chain16.update(chainAngles);
+    });
+    measure(out, "kinematics_32", 500, [&](uint32_t i) {
+        chainAngles[i & 31] = (float)(i & 63) - 32.0f;
+        chain32.update(chainAngles);
+    });
+
+    // Encoder reads, same calls the control and comms paths make
+    volatile float angleSink;
+    volatile int64_t countSink;
+    measure(out, "encoder_snapshot", 2000, [&](uint32_t) { snap = trackEncoder->snapshot(); });
+    measure(out, "encoder_get_count", 2000, [&](uint32_t) { countSink = trackEncoder->getCount(0); });
+    measure(out, "encoder_angle", 2000, [&](uint32_t) { angleSink = trackEncoder->getAngle<0>(); });
+    measure(out, "encoder_revolutions", 2000, [&](uint32_t) { countSink = trackEncoder->getRevolutions<0>(); });
+    measure(out, "deg_from_counts", 2000, [&](uint32_t i) {
+        angleSink = (float)(int32_t)i * Board::Joint<0>::DEG_PER_COUNT;
+    });
+
+    // Command parsing, the tar pattern that every setpoint goes through
+    measure(out, "parse_tar", 1000, [&](uint32_t) {
+        int joint;
+        float degrees;
+        if (sscanf("tar1=123.45", "tar%d=%f", &joint, &degrees) == 2) angleSink = degrees;
+    });
+
+    // Telemetry formatting: legacy text line against a binary frame of every channel
+    ControlState state = {};
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        state.joints[j] = {834.4f, 834.0f, 100.0f, 1.32f, 10.28f, 0.1f, 12.5f, 0.2f, 1.5f, 0.8f, 0};
+    }
+    measure(out, "telemetry_text", 200, [&](uint32_t i) {
+        state.joints[0].input = (float)(i & 1023);
+        Telemetry::printText(sink, state);
+    });
+    benchTelemetry.unsubscribeAll();
+    benchTelemetry.subscribeLetters(0, "pvoeh", 1);
+    measure(out, "telemetry_binary", 200, [&](uint32_t i) {
+        state.tick = i;
+        state.joints[0].input = (float)(i & 1023);
+        benchTelemetry.publish(state);
+    });
+
+    // NVS round trip as the encoder save task does it, kept short for flash wear
+    Preferences prefs;
+    if (prefs.begin("bench", false)) {
+        measure(out, "nvs_put_get", 4, [&](uint32_t i) {
+            prefs.putLong("count", (int32_t)i);
+            countSink = prefs.getLong("count", 0);
+        });
+        prefs.remove("count");
+        prefs.end();
+    }
+
+    out.printf("],\"pid_batch_max_diff\":%.6g,\"kinematics_max_err_mm\":%.6g}\n",
+               batchDisagreement(1000), chainError());
+}
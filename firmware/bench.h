@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+
+// On-target microbenchmarks for the hot paths. Each case runs in a few
+// fixed-size batches timed with the CPU cycle counter; the best and median
+// batch are reported as one JSON line so runs can be diffed over time.
+// Runs on the comms core and leaves the live joints alone.
+class Bench {
+public:
+    // Format: {"bench":1,"cpu_mhz":<n>,"results":[{"name":..,"iters":..,"cycles_min":..,
+    //          "cycles_median":..,"ns_median":..}, ...],"pid_batch_max_diff":<%>,
+    //          "kinematics_max_err_mm":<mm>}
+    static void run(Print& out);
+
+private:
+    static constexpr int BATCHES = 5;
+
+    template <typename Op>
+    static void measure(Print& out, const char* name, uint32_t iterations, Op&& op);
+
+    static bool firstResult;
+};
@@ -0,0 +1,45 @@
+#include "biquad.h"
+
+bool Biquad::design(Type type, float f1, float f2OrQ, float sampleHz) {
+    float nyquist = sampleHz * 0.5f;
+    if (!(f1 > 0.0f && f1 < nyquist)) return false;
+
+    if (type == LEAD_LAG) {
+        float f2 = f2OrQ;
+        if (!(f2 > 0.0f && f2 < nyquist)) return false;
+
+        // Bilinear transform of (1 + s/wz) / (1 + s/wp) with both corners prewarped
+        float kz = tanf(PI * f1 / sampleHz), kp = tanf(PI * f2 / sampleHz);
+        float norm = 1.0f / (1.0f + kp);  // Dividing by a0 = 1 + 1/kp is multiplying by kp * norm
+        b0 = (1.0f / kz + 1.0f) * kp * norm;
+        b1 = (1.0f - 1.0f / kz) * kp * norm;
+        b2 = 0.0f;
+        a1 = (kp - 1.0f) * norm;
+        a2 = 0.0f;
+        z1 = z2 = 0.0f;
+        return true;
+    }
+
+    float q = f2OrQ;
+    if (!(q > 0.05f && q < 50.0f)) return false;
+    float w = 2.0f * PI * f1 / sampleHz;
+    float cw = cosf(w), alpha = sinf(w) / (2.0f * q);
+    float norm = 1.0f / (1.0f + alpha);
+
+    switch (type) {
+        case LOWPASS:
+            b0 = b2 = (1.0f - cw) * 0.5f * norm;
+            b1 = (1.0f - cw) * norm;
+            break;
+        case NOTCH:
+            b0 = b2 = norm;
+            b1 = -2.0f * cw * norm;
+            break;
+        default:
+            return false;
+    }
+    a1 = -2.0f * cw * norm;
+    a2 = (1.0f - alpha) * norm;
+    z1 = z2 = 0.0f;
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <Arduino.h>
+
+// Second-order IIR section in transposed direct form II, coefficients
+// normalised so a0 = 1. Designs follow the RBJ audio EQ cookbook at the
+// control rate, so corner frequencies must stay below 50 Hz.
+struct Biquad {
+    enum Type : uint8_t { OFF, LOWPASS, NOTCH, LEAD_LAG, TYPE_COUNT };
+
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    float z1 = 0.0f, z2 = 0.0f;
+
+    float process(float x) {
+        float y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+
+    float dcGain() const { return (b0 + b1 + b2) / (1.0f + a1 + a2); }
+
+    // State of a section that has seen x forever; returns its output
+    float prime(float x) {
+        float y = dcGain() * x;
+        z1 = y - b0 * x;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+
+    // Unity gain at DC for all three. Lead-lag: zero at f1, pole at f2, both
+    // first order (b2 = a2 = 0), f1 < f2 leads. False if a frequency or q is
+    // out of range; the section is left unchanged
+    bool design(Type type, float f1, float f2OrQ, float sampleHz);
+};
+
+// Fixed-capacity cascade, run every tick on one signal. Sections are
+// applied in order; OFF sections are never stored.
+template <size_t MAX_SECTIONS>
+class BiquadChain {
+public:
+    static constexpr size_t capacity() { return MAX_SECTIONS; }
+
+    struct Spec {
+        Biquad::Type type;
+        float f1, f2OrQ;
+    };
+
+    float process(float x) {
+        for (size_t i = 0; i < count; i++) x = sections[i].process(x);
+        return x;
+    }
+
+    // Sets section i, or with OFF drops it and everything after it. The chain
+    // is primed to the present value so a change never kicks the signal
+    bool set(size_t i, Biquad::Type type, float f1, float f2OrQ, float sampleHz, float present) {
+        if (i > count || i >= MAX_SECTIONS) return false;
+        if (type == Biquad::OFF) {
+            count = i;
+        } else {
+            Biquad section;
+            if (!section.design(type, f1, f2OrQ, sampleHz)) return false;
+            sections[i] = section;
+            specs[i] = {type, f1, f2OrQ};
+            if (i == count) count++;
+        }
+        prime(present);
+        return true;
+    }
+
+    void prime(float x) {
+        for (size_t i = 0; i < count; i++) x = sections[i].prime(x);
+    }
+
+    // Appends a section exactly as saved, coefficients and state included
+    bool restore(const Spec& spec, const Biquad& section) {
+        if (count >= MAX_SECTIONS || spec.type == Biquad::OFF) return false;
+        specs[count] = spec;
+        sections[count++] = section;
+        return true;
+    }
+
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    const Biquad& section(size_t i) const { return sections[i]; }
+    const Spec& spec(size_t i) const { return specs[i]; }
+
+private:
+    Biquad sections[MAX_SECTIONS];
+    Spec specs[MAX_SECTIONS] = {};
+    size_t count = 0;
+};
@@ -1,85 +1,810 @@
 #include "bleCom.h"
 #include "motorConfig.h"
+#include "jointSupervisor.h"
+#include "controlTask.h"
+#include "memoryGuard.h"
+#include "recorder.h"
+#include "latencyTrace.h"
+#include "bench.h"
+#include "idleManager.h"
+#include "bootTrace.h"
+#include "paramStore.h"
+#include "sensorBus.h"
+#include "motionLibrary.h"
+#include "motionPlayer.h"
+#include "eventLog.h"
+#include "currentSense.h"
 #include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_gap_ble_api.h>
 
 bool BLECom::debugEnabled = true;  // Debug enabled by default
 
-extern MotorPID motor1, motor2;
-
 BLESerial<etl::circular_buffer<uint8_t, 255>> BLECom::SerialBLE;
-std::mutex BLECom::ble_mutex;
-String BLECom::buffer = "";
+Telemetry BLECom::telemetry(BLECom::SerialBLE);
+char BLECom::buffer[MAX_COMMAND_LENGTH + 1];
+unsigned BLECom::bufferLength = 0;
+int64_t BLECom::lineStartUs = 0;
+int BLECom::loopbackRemaining = 0;
+uint32_t BLECom::lastLoopbackMs = 0;
+esp_bd_addr_t BLECom::peerAddress;
+std::atomic<bool> BLECom::peerConnected{false};
+float BLECom::lqrSent[Board::NUM_JOINTS][Board::NUM_JOINTS][3] = {};
+bool BLECom::lqrSelected[Board::NUM_JOINTS] = {};
 
 void BLECom::init() {
     SerialBLE.begin("MotorController-BLE");
+    BLEDevice::setCustomGattsHandler(gattsEvent);  // Peer address for connection updates
     if(debugEnabled) Serial.println("BLE Initialized");
 }
 
 void BLECom::update() {
-    // Process only 1 character per call to prevent blocking
-    if (SerialBLE.available()) {
+    // Comms has its own core now, drain everything that arrived
+    while (SerialBLE.available()) {
         char c = SerialBLE.read();
         processCharacter(c);
     }
+    if (loopbackRemaining > 0) {
+        injectLoopback();
+    }
+}
+
+void BLECom::injectLoopback() {
+    if (bufferLength > 0 || millis() - lastLoopbackMs < Board::CONTROL_PERIOD_US / 1000) return;
+    lastLoopbackMs = millis();
+    loopbackRemaining--;
+
+    // Re-send the current target so the joint does not move
+    char line[32];
+    snprintf(line, sizeof(line), "tar1=%.2f\n", motors[0].getSetpointDeg());
+    for (const char* p = line; *p; p++) {
+        processCharacter(*p);
+    }
+}
+
+void BLECom::reportHealth() {
+    supervisor.report(SerialBLE);
+}
+
+// Runs in the Bluetooth task
+void BLECom::gattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gattsIf,
+                        esp_ble_gatts_cb_param_t* param) {
+    if (event == ESP_GATTS_CONNECT_EVT) {
+        memcpy(peerAddress, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+        peerConnected.store(true, std::memory_order_release);
+    } else if (event == ESP_GATTS_DISCONNECT_EVT) {
+        peerConnected.store(false, std::memory_order_release);
+    }
+}
+
+void BLECom::setLowPower(bool low) {
+    if (!peerConnected.load(std::memory_order_acquire)) return;
+
+    // Slave latency stays 0 so a command is never held back more than one interval
+    esp_ble_conn_update_params_t params = {};
+    memcpy(params.bda, peerAddress, sizeof(esp_bd_addr_t));
+    params.min_int = low ? IDLE_MIN_INTERVAL : ACTIVE_MIN_INTERVAL;
+    params.max_int = low ? IDLE_MAX_INTERVAL : ACTIVE_MAX_INTERVAL;
+    params.latency = 0;
+    params.timeout = SUPERVISION_TIMEOUT;
+    esp_ble_gap_update_conn_params(&params);
+}
+
+void BLECom::reportBacklash(size_t joint) {
+    motors[joint].backlash.report(SerialBLE, joint);
 }
 
 void BLECom::processCharacter(char c) {
     // Handle various line endings
     if (c == '\r' || c == '\n' || c == ';') {
-        if (buffer.length() > 0) {
-            std::lock_guard<std::mutex> lock(motor_mutex);
-            if(debugEnabled) Serial.printf("[BLE] Processing command: '%s'\n", buffer.c_str());
+        if (bufferLength > 0) {
+            buffer[bufferLength] = '\0';
+            if(debugEnabled) Serial.printf("[BLE] Processing command: '%s'\n", buffer);
             handleCommand(buffer);
-            buffer = "";
+            bufferLength = 0;
         }
         return;
     }
     
-    if (isPrintable(c) && buffer.length() < 32) {
-        buffer += c;
+    if (isPrintable(c) && bufferLength < MAX_COMMAND_LENGTH) {
+        if (bufferLength == 0) IdleManager::noteActivity();
+        // Receipt time is when the comms loop reads the byte, at most one tick after the radio
+        if (bufferLength == 0) lineStartUs = esp_timer_get_time();
+        buffer[bufferLength++] = c;
     }
 }
 
-void BLECom::handleCommand(const String& command) {
-   if(motor_mutex.try_lock_for(std::chrono::milliseconds(10))) {
+// Joint numbers on the wire are 1-based
+MotorPID* BLECom::joint(int number) {
+    return (number >= 1 && number <= (int)Board::NUM_JOINTS) ? &motors[number - 1] : nullptr;
+}
+
+// Queue a command for the control core, answering busy when its ring is full
+bool BLECom::sendControl(const ControlCommand& cmd) {
+    ControlCommand traced = cmd;
+    traced.receivedUs = lineStartUs;
+    if (ControlTask::send(traced)) {
+        return true;
+    }
+    SerialBLE.println("ERR: System busy");
+    return false;
+}
+
+void BLECom::handleCommand(const char* cmd) {
     float value = 0;
-    int motorNum = -1;
-    const char* cmd = command.c_str();
+    int motorNum = 0;
+
+    // Waypoint streaming: wp1=<ms>,<deg>[,<ms>,<deg>...]
+    if (strncmp(cmd, "wp", 2) == 0) {
+        handleWaypoints(cmd);
+        return;
+    }
     
-    // Strict pattern matching
-    if (sscanf(cmd, "tar1=%f", &value) == 1) {
-        motorNum = 0;
-    } 
-    else if (sscanf(cmd, "tar2=%f", &value) == 1) {
-        motorNum = 1;
-    }
-
-    if (motorNum != -1) {
-        value = constrain(value, MIN_SETPOINT, MAX_SETPOINT);
-        MotorPID* target = (motorNum == 0) ? &motor1 : &motor2;
-        
-        // Debug before/after values
-        if(debugEnabled) {
-            Serial.printf("[MOTOR%d] Previous Setpoint: %.2f\n", 
-                         motorNum+1, target->Setpoint);
-        }
-        
-        target->setSetpointDeg(value);
-        
-        if(debugEnabled) {
-            Serial.printf("[MOTOR%d] New Setpoint: %.2f\n", 
-                         motorNum+1, target->Setpoint);
-        }
-        
-        SerialBLE.printf("OK %s=%.2f\n", 
-                        (motorNum == 0) ? "tar1" : "tar2", value);
+    // Gain schedule upload: gs1=..., gsp1=..., gsc1, gsx1
+    if (strncmp(cmd, "gs", 2) == 0) {
+        handleGainSchedule(cmd);
+        return;
+    }
+
+    // Telemetry subscriptions: tsub=..., tclr=..., tstat. BLE only: USB input
+    // is the tuning table's, so the USB link's frames are subscribed from here
+    if (cmd[0] == 't' && (strncmp(cmd, "tsub=", 5) == 0 || strncmp(cmd, "tclr=", 5) == 0
+                          || strcmp(cmd, "tstat") == 0)) {
+        handleTelemetry(cmd);
+        return;
+    }
+
+    // Record and replay: rec, rec=..., recl=<hex>
+    if (strncmp(cmd, "rec", 3) == 0) {
+        handleRecorder(cmd);
+        return;
+    }
+
+    // Backlash compensation: bkl, bkl1=..., bklc1=...
+    if (strncmp(cmd, "bkl", 3) == 0) {
+        handleBacklash(cmd);
+        return;
+    }
+
+    // Parameter profiles and soft limits: prof, prof=..., profc=..., lim1=...
+    if (strncmp(cmd, "prof", 4) == 0 || strncmp(cmd, "lim", 3) == 0) {
+        handleProfile(cmd);
+        return;
+    }
+
+    // State feedback: lqr, lqr1=..., lqrx1,2=..., ctl1=<pid|lqr>
+    if (strncmp(cmd, "lqr", 3) == 0 || strncmp(cmd, "ctl", 3) == 0) {
+        handleLqr(cmd);
+        return;
+    }
+
+    // Biquad chains: flt, flt1=<m|d|o>,<section>,<type>[,<f1>,<q or f2>]
+    if (strncmp(cmd, "flt", 3) == 0) {
+        handleFilter(cmd);
+        return;
+    }
+
+    // Motion primitives: play, play <id>[ <blend ms>], play stop
+    if (strncmp(cmd, "play", 4) == 0) {
+        handlePlay(cmd);
+        return;
+    }
+
+    // Idle mode: idle, idle=<0|1>
+    if (strncmp(cmd, "idle", 4) == 0) {
+        handleIdle(cmd);
+        return;
+    }
+
+    // Joint health: status query and fault reset (a HEALTH line follows)
+    if (strcmp(cmd, "health") == 0) {
+        reportHealth();
+        return;
+    }
+    if (strcmp(cmd, "clr") == 0) {
+        if (sendControl({ControlCommand::Type::ClearFaults, 0, {}})) {
+            SerialBLE.println("OK clr");
+        }
+        return;
+    }
+
+    // Control loop timing, cross-core queue health and command latency percentiles
+    if (strcmp(cmd, "stats") == 0) {
+        ControlTask::Stats st = ControlTask::stats();
+        SerialBLE.printf("STATS ticks=%u overruns=%u tick_max_us=%u cmd_lat_max_us=%u "
+                        "cmd_drop=%u state_drop=%u\n",
+                        (unsigned)st.ticks, (unsigned)st.overruns, (unsigned)st.maxTickUs,
+                        (unsigned)st.maxCommandLatencyUs, (unsigned)st.commandsDropped,
+                        (unsigned)st.statesDropped);
+        LatencyTrace::report(SerialBLE);
+        return;
+    }
+    if (strcmp(cmd, "stats=reset") == 0) {
+        LatencyTrace::reset();
+        SerialBLE.println("OK stats=reset");
+        return;
+    }
+
+    // latb=<n>: n loopback tar1= commands through the parser, then read stats.
+    // Like any tar1=, this cancels a waypoint stream on joint 1
+    int count = 0;
+    if (sscanf(cmd, "latb=%d", &count) == 1 && count > 0 && count <= MAX_LOOPBACK) {
+        loopbackRemaining = count;
+        SerialBLE.printf("OK latb=%d\n", count);
+        return;
+    }
+
+    // Hot path microbenchmarks, one JSON line (blocks comms for about a second)
+    if (strcmp(cmd, "bench") == 0) {
+        Bench::run(SerialBLE);
+        return;
+    }
+
+    // Head IMU: bus health, transfer latency, poll cost and orientation
+    if (strcmp(cmd, "imu") == 0) {
+        SensorBus::report(SerialBLE);
+        return;
+    }
+
+    // Motor current: ADC health, phase lock and filtered amps
+    if (strcmp(cmd, "cur") == 0) {
+        CurrentSense::report(SerialBLE);
+        return;
+    }
+
+    // Startup phase timeline
+    if (strcmp(cmd, "boot") == 0) {
+        BootTrace::report(SerialBLE);
+        return;
+    }
+
+    // Event log kept across resets: log, log=clear
+    if (strcmp(cmd, "log") == 0) {
+        EventLog::report(SerialBLE);
+        return;
+    }
+    if (strcmp(cmd, "log=clear") == 0) {
+        EventLog::clear();
+        SerialBLE.println("OK log=clear");
+        return;
+    }
+
+    // Static memory budget and stack high-water marks
+    if (strcmp(cmd, "mem") == 0) {
+        MemoryGuard::report(SerialBLE);
+        return;
+    }
+
+    // Host-reported supply voltage for voltage-keyed schedules
+    if (sscanf(cmd, "vbat=%f", &value) == 1) {
+        if (sendControl({ControlCommand::Type::SupplyVolts, 0, {value}})) {
+            SerialBLE.printf("OK vbat=%.2f\n", value);
+        }
+        return;
+    }
+
+    // Strict pattern matching: tar<joint>=<deg>
+    MotorPID* target = nullptr;
+    if (sscanf(cmd, "tar%d=%f", &motorNum, &value) == 2) {
+        target = joint(motorNum);
+    }
+
+    if (target) {
+        value = target->clampDeg(value);
+        if (sendControl({ControlCommand::Type::SetpointDeg, (uint8_t)(motorNum - 1), {value}})) {
+            SerialBLE.printf("OK tar%d=%.2f\n", motorNum, value);
+        }
     } else {
         SerialBLE.println("ERR: Invalid format");
         if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
     }
+}
+
+void BLECom::handleWaypoints(const char* cmd) {
+    int motorIdx = 0;
+    int consumed = 0;
+    MotorPID* target = nullptr;
+
+    // wpq: queue depth and underrun counter per joint
+    if (strcmp(cmd, "wpq") == 0) {
+        SerialBLE.print("WPQ");
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            SerialBLE.printf(" q%u=%u u%u=%u", (unsigned)(j + 1), motors[j].trajectory.depth(),
+                            (unsigned)(j + 1), motors[j].trajectory.underruns());
+        }
+        SerialBLE.println();
+        return;
+    }
+
+    // wpc1 / wpc2: drop the stream and hold the current setpoint
+    if (sscanf(cmd, "wpc%d%n", &motorIdx, &consumed) == 1 && cmd[consumed] == '\0'
+        && (target = joint(motorIdx))) {
+        target->trajectory.requestClear();
+        SerialBLE.printf("OK wpc%d\n", motorIdx);
+        return;
+    }
+
+    // wpm1=<0|1>: underrun handling, 0 = hold last point, 1 = extrapolate
+    int mode = 0;
+    if (sscanf(cmd, "wpm%d=%d", &motorIdx, &mode) == 2 && (target = joint(motorIdx))) {
+        target->trajectory.underrunMode.store(mode ? WaypointQueue::UnderrunMode::Extrapolate
+                                                   : WaypointQueue::UnderrunMode::Hold,
+                                              std::memory_order_relaxed);
+        SerialBLE.printf("OK wpm%d=%d\n", motorIdx, mode ? 1 : 0);
+        return;
+    }
+
+    // wp1=<ms>,<deg>[,<ms>,<deg>...]: batch append, reply carries depth for flow control
+    if (sscanf(cmd, "wp%d=%n", &motorIdx, &consumed) == 1 && consumed > 0
+        && (target = joint(motorIdx))) {
+        const char* p = cmd + consumed;
+        int accepted = 0;
+        WaypointQueue::PushResult result = WaypointQueue::PushResult::Ok;
+
+        while (*p) {
+            char* end;
+            unsigned long timeMs = strtoul(p, &end, 10);
+            if (end == p || *end != ',') break;
+            p = end + 1;
+            float degrees = strtof(p, &end);
+            if (end == p) break;
+            p = (*end == ',') ? end + 1 : end;
+
+            degrees = target->clampDeg(degrees);
+            result = target->trajectory.push({(uint32_t)timeMs, degrees});
+            if (result != WaypointQueue::PushResult::Ok) break;
+            accepted++;
+        }
+
+        // Times must rise; the rest of the batch is dropped at the first that does not
+        if (result == WaypointQueue::PushResult::OutOfOrder) SerialBLE.println("ERR: Waypoint time not increasing");
+        SerialBLE.printf("WP%d n=%d q=%u free=%u\n", motorIdx, accepted,
+                        target->trajectory.depth(), target->trajectory.freeSlots());
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid waypoint command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+// Parses "<key>,<origin>,<step>,<count>" into an axis, returns chars consumed or 0
+static int parseAxis(const char* p, GainSchedule::Axis& axis) {
+    char key = 0;
+    float origin = 0, step = 0;
+    int count = 0, consumed = 0;
+    if (sscanf(p, "%c,%f,%f,%d%n", &key, &origin, &step, &count, &consumed) != 4) return 0;
+    axis.key = GainSchedule::parseKey(key);
+    if (axis.key == GainSchedule::Key::None || step <= 0 || count < 1 || count > 255) return 0;
+    axis.origin = origin;
+    axis.invStep = 1.0f / step;
+    axis.count = (uint8_t)count;
+    return consumed;
+}
+
+void BLECom::handleGainSchedule(const char* cmd) {
+    int motorIdx = 0;
+    int consumed = 0;
+    MotorPID* target = nullptr;
+
+    // The table swapped out by gsc stays in use until the next control tick
+    if (sscanf(cmd, "%*[gscp]%d", &motorIdx) == 1 && (target = joint(motorIdx))
+        && !target->stagingWritable()) {
+        SerialBLE.println("ERR: Gain table swap pending");
+        return;
+    }
+
+    // gs1=<key>,<origin>,<step>,<count>[,<key>,<origin>,<step>,<count>]
+    // Keys: e = |error| deg, v = |velocity| deg/s, s = supply V. Starts a new staging table.
+    if (sscanf(cmd, "gs%d=%n", &motorIdx, &consumed) == 1 && consumed > 0
+        && (target = joint(motorIdx))) {
+        GainSchedule::Axis x, y;
+        const char* p = cmd + consumed;
+        int used = parseAxis(p, x);
+        bool ok = used > 0;
+        if (ok && p[used] == ',') {
+            ok = parseAxis(p + used + 1, y) > 0;
+        }
+        if (ok && target->stagingSchedule().configure(x, y)) {
+            SerialBLE.printf("OK gs%d n=%u\n", motorIdx, target->stagingSchedule().size());
+        } else {
+            SerialBLE.println("ERR: Invalid gain table shape");
+        }
+        return;
+    }
+
+    // gsp1=<index>,<kp>,<ki>,<kd>[,<kp>,<ki>,<kd>...]: consecutive points from index
+    if (sscanf(cmd, "gsp%d=%n", &motorIdx, &consumed) == 1 && consumed > 0
+        && (target = joint(motorIdx))) {
+        GainSchedule& table = target->stagingSchedule();
+        const char* p = cmd + consumed;
+        char* end;
+        long index = strtol(p, &end, 10);
+        int written = 0;
+        p = end;
+        while (*p == ',') {
+            float gains[3];
+            int n = 0;
+            for (; n < 3 && *p == ','; n++) {
+                gains[n] = strtof(p + 1, &end);
+                if (end == p + 1) break;
+                p = end;
+            }
+            if (n < 3 || !table.setPoint((uint8_t)(index + written), {gains[0], gains[1], gains[2]})) break;
+            written++;
+        }
+        SerialBLE.printf("GSP%d set=%d complete=%d\n", motorIdx, written, table.complete() ? 1 : 0);
+        return;
+    }
+
+    // gsc1: swap the staging table in; gsx1: back to fixed gains
+    if (sscanf(cmd, "gsc%d%n", &motorIdx, &consumed) == 1 && cmd[consumed] == '\0'
+        && (target = joint(motorIdx))) {
+        if (target->commitSchedule()) {
+            SerialBLE.printf("OK gsc%d\n", motorIdx);
+        } else {
+            SerialBLE.println("ERR: Incomplete gain table");
+        }
+        return;
+    }
+    if (sscanf(cmd, "gsx%d%n", &motorIdx, &consumed) == 1 && cmd[consumed] == '\0'
+        && (target = joint(motorIdx))) {
+        target->disableSchedule();
+        SerialBLE.printf("OK gsx%d\n", motorIdx);
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid gain schedule command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+void BLECom::handleTelemetry(const char* cmd) {
+    // tstat: bytes and encoder cost per link
+    if (strcmp(cmd, "tstat") == 0) {
+        SerialBLE.print("u ");
+        usbTelemetry.report(SerialBLE);
+        SerialBLE.print("b ");
+        telemetry.report(SerialBLE);
+        return;
+    }
+
+    char link = 0;
+    Telemetry* engine = nullptr;
+
+    // tclr=<u|b>: drop every subscription on that link (USB falls back to text)
+    if (sscanf(cmd, "tclr=%c", &link) == 1) {
+        engine = (link == 'u') ? &usbTelemetry : (link == 'b') ? &telemetry : nullptr;
+        if (engine) {
+            engine->unsubscribeAll();
+            SerialBLE.printf("OK tclr=%c\n", link);
+            return;
+        }
+    }
+
+    // tsub=<u|b>,<joint, 0 = all>,<channels>,<decimation>
+    // Channels: p position, v velocity, o output, e error, h health, k curvature,
+    // i motor current, c body centre of mass, t timing
+    int jointNum = 0, decimation = 0;
+    char letters[12] = {0};
+    if (sscanf(cmd, "tsub=%c,%d,%11[a-z],%d", &link, &jointNum, letters, &decimation) == 4
+        && decimation >= 1 && decimation <= 255) {
+        engine = (link == 'u') ? &usbTelemetry : (link == 'b') ? &telemetry : nullptr;
+        if (engine) {
+            int added = engine->subscribeLetters(jointNum, letters, (uint8_t)decimation);
+            SerialBLE.printf("OK tsub n=%d\n", added);
+            return;
+        }
+    }
+
+    SerialBLE.println("ERR: Invalid telemetry command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+void BLECom::handleRecorder(const char* cmd) {
+    // rec: recorder state and log usage
+    if (strcmp(cmd, "rec") == 0) {
+        Recorder::report(SerialBLE);
+        return;
+    }
+
+    // recl=<hex>: append an uploaded log chunk, after rec=clear
+    if (strncmp(cmd, "recl=", 5) == 0) {
+        uint8_t chunk[MAX_COMMAND_LENGTH / 2];
+        size_t count = 0;
+        const char* p = cmd + 5;
+        while (isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1])) {
+            char hex[3] = {p[0], p[1], 0};
+            chunk[count++] = (uint8_t)strtoul(hex, nullptr, 16);
+            p += 2;
+        }
+        if (*p == '\0' && count > 0 && Recorder::load(chunk, count)) {
+            SerialBLE.printf("OK recl n=%u\n", (unsigned)count);
+        } else {
+            SerialBLE.println("ERR: Recorder busy or full");
+        }
+        return;
+    }
+
+    // rec=start|stop|clear|dump|replay; dumps go to USB, replay reports here
+    bool ok = false;
+    if (strcmp(cmd, "rec=start") == 0) {
+        ok = Recorder::start();
+    } else if (strcmp(cmd, "rec=stop") == 0) {
+        ok = Recorder::stop();
+    } else if (strcmp(cmd, "rec=clear") == 0) {
+        ok = Recorder::clear();
+    } else if (strcmp(cmd, "rec=dump") == 0) {
+        ok = Recorder::startDump(Serial);
+    } else if (strcmp(cmd, "rec=replay") == 0) {
+        ok = Recorder::startReplay(SerialBLE);
+    } else {
+        SerialBLE.println("ERR: Invalid recorder command");
+        if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+        return;
+    }
 
-     motor_mutex.unlock();
+    if (ok) {
+        SerialBLE.printf("OK %s\n", cmd);
     } else {
-        SerialBLE.println("ERR: System busy");
+        SerialBLE.println("ERR: Recorder busy");
+    }
+}
+
+void BLECom::handleBacklash(const char* cmd) {
+    int motorIdx = 0;
+    float a = 0, b = 0;
+
+    // bkl: current model per joint
+    if (strcmp(cmd, "bkl") == 0) {
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            reportBacklash(j);
+        }
+        return;
+    }
+
+    // bklc1=<amplitude deg>,<speed deg/s>: calibration sweep around the current target,
+    // a BKL line follows when it ends (ok=0 if the sweep would leave the limits)
+    if (sscanf(cmd, "bklc%d=%f,%f", &motorIdx, &a, &b) == 3 && joint(motorIdx)
+        && a > 0 && b > 0) {
+        const MotorPID::Config& cfg = joint(motorIdx)->config();
+        if (2.0f * a > cfg.maxDeg - cfg.minDeg) {
+            SerialBLE.println("ERR: Sweep wider than the joint range");
+            return;
+        }
+        if (sendControl({ControlCommand::Type::BacklashCalibrate, (uint8_t)(motorIdx - 1), {a, b}})) {
+            SerialBLE.printf("OK bklc%d\n", motorIdx);
+        }
+        return;
+    }
+
+    // bkl1=<width deg>,<compliance deg per %>: set the model, 0,0 disables
+    if (sscanf(cmd, "bkl%d=%f,%f", &motorIdx, &a, &b) == 3 && joint(motorIdx) && a >= 0) {
+        if (sendControl({ControlCommand::Type::Backlash, (uint8_t)(motorIdx - 1), {a, b}})) {
+            ParamStore::noteBacklash(motorIdx - 1, a, b);
+            SerialBLE.printf("OK bkl%d=%.3f,%.4f\n", motorIdx, a, b);
+        }
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid backlash command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+void BLECom::handleIdle(const char* cmd) {
+    int enable = 0;
+
+    // idle: state, time share and estimated saving
+    if (strcmp(cmd, "idle") == 0) {
+        IdleManager::report(SerialBLE);
+        return;
+    }
+
+    // idle=<0|1>: allow or forbid parking the joints
+    if (sscanf(cmd, "idle=%d", &enable) == 1) {
+        IdleManager::enabled = enable != 0;
+        SerialBLE.printf("OK idle=%d\n", IdleManager::enabled ? 1 : 0);
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid idle command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+void BLECom::handleProfile(const char* cmd) {
+    int index = 0;
+    float a = 0, b = 0;
+    char name[ParamStore::NAME_LENGTH] = {};
+
+    // prof: active profile, store health and the profile names
+    if (strcmp(cmd, "prof") == 0) {
+        ParamStore::report(SerialBLE);
+        return;
     }
-}
\ No newline at end of file
+
+    // prof=flush: write pending changes now instead of after the quiet period
+    if (strcmp(cmd, "prof=flush") == 0) {
+        ParamStore::flush();
+        SerialBLE.println("OK prof=flush");
+        return;
+    }
+
+    // prof=<n>: switch profile while running; gains, limits and backlash follow
+    if (sscanf(cmd, "prof=%d", &index) == 1 && index >= 0 && index < (int)ParamStore::MAX_PROFILES) {
+        if (ParamStore::select((uint8_t)index)) {
+            SerialBLE.printf("OK prof=%d %s\n", index, ParamStore::active().name);
+        } else {
+            SerialBLE.println("ERR: System busy");
+        }
+        return;
+    }
+
+    // profc=<n>,<name>: copy the active profile into slot n under a new name
+    if (sscanf(cmd, "profc=%d,%11[A-Za-z0-9_-]", &index, name) == 2 && index >= 0
+        && ParamStore::copyActive((uint8_t)index, name)) {
+        SerialBLE.printf("OK profc=%d,%s\n", index, name);
+        return;
+    }
+
+    // lim1=<min deg>,<max deg>: soft limits inside the board table's range
+    if (sscanf(cmd, "lim%d=%f,%f", &index, &a, &b) == 3 && joint(index) && a < b) {
+        if (sendControl({ControlCommand::Type::Limits, (uint8_t)(index - 1), {a, b}})) {
+            ParamStore::noteLimits(index - 1, a, b);
+            SerialBLE.printf("OK lim%d=%.2f,%.2f\n", index, a, b);
+        }
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid profile command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+void BLECom::handleLqr(const char* cmd) {
+    int motorIdx = 0, sourceIdx = 0;
+    float k[3] = {};
+    char mode[4] = {};
+
+    // lqr: controller and gain rows per joint, as queued to the control task
+    if (strcmp(cmd, "lqr") == 0) {
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            SerialBLE.printf("LQR j%u mode=%s", (unsigned)(j + 1), lqrSelected[j] ? "lqr" : "pid");
+            for (size_t i = 0; i < Board::NUM_JOINTS; i++) {
+                const float* k = lqrSent[j][i];
+                SerialBLE.printf(" k%u=%.4g,%.4g,%.4g", (unsigned)(i + 1), k[0], k[1], k[2]);
+            }
+            SerialBLE.println();
+        }
+        return;
+    }
+
+    // lqrx1,2=<kpos>,<kvel>,<kint>: joint 1's gains on joint 2's state (coupling)
+    if (sscanf(cmd, "lqrx%d,%d=%f,%f,%f", &motorIdx, &sourceIdx, &k[0], &k[1], &k[2]) == 5
+        && joint(motorIdx) && joint(sourceIdx)) {
+        uint8_t address = (uint8_t)((motorIdx - 1) | ((sourceIdx - 1) << 4));
+        if (sendControl({ControlCommand::Type::LqrGains, address, {k[0], k[1], k[2]}})) {
+            memcpy(lqrSent[motorIdx - 1][sourceIdx - 1], k, sizeof(k));
+            SerialBLE.printf("OK lqrx%d,%d\n", motorIdx, sourceIdx);
+        }
+        return;
+    }
+
+    // lqr1=<kpos>,<kvel>,<kint>: joint 1's gains on its own state, drive % per deg, deg/s, deg s
+    if (sscanf(cmd, "lqr%d=%f,%f,%f", &motorIdx, &k[0], &k[1], &k[2]) == 4 && joint(motorIdx)) {
+        uint8_t address = (uint8_t)((motorIdx - 1) | ((motorIdx - 1) << 4));
+        if (sendControl({ControlCommand::Type::LqrGains, address, {k[0], k[1], k[2]}})) {
+            memcpy(lqrSent[motorIdx - 1][motorIdx - 1], k, sizeof(k));
+            SerialBLE.printf("OK lqr%d=%.4g,%.4g,%.4g\n", motorIdx, k[0], k[1], k[2]);
+        }
+        return;
+    }
+
+    // ctl1=<pid|lqr>: switch controller while running, bumpless
+    if (sscanf(cmd, "ctl%d=%3s", &motorIdx, mode) == 2 && joint(motorIdx)
+        && (strcmp(mode, "pid") == 0 || strcmp(mode, "lqr") == 0)) {
+        float lqr = strcmp(mode, "lqr") == 0 ? 1.0f : 0.0f;
+        if (sendControl({ControlCommand::Type::Controller, (uint8_t)(motorIdx - 1), {lqr}})) {
+            lqrSelected[motorIdx - 1] = lqr != 0.0f;
+            SerialBLE.printf("OK ctl%d=%s\n", motorIdx, mode);
+        }
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid LQR command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+void BLECom::handlePlay(const char* cmd) {
+    int id = 0, blend = MotionPlayer::DEFAULT_BLEND_MS;
+
+    // play: what is playing, then the library contents
+    if (strcmp(cmd, "play") == 0) {
+        MotionPlayer::report(SerialBLE);
+        MotionLibrary::report(SerialBLE);
+        return;
+    }
+
+    // play stop: joints hold wherever the primitive left them
+    if (strcmp(cmd, "play stop") == 0) {
+        if (sendControl({ControlCommand::Type::Play, 0, {-1.0f}})) {
+            SerialBLE.println("OK play stop");
+        }
+        return;
+    }
+
+    // play <id>[ <blend ms>]: cross-fades from the current motion
+    int fields = sscanf(cmd, "play %d %d", &id, &blend);
+    if (fields >= 1 && id >= 0 && blend >= 0 && (uint32_t)blend <= MotionPlayer::MAX_BLEND_MS) {
+        if (!MotionLibrary::find((uint16_t)id)) {
+            SerialBLE.printf("ERR: No primitive %d\n", id);
+            return;
+        }
+        if (sendControl({ControlCommand::Type::Play, 0, {(float)id, (float)blend}})) {
+            SerialBLE.printf("OK play %d %d\n", id, blend);
+        }
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid play command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
+
+void BLECom::handleFilter(const char* cmd) {
+    static const char* const typeNames[Biquad::TYPE_COUNT] = {"off", "lp", "notch", "ll"};
+    static const char pathNames[MotorPID::FILTER_PATHS + 1] = "mdo";
+    int motorIdx = 0, section = 0;
+    char path = 0;
+    char type[6] = {};
+    float f1 = 0, f2 = 0;
+
+    // flt: every configured section with its coefficients, for tools/filter_response.py.
+    // The chains come from the active profile, which every flt and profile
+    // switch updates as it queues the change; the live ones are the control task's
+    if (strcmp(cmd, "flt") == 0) {
+        bool any = false;
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            for (size_t p = 0; p < MotorPID::FILTER_PATHS; p++) {
+                const ParamStore::FilterSpec* specs = ParamStore::active().joints[j].filters[p];
+                BiquadChain<MotorPID::FILTER_SECTIONS> chain;
+                for (size_t i = 0; i < MotorPID::FILTER_SECTIONS && specs[i].type != Biquad::OFF; i++) {
+                    chain.set(i, (Biquad::Type)specs[i].type, specs[i].f1, specs[i].f2OrQ,
+                              1e6f / Board::CONTROL_PERIOD_US, 0.0f);
+                }
+                for (size_t i = 0; i < chain.size(); i++) {
+                    const Biquad& b = chain.section(i);
+                    const auto& spec = chain.spec(i);
+                    SerialBLE.printf("FLT j=%u path=%c sec=%u type=%s f1=%.4g f2q=%.4g "
+                                     "b=%.9g,%.9g,%.9g a=%.9g,%.9g\n",
+                                     (unsigned)(j + 1), pathNames[p], (unsigned)i, typeNames[spec.type],
+                                     spec.f1, spec.f2OrQ, b.b0, b.b1, b.b2, b.a1, b.a2);
+                    any = true;
+                }
+            }
+        }
+        if (!any) SerialBLE.println("FLT none");
+        return;
+    }
+
+    // flt1=m,0,notch,12.5,4: section 0 of joint 1's measurement chain; off drops it and those after
+    int fields = sscanf(cmd, "flt%d=%c,%d,%5[a-z],%f,%f", &motorIdx, &path, &section, type, &f1, &f2);
+    const char* p = strchr(pathNames, path);
+    int kind = -1;
+    for (int t = 0; t < Biquad::TYPE_COUNT; t++) {
+        if (fields >= 4 && strcmp(type, typeNames[t]) == 0) kind = t;
+    }
+    if (joint(motorIdx) && p && path && section >= 0 && section < (int)MotorPID::FILTER_SECTIONS
+        && kind >= 0 && (kind == Biquad::OFF || fields == 6)) {
+        Biquad probe;
+        if (kind != Biquad::OFF && !probe.design((Biquad::Type)kind, f1, f2, 1e6f / Board::CONTROL_PERIOD_US)) {
+            SerialBLE.println("ERR: Filter frequency or q out of range");
+            return;
+        }
+        uint8_t address = (uint8_t)((motorIdx - 1) | (section << 4));
+        float code = (float)((p - pathNames) * 8 + kind);
+        if (sendControl({ControlCommand::Type::Filter, address, {code, f1, f2}})) {
+            ParamStore::noteFilter(motorIdx - 1, p - pathNames, section, kind, f1, f2);
+            SerialBLE.printf("OK flt%d=%c,%d,%s\n", motorIdx, path, section, type);
+        }
+        return;
+    }
+
+    SerialBLE.println("ERR: Invalid filter command");
+    if(debugEnabled) Serial.printf("[BLE] Rejected command: '%s'\n", cmd);
+}
@@ -2,24 +2,65 @@
 #include <BLESerial.h>
 #include <Embedded_Template_Library.h>
 #include <etl/circular_buffer.h>
-#include <mutex>
-#include "motorConfig.h" 
-class MotorPID;
-extern MotorPID motor1, motor2;
+#include <BLEDevice.h>
+#include <atomic>
+#include "motorConfig.h"
+#include "controlTask.h"
+#include "telemetry.h"
 
 class BLECom {
 public:
     static void init();
     static void update();
+    static void reportHealth();
+    static void reportBacklash(size_t joint);
+    // Stretches the connection interval while idle; no-op when nobody is connected
+    static void setLowPower(bool low);
+    static void publishTelemetry(const ControlState& state) { telemetry.publish(state); }
     static bool debugEnabled;  // Add debug flag
 
 private:
     static BLESerial<etl::circular_buffer<uint8_t, 255>> SerialBLE;
-    static std::mutex ble_mutex;
-    static String buffer;
-    static constexpr float MAX_SETPOINT = 360.0f;
-    static constexpr float MIN_SETPOINT = -360.0f;
+    static Telemetry telemetry;
+    static constexpr unsigned MAX_COMMAND_LENGTH = 128; // Room for waypoint batches
+    static char buffer[MAX_COMMAND_LENGTH + 1];
+    static unsigned bufferLength;
+    static int64_t lineStartUs;  // When the first byte of the current line was read
+
+    // Loopback stand-in for the radio: synthetic tar1= lines fed through the
+    // normal parser, one per control period, to exercise the traced path
+    static constexpr int MAX_LOOPBACK = 200;
+    static int loopbackRemaining;
+    static uint32_t lastLoopbackMs;
+    static void injectLoopback();
     
-    static void handleCommand(const String& command);
+    static void handleCommand(const char* cmd);
     static void processCharacter(char c);
+    static void handleWaypoints(const char* cmd);
+    static void handleGainSchedule(const char* cmd);
+    static void handleTelemetry(const char* cmd);
+    static void handleRecorder(const char* cmd);
+    static void handleBacklash(const char* cmd);
+    static void handleIdle(const char* cmd);
+    static void handleProfile(const char* cmd);
+    static void handleLqr(const char* cmd);
+    static void handlePlay(const char* cmd);
+    static void handleFilter(const char* cmd);
+
+    // Connection intervals in 1.25 ms units, supervision timeout in 10 ms units
+    static constexpr uint16_t ACTIVE_MIN_INTERVAL = 6;    // 7.5 ms
+    static constexpr uint16_t ACTIVE_MAX_INTERVAL = 12;   // 15 ms
+    static constexpr uint16_t IDLE_MIN_INTERVAL = 80;     // 100 ms
+    static constexpr uint16_t IDLE_MAX_INTERVAL = 120;    // 150 ms
+    static constexpr uint16_t SUPERVISION_TIMEOUT = 400;  // 4 s
+    static esp_bd_addr_t peerAddress;
+    static std::atomic<bool> peerConnected;
+    static void gattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gattsIf,
+                           esp_ble_gatts_cb_param_t* param);
+    // LQR rows and controller choice as last queued; motors[] belongs to the control task
+    static float lqrSent[Board::NUM_JOINTS][Board::NUM_JOINTS][3];
+    static bool lqrSelected[Board::NUM_JOINTS];
+
+    static MotorPID* joint(int number);
+    static bool sendControl(const ControlCommand& cmd);
 };
\ No newline at end of file
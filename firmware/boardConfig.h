@@ -0,0 +1,179 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Compile-time board description. Everything pin- or joint-specific lives
+// here; encoder, driver, PID and command tables are instantiated from it.
+namespace Board {
+
+struct EncoderConfig {
+    uint8_t pinA;
+    uint8_t pinB;
+    uint16_t linesPerRev;  // Motor-side lines, quadrature gives 4 counts per line
+};
+
+struct SpiDeviceConfig {
+    uint8_t cs;
+    uint32_t clockHz;
+    uint8_t mode;          // SPI mode 0-3
+    uint8_t readRegister;  // First register of the burst read each tick
+    uint8_t length;        // Bytes in the burst
+};
+
+struct JointConfig {
+    uint8_t encoder;       // Index into ENCODERS
+    uint8_t in1;           // Driver inputs
+    uint8_t in2;
+    uint16_t gearRatio;
+    bool inverted;         // Flip drive direction relative to encoder counts
+    float minDeg;          // Setpoint limits
+    float maxDeg;
+};
+
+constexpr uint8_t LED_PIN = 7;
+constexpr uint8_t PWM_2 = 41;
+constexpr uint8_t SLEEP_PIN = 39;
+
+constexpr bool RESET_COUNT_ON_BOOT = true;
+constexpr uint16_t ENCODER_GLITCH_FILTER = 250;  // PCNT filter in APB cycles, 0 disables
+constexpr float NOMINAL_SUPPLY_V = 7.4f;          // Until a measured value is reported
+constexpr float SEGMENT_LENGTH_MM = 65.0f;        // Joint axis to joint axis, for body shape
+
+// Task layout: control runs alone on core 1, comms and persistence on core 0
+constexpr uint32_t CONTROL_PERIOD_US = 10000;
+constexpr int CONTROL_CORE = 1;
+constexpr int COMMS_CORE = 0;
+
+constexpr EncoderConfig ENCODERS[] = {
+    {1, 2, 7},     // Encoder 1
+    {11, 12, 7},   // Encoder 2
+};
+
+constexpr JointConfig JOINTS[] = {
+    // Motor 1: AIN_2 = 37, AIN_1 = 38, read from encoder 2
+    {1, 37, 38, 298, false, -360.0f, 360.0f},
+    // Motor 2: BIN_2 = 35, BIN_1 = 36, read from encoder 1
+    {0, 35, 36, 298, false, -360.0f, 360.0f},
+};
+
+constexpr size_t NUM_ENCODERS = sizeof(ENCODERS) / sizeof(ENCODERS[0]);
+constexpr size_t NUM_JOINTS = sizeof(JOINTS) / sizeof(JOINTS[0]);
+
+// SPI sensor bus from the original pin map. Off: SCK and MOSI share GPIO 12
+// and 11 with encoder 2, so enabling it needs the encoder moved first (the
+// pin checks below refuse the clash). CS2 = 14 and CS3 = 21 are free for
+// auxiliary devices; device 0 is the head IMU.
+constexpr bool SPI_SENSORS_ENABLED = false;
+constexpr uint8_t SPI_MOSI = 11;
+constexpr uint8_t SPI_MISO = 13;
+constexpr uint8_t SPI_SCK = 12;
+constexpr SpiDeviceConfig SPI_DEVICES[] = {
+    {10, 8000000, 0, 0x1D, 14},  // CS1: ICM-42688-P, temperature, accel and gyro in one burst
+};
+constexpr size_t NUM_SPI_DEVICES = sizeof(SPI_DEVICES) / sizeof(SPI_DEVICES[0]);
+
+// Low-side shunt current sense from the original pin map, ADC_1 = 1 and
+// ADC_2 = 2, one per joint. Off for the same reason as the SPI bus: both are
+// encoder 1's pins here. Sampling runs on ADC1 (GPIO 1-10) at a whole
+// multiple of the driver's PWM rate so every sample keeps its place in the
+// PWM period.
+constexpr bool CURRENT_SENSE_ENABLED = false;
+constexpr uint8_t CURRENT_SENSE_PINS[] = {1, 2};  // Per joint, in JOINTS order
+constexpr float CURRENT_SENSE_MV_PER_A = 200.0f;  // 0.2 ohm shunt, no amplifier
+constexpr uint32_t PWM_FREQUENCY_HZ = 1000;       // ESP32MotorControl's MCPWM rate
+constexpr uint32_t CURRENT_BINS_PER_PWM = 20;     // ADC samples per joint per PWM period
+
+// Unit conversions, folded to constants at every call site
+constexpr int64_t countsPerRev(size_t joint) {
+    return int64_t(ENCODERS[JOINTS[joint].encoder].linesPerRev) * 4 * JOINTS[joint].gearRatio;
+}
+constexpr float countsPerDeg(size_t joint) { return countsPerRev(joint) / 360.0f; }
+constexpr float degPerCount(size_t joint) { return 360.0f / countsPerRev(joint); }
+
+// Output-side resolution of an encoder channel, taken from the joint it drives
+constexpr int64_t channelCountsPerRev(size_t encoder) {
+    for (size_t j = 0; j < NUM_JOINTS; j++) {
+        if (JOINTS[j].encoder == encoder) return countsPerRev(j);
+    }
+    return int64_t(ENCODERS[encoder].linesPerRev) * 4;
+}
+
+template <size_t J>
+struct Joint {
+    static_assert(J < NUM_JOINTS, "Joint index out of range");
+    static constexpr const JointConfig& config = JOINTS[J];
+    static constexpr int64_t COUNTS_PER_REV = countsPerRev(J);
+    static constexpr float COUNTS_PER_DEG = countsPerDeg(J);
+    static constexpr float DEG_PER_COUNT = degPerCount(J);
+};
+
+// ---- Build-time validation ----
+
+// ESP32-S3: GPIO 22-25 do not exist, 26-32 belong to flash/PSRAM and
+// 19/20 are the USB-CDC pair used for Serial
+constexpr bool isUsableGpio(uint8_t pin) {
+    return pin <= 48 && !(pin >= 19 && pin <= 32);
+}
+
+constexpr size_t BASE_PIN_COUNT = 3 + 2 * NUM_ENCODERS + 2 * NUM_JOINTS;
+constexpr size_t SPI_PIN_COUNT = SPI_SENSORS_ENABLED ? 3 + NUM_SPI_DEVICES : 0;
+constexpr size_t PIN_COUNT = BASE_PIN_COUNT + SPI_PIN_COUNT + (CURRENT_SENSE_ENABLED ? NUM_JOINTS : 0);
+
+constexpr uint8_t spiPinAt(size_t i) {
+    return i == 0 ? SPI_MOSI : i == 1 ? SPI_MISO : i == 2 ? SPI_SCK : SPI_DEVICES[i - 3].cs;
+}
+
+constexpr uint8_t pinAt(size_t i) {
+    return i >= BASE_PIN_COUNT + SPI_PIN_COUNT ? CURRENT_SENSE_PINS[i - BASE_PIN_COUNT - SPI_PIN_COUNT]
+         : i >= BASE_PIN_COUNT ? spiPinAt(i - BASE_PIN_COUNT)
+         : i == 0 ? LED_PIN
+         : i == 1 ? PWM_2
+         : i == 2 ? SLEEP_PIN
+         : i < 3 + 2 * NUM_ENCODERS
+             ? ((i - 3) % 2 ? ENCODERS[(i - 3) / 2].pinB : ENCODERS[(i - 3) / 2].pinA)
+             : ((i - 3 - 2 * NUM_ENCODERS) % 2 ? JOINTS[(i - 3 - 2 * NUM_ENCODERS) / 2].in2
+                                               : JOINTS[(i - 3 - 2 * NUM_ENCODERS) / 2].in1);
+}
+
+constexpr bool pinsUsable() {
+    for (size_t i = 0; i < PIN_COUNT; i++) {
+        if (!isUsableGpio(pinAt(i))) return false;
+    }
+    return true;
+}
+
+constexpr bool pinsUnique() {
+    for (size_t i = 0; i < PIN_COUNT; i++) {
+        for (size_t j = i + 1; j < PIN_COUNT; j++) {
+            if (pinAt(i) == pinAt(j)) return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool jointsValid() {
+    for (size_t j = 0; j < NUM_JOINTS; j++) {
+        if (JOINTS[j].encoder >= NUM_ENCODERS) return false;
+        if (JOINTS[j].gearRatio == 0 || JOINTS[j].minDeg >= JOINTS[j].maxDeg) return false;
+        for (size_t k = j + 1; k < NUM_JOINTS; k++) {
+            if (JOINTS[j].encoder == JOINTS[k].encoder) return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool currentSenseValid() {
+    if (sizeof(CURRENT_SENSE_PINS) != NUM_JOINTS) return false;
+    for (size_t j = 0; j < NUM_JOINTS; j++) {
+        if (CURRENT_SENSE_PINS[j] < 1 || CURRENT_SENSE_PINS[j] > 10) return false;  // ADC1 only
+    }
+    return true;
+}
+
+static_assert(pinsUsable(), "Board pin map uses a reserved or nonexistent GPIO");
+static_assert(pinsUnique(), "Board pin map assigns the same GPIO twice");
+static_assert(jointsValid(), "Joint table has a bad encoder index, gear ratio or limit range");
+static_assert(currentSenseValid(), "Current sense needs one ADC1 pin (GPIO 1-10) per joint");
+static_assert(NUM_JOINTS >= 1 && NUM_JOINTS <= 2, "ESP32MotorControl drives at most two motors");
+
+} // namespace Board
@@ -0,0 +1,33 @@
+#include "bootTrace.h"
+#include <esp_timer.h>
+
+BootTrace::Span BootTrace::spans[PHASE_COUNT];
+int64_t BootTrace::readyUs = 0;
+bool BootTrace::nvsOk = true;
+
+static const char* const PHASE_NAMES[] = {
+    "encoders", "motors", "pids", "params", "control_start", "first_tick", "ble", "services"
+};
+
+void BootTrace::begin(Phase phase) {
+    spans[phase].startUs = esp_timer_get_time();
+}
+
+void BootTrace::end(Phase phase) {
+    spans[phase].endUs = esp_timer_get_time();
+}
+
+void BootTrace::markReady() {
+    readyUs = esp_timer_get_time();
+}
+
+void BootTrace::report(Print& out) {
+    out.printf("BOOT first_tick_us=%lld ready_us=%lld nvs=%s\n",
+               (long long)spans[FIRST_TICK].endUs, (long long)readyUs, nvsOk ? "ok" : "fail");
+    for (size_t p = 0; p < PHASE_COUNT; p++) {
+        const Span& s = spans[p];
+        int64_t duration = s.endUs >= s.startUs ? s.endUs - s.startUs : 0;
+        out.printf("BOOT %s start_us=%lld dur_us=%lld\n", PHASE_NAMES[p],
+                   (long long)s.startUs, (long long)duration);
+    }
+}
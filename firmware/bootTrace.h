@@ -0,0 +1,41 @@
+#pragma once
+#include <Arduino.h>
+
+// Startup timeline. setup() only brings up what the control loop needs to
+// hold position (encoders with their persisted counts, motor driver, PIDs)
+// and starts the control task; BLE and everything else initialise at the top
+// of the comms task while the joints are already held. Each phase records
+// its start and end on the esp_timer clock, which counts from reset.
+class BootTrace {
+public:
+    enum Phase : uint8_t {
+        ENCODERS,       // NVS open, count restore, PCNT attach, save task
+        MOTORS,         // Driver attach and sleep pin
+        PIDS,           // Joint table into the controllers
+        PARAMS,         // Saved profile load, hold setpoints
+        CONTROL_START,  // Control task created
+        FIRST_TICK,     // The control task's first tick
+        BLE,            // BLE stack and UART service, deferred
+        SERVICES,       // SPI sensors, current ADC, tuning table, memory registration, heap lock, deferred
+        PHASE_COUNT
+    };
+
+    static void begin(Phase phase);
+    static void end(Phase phase);
+    static void setNvsOk(bool ok) { nvsOk = ok; }
+    static void markReady();                 // Deferred init finished
+
+    // Format: BOOT first_tick_us=<us> ready_us=<us> nvs=<ok|fail>
+    //         BOOT <phase> start_us=<us> dur_us=<us>   (one line per phase)
+    static void report(Print& out);
+
+private:
+    struct Span {
+        int64_t startUs;
+        int64_t endUs;
+    };
+
+    static Span spans[PHASE_COUNT];
+    static int64_t readyUs;
+    static bool nvsOk;
+};
@@ -0,0 +1,275 @@
+#include "controlTask.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+#include "memoryGuard.h"
+#include "recorder.h"
+#include "latencyTrace.h"
+#include "idleManager.h"
+#include "bootTrace.h"
+#include "sensorBus.h"
+#include "kinematics.h"
+#include "motionPlayer.h"
+#include "eventLog.h"
+#include "currentSense.h"
+#include "paramStore.h"
+
+SpscRing<ControlCommand, ControlTask::COMMAND_SLOTS> ControlTask::commands;
+SpscRing<ControlState, 8> ControlTask::states;
+TaskHandle_t ControlTask::handle = nullptr;
+StackType_t ControlTask::stack[STACK_SIZE];
+StaticTask_t ControlTask::taskBuffer;
+
+static ChainKinematics<Board::NUM_JOINTS> body(Board::SEGMENT_LENGTH_MM);
+
+volatile uint32_t ControlTask::tickCount = 0;
+volatile uint32_t ControlTask::overrunCount = 0;
+volatile uint32_t ControlTask::maxTickUs = 0;
+volatile uint32_t ControlTask::maxCommandLatencyUs = 0;
+
+void ControlTask::begin() {
+    SinCosTable::init();
+    handle = xTaskCreateStaticPinnedToCore(
+        run,                    // Task function
+        "ControlTask",          // Task name
+        STACK_SIZE,             // Stack size
+        nullptr,                // Parameter
+        configMAX_PRIORITIES - 2, // Above comms, below the IDF timer task
+        stack,                  // Stack buffer
+        &taskBuffer,            // Task control block
+        Board::CONTROL_CORE     // Control owns core 1
+    );
+    MemoryGuard::registerTask("ControlTask", handle, STACK_SIZE);
+    MemoryGuard::forbidAllocations(handle);  // The tick must never touch the heap
+}
+
+void ControlTask::boot(bool resetCounts, uint16_t encoderFilter) {
+    motorInit(resetCounts, encoderFilter);
+
+    BootTrace::begin(BootTrace::PIDS);
+    initMotors();
+    BootTrace::end(BootTrace::PIDS);
+
+    // Saved gains, limits and backlash model replace the compiled-in ones
+    BootTrace::begin(BootTrace::PARAMS);
+    ParamStore::begin();
+    TrackEncoder::Snapshot snap = trackEncoder->snapshot();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const MotorPID::Config& cfg = motors[j].config();
+        motors[j].setSetpointDeg(motors[j].clampDeg(snap.counts[cfg.encoderIndex] * cfg.degPerCount));
+    }
+    BootTrace::end(BootTrace::PARAMS);
+
+    BootTrace::begin(BootTrace::CONTROL_START);
+    begin();
+    BootTrace::end(BootTrace::CONTROL_START);
+}
+
+bool ControlTask::send(ControlCommand cmd) {
+    cmd.enqueuedUs = esp_timer_get_time();
+    if (cmd.receivedUs == 0) cmd.receivedUs = cmd.enqueuedUs;
+    return commands.push(cmd);
+}
+
+bool ControlTask::send(ControlCommand* cmds, size_t count) {
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < count; i++) {
+        cmds[i].enqueuedUs = now;
+        if (cmds[i].receivedUs == 0) cmds[i].receivedUs = now;
+    }
+    return commands.push(cmds, count);
+}
+
+bool ControlTask::latestState(ControlState& state) {
+    return states.popLatest(state);
+}
+
+bool ControlTask::nextState(ControlState& state) {
+    return states.pop(state);
+}
+
+ControlTask::Stats ControlTask::stats() {
+    return {tickCount, overrunCount, maxTickUs, maxCommandLatencyUs,
+            commands.droppedCount(), states.droppedCount()};
+}
+
+void ControlTask::run(void* parameter) {
+    const TickType_t period = pdMS_TO_TICKS(Board::CONTROL_PERIOD_US / 1000);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (true) {
+        int64_t start = esp_timer_get_time();
+        tick();
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+        if (elapsed > maxTickUs) maxTickUs = elapsed;
+
+        if (xTaskDelayUntil(&lastWake, period) == pdFALSE) {
+            overrunCount = overrunCount + 1;
+            EventLog::log(EventLog::OVERRUN, EventLog::NO_JOINT, 0, elapsed);
+        }
+    }
+}
+
+void ControlTask::apply(const ControlCommand& cmd) {
+    int64_t now = esp_timer_get_time();
+    uint32_t latency = (uint32_t)(now - cmd.enqueuedUs);
+    if (latency > maxCommandLatencyUs) maxCommandLatencyUs = latency;
+    LatencyTrace::applied(cmd, now);
+    EventLog::log(EventLog::COMMAND, cmd.joint, (uint16_t)cmd.type, latency);
+    IdleManager::wake();
+
+    if (applyControllerCommand(motors, cmd)) {
+        if (cmd.type == ControlCommand::Type::Controller) {
+            EventLog::log(EventLog::MODE, cmd.joint, cmd.value[0] != 0.0f ? 1 : 0);
+        }
+        return;
+    }
+
+    if (cmd.joint >= Board::NUM_JOINTS) return;
+    MotorPID& motor = motors[cmd.joint];
+
+    switch (cmd.type) {
+        case ControlCommand::Type::SetpointDeg:
+            motor.trajectory.requestClear(); // A step target cancels any stream
+            MotionPlayer::stop();
+            motor.backlash.cancelCalibration();
+            motor.setSetpointDeg(cmd.value[0]);
+            break;
+        case ControlCommand::Type::Gains:
+            motor.Kp = cmd.value[0];
+            motor.Ki = cmd.value[1];
+            motor.Kd = cmd.value[2];
+            break;
+        case ControlCommand::Type::SupplyVolts:
+            for (auto& m : motors) m.supplyVolts = cmd.value[0];
+            break;
+        case ControlCommand::Type::ClearFaults:
+            supervisor.clear();
+            break;
+        case ControlCommand::Type::Backlash:
+            motor.backlash.params.widthDeg = max(0.0f, cmd.value[0]);
+            motor.backlash.params.complianceDegPerPct = cmd.value[1];
+            break;
+        case ControlCommand::Type::BacklashCalibrate:
+            motor.trajectory.requestClear();
+            MotionPlayer::stop();
+            motor.backlash.startCalibration(motor.referenceDeg, cmd.value[0], cmd.value[1],
+                                            motor.config().minDeg, motor.config().maxDeg);
+            break;
+        case ControlCommand::Type::Controller:
+        case ControlCommand::Type::LqrGains:
+        case ControlCommand::Type::Filter:
+            break;  // Handled above
+        case ControlCommand::Type::Play:
+            if (cmd.value[0] < 0.0f) {
+                MotionPlayer::stop();
+            } else {
+                MotionPlayer::play((uint16_t)cmd.value[0], (uint32_t)max(0.0f, cmd.value[1]));
+            }
+            break;
+        case ControlCommand::Type::Limits:
+            // A narrower range pulls a target that is now outside it back in,
+            // and ends a calibration sweep sized for the old range
+            motor.backlash.cancelCalibration();
+            motor.setLimits(cmd.value[0], cmd.value[1]);
+            if (motor.clampDeg(motor.referenceDeg) != motor.referenceDeg) {
+                motor.trajectory.requestClear();
+                motor.setSetpointDeg(motor.clampDeg(motor.referenceDeg));
+            }
+            break;
+    }
+}
+
+bool ControlTask::applyControllerCommand(MotorPID* group, const ControlCommand& cmd) {
+    switch (cmd.type) {
+        case ControlCommand::Type::Controller:
+            if (cmd.joint < Board::NUM_JOINTS) {
+                group[cmd.joint].setController(cmd.value[0] != 0.0f ? MotorPID::Controller::Lqr
+                                                                    : MotorPID::Controller::Pid);
+            }
+            return true;
+        case ControlCommand::Type::LqrGains: {
+            // Gain rows address a block of another joint's state in the high nibble
+            uint8_t target = cmd.joint & 0x0F, source = cmd.joint >> 4;
+            if (target < Board::NUM_JOINTS && source < Board::NUM_JOINTS) {
+                memcpy(group[target].lqrGains[source], cmd.value, sizeof(cmd.value));
+            }
+            return true;
+        }
+        case ControlCommand::Type::Filter: {
+            uint8_t target = cmd.joint & 0x0F, section = cmd.joint >> 4;
+            int code = (int)cmd.value[0];
+            if (target < Board::NUM_JOINTS && code / 8 < (int)MotorPID::FILTER_PATHS) {
+                group[target].setFilter((MotorPID::FilterPath)(code / 8), section, (Biquad::Type)(code % 8),
+                                        cmd.value[1], cmd.value[2]);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void ControlTask::tick() {
+    if (tickCount == 0) BootTrace::begin(BootTrace::FIRST_TICK);
+    Recorder::beginTick();
+    EventLog::setTick(tickCount);
+
+    ControlCommand cmd;
+    while (commands.pop(cmd)) {
+        Recorder::recordCommand(cmd);
+        apply(cmd);
+    }
+
+    // Collect last tick's sensor bursts and ADC samples and queue the next, never waits on a bus
+    SensorBus::poll();
+    CurrentSense::poll();
+
+    // A playing primitive writes this tick's setpoints
+    MotionPlayer::tick();
+
+    // One consistent encoder latch for the idle check and every motor
+    TrackEncoder::Snapshot snap = trackEncoder->snapshot();
+
+    // Idle check on this latch, so a push wakes the driver before anything is driven this tick
+    bool settled = true, disturbed = false;
+    for (const auto& motor : motors) {
+        float error = fabsf(motor.errorCounts(snap));
+        bool moving = motor.trajectory.depth() > 0 || motor.backlash.calibrating() || MotionPlayer::active();
+        settled = settled && !moving && error <= BRAKING_THRESHOLD;
+        disturbed = disturbed || moving || error > IdleManager::WAKE_ERROR_COUNTS;
+    }
+    bool parked = IdleManager::update(settled, disturbed);
+
+    // Update all motors from the same latch
+    for (auto& motor : motors) motor.latchPeers();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        motors[j].update(snap, parked);
+        LatencyTrace::actuated(j, esp_timer_get_time());
+    }
+    Recorder::recordTick(snap, supervisor.tripped());
+
+    // Body shape from the same latch
+    float jointDeg[Board::NUM_JOINTS];
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const MotorPID::Config& cfg = motors[j].config();
+        jointDeg[j] = snap.counts[cfg.encoderIndex] * cfg.degPerCount;
+    }
+    body.update(jointDeg);
+    const auto& shape = body.shape();
+
+    ControlState state;
+    state.tick = tickCount;
+    state.timestampUs = snap.timestampUs;
+    state.tripped = supervisor.tripped();
+    state.comXMm = shape.comXMm;
+    state.comYMm = shape.comYMm;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const MotorPID& m = motors[j];
+        state.joints[j] = {m.Setpoint, m.Input, m.Output, m.Kp, m.Ki, m.Kd,
+                           m.velocityDeg, supervisor.thermalLoad(j), shape.curvature[j], CurrentSense::amps(j),
+                           supervisor.faults(j)};
+    }
+    states.push(state);  // Dropped (and counted) if comms falls behind
+    tickCount = tickCount + 1;
+    if (tickCount == 1) BootTrace::end(BootTrace::FIRST_TICK);
+}
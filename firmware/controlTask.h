@@ -0,0 +1,101 @@
+#pragma once
+#include <Arduino.h>
+#include "boardConfig.h"
+#include "spscRing.h"
+#include "kinematics.h"
+
+class MotorPID;
+
+// Comms core -> control core
+struct ControlCommand {
+    enum class Type : uint8_t {
+        SetpointDeg, Gains, SupplyVolts, ClearFaults, Backlash, BacklashCalibrate, Limits,
+        LqrGains,    // joint | source joint << 4, values: position, velocity, integral gain
+        Controller,  // value[0]: 0 PID, 1 LQR
+        Play,        // value[0]: primitive id, -1 stops; value[1]: blend ms
+        Filter       // joint | section << 4, value[0]: path * 8 + Biquad::Type, then f1 and f2 or q
+    };
+    Type type;
+    uint8_t joint;       // 0-based
+    float value[3];
+    int64_t enqueuedUs = 0;  // Filled in by ControlTask::send
+    int64_t receivedUs = 0;  // First byte of the command line, enqueuedUs if unknown
+};
+
+// Control core -> comms core, one frame per tick
+struct JointState {
+    float setpoint, input, output;
+    float kp, ki, kd;
+    float velocityDeg;
+    float thermalLoad;  // Fraction of the I2t limit
+    float curvature;    // 1/m, from the joint angle over the segment length
+    float currentA;     // Filtered shunt current, 0 without current sense
+    uint8_t faults;
+};
+
+// Sized by joint count so host benchmarks can encode longer bodies; the
+// firmware's frames are ControlState
+template <size_t N>
+struct BasicControlState {
+    uint32_t tick;
+    int64_t timestampUs;  // Encoder latch time
+    bool tripped;
+    float comXMm, comYMm;  // Body centre of mass in the head frame
+    JointState joints[N];
+};
+using ControlState = BasicControlState<Board::NUM_JOINTS>;
+
+// Fixed-rate control loop pinned to its own core. Nothing else touches the
+// motors; other tasks talk to it only through the two rings.
+class ControlTask {
+public:
+    struct Stats {
+        uint32_t ticks;
+        uint32_t overruns;             // Periods where the tick ran late
+        uint32_t maxTickUs;
+        uint32_t maxCommandLatencyUs;  // Enqueue on comms core to apply
+        uint32_t commandsDropped;
+        uint32_t statesDropped;
+    };
+
+    static void begin();
+    // What holding position needs, in setup() before anything else: encoders
+    // with their persisted counts, driver, PIDs, the saved profile with the
+    // joints held where they are, then the task. The host rig boots the same way
+    static void boot(bool resetCounts, uint16_t encoderFilter);
+
+    // Comms side only
+    static bool send(ControlCommand cmd);
+    static bool send(ControlCommand* cmds, size_t count);  // Applied in the same tick, or not queued
+    static constexpr size_t COMMAND_SLOTS = 32;            // Largest batch send() can take
+    static bool latestState(ControlState& state);
+    static bool nextState(ControlState& state);  // In order, for decimating consumers
+    static Stats stats();
+    static size_t staticBytes() {
+        return sizeof(commands) + sizeof(states) + sizeof(stack) + sizeof(taskBuffer) + SinCosTable::staticBytes();
+    }
+
+    // One control period; the task calls it on its own core, host simulations step it directly
+    static void tick();
+
+    // Controller, LQR gain and filter commands on a set of joints: the live
+    // ones, or the recorder's replay set. False for every other type
+    static bool applyControllerCommand(MotorPID* group, const ControlCommand& cmd);
+
+private:
+    static constexpr uint32_t STACK_SIZE = 4096;
+
+    static SpscRing<ControlCommand, COMMAND_SLOTS> commands;
+    static SpscRing<ControlState, 8> states;
+    static TaskHandle_t handle;
+    static StackType_t stack[STACK_SIZE];
+    static StaticTask_t taskBuffer;
+
+    static volatile uint32_t tickCount;
+    static volatile uint32_t overrunCount;
+    static volatile uint32_t maxTickUs;
+    static volatile uint32_t maxCommandLatencyUs;
+
+    static void run(void* parameter);
+    static void apply(const ControlCommand& cmd);
+};
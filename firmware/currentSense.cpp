@@ -0,0 +1,245 @@
+#include "currentSense.h"
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_timer.h>
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+#include "idleManager.h"
+
+std::atomic<CurrentSense::State> CurrentSense::state{State::Off};
+adc_continuous_handle_t CurrentSense::handle = nullptr;
+adc_cali_handle_t CurrentSense::cali = nullptr;
+bool CurrentSense::calibrated = false;
+CurrentSense::Channel CurrentSense::channels[Board::NUM_JOINTS];
+uint8_t CurrentSense::readBuffer[READ_BYTES];
+std::atomic<float> CurrentSense::published[Board::NUM_JOINTS];
+std::atomic<uint32_t> CurrentSense::overflows{0};
+uint32_t CurrentSense::samples = 0;
+uint32_t CurrentSense::maxPollUs = 0;
+uint32_t CurrentSense::handledOverflows = 0;
+
+static constexpr float FULL_SCALE_MV = 3100.0f;  // 12 dB attenuation, when uncalibrated
+static constexpr float RAW_MAX = 4095.0f;
+
+// Fake shunt: on-time start bin per joint and stall current at full drive
+static constexpr uint32_t FAKE_START_BIN[] = {5, 13, 2, 9};
+static constexpr float FAKE_FULL_AMPS = 1.5f;
+static constexpr float FAKE_OFFSET_RAW = 40.0f;
+
+void CurrentSense::begin(bool enabled) {
+    for (auto& c : channels) c = {};
+    resetPhase();
+
+    if (CURRENT_FAKE) {
+        for (auto& c : channels) c.offsetRaw = FAKE_OFFSET_RAW;
+        state.store(State::Fake, std::memory_order_release);
+        return;
+    }
+    if (!enabled) return;
+
+    adc_digi_pattern_config_t pattern[Board::NUM_JOINTS] = {};
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        adc_unit_t unit;
+        adc_channel_t channel;
+        if (adc_continuous_io_to_channel(Board::CURRENT_SENSE_PINS[j], &unit, &channel) != ESP_OK
+            || unit != ADC_UNIT_1) {
+            state.store(State::Failed, std::memory_order_release);
+            return;
+        }
+        channels[j].adcChannel = (uint8_t)channel;
+        pattern[j].atten = ADC_ATTEN_DB_12;
+        pattern[j].channel = (uint8_t)channel;
+        pattern[j].unit = ADC_UNIT_1;
+        pattern[j].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+
+    // Pool for about three ticks of samples; poll() drains one tick's worth
+    adc_continuous_handle_cfg_t handleConfig = {};
+    handleConfig.max_store_buf_size = 4096;
+    handleConfig.conv_frame_size = 256;
+    adc_continuous_config_t config = {};
+    config.sample_freq_hz = SAMPLE_HZ;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    config.pattern_num = Board::NUM_JOINTS;
+    config.adc_pattern = pattern;
+    adc_continuous_evt_cbs_t callbacks = {};
+    callbacks.on_pool_ovf = poolOverflow;
+
+    if (adc_continuous_new_handle(&handleConfig, &handle) != ESP_OK
+        || adc_continuous_config(handle, &config) != ESP_OK
+        || adc_continuous_register_event_callbacks(handle, &callbacks, nullptr) != ESP_OK
+        || adc_continuous_start(handle) != ESP_OK) {
+        Serial.println("Current sense ADC failed to start");
+        state.store(State::Failed, std::memory_order_release);
+        return;
+    }
+
+    adc_cali_curve_fitting_config_t caliConfig = {};
+    caliConfig.unit_id = ADC_UNIT_1;
+    caliConfig.atten = ADC_ATTEN_DB_12;
+    caliConfig.bitwidth = ADC_BITWIDTH_DEFAULT;
+    calibrated = adc_cali_create_scheme_curve_fitting(&caliConfig, &cali) == ESP_OK;
+    state.store(State::Running, std::memory_order_release);
+}
+
+// Runs in the ADC interrupt: the pool dropped samples, so bin positions are lost
+bool IRAM_ATTR CurrentSense::poolOverflow(adc_continuous_handle_t, const adc_continuous_evt_data_t*, void*) {
+    overflows.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void CurrentSense::resetPhase() {
+    for (auto& c : channels) {
+        for (auto& m : c.binMean) m = c.offsetRaw;
+        c.bin = 0;
+        c.midBin = 0;
+        c.onBins = 0;
+        c.halfWidth = 0;
+    }
+}
+
+void CurrentSense::addSample(Channel& c, uint16_t raw) {
+    c.binMean[c.bin] += (raw - c.binMean[c.bin]) * BIN_ALPHA;
+    uint32_t distance = (c.bin + BINS - c.midBin) % BINS;
+    if (c.onBins >= MIN_ON_BINS && min(distance, (uint32_t)BINS - distance) <= c.halfWidth) {
+        c.sum += raw;
+        c.count++;
+    }
+    c.bin = c.bin + 1 == BINS ? 0 : c.bin + 1;
+}
+
+// Largest circular window sum of onBins bins, one pass with a sliding sum
+void CurrentSense::relock(Channel& c) {
+    float window = 0.0f;
+    for (size_t i = 0; i < c.onBins; i++) window += c.binMean[i];
+    float best = window;
+    uint32_t start = 0;
+    for (size_t s = 1; s < BINS; s++) {
+        window += c.binMean[(s + c.onBins - 1) % BINS] - c.binMean[s - 1];
+        if (window > best) {
+            best = window;
+            start = s;
+        }
+    }
+    c.midBin = (start + c.onBins / 2) % BINS;
+}
+
+float CurrentSense::rawToAmps(float raw) {
+    float mv = raw * (FULL_SCALE_MV / RAW_MAX);
+    int calibratedMv = 0;
+    if (calibrated && adc_cali_raw_to_voltage(cali, (int)(raw + 0.5f), &calibratedMv) == ESP_OK) {
+        mv = (float)calibratedMv;
+    }
+    return mv / Board::CURRENT_SENSE_MV_PER_A;
+}
+
+void CurrentSense::endTick(Channel& c, float drive) {
+    constexpr float dt = Board::CONTROL_PERIOD_US * 1e-6f;
+    uint32_t onBins = (uint32_t)(fabsf(drive) * 0.01f * BINS + 0.5f);
+
+    // Undriven: the whole period is the zero reading, once the bins have
+    // let go of the current that was flowing before the stop
+    float magnitude = 0.0f;
+    c.undrivenTicks = onBins == 0 ? min(c.undrivenTicks + 1, OFFSET_SETTLE_TICKS + 1) : 0;
+    if (c.undrivenTicks > OFFSET_SETTLE_TICKS) {
+        float mean = 0.0f;
+        for (float m : c.binMean) mean += m;
+        c.offsetRaw += (mean / BINS - c.offsetRaw) * 0.1f;
+    } else if (onBins > 0 && c.count > 0) {
+        float raw = (float)c.sum / c.count;
+        magnitude = max(0.0f, rawToAmps(raw) - rawToAmps(c.offsetRaw));
+    }
+    c.amps += (copysignf(magnitude, drive) - c.amps) * dt / (FILTER_TAU_S + dt);
+
+    // Lock for the next tick; a full period on has no window to find
+    c.onBins = onBins;
+    if (onBins >= MIN_ON_BINS && onBins < BINS) relock(c);
+    c.halfWidth = onBins / 4;
+    c.sum = c.count = 0;
+}
+
+void CurrentSense::fakeSamples(int64_t nowUs) {
+    static int64_t lastUs = 0;
+    if (lastUs == 0) {
+        lastUs = nowUs;
+        return;
+    }
+    uint32_t periods = (uint32_t)((nowUs - lastUs) * Board::PWM_FREQUENCY_HZ / 1000000);
+    lastUs += (int64_t)periods * 1000000 / Board::PWM_FREQUENCY_HZ;
+
+    static uint32_t noise = 1;
+    for (uint32_t n = 0; n < periods * BINS; n++) {
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            Channel& c = channels[j];
+            float drive = fabsf(motors[j].appliedDrive());
+            uint32_t onBins = (uint32_t)(drive * 0.01f * BINS + 0.5f);
+            uint32_t phase = (c.bin + BINS - FAKE_START_BIN[j % 4]) % BINS;
+            float raw = FAKE_OFFSET_RAW;
+            if (phase < onBins) {
+                float amps = FAKE_FULL_AMPS * drive * 0.01f;
+                raw += amps * Board::CURRENT_SENSE_MV_PER_A * (RAW_MAX / FULL_SCALE_MV);
+            }
+            noise = noise * 1664525u + 1013904223u;
+            raw += (float)(noise >> 28) - 7.5f;
+            addSample(c, (uint16_t)max(0.0f, raw));
+            samples++;
+        }
+    }
+}
+
+void CurrentSense::poll() {
+    State s = state.load(std::memory_order_acquire);
+    if (s != State::Running && s != State::Fake) return;
+    int64_t start = esp_timer_get_time();
+
+    uint32_t dropped = overflows.load(std::memory_order_relaxed);
+    if (dropped != handledOverflows) {
+        handledOverflows = dropped;
+        resetPhase();
+    }
+
+    if (s == State::Fake) {
+        fakeSamples(start);
+    } else {
+        uint32_t length = 0;
+        while (adc_continuous_read(handle, readBuffer, READ_BYTES, &length, 0) == ESP_OK) {
+            const adc_digi_output_data_t* results = reinterpret_cast<const adc_digi_output_data_t*>(readBuffer);
+            for (size_t i = 0; i < length / SOC_ADC_DIGI_RESULT_BYTES; i++) {
+                for (auto& c : channels) {
+                    if (results[i].type2.channel == c.adcChannel) {
+                        addSample(c, results[i].type2.data);
+                        samples++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // The samples just drained were taken under last tick's drive
+    bool undriven = supervisor.tripped() || IdleManager::idle();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        endTick(channels[j], undriven ? 0.0f : motors[j].appliedDrive());
+        published[j].store(channels[j].amps, std::memory_order_relaxed);
+    }
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (elapsed > maxPollUs) maxPollUs = elapsed;
+}
+
+void CurrentSense::report(Print& out) {
+    static const char* const names[] = {"off", "fake", "ok", "failed"};
+    State s = state.load(std::memory_order_acquire);
+    out.printf("CUR state=%s samples=%u overflows=%u poll_us_max=%u", names[(int)s], (unsigned)samples,
+               (unsigned)overflows.load(std::memory_order_relaxed), (unsigned)maxPollUs);
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const Channel& c = channels[j];
+        out.printf(" i%u=%.3f lock%u=%u on%u=%u zero%u=%.1f", (unsigned)(j + 1), latestAmps(j), (unsigned)(j + 1),
+                   (unsigned)c.midBin, (unsigned)(j + 1), (unsigned)c.onBins, (unsigned)(j + 1), c.offsetRaw);
+        if (s == State::Fake) {
+            out.printf(" true%u=%u", (unsigned)(j + 1),
+                       (unsigned)((FAKE_START_BIN[j % 4] + c.onBins / 2) % BINS));
+        }
+    }
+    out.println();
+}
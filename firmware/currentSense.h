@@ -0,0 +1,95 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <esp_adc/adc_continuous.h>
+#include <esp_adc/adc_cali.h>
+#include "boardConfig.h"
+
+// Set to 1 to feed the pipeline a synthetic shunt waveform instead of the
+// ADC: each joint's PWM on-time sits at its own fixed phase, with current
+// following the drive. Shows whether the phase lock finds the on-time (the
+// report prints the true centre next to the locked one) on any board
+#ifndef CURRENT_FAKE
+#define CURRENT_FAKE 0
+#endif
+
+// Motor current from low-side shunts, sampled continuously by the ADC's DMA
+// at CURRENT_BINS_PER_PWM samples per joint per PWM period. The ADC and the
+// MCPWM share no trigger on the S3, but both run from the same crystal, so a
+// sample's position in the PWM period is fixed: sample n of a joint sits in
+// phase bin n mod CURRENT_BINS_PER_PWM. The shunt only carries current while
+// the bridge is on, so a running per-bin average shows the on-time as a
+// window of raised bins; its width is the duty, and the lock is the window
+// position with the largest sum. Each tick averages the samples in the
+// middle half of that window, where the current ripple crosses its mean, and
+// low-passes the result.
+//
+// poll() runs in the control tick like SensorBus::poll(): it drains whatever
+// the DMA delivered since the last tick with a zero timeout and never waits.
+class CurrentSense {
+public:
+    static constexpr size_t BINS = Board::CURRENT_BINS_PER_PWM;
+    static constexpr uint32_t SAMPLE_HZ = Board::PWM_FREQUENCY_HZ * BINS * Board::NUM_JOINTS;
+    static constexpr size_t MIN_ON_BINS = 3;        // Below this the on-time is too short to sample
+    static constexpr float BIN_ALPHA = 1.0f / 64;   // Per-bin average, about 64 PWM periods
+    static constexpr float FILTER_TAU_S = 0.02f;    // Output low-pass
+    // Undriven ticks before the bins have decayed to the zero reading (five
+    // bin time constants) and the offset may learn from them
+    static constexpr uint32_t OFFSET_SETTLE_TICKS =
+        (uint32_t)(5.0f / BIN_ALPHA) * (1000000 / Board::PWM_FREQUENCY_HZ) / Board::CONTROL_PERIOD_US;
+    static_assert(SAMPLE_HZ <= 83333, "ADC continuous mode tops out at 83.3 kHz");
+
+    enum class State : uint8_t { Off, Fake, Running, Failed };
+
+    // Comms side, from deferred init. Host tests pass true to run the ADC
+    // path on this board, where the shunt pins are taken by an encoder
+    static void begin(bool enabled = Board::CURRENT_SENSE_ENABLED);
+
+    // Control task, once per tick before the motors update
+    static void poll();
+    static float amps(size_t joint) { return channels[joint].amps; }  // Signed, drive direction
+
+    // Comms side: last published values
+    static float latestAmps(size_t joint) { return published[joint].load(std::memory_order_relaxed); }
+
+    // Format: CUR state=<off|fake|ok|failed> samples=<n> overflows=<n> poll_us_max=<us>
+    //         i1=<A> lock1=<bin> on1=<bins> zero1=<raw> [true1=<bin>] i2=...
+    static void report(Print& out);
+    static size_t staticBytes() { return sizeof(channels) + sizeof(readBuffer); }
+
+private:
+    struct Channel {
+        float binMean[BINS];  // Raw counts per phase bin
+        uint32_t bin;         // Phase bin of the next sample
+        uint32_t midBin;      // Centre of the on-time from the last lock
+        uint32_t halfWidth;   // Samples this far from midBin count towards the tick
+        uint32_t onBins;
+        uint32_t sum, count;  // This tick's on-time samples
+        float offsetRaw;      // Zero-current reading, learnt while undriven
+        uint32_t undrivenTicks;
+        float amps;
+        uint8_t adcChannel;
+    };
+
+    static constexpr size_t READ_BYTES = 1024;
+
+    static std::atomic<State> state;
+    static adc_continuous_handle_t handle;
+    static adc_cali_handle_t cali;
+    static bool calibrated;
+    static Channel channels[Board::NUM_JOINTS];
+    static uint8_t readBuffer[READ_BYTES];
+    static std::atomic<float> published[Board::NUM_JOINTS];
+    static std::atomic<uint32_t> overflows;
+    static uint32_t samples;
+    static uint32_t maxPollUs;
+    static uint32_t handledOverflows;
+
+    static void addSample(Channel& c, uint16_t raw);
+    static void endTick(Channel& c, float drive);
+    static void relock(Channel& c);
+    static float rawToAmps(float raw);
+    static void resetPhase();
+    static void fakeSamples(int64_t nowUs);
+    static bool IRAM_ATTR poolOverflow(adc_continuous_handle_t, const adc_continuous_evt_data_t*, void*);
+};
@@ -0,0 +1,93 @@
+#include "eventLog.h"
+#include <esp_system.h>
+
+// Survive everything but a power cycle; validated by the magic word at boot
+RTC_NOINIT_ATTR volatile EventLog::Event EventLog::ring[CAPACITY];
+RTC_NOINIT_ATTR volatile EventLog::Event EventLog::commandRing[COMMAND_CAPACITY];
+static RTC_NOINIT_ATTR uint32_t logMagic;
+static RTC_NOINIT_ATTR uint32_t bootCount;
+static RTC_NOINIT_ATTR uint32_t clearedSeq;
+static RTC_NOINIT_ATTR uint32_t clearedCommandSeq;
+static constexpr uint32_t LOG_MAGIC = 0x45564C32;  // "EVL2", bumped with the command ring
+
+std::atomic<uint32_t> EventLog::head{0};
+std::atomic<uint32_t> EventLog::commandHead{0};
+volatile uint32_t EventLog::currentTick = 0;
+uint32_t EventLog::bootSeq = 0;
+uint32_t EventLog::commandBootSeq = 0;
+
+void EventLog::begin() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (logMagic != LOG_MAGIC || reason == ESP_RST_POWERON) {
+        for (auto& e : ring) e.seq = 0;
+        for (auto& e : commandRing) e.seq = 0;
+        bootCount = clearedSeq = clearedCommandSeq = 0;
+        logMagic = LOG_MAGIC;
+    }
+
+    uint32_t last = recover(ring, CAPACITY);
+    if (clearedSeq > last) clearedSeq = last;
+    head.store(last, std::memory_order_relaxed);
+    bootSeq = last + 1;
+
+    last = recover(commandRing, COMMAND_CAPACITY);
+    if (clearedCommandSeq > last) clearedCommandSeq = last;
+    commandHead.store(last, std::memory_order_relaxed);
+    commandBootSeq = last + 1;
+
+    bootCount = bootCount + 1;
+    log(BOOT, NO_JOINT, (uint16_t)reason, bootCount);
+}
+
+// The newest correctly placed stamp is where the last run stopped
+uint32_t EventLog::recover(const volatile Event* slots, size_t capacity) {
+    uint32_t last = 0;
+    for (size_t i = 0; i < capacity; i++) {
+        uint32_t seq = slots[i].seq;
+        if (seq != 0 && (seq & (capacity - 1)) == i && seq > last) last = seq;
+    }
+    return last;
+}
+
+void EventLog::clear() {
+    clearedSeq = head.load(std::memory_order_relaxed);
+    clearedCommandSeq = commandHead.load(std::memory_order_relaxed);
+}
+
+void EventLog::report(Print& out) {
+    out.printf("LOG boots=%u ", (unsigned)bootCount);
+    reportRing(out, ring, CAPACITY, head.load(std::memory_order_acquire), clearedSeq, bootSeq);
+    out.print("CMDLOG ");
+    reportRing(out, commandRing, COMMAND_CAPACITY, commandHead.load(std::memory_order_acquire),
+               clearedCommandSeq, commandBootSeq);
+}
+
+void EventLog::reportRing(Print& out, const volatile Event* slots, size_t capacity,
+                          uint32_t end, uint32_t cleared, uint32_t firstThisBoot) {
+    uint32_t start = end > capacity ? end - capacity + 1 : 1;
+    if (cleared + 1 > start) start = cleared + 1;
+
+    uint32_t lost = 0;
+    for (uint32_t seq = start; seq <= end; seq++) {
+        if (slots[seq & (capacity - 1)].seq != seq) lost++;
+    }
+    out.printf("events=%u lost=%u this_boot=%u\n",
+               (unsigned)(end >= start ? end - start + 1 - lost : 0), (unsigned)lost, (unsigned)firstThisBoot);
+
+    for (uint32_t seq = start; seq <= end; seq++) {
+        const volatile Event& slot = slots[seq & (capacity - 1)];
+        if (slot.seq != seq) continue;
+        uint32_t tick = slot.tick, value = slot.value;
+        uint8_t type = slot.type, joint = slot.joint;
+        uint16_t arg = slot.arg;
+        if (slot.seq != seq) continue;  // Lapped while copying
+        out.printf("EVT seq=%u tick=%u type=%s j=%u arg=%u value=%u\n", (unsigned)seq, (unsigned)tick,
+                   typeName(type), joint == NO_JOINT ? 0u : (unsigned)joint + 1, (unsigned)arg, (unsigned)value);
+    }
+}
+
+const char* EventLog::typeName(uint8_t type) {
+    static const char* const names[TYPE_COUNT] = {
+        "boot", "fault", "fault_clear", "idle", "wake", "mode", "command", "overrun"};
+    return type < TYPE_COUNT ? names[type] : "?";
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// Post-mortem event ring in RTC memory. RTC_NOINIT data is left alone by
+// software resets, panics and the watchdog, so the events leading up to an
+// unexpected reset are still there on the next boot, which prints them.
+//
+// log() is lock-free and safe from any task or ISR: a slot is claimed with
+// one atomic add on a DRAM counter, then filled and stamped with its
+// sequence number last. A slot whose stamp does not match the sequence the
+// reader expects is being written or was lapped and is skipped. The counter
+// itself is rebuilt from the stamps at boot.
+//
+// COMMAND events go to a ring of their own: a 50 Hz setpoint stream would
+// otherwise lap the main ring in a few seconds and push out the faults that
+// led up to a reset. Each ring numbers its events separately.
+class EventLog {
+public:
+    enum Type : uint8_t {
+        BOOT,         // arg: esp_reset_reason(), value: boot number
+        FAULT,        // joint, arg: fault bit
+        FAULT_CLEAR,  // arg: 1 cleared, 0 refused while hot
+        IDLE,         // Joints parked
+        WAKE,
+        MODE,         // joint, arg: 0 PID, 1 LQR
+        COMMAND,      // joint, arg: ControlCommand::Type, value: queue latency us
+        OVERRUN,      // value: tick duration us
+        TYPE_COUNT
+    };
+
+    static constexpr size_t CAPACITY = 128;         // Power of two; 2 KB of the 8 KB RTC slow memory
+    static constexpr size_t COMMAND_CAPACITY = 32;  // Another 512 B for the command ring
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+    static_assert((COMMAND_CAPACITY & (COMMAND_CAPACITY - 1)) == 0, "COMMAND_CAPACITY must be a power of two");
+    static constexpr uint8_t NO_JOINT = 0xFF;
+
+    struct Event {
+        uint32_t seq;   // 0 while being written
+        uint32_t tick;  // Control tick, restarts at 0 each boot
+        uint8_t type;
+        uint8_t joint;  // 0-based, NO_JOINT for board-wide events
+        uint16_t arg;
+        uint32_t value;
+    };
+
+    // First thing in setup(): keeps the previous runs' events unless power was cycled
+    static void begin();
+
+    static inline void IRAM_ATTR log(Type type, uint8_t joint = NO_JOINT, uint16_t arg = 0, uint32_t value = 0) {
+        if (type == COMMAND) {
+            append(commandRing, COMMAND_CAPACITY, commandHead, type, joint, arg, value);
+        } else {
+            append(ring, CAPACITY, head, type, joint, arg, value);
+        }
+    }
+
+    // The ring discipline behind log(), also run by bench on a scratch ring
+    static inline void IRAM_ATTR append(volatile Event* slots, size_t capacity, std::atomic<uint32_t>& counter,
+                                        Type type, uint8_t joint, uint16_t arg, uint32_t value) {
+        uint32_t seq = counter.fetch_add(1, std::memory_order_relaxed) + 1;
+        volatile Event& e = slots[seq & (capacity - 1)];
+        e.seq = 0;
+        e.tick = currentTick;
+        e.type = type;
+        e.joint = joint;
+        e.arg = arg;
+        e.value = value;
+        std::atomic_thread_fence(std::memory_order_release);
+        e.seq = seq;
+    }
+
+    // Control task, once per tick
+    static void setTick(uint32_t tick) { currentTick = tick; }
+
+    // Hides everything logged so far from report(); the ring itself is left as is
+    static void clear();
+
+    // Format: LOG boots=<n> events=<n> lost=<n> this_boot=<seq>
+    //         EVT seq=<n> tick=<n> type=<name> j=<1-based, 0 none> arg=<n> value=<n>   (oldest first)
+    //         CMDLOG events=<n> lost=<n> this_boot=<seq>
+    //         EVT ... type=command ...   (oldest first)
+    static void report(Print& out);
+    static size_t staticBytes() { return sizeof(ring) + sizeof(commandRing); }
+
+private:
+    static volatile Event ring[CAPACITY];
+    static volatile Event commandRing[COMMAND_CAPACITY];
+    static std::atomic<uint32_t> head, commandHead;
+    static volatile uint32_t currentTick;
+    static uint32_t bootSeq, commandBootSeq;
+
+    static uint32_t recover(const volatile Event* slots, size_t capacity);
+    static void reportRing(Print& out, const volatile Event* slots, size_t capacity,
+                           uint32_t end, uint32_t cleared, uint32_t firstThisBoot);
+    static const char* typeName(uint8_t type);
+};
@@ -1,83 +1,185 @@
-#define ENCODER1_PIN_A 1
-#define ENCODER1_PIN_B 2
-#define ENCODER2_PIN_A 11
-#define ENCODER2_PIN_B 12
-#define RESET_COUNT_ON_BOOT 1
-
-#define LED_PIN 7
-#define PWM_2 41
-#define AIN_1 38
-#define AIN_2 37
-#define BIN_1 36
-#define BIN_2 35
-#define SLEEP_PIN 39
-
+// Pin map, encoder resolution and joint limits live in boardConfig.h
 #include <Arduino.h>
+#include "boardConfig.h"
 #include "motorConfig.h"
 #include "tuning.h"
 #include "bleCom.h"
+#include "jointSupervisor.h"
+#include "controlTask.h"
+#include "memoryGuard.h"
+#include "telemetry.h"
+#include "recorder.h"
+#include "idleManager.h"
+#include "bootTrace.h"
+#include "paramStore.h"
+#include "sensorBus.h"
+#include "motionLibrary.h"
+#include "motionPlayer.h"
+#include "eventLog.h"
+#include "currentSense.h"
 
-MotorPID motor1, motor2;
 TuneSet<> tuning;
 
-void setup() {
-    Serial.begin(115200);
-    
-    // Initialize motor system with correct pin mapping
-    motorInit(
-        ENCODER1_PIN_A, ENCODER1_PIN_B,
-        ENCODER2_PIN_A, ENCODER2_PIN_B,
-        AIN_2, AIN_1,  // Motor 1 pins (AIN_2 = 37, AIN_1 = 38)
-        BIN_2, BIN_1,  // Motor 2 pins (BIN_2 = 35, BIN_1 = 36)
-        SLEEP_PIN,
-        RESET_COUNT_ON_BOOT,
-        8344
-    );
-
-    // Initialize motor controllers with explicit configurations
-    motor1.init({0, AIN_2, AIN_1, 8344}); // Motor 1 (num 0) uses AIN_2 & AIN_1
-    motor2.init({1, BIN_2, BIN_1, 8344}); // Motor 2 (num 1) uses BIN_2 & BIN_1
-
-    // Tuning setup
-    tuning.add("tar1", motor1.Setpoint);
-    tuning.add("kp1", motor1.Kp);
-    tuning.add("ki1", motor1.Ki);
-    tuning.add("kd1", motor1.Kd);
-    tuning.add("tar2", motor2.Setpoint);
-    tuning.add("kp2", motor2.Kp);
-    tuning.add("ki2", motor2.Ki);
-    tuning.add("kd2", motor2.Kd);
-
-    motor1.setSetpointDeg(0.0f);
-    motor2.setSetpointDeg(0.0f);
+// Tuning names per joint: tar1, kp1, ki1, kd1, tar2, ...
+static char tuningNames[Board::NUM_JOINTS][4][8];
+
+// TuneSet writes land here on the comms core and are forwarded to the
+// control core as commands; [0] is the target in counts, [1..3] the gains
+static float tuningValues[Board::NUM_JOINTS][4];
+static float tuningSent[Board::NUM_JOINTS][4];
+
+static constexpr uint32_t COMMS_STACK_SIZE = 8192;
+static StackType_t commsTaskStack[COMMS_STACK_SIZE];
+static StaticTask_t commsTaskBuffer;
+
+static void forwardTuning() {
+    // A profile switch replaces the gains under the tuning table
+    static uint32_t profileGeneration = 0;
+    if (ParamStore::generation() != profileGeneration) {
+        profileGeneration = ParamStore::generation();
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            const ParamStore::JointParams& p = ParamStore::active().joints[j];
+            tuningValues[j][1] = tuningSent[j][1] = p.kp;
+            tuningValues[j][2] = tuningSent[j][2] = p.ki;
+            tuningValues[j][3] = tuningSent[j][3] = p.kd;
+        }
+    }
+
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        float* v = tuningValues[j];
+        float* sent = tuningSent[j];
+
+        if (v[0] != sent[0]) {
+            float degrees = v[0] * motors[j].config().degPerCount;
+            if (ControlTask::send({ControlCommand::Type::SetpointDeg, (uint8_t)j, {degrees}})) {
+                sent[0] = v[0];
+            }
+        }
+        if (v[1] != sent[1] || v[2] != sent[2] || v[3] != sent[3]) {
+            if (ControlTask::send({ControlCommand::Type::Gains, (uint8_t)j, {v[1], v[2], v[3]}})) {
+                sent[1] = v[1];
+                sent[2] = v[2];
+                sent[3] = v[3];
+                ParamStore::noteGains(j, v[1], v[2], v[3]);
+            }
+        }
+    }
+}
+
+// Startup work the control loop does not need, done with the joints already held
+static void deferredInit() {
+    BootTrace::begin(BootTrace::BLE);
     BLECom::init();
+    BootTrace::end(BootTrace::BLE);
 
+    BootTrace::begin(BootTrace::SERVICES);
+    SensorBus::begin();
+    CurrentSense::begin();
+    MotionLibrary::begin();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        for (int k = 0; k < 4; k++) {
+            tuning.add(tuningNames[j][k], tuningValues[j][k]);
+        }
+    }
+    MemoryGuard::registerObject("motors", sizeof(motors));
+    MemoryGuard::registerObject("TrackEncoder", sizeof(TrackEncoder));  // Includes save task stack
+    MemoryGuard::registerObject("ControlTask", ControlTask::staticBytes());
+    MemoryGuard::registerObject("CommsTask", sizeof(commsTaskStack) + sizeof(commsTaskBuffer));
+    MemoryGuard::registerObject("Supervisor", sizeof(supervisor));
+    MemoryGuard::registerObject("Recorder", Recorder::staticBytes());
+    MemoryGuard::registerObject("ParamStore", ParamStore::staticBytes());
+    MemoryGuard::registerObject("SensorBus", SensorBus::staticBytes());
+    MemoryGuard::registerObject("CurrentSense", CurrentSense::staticBytes());
+    MemoryGuard::registerObject("MotionPlayer", MotionPlayer::staticBytes());  // Library stays in flash
+    MemoryGuard::lockHeap();
+    MemoryGuard::report(Serial);
+    EventLog::report(Serial);  // What led up to the last reset
+    BootTrace::end(BootTrace::SERVICES);
+
+    BootTrace::markReady();
+    BootTrace::report(Serial);
     Serial.println("Setup complete");
 }
 
-void loop() {
-    tuning.readSerial();
-    BLECom::update();
-    // Update both motors
-    motor1.update();
-    motor2.update();
-    static uint32_t lastPrint = 0;
-    if(millis() - lastPrint > 20) { // Throttle printing
-        lastPrint = millis();
-    // Serial print statements remain unchanged
-    Serial.print(motor1.Setpoint); Serial.print("\t");
-    Serial.print(motor1.Input);    Serial.print("\t");
-    Serial.print(motor1.Output);   Serial.print("\t");
-    Serial.print(motor1.Kp);       Serial.print("\t");
-    Serial.print(motor1.Ki);       Serial.print("\t");
-    Serial.print(motor1.Kd);       Serial.print("\t");
-
-    Serial.print(motor2.Setpoint); Serial.print("\t");
-    Serial.print(motor2.Input);    Serial.print("\t");
-    Serial.print(motor2.Output);   Serial.print("\t");
-    Serial.print(motor2.Kp);       Serial.print("\t");
-    Serial.print(motor2.Ki);       Serial.print("\t");
-    Serial.println(motor2.Kd);
+// USB serial, BLE and telemetry, pinned to the comms core
+static void commsTask(void *parameter) {
+    ControlState state;
+    bool haveState = false;
+    uint32_t lastPrint = 0;
+
+    deferredInit();
+
+    while (true) {
+        tuning.readSerial();
+        forwardTuning();
+        BLECom::update();
+        Recorder::service();
+        ParamStore::service();
+        IdleManager::service();
+
+        // Publish new faults and calibration results on both links
+        if (supervisor.takeReport()) {
+            supervisor.report(Serial);
+            BLECom::reportHealth();
+        }
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            if (motors[j].backlash.takeReport()) {
+                motors[j].backlash.report(Serial, j);
+                BLECom::reportBacklash(j);
+                const BacklashComp::Params& params = motors[j].backlash.params;
+                ParamStore::noteBacklash(j, params.widthDeg, params.complianceDegPerPct);
+            }
+        }
+
+        // Every frame in order, so subscription decimation stays exact; idle
+        // thins the stream further by only passing every Nth frame
+        bool idle = IdleManager::idle();
+        while (ControlTask::nextState(state)) {
+            haveState = true;
+            if (idle && state.tick % IdleManager::IDLE_TELEMETRY_DECIMATION != 0) continue;
+            usbTelemetry.publish(state);
+            BLECom::publishTelemetry(state);
+        }
+
+        // Legacy text line for the tuning GUI, unless USB has binary subscribers
+        uint32_t textPeriod = idle ? IdleManager::IDLE_TEXT_PERIOD_MS : 20;
+        if (haveState && !usbTelemetry.active() && millis() - lastPrint > textPeriod) { // Throttle printing
+            lastPrint = millis();
+            Telemetry::printText(Serial, state);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(IdleManager::commsDelayMs()));
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    EventLog::begin();
+
+    // Only what holding position needs runs here, with control alone on core 1
+    // and holding from the persisted position; BLE and the rest follow in the
+    // comms task on core 0
+    ControlTask::boot(Board::RESET_COUNT_ON_BOOT, Board::ENCODER_GLITCH_FILTER);
+
+    // The tuning table starts from what the joints now hold
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        snprintf(tuningNames[j][0], sizeof(tuningNames[j][0]), "tar%u", (unsigned)(j + 1));
+        snprintf(tuningNames[j][1], sizeof(tuningNames[j][1]), "kp%u", (unsigned)(j + 1));
+        snprintf(tuningNames[j][2], sizeof(tuningNames[j][2]), "ki%u", (unsigned)(j + 1));
+        snprintf(tuningNames[j][3], sizeof(tuningNames[j][3]), "kd%u", (unsigned)(j + 1));
+        tuningValues[j][0] = tuningSent[j][0] = motors[j].Setpoint;
+        tuningValues[j][1] = tuningSent[j][1] = motors[j].Kp;
+        tuningValues[j][2] = tuningSent[j][2] = motors[j].Ki;
+        tuningValues[j][3] = tuningSent[j][3] = motors[j].Kd;
     }
-    //delay(10);
+
+    TaskHandle_t commsTaskHandle = xTaskCreateStaticPinnedToCore(
+        commsTask, "CommsTask", COMMS_STACK_SIZE, nullptr, 2,
+        commsTaskStack, &commsTaskBuffer, Board::COMMS_CORE);
+    MemoryGuard::registerTask("CommsTask", commsTaskHandle, COMMS_STACK_SIZE);
+}
+
+void loop() {
+    // All work happens in the control and comms tasks
+    vTaskDelete(NULL);
 }
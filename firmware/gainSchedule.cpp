@@ -0,0 +1,64 @@
+#include "gainSchedule.h"
+
+bool GainSchedule::configure(const Axis& x, const Axis& y) {
+    if (x.count == 0 || y.count == 0 || x.count * y.count > MAX_POINTS) {
+        return false;
+    }
+    xAxis = x;
+    yAxis = y;
+    for (Axis* axis : {&xAxis, &yAxis}) {
+        axis->lastCell = axis->count > 1 ? axis->count - 2 : 0;
+        axis->stride = axis->count > 1 ? 1 : 0;
+    }
+    pointMask = 0;
+    return true;
+}
+
+bool GainSchedule::setPoint(uint8_t index, const Gains& gains) {
+    if (index >= size()) {
+        return false;
+    }
+    points[index] = gains;
+    pointMask |= (uint16_t)(1u << index);
+    return true;
+}
+
+GainSchedule::Key GainSchedule::parseKey(char c) {
+    switch (c) {
+        case 'e': return Key::Error;     // |error| in degrees
+        case 'v': return Key::Velocity;  // |velocity| in deg/s
+        case 's': return Key::Supply;    // Supply voltage
+        default:  return Key::None;
+    }
+}
+
+void GainSchedule::locate(const Axis& axis, float value, uint8_t& cell, float& frac) {
+    float f = (value - axis.origin) * axis.invStep;
+    f = fminf(fmaxf(f, 0.0f), (float)(axis.count - 1));
+    cell = min((uint8_t)f, axis.lastCell);
+    frac = f - cell;
+}
+
+GainSchedule::Gains GainSchedule::lookup(float x, float y) const {
+    uint8_t ix, iy;
+    float tx, ty;
+    locate(xAxis, x, ix, tx);
+    locate(yAxis, y, iy, ty);
+
+    const uint8_t row = xAxis.count;
+    const Gains& g00 = points[iy * row + ix];
+    const Gains& g10 = points[iy * row + ix + xAxis.stride];
+    const Gains& g01 = points[(iy + yAxis.stride) * row + ix];
+    const Gains& g11 = points[(iy + yAxis.stride) * row + ix + xAxis.stride];
+
+    float w00 = (1 - tx) * (1 - ty);
+    float w10 = tx * (1 - ty);
+    float w01 = (1 - tx) * ty;
+    float w11 = tx * ty;
+
+    return {
+        w00 * g00.kp + w10 * g10.kp + w01 * g01.kp + w11 * g11.kp,
+        w00 * g00.ki + w10 * g10.ki + w01 * g01.ki + w11 * g11.ki,
+        w00 * g00.kd + w10 * g10.kd + w01 * g01.kd + w11 * g11.kd,
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+
+// Small 1D/2D gain table on uniform breakpoints, bilinear interpolation.
+// Uniform spacing keeps the lookup constant time: one multiply per axis
+// instead of a breakpoint search.
+class GainSchedule {
+public:
+    static constexpr uint8_t MAX_POINTS = 16;
+
+    enum class Key : uint8_t { None, Error, Velocity, Supply };
+
+    struct Gains {
+        float kp, ki, kd;
+    };
+
+    struct Axis {
+        Key key = Key::None;
+        float origin = 0.0f;
+        float invStep = 0.0f;  // 1 / breakpoint spacing
+        uint8_t count = 1;
+        uint8_t lastCell = 0;  // Index of the last interpolation cell
+        uint8_t stride = 0;    // 1 when the axis has a second breakpoint
+    };
+
+    // Start a new table; a 1D table has y.count == 1
+    bool configure(const Axis& x, const Axis& y);
+    bool setPoint(uint8_t index, const Gains& gains);
+    bool complete() const { return pointMask == fullMask(); }
+    uint8_t size() const { return xAxis.count * yAxis.count; }
+
+    const Axis& axisX() const { return xAxis; }
+    const Axis& axisY() const { return yAxis; }
+
+    Gains lookup(float x, float y) const;
+
+    static Key parseKey(char c);
+
+private:
+    Axis xAxis, yAxis;
+    Gains points[MAX_POINTS] = {};
+    uint16_t pointMask = 0;
+
+    uint16_t fullMask() const { return (uint16_t)((1u << size()) - 1); }
+    static void locate(const Axis& axis, float value, uint8_t& cell, float& frac);
+};
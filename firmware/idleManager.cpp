@@ -0,0 +1,80 @@
+#include "idleManager.h"
+#include "jointSupervisor.h"
+#include "bleCom.h"
+#include "eventLog.h"
+
+bool IdleManager::enabled = true;
+std::atomic<bool> IdleManager::idleFlag{false};
+uint32_t IdleManager::settledTicks = 0;
+volatile uint32_t IdleManager::idleTicks = 0;
+volatile uint32_t IdleManager::activeTicks = 0;
+volatile uint32_t IdleManager::wakeCount = 0;
+bool IdleManager::lowPower = false;
+uint32_t IdleManager::lastActivityMs = 0;
+
+bool IdleManager::update(bool settled, bool disturbed) {
+    if (idle()) {
+        idleTicks = idleTicks + 1;
+        if (disturbed || !enabled) wake();
+        return idle();
+    }
+
+    activeTicks = activeTicks + 1;
+    settledTicks = settled ? settledTicks + 1 : 0;
+    if (enabled && settledTicks >= DWELL_TICKS && !supervisor.tripped()) {
+        digitalWrite(Board::SLEEP_PIN, LOW);
+        EventLog::log(EventLog::IDLE);
+        idleFlag.store(true, std::memory_order_release);
+    }
+    return idle();
+}
+
+// Driver wake-up takes about 1 ms, well inside the tick it is called from
+void IdleManager::wake() {
+    settledTicks = 0;
+    if (!idle()) return;
+    if (!supervisor.tripped()) {
+        digitalWrite(Board::SLEEP_PIN, HIGH);
+    }
+    wakeCount = wakeCount + 1;
+    EventLog::log(EventLog::WAKE);
+    idleFlag.store(false, std::memory_order_release);
+}
+
+void IdleManager::noteActivity() {
+    lastActivityMs = millis();
+    if (lowPower) leaveLowPower();
+}
+
+void IdleManager::service() {
+    // Commands that wake the control task reach it a tick later; do not drop back meanwhile
+    bool wantLow = idle() && millis() - lastActivityMs > ACTIVITY_GRACE_MS;
+    if (wantLow && !lowPower) {
+        enterLowPower();
+    } else if (!wantLow && lowPower) {
+        leaveLowPower();
+    }
+}
+
+void IdleManager::enterLowPower() {
+    lowPower = true;
+    setCpuFrequencyMhz(IDLE_CPU_MHZ);
+    BLECom::setLowPower(true);
+}
+
+void IdleManager::leaveLowPower() {
+    lowPower = false;
+    setCpuFrequencyMhz(ACTIVE_CPU_MHZ);
+    BLECom::setLowPower(false);
+}
+
+void IdleManager::report(Print& out) {
+    Stats s = stats();
+    uint32_t total = s.idleTicks + s.activeTicks;
+    float idleFraction = total ? (float)s.idleTicks / total : 0.0f;
+    float savedMa = idleFraction * ((CPU_ACTIVE_MA - CPU_IDLE_MA) + (BLE_ACTIVE_MA - BLE_IDLE_MA)
+                                    + DRIVER_AWAKE_MA);
+    out.printf("IDLE state=%s idle_pct=%.1f wakes=%u est_saved_ma=%.1f cpu_mhz=%u\n",
+               idle() ? "idle" : "active", idleFraction * 100.0f, (unsigned)s.wakes,
+               savedMa, (unsigned)getCpuFrequencyMhz());
+}
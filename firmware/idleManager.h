@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "boardConfig.h"
+#include "motorConfig.h"
+
+// Power-aware idle mode. Once every joint has held its target within the
+// braking band for DWELL_MS the control task parks the PIDs and puts the
+// driver to sleep; the comms side then drops the CPU clock, stretches the
+// BLE connection interval and slows telemetry. Any command, a waypoint
+// stream or the joint being pushed off target wakes everything: the driver
+// within the same control tick, the clock as soon as a command byte arrives.
+//
+// Worst-case wake latency is one idle BLE connection interval plus one idle
+// comms period, about 160 ms; slave latency stays 0 so it is never longer.
+class IdleManager {
+public:
+    static constexpr uint32_t DWELL_MS = 2000;
+    static constexpr int WAKE_ERROR_COUNTS = 4 * BRAKING_THRESHOLD;  // Pushed off target
+
+    static constexpr uint32_t ACTIVE_CPU_MHZ = 240;
+    static constexpr uint32_t IDLE_CPU_MHZ = 80;
+    static constexpr uint32_t IDLE_COMMS_DELAY_MS = 10;
+    static constexpr uint32_t IDLE_TEXT_PERIOD_MS = 200;
+    static constexpr uint8_t IDLE_TELEMETRY_DECIMATION = 10;
+    static constexpr uint32_t ACTIVITY_GRACE_MS = 100;  // Full clock kept after any command
+
+    // Rough current budget for the estimate in report(), mA at the 3.3 V rail
+    static constexpr float CPU_ACTIVE_MA = 42.0f;  // 240 MHz, both cores mostly waiting
+    static constexpr float CPU_IDLE_MA = 22.0f;    // 80 MHz
+    static constexpr float BLE_ACTIVE_MA = 9.0f;   // 7.5-15 ms connection interval
+    static constexpr float BLE_IDLE_MA = 1.5f;     // 100-150 ms
+    static constexpr float DRIVER_AWAKE_MA = 1.7f; // Driver logic, outputs off
+
+    static bool enabled;
+
+    // Control task only, once per tick before the motors update. settled: all
+    // joints inside the braking band with nothing streaming; disturbed: a joint
+    // pushed past WAKE_ERROR_COUNTS or new motion queued. Returns true while parked.
+    static bool update(bool settled, bool disturbed);
+    static void wake();
+
+    // Comms side
+    static void noteActivity();  // Raise the clock before parsing an incoming command
+    static bool idle() { return idleFlag.load(std::memory_order_acquire); }
+    static void service();       // Applies clock and radio settings on state changes
+    static uint32_t commsDelayMs() { return lowPower ? IDLE_COMMS_DELAY_MS : 1; }
+
+    struct Stats {
+        uint32_t idleTicks;    // Control ticks spent parked
+        uint32_t activeTicks;
+        uint32_t wakes;
+    };
+    static Stats stats() { return {idleTicks, activeTicks, wakeCount}; }
+
+    // Format: IDLE state=<idle|active> idle_pct=<%> wakes=<n> est_saved_ma=<mA> cpu_mhz=<n>
+    static void report(Print& out);
+
+private:
+    static constexpr uint32_t DWELL_TICKS = DWELL_MS * 1000 / Board::CONTROL_PERIOD_US;
+
+    static std::atomic<bool> idleFlag;
+    static uint32_t settledTicks;
+    static volatile uint32_t idleTicks;
+    static volatile uint32_t activeTicks;
+    static volatile uint32_t wakeCount;
+    static bool lowPower;  // Comms side view of what is applied
+    static uint32_t lastActivityMs;
+
+    static void enterLowPower();
+    static void leaveLowPower();
+};
@@ -0,0 +1,107 @@
+#include "jointSupervisor.h"
+#include "motorConfig.h"
+#include "eventLog.h"
+
+JointSupervisor supervisor;
+
+bool JointSupervisor::evaluate(size_t joint, float drive, float positionDeg, float velocityDeg,
+                               int64_t counts, float dt) {
+    JointState& s = joints[joint];
+    const MotorPID::Config& cfg = motors[joint].config();  // Live limits, as set by lim and profiles
+    float effort = fabsf(drive);
+
+    // Stall: pushing hard without getting anywhere
+    s.stallTime = (effort >= limits.stallDrive && fabsf(velocityDeg) < limits.stallVelocity)
+                ? s.stallTime + dt : 0.0f;
+    if (s.stallTime >= limits.stallTime) trip(joint, STALL);
+
+    // Encoder lost: a free motor at moderate drive always produces counts
+    s.frozenTime = (effort >= limits.encoderDrive && counts == s.lastCounts)
+                 ? s.frozenTime + dt : 0.0f;
+    s.lastCounts = counts;
+    if (s.frozenTime >= limits.encoderTime) trip(joint, ENCODER);
+
+    // Runaway: moving fast opposite to the drive, e.g. swapped motor leads
+    s.runawayTime = (effort >= limits.runawayDrive && drive * velocityDeg < 0
+                     && fabsf(velocityDeg) >= limits.runawayVelocity)
+                  ? s.runawayTime + dt : 0.0f;
+    if (s.runawayTime >= limits.runawayTime) trip(joint, RUNAWAY);
+
+    // I2t with drive fraction as the current proxy, cools at the continuous rating
+    float i = effort * 0.01f;
+    s.heat = max(0.0f, s.heat + (i * i - limits.i2tContinuous * limits.i2tContinuous) * dt);
+    if (s.heat >= limits.i2tLimit) trip(joint, THERMAL);
+
+    // Soft position limits, with margin for normal overshoot at the setpoint limits
+    if (positionDeg < cfg.minDeg - limits.limitMarginDeg ||
+        positionDeg > cfg.maxDeg + limits.limitMarginDeg) {
+        trip(joint, LIMIT);
+    }
+
+    return !tripped();
+}
+
+void JointSupervisor::trip(size_t joint, uint8_t fault) {
+    uint8_t previous = joints[joint].faults.fetch_or(fault, std::memory_order_relaxed);
+    if (previous & fault) return;
+    EventLog::log(EventLog::FAULT, (uint8_t)joint, fault);
+
+    // Safe torque off: coast every motor and put the driver to sleep
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        motorControl.motorStop(j);
+    }
+    digitalWrite(Board::SLEEP_PIN, LOW);
+
+    tripFlag.store(true, std::memory_order_release);
+    reportPending.store(true, std::memory_order_release);
+}
+
+bool JointSupervisor::clear() {
+    for (const auto& s : joints) {
+        if (s.heat > limits.i2tLimit * limits.i2tClearFraction) {
+            reportPending.store(true, std::memory_order_release);
+            EventLog::log(EventLog::FAULT_CLEAR, EventLog::NO_JOINT, 0);
+            return false;
+        }
+    }
+    for (auto& s : joints) {
+        s.stallTime = s.frozenTime = s.runawayTime = 0.0f;
+        s.faults.store(NONE, std::memory_order_relaxed);
+    }
+    digitalWrite(Board::SLEEP_PIN, HIGH);
+    EventLog::log(EventLog::FAULT_CLEAR, EventLog::NO_JOINT, 1);
+    tripFlag.store(false, std::memory_order_release);
+    reportPending.store(true, std::memory_order_release);
+    return true;
+}
+
+const char* JointSupervisor::faultName(uint8_t fault) {
+    switch (fault) {
+        case STALL:   return "STALL";
+        case THERMAL: return "THERMAL";
+        case LIMIT:   return "LIMIT";
+        case RUNAWAY: return "RUNAWAY";
+        case ENCODER: return "ENCODER";
+        default:      return "OK";
+    }
+}
+
+// Format: HEALTH trip=<0|1> j1=<faults> heat1=<0..1> j2=...
+void JointSupervisor::report(Print& out) const {
+    out.printf("HEALTH trip=%d", tripped() ? 1 : 0);
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        uint8_t mask = faults(j);
+        out.printf(" j%u=", (unsigned)(j + 1));
+        if (mask == NONE) {
+            out.print("OK");
+        }
+        for (uint8_t bit = 1, first = 1; bit && bit <= ENCODER; bit <<= 1) {
+            if (mask & bit) {
+                out.printf("%s%s", first ? "" : ",", faultName(bit));
+                first = 0;
+            }
+        }
+        out.printf(" heat%u=%.2f", (unsigned)(j + 1), thermalLoad(j));
+    }
+    out.println();
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "boardConfig.h"
+
+// Per-tick joint health checks. Any fault trips the whole driver: both
+// motors coast and SLEEP_PIN goes low until the fault is cleared.
+class JointSupervisor {
+public:
+    enum Fault : uint8_t {
+        NONE    = 0,
+        STALL   = 1 << 0,  // High drive, no motion
+        THERMAL = 1 << 1,  // I2t estimate over limit
+        LIMIT   = 1 << 2,  // Position outside the soft limits
+        RUNAWAY = 1 << 3,  // Moving fast against the drive direction
+        ENCODER = 1 << 4,  // Counts frozen under moderate drive
+    };
+
+    struct Limits {
+        float stallDrive = 80.0f;        // % output
+        float stallVelocity = 5.0f;      // deg/s
+        float stallTime = 0.5f;          // s
+        float encoderDrive = 30.0f;
+        float encoderTime = 1.0f;
+        float runawayDrive = 30.0f;
+        float runawayVelocity = 45.0f;
+        float runawayTime = 0.25f;
+        float i2tContinuous = 0.4f;      // Sustainable fraction of full drive
+        float i2tLimit = 4.0f;           // Accumulated (i^2 - ic^2) * s at trip
+        float i2tClearFraction = 0.5f;   // Must cool below this to clear
+        float limitMarginDeg = 15.0f;
+    };
+
+    // Evaluated from the control tick. drive is the signed % actually applied
+    // (0 while braking). Returns false when the joint must not be driven.
+    bool evaluate(size_t joint, float drive, float positionDeg, float velocityDeg,
+                  int64_t counts, float dt);
+
+    bool tripped() const { return tripFlag.load(std::memory_order_acquire); }
+    uint8_t faults(size_t joint) const { return joints[joint].faults.load(std::memory_order_relaxed); }
+    float thermalLoad(size_t joint) const { return joints[joint].heat / limits.i2tLimit; }
+
+    // Clears latched faults and wakes the driver, refused while still hot
+    bool clear();
+
+    // True once after each new trip, for the comms side to publish
+    bool takeReport() { return reportPending.exchange(false, std::memory_order_acq_rel); }
+    void report(Print& out) const;
+
+    static const char* faultName(uint8_t fault);
+
+    Limits limits;
+
+private:
+    struct JointState {
+        float stallTime = 0.0f;
+        float frozenTime = 0.0f;
+        float runawayTime = 0.0f;
+        float heat = 0.0f;
+        int64_t lastCounts = 0;
+        std::atomic<uint8_t> faults{NONE};
+    };
+
+    JointState joints[Board::NUM_JOINTS];
+    std::atomic<bool> tripFlag{false};
+    std::atomic<bool> reportPending{false};
+
+    void trip(size_t joint, uint8_t fault);
+};
+
+extern JointSupervisor supervisor;
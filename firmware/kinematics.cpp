@@ -0,0 +1,9 @@
+#include "kinematics.h"
+
+float SinCosTable::table[SIZE + SIZE / 4 + 1];
+
+void SinCosTable::init() {
+    for (uint32_t i = 0; i < SIZE + SIZE / 4 + 1; i++) {
+        table[i] = (float)sin(2.0 * PI * i / SIZE);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <Arduino.h>
+
+// Sine and cosine from one table, indexed by a 32-bit phase where a full turn
+// is 2^32: angles add and wrap in integer arithmetic with no range reduction.
+// Linear interpolation between 1024 points keeps the error under 5e-6.
+class SinCosTable {
+public:
+    static constexpr uint32_t BITS = 10;
+    static constexpr uint32_t SIZE = 1u << BITS;
+
+    static void init();  // Before the first lookup, from setup()
+
+    static uint32_t phaseFromDeg(float degrees) {
+        return (uint32_t)(int64_t)(degrees * (4294967296.0f / 360.0f));
+    }
+
+    static void lookup(uint32_t phase, float& s, float& c) {
+        uint32_t index = phase >> (32 - BITS);
+        float frac = (float)(phase & ((1u << (32 - BITS)) - 1)) * (1.0f / (1u << (32 - BITS)));
+        const float* sp = &table[index];
+        const float* cp = &table[index + SIZE / 4];  // cos x = sin(x + 90 deg)
+        s = sp[0] + (sp[1] - sp[0]) * frac;
+        c = cp[0] + (cp[1] - cp[0]) * frac;
+    }
+
+    static size_t staticBytes() { return sizeof(table); }
+
+private:
+    static float table[SIZE + SIZE / 4 + 1];  // One turn of sine plus a quarter for cosine
+};
+
+// Planar forward kinematics of the snake: N joints between N + 1 equal
+// segments, each joint turning the next segment about the body normal.
+// The head segment is the frame: it starts at the origin pointing along +x.
+// Headings accumulate as phases, so each segment costs one table lookup.
+template <size_t N>
+class ChainKinematics {
+public:
+    static constexpr size_t SEGMENTS = N + 1;
+
+    // Structure of arrays; mm, degrees and 1/m
+    struct Shape {
+        float xMm[SEGMENTS], yMm[SEGMENTS];  // Segment start
+        float headingDeg[SEGMENTS];
+        float curvature[N];                  // Joint angle over segment length
+        float comXMm, comYMm;                // Uniform segments, mass at the midpoints
+    };
+
+    explicit ChainKinematics(float segmentLengthMm) : lengthMm(segmentLengthMm) {}
+
+    // N joint angles in degrees
+    void update(const float* jointDeg) {
+        uint32_t phase = 0;
+        float x = 0.0f, y = 0.0f, s = 0.0f, c = 1.0f;
+        float sumX = 0.0f, sumY = 0.0f;
+        float curvaturePerRad = 1000.0f / lengthMm;
+
+        for (size_t k = 0; k < SEGMENTS; k++) {
+            if (k > 0) {
+                phase += SinCosTable::phaseFromDeg(jointDeg[k - 1]);
+                SinCosTable::lookup(phase, s, c);
+                out.curvature[k - 1] = radians(jointDeg[k - 1]) * curvaturePerRad;
+            }
+            out.xMm[k] = x;
+            out.yMm[k] = y;
+            out.headingDeg[k] = (float)(int32_t)phase * (360.0f / 4294967296.0f);
+
+            float dx = c * lengthMm, dy = s * lengthMm;
+            sumX += x + 0.5f * dx;
+            sumY += y + 0.5f * dy;
+            x += dx;
+            y += dy;
+        }
+        out.comXMm = sumX * (1.0f / SEGMENTS);
+        out.comYMm = sumY * (1.0f / SEGMENTS);
+    }
+
+    const Shape& shape() const { return out; }
+
+private:
+    float lengthMm;
+    Shape out = {};
+};
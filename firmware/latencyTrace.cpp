@@ -0,0 +1,73 @@
+#include "latencyTrace.h"
+
+LatencyTrace::Histogram LatencyTrace::histograms[STAGE_COUNT];
+LatencyTrace::Pending LatencyTrace::pending[Board::NUM_JOINTS];
+std::atomic<bool> LatencyTrace::resetRequested{false};
+
+static const char* const STAGE_NAMES[] = {"parse", "queue", "actuate", "total"};
+
+void LatencyTrace::applied(const ControlCommand& cmd, int64_t nowUs) {
+    if (resetRequested.exchange(false, std::memory_order_acq_rel)) {
+        memset(histograms, 0, sizeof(histograms));
+        memset(pending, 0, sizeof(pending));
+    }
+
+    histograms[PARSE].add((uint32_t)(cmd.enqueuedUs - cmd.receivedUs));
+    histograms[QUEUE].add((uint32_t)(nowUs - cmd.enqueuedUs));
+
+    // Only joint commands end in a motor write; the first one per tick wins
+    bool jointCommand = cmd.type == ControlCommand::Type::SetpointDeg
+                     || cmd.type == ControlCommand::Type::Gains;
+    if (jointCommand && cmd.joint < Board::NUM_JOINTS && !pending[cmd.joint].active) {
+        pending[cmd.joint] = {cmd.receivedUs, nowUs, true};
+    }
+}
+
+void LatencyTrace::actuated(size_t joint, int64_t nowUs) {
+    Pending& p = pending[joint];
+    if (!p.active) return;
+    histograms[ACTUATE].add((uint32_t)(nowUs - p.appliedUs));
+    histograms[TOTAL].add((uint32_t)(nowUs - p.receivedUs));
+    p.active = false;
+}
+
+void LatencyTrace::report(Print& out) {
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        const Histogram& h = histograms[s];
+        out.printf("LAT %s n=%u p50=%u p90=%u p99=%u max=%u\n", STAGE_NAMES[s],
+                   (unsigned)h.count, (unsigned)h.percentile(500), (unsigned)h.percentile(900),
+                   (unsigned)h.percentile(990), (unsigned)h.maxUs);
+    }
+}
+
+uint32_t LatencyTrace::bucketOf(uint32_t us) {
+    if (us < LINEAR_BUCKETS) return us;
+    uint32_t exponent = 31 - __builtin_clz(us);  // >= 4
+    uint32_t sub = (us >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    return min(BUCKETS - 1, LINEAR_BUCKETS + (exponent - 4) * SUB_BUCKETS + sub);
+}
+
+uint32_t LatencyTrace::bucketUpper(uint32_t bucket) {
+    if (bucket < LINEAR_BUCKETS) return bucket;
+    uint32_t exponent = 4 + (bucket - LINEAR_BUCKETS) / SUB_BUCKETS;
+    uint32_t sub = (bucket - LINEAR_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (exponent - 3)) - 1;
+}
+
+void LatencyTrace::Histogram::add(uint32_t us) {
+    buckets[bucketOf(us)]++;
+    count++;
+    if (us > maxUs) maxUs = us;
+}
+
+// Upper edge of the bucket holding the given rank, capped at the true max
+uint32_t LatencyTrace::Histogram::percentile(uint32_t permille) const {
+    if (count == 0) return 0;
+    uint32_t rank = (uint32_t)(((uint64_t)count * permille + 999) / 1000);
+    uint32_t seen = 0;
+    for (uint32_t b = 0; b < BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return min(bucketUpper(b), maxUs);
+    }
+    return maxUs;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "boardConfig.h"
+#include "controlTask.h"
+
+// Command path latency: receipt of the first byte on the comms core, parse
+// done (queued for control), applied on the control core, and the joint's
+// next motor write. Stages go into fixed log-linear histograms in static
+// RAM (about 3 KB), so the percentiles cost no heap.
+class LatencyTrace {
+public:
+    enum Stage : uint8_t {
+        PARSE,      // Receipt to queued
+        QUEUE,      // Queued to applied
+        ACTUATE,    // Applied to motor write
+        TOTAL,      // Receipt to motor write
+        STAGE_COUNT
+    };
+
+    // Control task only
+    static void applied(const ControlCommand& cmd, int64_t nowUs);
+    static void actuated(size_t joint, int64_t nowUs);
+
+    // Comms side; the control task clears on its next command
+    static void reset() { resetRequested.store(true, std::memory_order_release); }
+
+    // Format: LAT <stage> n=<count> p50=<us> p90=<us> p99=<us> max=<us>  (one line per stage)
+    static void report(Print& out);
+    static uint32_t count(Stage stage) { return histograms[stage].count; }
+    static uint32_t percentileUs(Stage stage, uint32_t permille) { return histograms[stage].percentile(permille); }
+
+private:
+    // Exact below 16 us, then 8 sub-buckets per power of two up to ~8 s
+    static constexpr uint32_t LINEAR_BUCKETS = 16;
+    static constexpr uint32_t SUB_BUCKETS = 8;
+    static constexpr uint32_t BUCKETS = LINEAR_BUCKETS + 20 * SUB_BUCKETS;
+
+    struct Histogram {
+        uint32_t buckets[BUCKETS];
+        uint32_t count;
+        uint32_t maxUs;
+
+        void add(uint32_t us);
+        uint32_t percentile(uint32_t permille) const;
+    };
+
+    struct Pending {
+        int64_t receivedUs;
+        int64_t appliedUs;
+        bool active;
+    };
+
+    static Histogram histograms[STAGE_COUNT];
+    static Pending pending[Board::NUM_JOINTS];
+    static std::atomic<bool> resetRequested;
+
+    static uint32_t bucketOf(uint32_t us);
+    static uint32_t bucketUpper(uint32_t bucket);
+};
@@ -0,0 +1,68 @@
+#include "mahonyFilter.h"
+
+void MahonyFilter::initFromGravity(float ax, float ay, float az) {
+    // Roll and pitch straight from the accelerometer, yaw zero
+    float roll = atan2f(ay, az);
+    float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+    float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+    float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+    q0 = cr * cp;
+    q1 = sr * cp;
+    q2 = cr * sp;
+    q3 = -sr * sp;
+    biasX = biasY = biasZ = 0.0f;
+    initialized = true;
+}
+
+void MahonyFilter::update(float gx, float gy, float gz, float ax, float ay, float az, float dt) {
+    float norm = ax * ax + ay * ay + az * az;
+    if (!initialized) {
+        if (norm > 0.0f) initFromGravity(ax, ay, az);
+        return;
+    }
+
+    // Correction only with a usable gravity reading
+    if (norm > 0.0f) {
+        float inv = 1.0f / sqrtf(norm);
+        ax *= inv;
+        ay *= inv;
+        az *= inv;
+
+        // Gravity as the current estimate sees it, error is its cross product with the measurement
+        float vx = 2.0f * (q1 * q3 - q0 * q2);
+        float vy = 2.0f * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        if (ki > 0.0f) {
+            biasX += ki * ex * dt;
+            biasY += ki * ey * dt;
+            biasZ += ki * ez * dt;
+        }
+        gx += kp * ex + biasX;
+        gy += kp * ey + biasY;
+        gz += kp * ez + biasZ;
+    }
+
+    // q += 0.5 q * omega dt
+    float h = 0.5f * dt;
+    float a = q0, b = q1, c = q2;
+    q0 += (-b * gx - c * gy - q3 * gz) * h;
+    q1 += (a * gx + c * gz - q3 * gy) * h;
+    q2 += (a * gy - b * gz + q3 * gx) * h;
+    q3 += (a * gz + b * gy - c * gx) * h;
+
+    float inv = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= inv;
+    q1 *= inv;
+    q2 *= inv;
+    q3 *= inv;
+}
+
+void MahonyFilter::euler(float& rollDeg, float& pitchDeg, float& yawDeg) const {
+    rollDeg = degrees(atan2f(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2)));
+    pitchDeg = degrees(asinf(constrain(2.0f * (q0 * q2 - q3 * q1), -1.0f, 1.0f)));
+    yawDeg = degrees(atan2f(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3)));
+}
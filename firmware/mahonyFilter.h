@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+
+// Mahony complementary filter on gyro and accelerometer: the gyro is
+// integrated into a quaternion and the accelerometer's gravity direction
+// pulls roll and pitch back through a PI correction on the angular rate.
+// Yaw has no reference and drifts with the gyro bias.
+class MahonyFilter {
+public:
+    float kp = 1.0f;   // Proportional pull toward gravity, 1/s
+    float ki = 0.0f;   // Gyro bias learning, 1/s^2; 0 disables
+
+    // Gyro in rad/s, accel in any unit (only its direction is used), dt in s
+    void update(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+    void reset() { initialized = false; }
+
+    void quaternion(float (&out)[4]) const { out[0] = q0; out[1] = q1; out[2] = q2; out[3] = q3; }
+    // Aerospace sequence, degrees
+    void euler(float& rollDeg, float& pitchDeg, float& yawDeg) const;
+
+private:
+    float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
+    float biasX = 0.0f, biasY = 0.0f, biasZ = 0.0f;
+    bool initialized = false;
+
+    void initFromGravity(float ax, float ay, float az);
+};
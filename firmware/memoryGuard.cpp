@@ -0,0 +1,91 @@
+#include "memoryGuard.h"
+#include <esp_heap_caps.h>
+#include <new>
+
+MemoryGuard::TaskEntry MemoryGuard::tasks[MAX_TASKS];
+size_t MemoryGuard::taskCount = 0;
+MemoryGuard::ObjectEntry MemoryGuard::objects[MAX_OBJECTS];
+size_t MemoryGuard::objectCount = 0;
+volatile bool MemoryGuard::locked = false;
+volatile uint32_t MemoryGuard::lateAllocations = 0;
+TaskHandle_t MemoryGuard::forbiddenTask = nullptr;
+
+void MemoryGuard::registerTask(const char* name, TaskHandle_t handle, uint32_t stackBytes) {
+    if (taskCount < MAX_TASKS) {
+        tasks[taskCount++] = {name, handle, stackBytes};
+    }
+}
+
+void MemoryGuard::registerObject(const char* name, size_t bytes) {
+    if (objectCount < MAX_OBJECTS) {
+        objects[objectCount++] = {name, bytes};
+    }
+}
+
+void MemoryGuard::lockHeap() {
+    locked = true;
+}
+
+void MemoryGuard::noteAllocation(size_t bytes) {
+    if (!locked) return;
+    lateAllocations = lateAllocations + 1;
+    if (forbiddenTask && xTaskGetCurrentTaskHandle() == forbiddenTask) {
+        // Not Serial: printing may itself allocate
+        esp_rom_printf("MemoryGuard: %u byte allocation in control task\n", (unsigned)bytes);
+        abort();
+    }
+}
+
+void MemoryGuard::report(Print& out) {
+    size_t staticBytes = 0;
+    for (size_t i = 0; i < objectCount; i++) staticBytes += objects[i].bytes;
+
+    out.printf("MEM static=%u heap_free=%u heap_min=%u late_allocs=%u\n",
+               (unsigned)staticBytes,
+               (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+               (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+               (unsigned)lateAllocations);
+    for (size_t i = 0; i < objectCount; i++) {
+        out.printf("OBJ %s bytes=%u\n", objects[i].name, (unsigned)objects[i].bytes);
+    }
+    for (size_t i = 0; i < taskCount; i++) {
+        // High-water mark is reported in bytes on ESP32 (StackType_t is 8-bit)
+        out.printf("TASK %s stack=%u free_min=%u\n", tasks[i].name,
+                   (unsigned)tasks[i].stackBytes,
+                   (unsigned)uxTaskGetStackHighWaterMark(tasks[i].handle));
+    }
+}
+
+#if MEMORY_DEBUG && CONFIG_HEAP_USE_HOOKS
+// Every heap allocation, C or C++, reaches this hook
+extern "C" void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    MemoryGuard::noteAllocation(size);
+}
+
+extern "C" void esp_heap_trace_free_hook(void* ptr) {}
+#elif MEMORY_DEBUG
+// Every C++ allocation in the firmware goes through these
+void* operator new(size_t size) {
+    MemoryGuard::noteAllocation(size);
+    void* p = malloc(size);
+    if (!p) abort();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    MemoryGuard::noteAllocation(size);
+    void* p = malloc(size);
+    if (!p) abort();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    MemoryGuard::noteAllocation(size);
+    return malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    MemoryGuard::noteAllocation(size);
+    return malloc(size);
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+
+// Set to 1 to abort on any allocation from the control task once setup()
+// has finished, and to count every other allocation after that point.
+// Allocations are seen through the IDF heap hooks when the core is built with
+// CONFIG_HEAP_USE_HOOKS, which covers malloc and heap_caps_malloc too. The
+// prebuilt Arduino core leaves the hooks off; then only C++ operator new is
+// trapped and C allocations go unseen on target. The host no-allocation test
+// (host/test/noAllocationTest.cpp) counts both around the control tick.
+#ifndef MEMORY_DEBUG
+#define MEMORY_DEBUG 0
+#endif
+
+// Bookkeeping for the fully static memory layout: registered task stacks,
+// static object sizes and post-setup heap activity
+class MemoryGuard {
+public:
+    static constexpr size_t MAX_TASKS = 6;
+    static constexpr size_t MAX_OBJECTS = 12;
+
+    // Tasks are listed for their stack high-water mark; their stack buffers
+    // are counted through the object that owns them
+    static void registerTask(const char* name, TaskHandle_t handle, uint32_t stackBytes);
+    static void registerObject(const char* name, size_t bytes);
+
+    // Called at the end of setup(); from here on the heap should stay untouched
+    static void lockHeap();
+    static bool heapLocked() { return locked; }
+    static uint32_t allocationsAfterSetup() { return lateAllocations; }
+
+    // Strict mode: allocation from this task aborts (the control task)
+    static void forbidAllocations(TaskHandle_t handle) { forbiddenTask = handle; }
+    static void noteAllocation(size_t bytes);
+
+    // Format: MEM static=<bytes> heap_free=<bytes> heap_min=<bytes> late_allocs=<n>
+    //         TASK <name> stack=<bytes> free_min=<bytes>   (one line per task)
+    static void report(Print& out);
+
+private:
+    struct TaskEntry {
+        const char* name;
+        TaskHandle_t handle;
+        uint32_t stackBytes;
+    };
+    struct ObjectEntry {
+        const char* name;
+        size_t bytes;
+    };
+
+    static TaskEntry tasks[MAX_TASKS];
+    static size_t taskCount;
+    static ObjectEntry objects[MAX_OBJECTS];
+    static size_t objectCount;
+    static volatile bool locked;
+    static volatile uint32_t lateAllocations;
+    static TaskHandle_t forbiddenTask;
+};
@@ -0,0 +1,98 @@
+#include "motionLibrary.h"
+#include <esp_crc.h>
+
+const MotionLibrary::Header* MotionLibrary::header = nullptr;
+const MotionLibrary::Entry* MotionLibrary::entries = nullptr;
+size_t MotionLibrary::imageBytes = 0;
+esp_partition_mmap_handle_t MotionLibrary::mapping;
+
+bool MotionLibrary::begin() {
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)PARTITION_SUBTYPE, "motion");
+    if (!part) {
+        Serial.println("No motion partition, primitives unavailable");
+        return false;
+    }
+
+    const void* mapped = nullptr;
+    if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &mapped, &mapping) != ESP_OK) {
+        Serial.println("Motion partition could not be mapped");
+        return false;
+    }
+    const uint8_t* image = static_cast<const uint8_t*>(mapped);
+    if (!validate(image, part->size)) {
+        Serial.println("Motion partition holds no valid primitive image");
+        esp_partition_munmap(mapping);
+        return false;
+    }
+
+    entries = reinterpret_cast<const Entry*>(image + sizeof(Header));
+    header = reinterpret_cast<const Header*>(image);
+    return true;
+}
+
+// Every offset is checked here, so lookups at run time need no bounds checks
+bool MotionLibrary::validate(const uint8_t* image, size_t size) {
+    const Header* h = reinterpret_cast<const Header*>(image);
+    if (h->magic != MAGIC || h->version != VERSION) return false;
+
+    size_t indexEnd = sizeof(Header) + h->count * sizeof(Entry);
+    if (indexEnd > size) return false;
+    const Entry* index = reinterpret_cast<const Entry*>(image + sizeof(Header));
+
+    size_t end = indexEnd;
+    for (size_t i = 0; i < h->count; i++) {
+        const Entry& e = index[i];
+        size_t bytes = (size_t)e.keyframes * keyframeBytes(e);
+        if (e.keyframes == 0 || e.joints == 0 || e.offset % 2 != 0
+            || e.offset < indexEnd || e.offset > size || bytes > size - e.offset) {
+            return false;
+        }
+        end = max(end, (size_t)e.offset + bytes);
+    }
+
+    // Times start at 0 and rise, so the player's segment arithmetic never goes negative
+    for (size_t i = 0; i < h->count; i++) {
+        const Entry& e = index[i];
+        size_t stride = keyframeBytes(e);
+        uint32_t last = 0;
+        for (size_t k = 0; k < e.keyframes; k++) {
+            const Keyframe* f = reinterpret_cast<const Keyframe*>(image + e.offset + k * stride);
+            if (k == 0 ? f->timeMs != 0 : f->timeMs <= last) return false;
+            last = f->timeMs;
+        }
+    }
+
+    if (esp_crc32_le(0, image + sizeof(Header), end - sizeof(Header)) != h->crc) return false;
+    imageBytes = end;
+    return true;
+}
+
+const MotionLibrary::Entry* MotionLibrary::find(uint16_t id) {
+    if (!header) return nullptr;
+    for (size_t i = 0; i < header->count; i++) {
+        if (entries[i].id == id) return &entries[i];
+    }
+    return nullptr;
+}
+
+const MotionLibrary::Keyframe* MotionLibrary::keyframe(const Entry& entry, size_t index) {
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(header) + entry.offset;
+    return reinterpret_cast<const Keyframe*>(base + index * keyframeBytes(entry));
+}
+
+uint32_t MotionLibrary::durationMs(const Entry& entry) {
+    return keyframe(entry, entry.keyframes - 1)->timeMs;
+}
+
+void MotionLibrary::report(Print& out) {
+    out.printf("MOTION loaded=%u count=%u bytes=%u\n", loaded() ? 1u : 0u,
+               loaded() ? (unsigned)header->count : 0u, (unsigned)imageBytes);
+    if (!loaded()) return;
+    for (size_t i = 0; i < header->count; i++) {
+        const Entry& e = entries[i];
+        out.printf("PRIM id=%u joints=%u keyframes=%u ms=%u loop=%u\n", (unsigned)e.id,
+                   (unsigned)e.joints, (unsigned)e.keyframes, (unsigned)durationMs(e),
+                   (e.flags & FLAG_LOOP) ? 1u : 0u);
+    }
+}
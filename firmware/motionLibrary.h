@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_partition.h>
+
+// Motion primitives in their own flash partition ("motion" in partitions.csv),
+// memory-mapped once at boot and read in place: the control task walks the
+// keyframes straight out of flash through the cache, nothing is copied.
+// tools/motion_encode.py builds the image and flashes it with esptool.
+//
+// Image layout (little endian, natural alignment):
+//   header: "MPRM" | version u8 | count u8 | reserved u16 | crc32 of the rest
+//   index:  count x { id u16, joints u8, flags u8, offset u32, keyframes u16, reserved u16 }
+//   data:   per primitive, keyframes x { time_ms u16, interp u8, reserved u8, joints x deg*100 i16 }
+// The interpolation of keyframe k shapes the segment from k to k + 1. Keyframe
+// times start at 0 and rise strictly.
+class MotionLibrary {
+public:
+    static constexpr uint32_t MAGIC = 0x4D52504D;  // "MPRM"
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t PARTITION_SUBTYPE = 0x40;
+    static constexpr uint8_t FLAG_LOOP = 0x01;
+
+    enum Interp : uint8_t { STEP, LINEAR, SMOOTH };
+
+    struct Header {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t count;
+        uint16_t reserved;
+        uint32_t crc;
+    };
+
+    struct Entry {
+        uint16_t id;
+        uint8_t joints;
+        uint8_t flags;
+        uint32_t offset;     // From the start of the image
+        uint16_t keyframes;
+        uint16_t reserved;
+    };
+
+    struct Keyframe {
+        uint16_t timeMs;     // From the start of the primitive
+        uint8_t interp;
+        uint8_t reserved;
+        int16_t centiDeg[];  // One per joint in the primitive
+    };
+
+    // Comms side, from deferred init; validates the whole image once
+    static bool begin();
+    static bool loaded() { return header != nullptr; }
+
+    // Either side once loaded; flash contents never change at run time
+    static const Entry* find(uint16_t id);
+    static const Keyframe* keyframe(const Entry& entry, size_t index);
+    static uint32_t durationMs(const Entry& entry);
+
+    // Format: MOTION loaded=<0|1> count=<n> bytes=<n>
+    //         PRIM id=<n> joints=<n> keyframes=<n> ms=<n> loop=<0|1>  (one line per primitive)
+    static void report(Print& out);
+
+private:
+    static const Header* header;
+    static const Entry* entries;
+    static size_t imageBytes;
+    static esp_partition_mmap_handle_t mapping;
+
+    static size_t keyframeBytes(const Entry& entry) { return sizeof(Keyframe) + 2 * entry.joints; }
+    static bool validate(const uint8_t* image, size_t size);
+};
@@ -0,0 +1,138 @@
+#include "motionPlayer.h"
+#include "motorConfig.h"
+
+MotionPlayer::Track MotionPlayer::current = {};
+MotionPlayer::Track MotionPlayer::previous = {};
+float MotionPlayer::fromDeg[Board::NUM_JOINTS];
+uint32_t MotionPlayer::blendMs = 0;
+uint32_t MotionPlayer::blendElapsedMs = 0;
+
+std::atomic<int32_t> MotionPlayer::playingId{-1};
+std::atomic<uint32_t> MotionPlayer::playingMs{0};
+std::atomic<uint32_t> MotionPlayer::playCount{0};
+std::atomic<uint32_t> MotionPlayer::rejectCount{0};
+
+static constexpr uint32_t PERIOD_MS = Board::CONTROL_PERIOD_US / 1000;
+
+bool MotionPlayer::play(uint16_t id, uint32_t blend) {
+    const MotionLibrary::Entry* entry = MotionLibrary::find(id);
+    if (!entry) {
+        rejectCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Fade from the running primitive if there is one, else from where the joints are held
+    previous = current;
+    if (!previous.entry) {
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) fromDeg[j] = motors[j].referenceDeg;
+    }
+    current = {entry, 0, 0};
+    blendMs = min(blend, MAX_BLEND_MS);
+    blendElapsedMs = 0;
+
+    // The primitive owns the setpoints from here
+    for (size_t j = 0; j < entry->joints && j < Board::NUM_JOINTS; j++) {
+        motors[j].trajectory.requestClear();
+        motors[j].backlash.cancelCalibration();
+    }
+    playingId.store(id, std::memory_order_relaxed);
+    playCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void MotionPlayer::stop() {
+    current.entry = previous.entry = nullptr;
+    playingId.store(-1, std::memory_order_relaxed);
+}
+
+// Moves the cursor to the segment holding elapsedMs, wrapping looped primitives
+void MotionPlayer::advance(Track& track) {
+    const MotionLibrary::Entry& e = *track.entry;
+    uint32_t duration = MotionLibrary::durationMs(e);
+    if ((e.flags & MotionLibrary::FLAG_LOOP) && duration > 0 && track.elapsedMs >= duration) {
+        track.elapsedMs %= duration;
+        track.cursor = 0;
+    }
+    while (track.cursor + 1 < e.keyframes
+           && MotionLibrary::keyframe(e, track.cursor + 1)->timeMs <= track.elapsedMs) {
+        track.cursor++;
+    }
+}
+
+// Writes the track's pose into deg; false once a one-shot primitive has played out
+bool MotionPlayer::sample(Track& track, float* deg) {
+    advance(track);
+    const MotionLibrary::Entry& e = *track.entry;
+    const MotionLibrary::Keyframe* a = MotionLibrary::keyframe(e, track.cursor);
+    size_t joints = min((size_t)e.joints, Board::NUM_JOINTS);
+
+    if (track.cursor + 1 >= e.keyframes) {
+        for (size_t j = 0; j < joints; j++) deg[j] = a->centiDeg[j] * 0.01f;
+        return track.elapsedMs < a->timeMs || (e.flags & MotionLibrary::FLAG_LOOP);
+    }
+
+    const MotionLibrary::Keyframe* b = MotionLibrary::keyframe(e, track.cursor + 1);
+    float u = 0.0f;
+    if (a->interp != MotionLibrary::STEP && b->timeMs > a->timeMs) {
+        u = (float)(track.elapsedMs - a->timeMs) / (b->timeMs - a->timeMs);
+        if (a->interp == MotionLibrary::SMOOTH) u = u * u * (3.0f - 2.0f * u);
+    }
+    for (size_t j = 0; j < joints; j++) {
+        deg[j] = (a->centiDeg[j] + u * (b->centiDeg[j] - a->centiDeg[j])) * 0.01f;
+    }
+    return true;
+}
+
+void MotionPlayer::tick() {
+    if (!current.entry) return;
+
+    // A waypoint stream on one of its joints takes over from the primitive
+    for (size_t j = 0; j < current.entry->joints && j < Board::NUM_JOINTS; j++) {
+        if (motors[j].trajectory.pending() > 0) {
+            stop();
+            return;
+        }
+    }
+
+    float pose[Board::NUM_JOINTS], from[Board::NUM_JOINTS];
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) pose[j] = from[j] = motors[j].referenceDeg;
+    bool running = sample(current, pose);
+
+    if (blendElapsedMs < blendMs) {
+        if (previous.entry) {
+            sample(previous, from);
+            previous.elapsedMs += PERIOD_MS;
+        } else {
+            memcpy(from, fromDeg, sizeof(from));
+        }
+        float w = (float)blendElapsedMs / blendMs;
+        w = w * w * (3.0f - 2.0f * w);
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) pose[j] = from[j] + w * (pose[j] - from[j]);
+        blendElapsedMs += PERIOD_MS;
+    } else {
+        previous.entry = nullptr;
+    }
+
+    size_t joints = min((size_t)current.entry->joints, Board::NUM_JOINTS);
+    for (size_t j = 0; j < joints; j++) {
+        motors[j].setSetpointDeg(motors[j].clampDeg(pose[j]));
+    }
+
+    current.elapsedMs += PERIOD_MS;
+    playingMs.store(current.elapsedMs, std::memory_order_relaxed);
+    if (!running && blendElapsedMs >= blendMs) stop();
+}
+
+void MotionPlayer::report(Print& out) {
+    int32_t id = playingId.load(std::memory_order_relaxed);
+    if (id < 0) {
+        out.print("PLAY id=none");
+    } else {
+        out.printf("PLAY id=%d", (int)id);
+    }
+    out.printf(" ms=%u blend=%u plays=%u rejected=%u\n",
+               (unsigned)playingMs.load(std::memory_order_relaxed),
+               (id >= 0 && blendElapsedMs < blendMs) ? 1u : 0u,
+               (unsigned)playCount.load(std::memory_order_relaxed),
+               (unsigned)rejectCount.load(std::memory_order_relaxed));
+}
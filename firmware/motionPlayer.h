@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "boardConfig.h"
+#include "motionLibrary.h"
+
+// Plays motion primitives from the flash library into the joint setpoints,
+// one sample per control tick. A new primitive cross-fades in over a blend
+// time from whatever was playing (which keeps running underneath until the
+// fade ends) or from the held pose. Joints beyond a primitive's joint count
+// are left alone. A tar, bklc or play stop command ends playback, and so do
+// waypoints streamed to any joint the primitive drives.
+class MotionPlayer {
+public:
+    static constexpr uint32_t DEFAULT_BLEND_MS = 200;
+    static constexpr uint32_t MAX_BLEND_MS = 5000;
+
+    // Control task only
+    static bool play(uint16_t id, uint32_t blendMs);
+    static void stop();
+    static void tick();  // Before the motors update
+    static bool active() { return current.entry != nullptr; }
+
+    // Format: PLAY id=<n|none> ms=<n> blend=<0|1> plays=<n> rejected=<n>
+    static void report(Print& out);
+    static size_t staticBytes() { return sizeof(current) + sizeof(previous) + sizeof(fromDeg); }
+
+private:
+    struct Track {
+        const MotionLibrary::Entry* entry;
+        uint32_t elapsedMs;
+        size_t cursor;  // Keyframe starting the current segment
+    };
+
+    static Track current, previous;
+    static float fromDeg[Board::NUM_JOINTS];  // Held pose when nothing was playing
+    static uint32_t blendMs, blendElapsedMs;
+
+    // Published for the comms side
+    static std::atomic<int32_t> playingId;
+    static std::atomic<uint32_t> playingMs;
+    static std::atomic<uint32_t> playCount;
+    static std::atomic<uint32_t> rejectCount;
+
+    static bool sample(Track& track, float* deg);
+    static void advance(Track& track);
+};
@@ -1,81 +1,310 @@
 #include "motorConfig.h"
-#include <mutex>
+#include "jointSupervisor.h"
+#include "bootTrace.h"
 // Global motor control and encoder instances
-std::timed_mutex motor_mutex; // Update mutex type
 TrackEncoder* trackEncoder = nullptr;
 ESP32MotorControl motorControl; // <-- Global instance defined here
+MotorPID motors[Board::NUM_JOINTS];
 
-void motorInit(int enc1A, int enc1B, int enc2A, int enc2B,
-              int ain1_1, int ain1_2, int ain2_1, int ain2_2,
-              int sleepPin, bool resetCounts, float pulsesPerRev) {
-    // Update TrackEncoder instantiation
-    trackEncoder = new TrackEncoder(enc1A, enc1B, enc2A, enc2B, "encoderStorage", pulsesPerRev);
+void motorInit(bool resetCounts, uint16_t encoderFilter) {
+    BootTrace::begin(BootTrace::ENCODERS);
+    // Static storage, constructed here rather than during static init
+    static TrackEncoder encoderInstance("encoderStorage");
+    trackEncoder = &encoderInstance;
+    trackEncoder->setGlitchFilter(encoderFilter);
     trackEncoder->begin(200);
+    BootTrace::setNvsOk(trackEncoder->persistent());
     
     if(resetCounts) {
         trackEncoder->resetCounts();
     }
+    BootTrace::end(BootTrace::ENCODERS);
 
     // Initialize motor control with correct pin assignments
-    motorControl.attachMotors(ain1_1, ain1_2, ain2_1, ain2_2);
-    pinMode(sleepPin, OUTPUT);
-    digitalWrite(sleepPin, HIGH);
+    BootTrace::begin(BootTrace::MOTORS);
+    if (Board::NUM_JOINTS == 1) {
+        motorControl.attachMotor(Board::JOINTS[0].in1, Board::JOINTS[0].in2);
+    } else {
+        motorControl.attachMotors(Board::JOINTS[0].in1, Board::JOINTS[0].in2,
+                                  Board::JOINTS[1].in1, Board::JOINTS[1].in2);
+    }
+    pinMode(Board::SLEEP_PIN, OUTPUT);
+    digitalWrite(Board::SLEEP_PIN, HIGH);
+    BootTrace::end(BootTrace::MOTORS);
 }
 
-void MotorPID::init(const Config& config) {
+void MotorPID::init(const Config& config, const MotorPID* group) {
     cfg = config;
+    peers = group ? group : ::motors;
     motorControl = &::motorControl; // <-- Critical fix: Assign global instance
     motorNum = config.motorNum;     // 0 = Motor 1, 1 = Motor 2
 
     // PID initialization
-    pid = QuickPID(&Input, &Output, &Setpoint, Kp, Ki, Kd,
+    pid = QuickPID(&Input, &Output, &Setpoint, Kp, Ki, 0.0f,  // D is added in updatePID()
                   QuickPID::pMode::pOnError,
                   QuickPID::dMode::dOnMeas,
                   QuickPID::iAwMode::iAwClamp,
                   QuickPID::Action::direct);
     pid.SetOutputLimits(-100, 100);
-    pid.SetSampleTimeUs(10000);
-    pid.SetMode(QuickPID::Control::automatic);
+    pid.SetSampleTimeUs(Board::CONTROL_PERIOD_US);
+    pid.SetMode(QuickPID::Control::timer); // The control task owns the cadence
 }
 
-void MotorPID::update() {
-    // Use try_lock_for to prevent deadlocks
-    if(motor_mutex.try_lock_for(std::chrono::milliseconds(10))) {
-        Input = (motorNum == 0) ? trackEncoder->getEncoder2Count() 
-                               : trackEncoder->getEncoder1Count();
-        updatePID();
+void MotorPID::update(const TrackEncoder::Snapshot& snap, bool parked) {
+    float trajectoryDeg;
+    if(trajectory.sample(millis(), referenceDeg, trajectoryDeg)) {
+        referenceDeg = clampDeg(trajectoryDeg);  // Hermite overshoot and extrapolation stay in range
+    }
+
+    // Reference through the gearbox model, or the calibration sweep
+    float sampleDt = lastSampleUs != 0 ? (snap.timestampUs - lastSampleUs) * 1e-6f : 0.0f;
+    float targetDeg = referenceDeg;
+    if(backlash.calibrating()) {
+        if(supervisor.tripped()) {
+            backlash.cancelCalibration();
+        } else {
+            targetDeg = clampDeg(backlash.calibrationStep(snap.counts[cfg.encoderIndex] * cfg.degPerCount,
+                                                          Output, sampleDt));
+        }
+    }
+    Setpoint = backlash.apply(targetDeg, Output, sampleDt) * cfg.countsPerDeg;
+
+    float dt = compute(snap, supervisor.tripped() || parked);
+
+    bool driveAllowed = true;
+    if(dt > 0) {
+        driveAllowed = supervisor.evaluate(motorNum, appliedDrive(), Input * cfg.degPerCount,
+                                           velocityDeg, snap.counts[cfg.encoderIndex], dt);
+    }
+
+    if(driveAllowed) {
         controlMotor();
-        motor_mutex.unlock();
+    } else {
+        motorControl->motorStop(motorNum);
+    }
+}
+
+float MotorPID::compute(const TrackEncoder::Snapshot& snap, bool tripped) {
+    float previousInput = Input;
+    Input = filters[(int)FilterPath::Measurement].process((float)snap.counts[cfg.encoderIndex]);
+
+    // The last tick's lookup is done, later ones read the committed table
+    uint32_t commits = scheduleCommits.load(std::memory_order_acquire);
+    if(commits != scheduleAcked.load(std::memory_order_relaxed)) {
+        scheduleAcked.store(commits, std::memory_order_release);
     }
+
+    float dt = (snap.timestampUs - lastSampleUs) * 1e-6f;
+    bool haveHistory = lastSampleUs != 0 && dt > 0;
+    float derivativeDeg = 0.0f;
+    if(haveHistory) {
+        rawVelocityDeg = (Input - previousInput) * cfg.degPerCount / dt;
+        derivativeDeg = filters[(int)FilterPath::Derivative].process(rawVelocityDeg);
+        velocityDeg += (derivativeDeg - velocityDeg) * dt / (VELOCITY_TAU_S + dt);
+        if(scheduleEnabled.load(std::memory_order_relaxed)) {
+            applySchedule(dt);
+        }
+    }
+    // Park the PID while tripped so it does not wind up, resume bumplessly
+    if(tripped != halted) {
+        halted = tripped;
+        if(halted) {
+            pid.SetMode(QuickPID::Control::manual);
+            Output = 0.0f;
+        } else if(mode == Controller::Pid) {
+            pid.SetMode(QuickPID::Control::timer);
+        } else {
+            seedLqrIntegral();
+        }
+        filters[(int)FilterPath::Output].prime(Output);
+    }
+
+    if(mode == Controller::Lqr) {
+        if(!halted) updateLqr(haveHistory ? dt : 0.0f);
+    } else {
+        updatePID(derivativeDeg);
+    }
+    if(!halted) {
+        float filtered = filters[(int)FilterPath::Output].size() > 0
+                       ? filters[(int)FilterPath::Output].process(Output) : Output;
+        Output = constrain(filtered, -100.0f, 100.0f);
+        // QuickPID only sees its own clamp; hold the integral while the
+        // filtered output is pinned and the error pushes further in
+        if(mode == Controller::Pid && filtered != Output && (filtered > 0.0f) == (errorCounts() > 0.0f)) {
+            pid.SetOutputSum(pid.GetOutputSum() - pid.GetIterm());
+        }
+    }
+    lastSampleUs = snap.timestampUs;
+    return haveHistory ? dt : 0.0f;
+}
+
+MotorPID::Checkpoint MotorPID::checkpoint() {
+    Checkpoint cp = {Input, Output, pid.GetOutputSum(), velocityDeg, rawVelocityDeg,
+                     Setpoint, Kp, Ki, Kd, lastSampleUs, halted, mode, lqr, {}, {}};
+    memcpy(cp.lqrGains, lqrGains, sizeof(lqrGains));
+    for(size_t i = 0; i < FILTER_PATHS; i++) cp.filters[i] = filters[i];
+    return cp;
+}
+
+// Loads a checkpoint so the next compute matches the recorded one exactly
+void MotorPID::restore(const Checkpoint& cp) {
+    Input = cp.input;
+    Output = cp.outputSum;
+    velocityDeg = cp.velocityDeg;
+    rawVelocityDeg = cp.rawVelocityDeg;
+    Setpoint = cp.setpoint;
+    referenceDeg = cp.setpoint * cfg.degPerCount;
+    Kp = cp.kp;
+    Ki = cp.ki;
+    Kd = cp.kd;
+    lastSampleUs = cp.sampleUs;
+    halted = cp.halted;
+    mode = cp.controller;
+    lqr = cp.lqr;
+    memcpy(lqrGains, cp.lqrGains, sizeof(lqrGains));
+    for(size_t i = 0; i < FILTER_PATHS; i++) filters[i] = cp.filters[i];
+
+    // QuickPID keeps only the integral and last input; while it is parked
+    // (halted or LQR) they are rebuilt when it resumes, as on the live joint
+    pid.SetTunings(Kp, Ki, 0.0f);
+    pid.SetMode(QuickPID::Control::timer);
+    pid.Initialize();  // Integral from Output, derivative from Input
+    if(halted || mode == Controller::Lqr) pid.SetMode(QuickPID::Control::manual);
+    Output = cp.output;
 }
 
 void MotorPID::setSetpointDeg(float degrees) {
-    std::lock_guard<std::mutex> lock(motor_mutex);
-    
-    float newSetpoint = (degrees * cfg.pulsesPerRev) / 360.0f;
-    Serial.printf("[Motor%d] Setpoint update:\n", motorNum+1);
-    Serial.printf("  Degrees: %.2f → Pulses: %.2f (PPR: %.2f)\n", 
-                 degrees, newSetpoint, cfg.pulsesPerRev);
-    
-    Setpoint = newSetpoint;
+    referenceDeg = degrees;
+    Setpoint = degrees * cfg.countsPerDeg;
+}
+
+// Soft limits inside the board table's mechanical range
+void MotorPID::setLimits(float minDeg, float maxDeg) {
+    const Board::JointConfig& board = Board::JOINTS[cfg.motorNum];
+    cfg.minDeg = constrain(minDeg, board.minDeg, board.maxDeg);
+    cfg.maxDeg = constrain(maxDeg, board.minDeg, board.maxDeg);
+    if (cfg.maxDeg <= cfg.minDeg) {
+        cfg.minDeg = board.minDeg;
+        cfg.maxDeg = board.maxDeg;
+    }
+}
+
+bool MotorPID::setFilter(FilterPath path, size_t section, Biquad::Type type, float f1, float f2OrQ) {
+    float present = path == FilterPath::Measurement ? Input
+                  : path == FilterPath::Derivative ? rawVelocityDeg : Output;
+    return filters[(int)path].set(section, type, f1, f2OrQ, 1e6f / Board::CONTROL_PERIOD_US, present);
+}
+
+bool MotorPID::commitSchedule() {
+    uint8_t staging = activeGainTable.load() ^ 1;
+    if(!stagingWritable() || !gainTables[staging].complete()) {
+        return false;
+    }
+    activeGainTable.store(staging);
+    scheduleEnabled.store(true);
+    scheduleCommits.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+float MotorPID::scheduleInput(GainSchedule::Key key) const {
+    switch(key) {
+        case GainSchedule::Key::Error:    return fabsf(Setpoint - Input) * cfg.degPerCount;
+        case GainSchedule::Key::Velocity: return fabsf(velocityDeg);
+        case GainSchedule::Key::Supply:   return supplyVolts;
+        default:                          return 0.0f;
+    }
+}
+
+void MotorPID::applySchedule(float dt) {
+    const GainSchedule& table = gainTables[activeGainTable.load(std::memory_order_acquire)];
+    GainSchedule::Gains target = table.lookup(scheduleInput(table.axisX().key),
+                                              scheduleInput(table.axisY().key));
+
+    // Blend toward the scheduled set so a table step never kicks the output
+    float alpha = dt / (GAIN_TAU_S + dt);
+    Kp += (target.kp - Kp) * alpha;
+    Ki += (target.ki - Ki) * alpha;
+    Kd += (target.kd - Kd) * alpha;
+}
+
+// QuickPID runs P and I; the D on measurement comes from the derivative
+// path, so its filters shape this term as well as the velocity estimate
+void MotorPID::updatePID(float derivativeDeg) {
+    if(pid.GetKp() != Kp || pid.GetKi() != Ki) {
+        pid.SetTunings(Kp, Ki, 0.0f);
+    }
+    if(pid.Compute()) {
+        float dTerm = -Kd * derivativeDeg * cfg.countsPerDeg;
+        Output = constrain(pid.GetOutputSum() + pid.GetPterm() + dTerm, -100.0f, 100.0f);
+    }
+}
+
+// One consistent set for the coupled rows, whatever order the joints update in
+void MotorPID::latchPeers() {
+    for(size_t i = 0; i < Board::NUM_JOINTS; i++) {
+        const MotorPID& peer = peers[i];
+        bool live = (int)i != motorNum && peer.controller() == Controller::Lqr && !peer.isHalted();
+        peerState[i] = live ? peer.lqrState() : LqrState{};
+    }
 }
 
-void MotorPID::updatePID() {
-    if(pid.GetKp() != Kp || pid.GetKi() != Ki || pid.GetKd() != Kd) {
-        pid.SetTunings(Kp, Ki, Kd);
+// -K x, optionally without this joint's integral term
+float MotorPID::lqrFeedback(bool includeIntegral) const {
+    float u = 0.0f;
+    for(size_t i = 0; i < Board::NUM_JOINTS; i++) {
+        const LqrState& s = ((int)i == motorNum) ? lqr : peerState[i];
+        const float* k = lqrGains[i];
+        u -= k[0] * s.errorDeg + k[1] * s.velocityDeg;
+        if(includeIntegral || (int)i != motorNum) u -= k[2] * s.integralDeg;
     }
-    pid.Compute();
+    return u;
+}
+
+// Pick the integral that reproduces the present output, so the switch does not kick
+void MotorPID::seedLqrIntegral() {
+    lqr.errorDeg = (Input - Setpoint) * cfg.degPerCount;
+    lqr.velocityDeg = velocityDeg;
+    float k = lqrGains[motorNum][2];
+    lqr.integralDeg = (k != 0.0f) ? (lqrFeedback(false) - Output) / k : 0.0f;
+}
+
+void MotorPID::setController(Controller next) {
+    if(next == mode) return;
+    mode = next;
+    if(mode == Controller::Lqr) {
+        pid.SetMode(QuickPID::Control::manual);
+        seedLqrIntegral();
+    } else if(!halted) {
+        pid.SetMode(QuickPID::Control::timer);  // QuickPID re-initialises from Output
+    }
+}
+
+void MotorPID::updateLqr(float dt) {
+    lqr.errorDeg = (Input - Setpoint) * cfg.degPerCount;
+    lqr.velocityDeg = velocityDeg;
+    float u = lqrFeedback(true);
+    Output = constrain(u, -100.0f, 100.0f);
+
+    // Integrate unless saturated and the error would push further into the limit
+    bool windingUp = (u > 100.0f && lqr.errorDeg < 0.0f) || (u < -100.0f && lqr.errorDeg > 0.0f);
+    if(!windingUp) lqr.integralDeg += lqr.errorDeg * dt;
+}
+
+// Signed drive in the controller frame, zero inside the braking band
+float MotorPID::appliedDrive() const {
+    return (abs(Setpoint - Input) <= BRAKING_THRESHOLD) ? 0.0f : Output;
 }
 
 void MotorPID::controlMotor() {
-    float error = Setpoint - Input;
+    float drive = appliedDrive();
+    if(cfg.inverted) drive = -drive;
     
     // Use valid motorControl pointer
-    if(abs(error) <= BRAKING_THRESHOLD) {
+    if(drive == 0.0f) {
         motorControl->motorStop(motorNum);
-    } else if(Output > 0) {
-        motorControl->motorForward(motorNum, abs(Output));
+    } else if(drive > 0) {
+        motorControl->motorForward(motorNum, abs(drive));
     } else {
-        motorControl->motorReverse(motorNum, abs(Output));
+        motorControl->motorReverse(motorNum, abs(drive));
     }
 }
\ No newline at end of file
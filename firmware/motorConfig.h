@@ -1,18 +1,20 @@
 #pragma once
 #include <Arduino.h>
-#include "TrackEncoder.h"
+#include "trackEncoder.h"
 #include <ESP32MotorControl.h>
 #include <QuickPID.h>
+#include "waypointQueue.h"
+#include "gainSchedule.h"
+#include "backlashComp.h"
+#include "biquad.h"
+#include "boardConfig.h"
 #define BRAKING_THRESHOLD 2
 
-#include <mutex>
-#include <chrono>
+#include <utility>
+#include <atomic>
 
-extern std::timed_mutex motor_mutex;
-
-void motorInit(int enc1A, int enc1B, int enc2A, int enc2B,
-              int ain1_1, int ain1_2, int ain2_1, int ain2_2,
-              int sleepPin, bool resetCounts, float pulsesPerRev);
+// Encoders, driver and sleep pin are taken from the Board description
+void motorInit(bool resetCounts, uint16_t encoderFilter);
 
 class MotorPID {
 public:
@@ -21,7 +23,12 @@ public:
         int motorNum;  // 0 = Motor 1, 1 = Motor 2
         int ain1;
         int ain2;
-        float pulsesPerRev;
+        float countsPerDeg;  // Precomputed from the board table
+        float degPerCount;
+        int encoderIndex;  // Channel in TrackEncoder::Snapshot
+        bool inverted;
+        float minDeg;
+        float maxDeg;
     };
 
     // PID Parameters
@@ -32,19 +39,139 @@ public:
     float Ki = 10.28f;
     float Kd = 0.10f;
 
-    void init(const Config& config);
-    void update();
+    // Streamed trajectory, takes over the setpoint while running
+    WaypointQueue trajectory;
+
+    // Output-side reference; Setpoint is the motor-side value after compensation
+    float referenceDeg = 0.0f;
+    BacklashComp backlash;
+
+    // Scheduling inputs
+    float velocityDeg = 0.0f;                      // Filtered, deg/s
+    float supplyVolts = Board::NOMINAL_SUPPLY_V;
+
+    // Gain schedule: tables are double buffered, the comms side fills the
+    // staging table and commits it in one step. After a commit the staging
+    // table is the one the control side may still be reading, so it stays
+    // read-only until the next tick acknowledges the swap
+    GainSchedule& stagingSchedule() { return gainTables[activeGainTable.load() ^ 1]; }
+    bool stagingWritable() const {
+        return scheduleAcked.load(std::memory_order_acquire) == scheduleCommits.load(std::memory_order_relaxed);
+    }
+    bool commitSchedule();  // False if incomplete or the last swap is unacknowledged
+    void disableSchedule() { scheduleEnabled.store(false); }
+    bool scheduleActive() const { return scheduleEnabled.load(); }
+
+    // Full-state feedback in place of the PID: drive = -sum over joints i of
+    // K[i] . (position error deg, velocity deg/s, integral of error deg s).
+    // Gains come from tools/lqr_design.py; rows for other joints couple them
+    // and use those joints' state as latchPeers() found it before the tick,
+    // zero for a peer that is not running LQR (its state is not kept then)
+    enum class Controller : uint8_t { Pid, Lqr };
+    struct LqrState {
+        float errorDeg, velocityDeg, integralDeg;
+    };
+    float lqrGains[Board::NUM_JOINTS][3] = {};
+    void setController(Controller next);  // Control task only, bumpless both ways
+    Controller controller() const { return mode; }
+    const LqrState& lqrState() const { return lqr; }
+    void latchPeers();  // Control task, for every joint of the group before any of them updates
+
+    // Biquad cascades on the encoder input (ahead of PID and LQR), the raw
+    // velocity that feeds both the PID's D term and the velocity estimate,
+    // and the controller output. The PID integral holds while the filtered
+    // output sits at its clamp. Empty by default; a change re-primes the
+    // chain so nothing kicks
+    enum class FilterPath : uint8_t { Measurement, Derivative, Output };
+    static constexpr size_t FILTER_PATHS = 3;
+    static constexpr size_t FILTER_SECTIONS = 4;
+    BiquadChain<FILTER_SECTIONS> filters[FILTER_PATHS];
+    bool setFilter(FilterPath path, size_t section, Biquad::Type type, float f1, float f2OrQ);  // Control task only
+
+    // Everything compute() carries from one tick to the next, so a replay
+    // started from it reproduces the following ticks exactly
+    struct Checkpoint {
+        float input, output, outputSum, velocityDeg, rawVelocityDeg;
+        float setpoint, kp, ki, kd;
+        int64_t sampleUs;
+        bool halted;
+        Controller controller;
+        LqrState lqr;
+        float lqrGains[Board::NUM_JOINTS][3];
+        BiquadChain<FILTER_SECTIONS> filters[FILTER_PATHS];
+    };
+
+    // group: the joints LQR rows couple to, the live motors[] unless given
+    void init(const Config& config, const MotorPID* group = nullptr);
+    // Control task only
+    void update(const TrackEncoder::Snapshot& snap, bool parked = false);  // parked: idle, PID held
+    float errorCounts() const { return Setpoint - Input; }
+    // Against a fresh latch, before update() moves the setpoint
+    float errorCounts(const TrackEncoder::Snapshot& snap) const { return Setpoint - (float)snap.counts[cfg.encoderIndex]; }
+    // Control math without the hardware or supervisor, returns dt (0 on the first sample)
+    float compute(const TrackEncoder::Snapshot& snap, bool tripped);
+    Checkpoint checkpoint();
+    void restore(const Checkpoint& cp);
+    bool sampled() const { return lastSampleUs != 0; }
+    bool isHalted() const { return halted; }  // What the last compute ran with
     void setSetpointDeg(float degrees);
+    float getSetpointDeg() const { return referenceDeg; }
+    void setLimits(float minDeg, float maxDeg);
+    float clampDeg(float degrees) const { return constrain(degrees, cfg.minDeg, cfg.maxDeg); }
+    const Config& config() const { return cfg; }
+    float appliedDrive() const;  // Signed % last sent to the driver, 0 while braking
 
 private:
     QuickPID pid;
     ESP32MotorControl* motorControl = nullptr; // Initialize to nullptr
     int motorNum = 0; // Default to motor 0
     Config cfg;
-    
-    void updatePID();
+    int64_t lastSampleUs = 0;
+    bool halted = false;  // PID parked while the supervisor holds torque off
+    Controller mode = Controller::Pid;
+    LqrState lqr = {};
+    LqrState peerState[Board::NUM_JOINTS] = {};  // Previous tick's, from latchPeers()
+    const MotorPID* peers = nullptr;
+
+    GainSchedule gainTables[2];
+    std::atomic<uint8_t> activeGainTable{0};
+    std::atomic<bool> scheduleEnabled{false};
+    std::atomic<uint32_t> scheduleCommits{0};  // Comms side
+    std::atomic<uint32_t> scheduleAcked{0};    // Control side, once past the old table
+    static constexpr float GAIN_TAU_S = 0.05f;      // Bumpless blend between gain sets
+    static constexpr float VELOCITY_TAU_S = 0.02f;
+    float rawVelocityDeg = 0.0f;  // Before the derivative chain, for priming it
+
+    float scheduleInput(GainSchedule::Key key) const;
+    void applySchedule(float dt);
+    void updatePID(float derivativeDeg);
+    float lqrFeedback(bool includeIntegral) const;
+    void seedLqrIntegral();
+    void updateLqr(float dt);
     void controlMotor();
 };
 
-// Declare global motor control instance
-extern ESP32MotorControl motorControl;
\ No newline at end of file
+// Declare global motor control and encoder instances
+extern ESP32MotorControl motorControl;
+extern TrackEncoder* trackEncoder;
+extern MotorPID motors[Board::NUM_JOINTS];
+
+// Motor configuration for joint J, unit conversions folded at compile time
+template <size_t J>
+constexpr MotorPID::Config motorConfigFor() {
+    using Joint = Board::Joint<J>;
+    return {int(J), Joint::config.in1, Joint::config.in2,
+            Joint::COUNTS_PER_DEG, Joint::DEG_PER_COUNT,
+            Joint::config.encoder, Joint::config.inverted,
+            Joint::config.minDeg, Joint::config.maxDeg};
+}
+
+template <size_t... J>
+void initMotors(std::index_sequence<J...>) {
+    (motors[J].init(motorConfigFor<J>()), ...);
+}
+
+// Initialize every joint in the board table
+inline void initMotors() {
+    initMotors(std::make_index_sequence<Board::NUM_JOINTS>{});
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "paramStore.h"
+#include "motorConfig.h"
+#include "controlTask.h"
+#include <esp_timer.h>
+
+Preferences ParamStore::prefs;
+ParamStore::Blob ParamStore::blob;
+bool ParamStore::nvsOk = false;
+bool ParamStore::fromNvs = false;
+uint8_t ParamStore::rejected = 0;
+uint32_t ParamStore::loadUs = 0;
+bool ParamStore::dirty = false;
+bool ParamStore::flushRequested = false;
+uint32_t ParamStore::firstChangeMs = 0;
+uint32_t ParamStore::lastChangeMs = 0;
+uint32_t ParamStore::changeCount = 0;
+uint32_t ParamStore::writeCount = 0;
+uint32_t ParamStore::selectCount = 0;
+
+static const char* const BLOB_KEY = "blob";
+static const char* const LEGACY_KEYS[] = {"blobA", "blobB"};  // Version 1 slots
+
+// Per joint: limits, gains, backlash, and per path at most every section or
+// the changed tail plus the OFF that shortens the chain
+static constexpr size_t MAX_BATCH = Board::NUM_JOINTS * (3 + MotorPID::FILTER_PATHS * MotorPID::FILTER_SECTIONS);
+static_assert(MAX_BATCH <= ControlTask::COMMAND_SLOTS, "A profile switch must fit the command ring");
+
+void ParamStore::begin() {
+    int64_t start = esp_timer_get_time();
+    nvsOk = prefs.begin("params", false);
+    fromNvs = nvsOk && load();
+    if (!fromNvs) loadDefaults();
+    loadUs = (uint32_t)(esp_timer_get_time() - start);
+
+    if (!nvsOk) {
+        Serial.println("NVS unavailable, parameters use compiled-in defaults and are not saved");
+    }
+    applyDirect();
+}
+
+bool ParamStore::load() {
+    // Version 1 layouts are not read back; drop them rather than keep the flash
+    for (const char* key : LEGACY_KEYS) {
+        if (prefs.isKey(key)) {
+            prefs.remove(key);
+            rejected++;
+        }
+    }
+
+    // A blob of another size is another version; only an empty key is not a rejection
+    size_t length = prefs.getBytesLength(BLOB_KEY);
+    if (length == 0) return false;
+    if (length != sizeof(Blob) || prefs.getBytes(BLOB_KEY, &blob, sizeof(Blob)) != sizeof(Blob) || !valid(blob)) {
+        rejected++;
+        return false;
+    }
+    return true;
+}
+
+bool ParamStore::valid(const Blob& b) {
+    return b.magic == MAGIC && b.version == VERSION && b.size == sizeof(Blob) && b.active < MAX_PROFILES;
+}
+
+// Every profile starts as the compiled-in gains, the board limits, no backlash model and no filters
+void ParamStore::loadDefaults() {
+    memset(&blob, 0, sizeof(blob));
+    blob.magic = MAGIC;
+    blob.version = VERSION;
+    blob.size = sizeof(Blob);
+    for (size_t p = 0; p < MAX_PROFILES; p++) {
+        Profile& profile = blob.profiles[p];
+        if (p == 0) {
+            strncpy(profile.name, "default", NAME_LENGTH - 1);
+        } else {
+            snprintf(profile.name, NAME_LENGTH, "p%u", (unsigned)(p + 1));
+        }
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            const MotorPID& m = motors[j];
+            profile.joints[j] = {m.Kp, m.Ki, m.Kd, m.config().minDeg, m.config().maxDeg,
+                                 m.backlash.params.widthDeg, m.backlash.params.complianceDegPerPct, {}};
+        }
+    }
+    fromNvs = false;
+}
+
+// Boot only, before the control task owns the controllers
+void ParamStore::applyDirect() {
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const JointParams& p = active().joints[j];
+        MotorPID& m = motors[j];
+        m.Kp = p.kp;
+        m.Ki = p.ki;
+        m.Kd = p.kd;
+        m.setLimits(p.minDeg, p.maxDeg);
+        m.backlash.params.widthDeg = p.backlashWidthDeg;
+        m.backlash.params.complianceDegPerPct = p.complianceDegPerPct;
+        for (size_t path = 0; path < MotorPID::FILTER_PATHS; path++) {
+            m.filters[path].clear();
+            for (size_t i = 0; i < chainLength(p.filters[path]); i++) {
+                const FilterSpec& f = p.filters[path][i];
+                m.setFilter((MotorPID::FilterPath)path, i, (Biquad::Type)f.type, f.f1, f.f2OrQ);
+            }
+        }
+    }
+}
+
+size_t ParamStore::chainLength(const FilterSpec* chain) {
+    size_t n = 0;
+    while (n < MotorPID::FILTER_SECTIONS && chain[n].type != Biquad::OFF) n++;
+    return n;
+}
+
+ParamStore::JointParams* ParamStore::activeJoint(size_t joint) {
+    return joint < Board::NUM_JOINTS ? &blob.profiles[blob.active].joints[joint] : nullptr;
+}
+
+void ParamStore::markDirty() {
+    uint32_t now = millis();
+    if (!dirty) firstChangeMs = now;
+    lastChangeMs = now;
+    dirty = true;
+    changeCount++;
+}
+
+void ParamStore::noteGains(size_t joint, float kp, float ki, float kd) {
+    JointParams* p = activeJoint(joint);
+    if (!p || (p->kp == kp && p->ki == ki && p->kd == kd)) return;
+    p->kp = kp;
+    p->ki = ki;
+    p->kd = kd;
+    markDirty();
+}
+
+void ParamStore::noteBacklash(size_t joint, float widthDeg, float complianceDegPerPct) {
+    JointParams* p = activeJoint(joint);
+    if (!p || (p->backlashWidthDeg == widthDeg && p->complianceDegPerPct == complianceDegPerPct)) return;
+    p->backlashWidthDeg = widthDeg;
+    p->complianceDegPerPct = complianceDegPerPct;
+    markDirty();
+}
+
+void ParamStore::noteLimits(size_t joint, float minDeg, float maxDeg) {
+    JointParams* p = activeJoint(joint);
+    if (!p || (p->minDeg == minDeg && p->maxDeg == maxDeg)) return;
+    p->minDeg = minDeg;
+    p->maxDeg = maxDeg;
+    markDirty();
+}
+
+// Mirrors BiquadChain::set: OFF drops the section and those after it, and
+// a section past the end of the chain is refused there too
+void ParamStore::noteFilter(size_t joint, size_t path, size_t section, uint8_t type, float f1, float f2OrQ) {
+    JointParams* p = activeJoint(joint);
+    if (!p || path >= MotorPID::FILTER_PATHS || section >= MotorPID::FILTER_SECTIONS) return;
+    FilterSpec* chain = p->filters[path];
+    if (section > chainLength(chain)) return;
+    if (type == Biquad::OFF) {
+        if (chain[section].type == Biquad::OFF) return;
+        memset(&chain[section], 0, (MotorPID::FILTER_SECTIONS - section) * sizeof(FilterSpec));
+    } else {
+        FilterSpec& f = chain[section];
+        if (f.type == type && f.f1 == f1 && f.f2OrQ == f2OrQ) return;
+        f = {type, {}, f1, f2OrQ};
+    }
+    markDirty();
+}
+
+// Filter commands that turn chain from into chain to: every section from the
+// first that differs, then an OFF if the old chain ran longer
+size_t ParamStore::filterCommands(uint8_t joint, size_t path, const FilterSpec* from, const FilterSpec* to,
+                                  ControlCommand* out) {
+    size_t fromLength = chainLength(from), toLength = chainLength(to);
+    size_t first = 0;
+    while (first < toLength && first < fromLength && from[first].type == to[first].type
+           && from[first].f1 == to[first].f1 && from[first].f2OrQ == to[first].f2OrQ) {
+        first++;
+    }
+    size_t n = 0;
+    for (size_t i = first; i < toLength; i++) {
+        float code = (float)(path * 8 + to[i].type);
+        out[n++] = {ControlCommand::Type::Filter, (uint8_t)(joint | i << 4), {code, to[i].f1, to[i].f2OrQ}};
+    }
+    if (fromLength > toLength) {
+        float code = (float)(path * 8 + Biquad::OFF);
+        out[n++] = {ControlCommand::Type::Filter, (uint8_t)(joint | toLength << 4), {code, 0.0f, 0.0f}};
+    }
+    return n;
+}
+
+// Three commands per joint and the filter changes, queued as one batch so the control task applies
+// the whole profile between two ticks or, with the ring too full, none of it.
+// Limits go first so a narrower range is in place before gains meant for it.
+bool ParamStore::select(uint8_t profile) {
+    if (profile >= MAX_PROFILES) return false;
+    const Profile& next = blob.profiles[profile];
+    ControlCommand batch[MAX_BATCH] = {};
+    size_t n = 0;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const JointParams& p = next.joints[j];
+        uint8_t joint = (uint8_t)j;
+        batch[n++] = {ControlCommand::Type::Limits, joint, {p.minDeg, p.maxDeg}};
+        batch[n++] = {ControlCommand::Type::Gains, joint, {p.kp, p.ki, p.kd}};
+        batch[n++] = {ControlCommand::Type::Backlash, joint, {p.backlashWidthDeg, p.complianceDegPerPct}};
+        for (size_t path = 0; path < MotorPID::FILTER_PATHS; path++) {
+            n += filterCommands(joint, path, active().joints[j].filters[path], p.filters[path], &batch[n]);
+        }
+    }
+    if (!ControlTask::send(batch, n)) return false;
+
+    if (blob.active != profile) {
+        blob.active = profile;
+        markDirty();
+    }
+    selectCount++;
+    return true;
+}
+
+bool ParamStore::copyActive(uint8_t profile, const char* name) {
+    if (profile >= MAX_PROFILES || name[0] == '\0') return false;
+    Profile& target = blob.profiles[profile];
+    if (profile != blob.active) target = active();
+    memset(target.name, 0, NAME_LENGTH);
+    strncpy(target.name, name, NAME_LENGTH - 1);
+    markDirty();
+    return true;
+}
+
+void ParamStore::service() {
+    if (!dirty || !nvsOk) return;
+    uint32_t now = millis();
+    bool quiet = now - lastChangeMs >= COALESCE_MS;
+    bool overdue = now - firstChangeMs >= MAX_DEFER_MS;
+    if (!quiet && !overdue && !flushRequested) return;
+
+    // A failed put leaves the previous blob in place
+    blob.sequence++;
+    if (prefs.putBytes(BLOB_KEY, &blob, sizeof(Blob)) == sizeof(Blob)) {
+        fromNvs = true;
+        writeCount++;
+        dirty = false;
+    } else {
+        blob.sequence--;
+        lastChangeMs = now;  // Retry after another quiet period
+    }
+    flushRequested = false;
+}
+
+void ParamStore::report(Print& out) {
+    out.printf("PRM active=%u name=%s seq=%u source=%s rejected=%u nvs=%s dirty=%u "
+               "changes=%u writes=%u load_us=%u\n",
+               (unsigned)blob.active, active().name, (unsigned)blob.sequence,
+               fromNvs ? "nvs" : "defaults", (unsigned)rejected,
+               nvsOk ? "ok" : "fail", dirty ? 1u : 0u, (unsigned)changeCount,
+               (unsigned)writeCount, (unsigned)loadUs);
+    for (size_t p = 0; p < MAX_PROFILES; p++) {
+        out.printf("PROF %u name=%s\n", (unsigned)p, blob.profiles[p].name);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "boardConfig.h"
+#include "motorConfig.h"
+
+struct ControlCommand;
+
+// Named parameter profiles kept as one versioned blob under a single NVS key.
+// NVS already makes a put atomic per key and checks every entry with its own
+// CRC, so a write torn by a reset leaves the previous blob readable; a blob
+// whose header or size does not match this build falls back to the
+// compiled-in defaults. Edits land in the RAM copy and are written by
+// service() once they have been quiet for COALESCE_MS, so a slider dragged
+// in the tuning GUI costs one flash write rather than hundreds.
+//
+// Everything here runs on the comms side; the control task only sees the
+// Limits, Gains, Backlash and Filter commands a profile switch sends as one
+// batch. Filter chains are sent as the sections that differ from the
+// profile being left, so a whole switch fits the command ring.
+class ParamStore {
+public:
+    static constexpr uint32_t MAGIC = 0x534D5250;  // "PRMS"
+    static constexpr uint16_t VERSION = 3;  // 2 had no filter chains, 1 kept alternate A/B slots with a CRC
+    static constexpr size_t MAX_PROFILES = 4;
+    static constexpr size_t NAME_LENGTH = 12;      // Including the terminator
+    static constexpr uint32_t COALESCE_MS = 1000;  // Quiet time before a write
+    static constexpr uint32_t MAX_DEFER_MS = 10000; // Upper bound under continuous edits
+
+    // One biquad section as flt sets it; the first OFF ends the chain
+    struct FilterSpec {
+        uint8_t type;
+        uint8_t reserved[3];
+        float f1, f2OrQ;
+    };
+
+    struct JointParams {
+        float kp, ki, kd;
+        float minDeg, maxDeg;
+        float backlashWidthDeg, complianceDegPerPct;
+        FilterSpec filters[MotorPID::FILTER_PATHS][MotorPID::FILTER_SECTIONS];
+    };
+
+    struct Profile {
+        char name[NAME_LENGTH];
+        JointParams joints[Board::NUM_JOINTS];
+    };
+
+    // Called from setup() before the control task starts: loads the blob and
+    // writes the active profile straight into the controllers
+    static void begin();
+
+    // Comms side
+    static void noteGains(size_t joint, float kp, float ki, float kd);
+    static void noteBacklash(size_t joint, float widthDeg, float complianceDegPerPct);
+    static void noteLimits(size_t joint, float minDeg, float maxDeg);
+    static void noteFilter(size_t joint, size_t path, size_t section, uint8_t type, float f1, float f2OrQ);
+    static bool select(uint8_t profile);     // Sends the profile to the control task, all or nothing
+    static bool copyActive(uint8_t profile, const char* name);
+    static void flush() { flushRequested = true; }
+    static void service();                   // Coalesced background write, called from the comms loop
+
+    static const Profile& active() { return blob.profiles[blob.active]; }
+    static uint32_t generation() { return selectCount; }  // Changes when a profile is switched in
+
+    // Format: PRM active=<n> name=<s> seq=<n> source=<nvs|defaults> rejected=<n> nvs=<ok|fail>
+    //         dirty=<0|1> changes=<n> writes=<n> load_us=<us>
+    //         PROF <n> name=<s>   (one line per profile)
+    static void report(Print& out);
+    static size_t staticBytes() { return sizeof(blob) + sizeof(prefs); }
+
+private:
+    struct Blob {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size;
+        uint32_t sequence;
+        uint8_t active;
+        uint8_t reserved[3];
+        Profile profiles[MAX_PROFILES];
+    };
+
+    static Preferences prefs;
+    static Blob blob;
+    static bool nvsOk;
+    static bool fromNvs;  // False when running on the defaults
+    static uint8_t rejected;
+    static uint32_t loadUs;
+    static bool dirty;
+    static bool flushRequested;
+    static uint32_t firstChangeMs, lastChangeMs;
+    static uint32_t changeCount, writeCount;
+    static uint32_t selectCount;
+
+    static void loadDefaults();
+    static bool load();
+    static bool valid(const Blob& b);
+    static void applyDirect();
+    static void markDirty();
+    static JointParams* activeJoint(size_t joint);
+    static size_t chainLength(const FilterSpec* chain);
+    static size_t filterCommands(uint8_t joint, size_t path, const FilterSpec* from, const FilterSpec* to,
+                                 ControlCommand* out);
+};
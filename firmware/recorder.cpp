@@ -0,0 +1,487 @@
+#include "recorder.h"
+#include "esp_timer.h"
+#include <utility>
+
+std::atomic<Recorder::Mode> Recorder::state{Recorder::Mode::Idle};
+uint8_t Recorder::log[LOG_BYTES];
+size_t Recorder::length = 0;
+bool Recorder::truncated = false;
+uint32_t Recorder::tickCount = 0;
+uint32_t Recorder::commandCount = 0;
+Print* Recorder::output = nullptr;
+size_t Recorder::cursor = 0;
+
+int64_t Recorder::lastUs = 0;
+int64_t Recorder::seenCounts[Board::NUM_JOINTS];
+int64_t Recorder::lastCounts[Board::NUM_JOINTS];
+int32_t Recorder::lastOutput[Board::NUM_JOINTS];
+float Recorder::lastSetpoint[Board::NUM_JOINTS];
+float Recorder::lastGains[Board::NUM_JOINTS][3];
+
+Recorder::Replay Recorder::replay;
+
+// Spare controllers for replay, same configuration as the live joints
+static MotorPID replayMotors[Board::NUM_JOINTS];
+static bool replayMotorsReady = false;
+
+// LQR rows in the replay set couple to each other, not to the live joints
+template <size_t... J>
+static void initReplayMotors(std::index_sequence<J...>) {
+    (replayMotors[J].init(motorConfigFor<J>(), replayMotors), ...);
+}
+
+template <typename T>
+static uint8_t* put(uint8_t* p, const T& value) {
+    memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+}
+
+static bool isIdle(Recorder::Mode m) {
+    return m == Recorder::Mode::Idle || m == Recorder::Mode::Stopped;
+}
+
+static const char* modeName(Recorder::Mode m) {
+    switch (m) {
+        case Recorder::Mode::Idle:      return "idle";
+        case Recorder::Mode::Armed:     return "armed";
+        case Recorder::Mode::Recording: return "recording";
+        case Recorder::Mode::Stopping:  return "stopping";
+        case Recorder::Mode::Stopped:   return "stopped";
+        case Recorder::Mode::Dumping:   return "dumping";
+        case Recorder::Mode::Replaying: return "replaying";
+    }
+    return "?";
+}
+
+size_t Recorder::staticBytes() {
+    return sizeof(log) + sizeof(replayMotors) + sizeof(replay);
+}
+
+bool Recorder::start() {
+    if (!isIdle(mode())) return false;
+    length = 0;
+    truncated = false;
+    tickCount = 0;
+    commandCount = 0;
+    state.store(Mode::Armed, std::memory_order_release);
+    return true;
+}
+
+bool Recorder::stop() {
+    Mode expected = Mode::Armed;
+    if (state.compare_exchange_strong(expected, Mode::Idle)) return true;
+    expected = Mode::Recording;
+    if (state.compare_exchange_strong(expected, Mode::Stopping)) return true;
+    return expected == Mode::Stopping || expected == Mode::Stopped;
+}
+
+bool Recorder::clear() {
+    if (!isIdle(mode())) return false;
+    length = 0;
+    truncated = false;
+    tickCount = 0;
+    commandCount = 0;
+    state.store(Mode::Idle, std::memory_order_release);
+    return true;
+}
+
+// Host upload, appended in order; counters are unknown until replayed
+bool Recorder::load(const uint8_t* data, size_t count) {
+    if (!isIdle(mode()) || length + count > LOG_BYTES) return false;
+    memcpy(log + length, data, count);
+    length += count;
+    state.store(Mode::Stopped, std::memory_order_release);
+    return true;
+}
+
+bool Recorder::startDump(Print& out) {
+    if (!isIdle(mode()) || length == 0) return false;
+    output = &out;
+    cursor = 0;
+    out.printf("REC BEGIN bytes=%u\n", (unsigned)length);
+    state.store(Mode::Dumping, std::memory_order_release);
+    return true;
+}
+
+bool Recorder::startReplay(Print& out) {
+    if (!isIdle(mode()) || length < MIN_HEADER_BYTES) return false;
+    if (!replayMotorsReady) {
+        initReplayMotors(std::make_index_sequence<Board::NUM_JOINTS>{});
+        replayMotorsReady = true;
+    }
+    output = &out;
+    if (!replayHeader()) {
+        out.println("ERR: Bad recording header");
+        return false;
+    }
+    state.store(Mode::Replaying, std::memory_order_release);
+    return true;
+}
+
+void Recorder::service() {
+    Mode m = mode();
+
+    if (m == Mode::Dumping) {
+        size_t end = min(length, cursor + DUMP_BYTES_PER_SERVICE);
+        output->printf("REC %04X ", (unsigned)cursor);
+        for (; cursor < end; cursor++) {
+            output->printf("%02X", log[cursor]);
+        }
+        output->println();
+        if (cursor >= length) {
+            output->println("REC END");
+            state.store(Mode::Stopped, std::memory_order_release);
+        }
+    } else if (m == Mode::Replaying) {
+        for (size_t i = 0; i < REPLAY_TICKS_PER_SERVICE; i++) {
+            if (replay.offset >= length || !replayRecord()) {
+                finishReplay();
+                break;
+            }
+        }
+    }
+}
+
+// Format: REC mode=<name> bytes=<used>/<capacity> ticks=<n> cmds=<n> full=<0|1>
+void Recorder::report(Print& out) {
+    out.printf("REC mode=%s bytes=%u/%u ticks=%u cmds=%u full=%d\n", modeName(mode()),
+               (unsigned)length, (unsigned)LOG_BYTES, (unsigned)tickCount,
+               (unsigned)commandCount, truncated ? 1 : 0);
+}
+
+void Recorder::beginTick() {
+    Mode m = mode();
+    if (m == Mode::Armed) {
+        // Wait for the controllers' first sample so dt is defined from the start
+        if (!motors[0].sampled()) return;
+        writeHeader();
+        Mode expected = Mode::Armed;
+        state.compare_exchange_strong(expected, Mode::Recording);
+    } else if (m == Mode::Stopping) {
+        state.store(Mode::Stopped, std::memory_order_release);
+    }
+}
+
+void Recorder::writeHeader() {
+    uint8_t* p = log;
+    memcpy(p, "RPLY", 4);
+    p[4] = VERSION;
+    p[5] = Board::NUM_JOINTS;
+    uint32_t period = Board::CONTROL_PERIOD_US;
+    memcpy(p + 6, &period, 4);
+    p += 10;
+
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        MotorPID::Checkpoint cp = motors[j].checkpoint();
+        int32_t counts = (int32_t)seenCounts[j];
+        float values[9] = {cp.input, cp.output, cp.outputSum, cp.velocityDeg, cp.rawVelocityDeg,
+                           cp.setpoint, cp.kp, cp.ki, cp.kd};
+        p = put(p, counts);
+        p = put(p, values);
+        *p++ = cp.halted ? 1 : 0;
+        *p++ = (uint8_t)cp.controller;
+        p = put(p, cp.lqr);
+        p = put(p, cp.lqrGains);
+        for (const auto& chain : cp.filters) {
+            *p++ = (uint8_t)chain.size();
+            for (size_t i = 0; i < chain.size(); i++) {
+                const auto& spec = chain.spec(i);
+                const Biquad& s = chain.section(i);
+                float section[9] = {spec.f1, spec.f2OrQ, s.b0, s.b1, s.b2, s.a1, s.a2, s.z1, s.z2};
+                *p++ = (uint8_t)spec.type;
+                p = put(p, section);
+            }
+        }
+
+        lastCounts[j] = counts;
+        lastOutput[j] = 0;
+        lastSetpoint[j] = cp.setpoint;
+        lastGains[j][0] = cp.kp;
+        lastGains[j][1] = cp.ki;
+        lastGains[j][2] = cp.kd;
+        if (j == 0) lastUs = cp.sampleUs;
+    }
+    length = p - log;
+}
+
+void Recorder::recordCommand(const ControlCommand& cmd) {
+    if (mode() != Mode::Recording) return;
+    if (length + MAX_COMMAND_BYTES > LOG_BYTES) {
+        truncated = true;
+        return;
+    }
+
+    uint8_t* p = log + length;
+    *p++ = TAG_COMMAND;
+    p += putVarint(p, tickCount);  // Applied just before this recorded tick
+    *p++ = (uint8_t)cmd.type;
+    *p++ = cmd.joint;
+    memcpy(p, cmd.value, sizeof(cmd.value));
+    p += sizeof(cmd.value);
+    length = p - log;
+    commandCount++;
+}
+
+void Recorder::recordTick(const TrackEncoder::Snapshot& snap, bool tripped) {
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        seenCounts[j] = snap.counts[motors[j].config().encoderIndex];
+    }
+    if (mode() != Mode::Recording) return;
+    if (length + MAX_TICK_BYTES > LOG_BYTES) {
+        truncated = true;
+        Mode expected = Mode::Recording;
+        state.compare_exchange_strong(expected, Mode::Stopped);
+        return;
+    }
+
+    uint8_t* p = log + length;
+    *p++ = TAG_TICK;
+    uint8_t* flags = p++;
+    *flags = tripped ? FLAG_TRIPPED : 0;
+    uint8_t halted = 0;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        if (motors[j].isHalted()) halted |= 1 << j;
+    }
+    *p++ = halted;
+    p += putVarint(p, (uint32_t)(snap.timestampUs - lastUs));
+    lastUs = snap.timestampUs;
+
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const MotorPID& m = motors[j];
+        int64_t counts = snap.counts[m.config().encoderIndex];
+        int32_t out = quantizeOutput(m.Output);
+        p += putVarint(p, zigzag((int32_t)(counts - lastCounts[j])));
+        p += putVarint(p, zigzag(out - lastOutput[j]));
+        lastCounts[j] = counts;
+        lastOutput[j] = out;
+    }
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        if (motors[j].Setpoint != lastSetpoint[j]) {
+            lastSetpoint[j] = motors[j].Setpoint;
+            memcpy(p, &lastSetpoint[j], 4);
+            p += 4;
+            *flags |= 1 << j;
+        }
+    }
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const MotorPID& m = motors[j];
+        if (m.Kp != lastGains[j][0] || m.Ki != lastGains[j][1] || m.Kd != lastGains[j][2]) {
+            lastGains[j][0] = m.Kp;
+            lastGains[j][1] = m.Ki;
+            lastGains[j][2] = m.Kd;
+            memcpy(p, lastGains[j], 12);
+            p += 12;
+            *flags |= 1 << (3 + j);
+        }
+    }
+    length = p - log;
+    tickCount++;
+}
+
+bool Recorder::replayHeader() {
+    if (memcmp(log, "RPLY", 4) != 0 || log[4] != VERSION || log[5] != Board::NUM_JOINTS) {
+        return false;
+    }
+
+    replay = {};
+    replay.offset = 10;
+    replay.timeUs = REPLAY_BASE_US;
+    replay.firstDivergentTick = -1;
+    replay.minTickUs = UINT32_MAX;
+
+    // Parsed one joint at a time, a checkpoint is large for the comms stack
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        static MotorPID::Checkpoint cp;
+        int32_t counts;
+        if (!replayJoint(cp, counts)) return false;
+        cp.sampleUs = REPLAY_BASE_US;
+        replay.counts[j] = counts;
+        replayMotors[j].restore(cp);
+    }
+    return true;
+}
+
+bool Recorder::replayJoint(MotorPID::Checkpoint& cp, int32_t& counts) {
+    size_t& at = replay.offset;
+    if (at + MIN_JOINT_BYTES > length) return false;
+    float values[9];
+    memcpy(&counts, log + at, 4);
+    memcpy(values, log + at + 4, sizeof(values));
+    at += 4 + sizeof(values);
+    cp.input = values[0];
+    cp.output = values[1];
+    cp.outputSum = values[2];
+    cp.velocityDeg = values[3];
+    cp.rawVelocityDeg = values[4];
+    cp.setpoint = values[5];
+    cp.kp = values[6];
+    cp.ki = values[7];
+    cp.kd = values[8];
+    cp.halted = log[at++] != 0;
+    uint8_t controller = log[at++];
+    if (controller > (uint8_t)MotorPID::Controller::Lqr) return false;
+    cp.controller = (MotorPID::Controller)controller;
+    memcpy(&cp.lqr, log + at, sizeof(cp.lqr));
+    at += sizeof(cp.lqr);
+    memcpy(cp.lqrGains, log + at, sizeof(cp.lqrGains));
+    at += sizeof(cp.lqrGains);
+
+    for (auto& chain : cp.filters) {
+        chain.clear();
+        if (at >= length) return false;
+        uint8_t sections = log[at++];
+        if (sections > MotorPID::FILTER_SECTIONS || at + sections * SECTION_BYTES > length) return false;
+        for (uint8_t i = 0; i < sections; i++) {
+            uint8_t type = log[at++];
+            float v[9];
+            memcpy(v, log + at, sizeof(v));
+            at += sizeof(v);
+            Biquad section;
+            section.b0 = v[2];
+            section.b1 = v[3];
+            section.b2 = v[4];
+            section.a1 = v[5];
+            section.a2 = v[6];
+            section.z1 = v[7];
+            section.z2 = v[8];
+            if (type >= Biquad::TYPE_COUNT || !chain.restore({(Biquad::Type)type, v[0], v[1]}, section)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// One record; false at a malformed or cut-off record
+bool Recorder::replayRecord() {
+    uint8_t tag = log[replay.offset++];
+    uint32_t v;
+
+    if (tag == TAG_COMMAND) {
+        // Setpoints and gains come from the tick records; controller and
+        // filter changes are applied to the replay set as the tick did
+        if (!getVarint(replay.offset, v) || replay.offset + 14 > length) {
+            replay.corrupt = true;
+            return false;
+        }
+        ControlCommand cmd = {};
+        cmd.type = (ControlCommand::Type)log[replay.offset];
+        cmd.joint = log[replay.offset + 1];
+        memcpy(cmd.value, log + replay.offset + 2, sizeof(cmd.value));
+        ControlTask::applyControllerCommand(replayMotors, cmd);
+        replay.offset += 14;
+        replay.commands++;
+        return true;
+    }
+    if (tag != TAG_TICK || replay.offset >= length) {
+        replay.corrupt = true;
+        return false;
+    }
+
+    if (replay.offset + 2 > length) {
+        replay.corrupt = true;
+        return false;
+    }
+    uint8_t flags = log[replay.offset++];
+    uint8_t halted = log[replay.offset++];
+    if (!getVarint(replay.offset, v)) {
+        replay.corrupt = true;
+        return false;
+    }
+    replay.timeUs += v;
+
+    TrackEncoder::Snapshot snap = {};
+    snap.timestampUs = replay.timeUs;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        uint32_t countDelta, outputDelta;
+        if (!getVarint(replay.offset, countDelta) || !getVarint(replay.offset, outputDelta)) {
+            replay.corrupt = true;
+            return false;
+        }
+        replay.counts[j] += unzigzag(countDelta);
+        replay.recordedOutput[j] += unzigzag(outputDelta);
+        snap.counts[replayMotors[j].config().encoderIndex] = replay.counts[j];
+    }
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        if (!(flags & (1 << j))) continue;
+        if (replay.offset + 4 > length) {
+            replay.corrupt = true;
+            return false;
+        }
+        memcpy(&replayMotors[j].Setpoint, log + replay.offset, 4);
+        replay.offset += 4;
+    }
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        if (!(flags & (1 << (3 + j)))) continue;
+        if (replay.offset + 12 > length) {
+            replay.corrupt = true;
+            return false;
+        }
+        float gains[3];
+        memcpy(gains, log + replay.offset, 12);
+        replay.offset += 12;
+        replayMotors[j].Kp = gains[0];
+        replayMotors[j].Ki = gains[1];
+        replayMotors[j].Kd = gains[2];
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (auto& motor : replayMotors) motor.latchPeers();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        replayMotors[j].compute(snap, halted & (1 << j));
+    }
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    replay.minTickUs = min(replay.minTickUs, elapsed);
+    replay.maxTickUs = max(replay.maxTickUs, elapsed);
+    replay.totalTickUs += elapsed;
+
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        int32_t divergence = abs(quantizeOutput(replayMotors[j].Output) - replay.recordedOutput[j]);
+        if (divergence > replay.maxDivergence[j]) replay.maxDivergence[j] = divergence;
+        if (divergence > 0 && replay.firstDivergentTick < 0) replay.firstDivergentTick = replay.ticks;
+    }
+    replay.ticks++;
+    return true;
+}
+
+// Format: REPLAY ticks=<n> cmds=<n> first_div=<tick|-1> div1=<%> ... tick_us_min= mean= max= [corrupt=1]
+void Recorder::finishReplay() {
+    Print& out = *output;
+    out.printf("REPLAY ticks=%u cmds=%u first_div=%d", (unsigned)replay.ticks,
+               (unsigned)replay.commands, (int)replay.firstDivergentTick);
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        out.printf(" div%u=%.1f", (unsigned)(j + 1), replay.maxDivergence[j] * 0.1f);
+    }
+    if (replay.ticks > 0) {
+        out.printf(" tick_us_min=%u tick_us_mean=%u tick_us_max=%u", (unsigned)replay.minTickUs,
+                   (unsigned)(replay.totalTickUs / replay.ticks), (unsigned)replay.maxTickUs);
+    }
+    if (replay.corrupt) {
+        out.print(" corrupt=1");
+    }
+    out.println();
+
+    tickCount = replay.ticks;
+    commandCount = replay.commands;
+    state.store(Mode::Stopped, std::memory_order_release);
+}
+
+size_t Recorder::putVarint(uint8_t* p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+bool Recorder::getVarint(size_t& offset, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 35 && offset < length; shift += 7) {
+        uint8_t b = log[offset++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
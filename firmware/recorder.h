@@ -0,0 +1,116 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "boardConfig.h"
+#include "controlTask.h"
+#include "motorConfig.h"
+
+// Flight recorder for the control loop. While recording, every inbound
+// command and every tick's encoder latch, effective setpoint, gains, halt
+// state and output go into a static log. The log can be dumped over USB,
+// loaded back from the host, and replayed through MotorPID::compute on spare
+// controllers to check the run reproduces bit for bit.
+//
+// The header holds each joint's full MotorPID::Checkpoint, so replay starts
+// with the recorded controller, LQR state and filter chains. Controller, LQR
+// gain and filter commands are replayed as recorded; everything else that
+// runs ahead of compute (trajectories, schedules, backlash, limits) reaches
+// it through the recorded setpoints and gains.
+//
+// Log layout (little endian):
+//   header: "RPLY" | version | joints | period_us u32 | per joint:
+//           counts i32 | input, output, outputSum, velocityDeg, rawVelocityDeg,
+//           setpoint, kp, ki, kd (f32) | halted u8 | controller u8 |
+//           lqr error, velocity, integral (f32) | lqr gains joints x 3 f32 |
+//           per filter path: sections u8, per section: type u8,
+//           f1, f2OrQ, b0, b1, b2, a1, a2, z1, z2 (f32)
+//   tick:   0x01 | flags | halted | varint dt_us | per joint: zigzag count delta,
+//           zigzag output delta (0.1 %) | changed setpoints f32 | changed gains 3x f32
+//   cmd:    0x02 | varint tick | type | joint | 3x f32
+// flags: bit j = setpoint j changed, bit 3+j = gains j changed, bit 7 = tripped after the tick
+// halted: bit j = joint j's compute ran halted (tripped or parked)
+class Recorder {
+public:
+    static constexpr size_t LOG_BYTES = 32 * 1024;
+    static constexpr uint8_t VERSION = 2;
+    static constexpr uint8_t TAG_TICK = 0x01;
+    static constexpr uint8_t TAG_COMMAND = 0x02;
+    static constexpr uint8_t FLAG_TRIPPED = 0x80;
+    static_assert(Board::NUM_JOINTS <= 3, "Tick flags hold three joints");
+
+    enum class Mode : uint8_t { Idle, Armed, Recording, Stopping, Stopped, Dumping, Replaying };
+
+    // Comms side
+    static bool start();                    // Clears the log and records from the next tick
+    static bool stop();
+    static bool clear();                    // Empty log, ready for load()
+    static bool load(const uint8_t* data, size_t length);
+    static bool startDump(Print& out);
+    static bool startReplay(Print& out);
+    static void service();                  // Advances a dump or replay, called from the comms loop
+    static void report(Print& out);
+    static Mode mode() { return state.load(std::memory_order_acquire); }
+    static size_t staticBytes();
+
+    // Control task only
+    static void beginTick();
+    static void recordCommand(const ControlCommand& cmd);
+    static void recordTick(const TrackEncoder::Snapshot& snap, bool tripped);
+
+private:
+    static constexpr size_t SECTION_BYTES = 1 + 9 * 4;
+    static constexpr size_t MIN_JOINT_BYTES = 4 + 9 * 4 + 2 + 3 * 4 + Board::NUM_JOINTS * 12 + MotorPID::FILTER_PATHS;
+    static constexpr size_t MAX_JOINT_BYTES = MIN_JOINT_BYTES
+                                            + MotorPID::FILTER_PATHS * MotorPID::FILTER_SECTIONS * SECTION_BYTES;
+    static constexpr size_t MIN_HEADER_BYTES = 10 + Board::NUM_JOINTS * MIN_JOINT_BYTES;
+    static constexpr size_t MAX_TICK_BYTES = 8 + Board::NUM_JOINTS * 26;
+    static constexpr size_t MAX_COMMAND_BYTES = 20;
+    static constexpr size_t DUMP_BYTES_PER_SERVICE = 48;
+    static constexpr size_t REPLAY_TICKS_PER_SERVICE = 100;
+    static constexpr int64_t REPLAY_BASE_US = 1000000;  // Any non-zero start time
+
+    struct Replay {
+        size_t offset;
+        int64_t timeUs;
+        int64_t counts[Board::NUM_JOINTS];
+        int32_t recordedOutput[Board::NUM_JOINTS];
+        int32_t maxDivergence[Board::NUM_JOINTS];  // 0.1 %
+        uint32_t ticks;
+        uint32_t commands;
+        int32_t firstDivergentTick;
+        uint32_t minTickUs, maxTickUs;
+        uint64_t totalTickUs;
+        bool corrupt;
+    };
+
+    static std::atomic<Mode> state;
+    static uint8_t log[LOG_BYTES];
+    static size_t length;
+    static bool truncated;
+    static uint32_t tickCount;
+    static uint32_t commandCount;
+    static Print* output;
+    static size_t cursor;  // Dump position
+
+    // Last values written, for delta and change coding
+    static int64_t lastUs;
+    static int64_t seenCounts[Board::NUM_JOINTS];  // Every tick, the base a new header starts from
+    static int64_t lastCounts[Board::NUM_JOINTS];
+    static int32_t lastOutput[Board::NUM_JOINTS];
+    static float lastSetpoint[Board::NUM_JOINTS];
+    static float lastGains[Board::NUM_JOINTS][3];
+
+    static Replay replay;
+
+    static void writeHeader();
+    static bool replayHeader();
+    static bool replayJoint(MotorPID::Checkpoint& cp, int32_t& counts);
+    static bool replayRecord();
+    static void finishReplay();
+
+    static size_t putVarint(uint8_t* p, uint32_t v);
+    static bool getVarint(size_t& offset, uint32_t& v);
+    static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+    static int32_t quantizeOutput(float output) { return (int32_t)lroundf(output * 10.0f); }
+};
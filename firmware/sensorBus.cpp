@@ -0,0 +1,247 @@
+#include "sensorBus.h"
+#include <esp_timer.h>
+
+std::atomic<SensorBus::State> SensorBus::state{SensorBus::State::Off};
+SensorBus::Device SensorBus::devices[Board::NUM_SPI_DEVICES];
+WORD_ALIGNED_ATTR uint8_t SensorBus::frames[Board::NUM_SPI_DEVICES][2][MAX_FRAME];
+
+MahonyFilter SensorBus::filter;
+SensorBus::Orientation SensorBus::orientation[2];
+std::atomic<uint32_t> SensorBus::orientationSeq{0};
+int64_t SensorBus::lastImuUs = 0;
+uint32_t SensorBus::maxPollUs = 0;
+uint64_t SensorBus::totalPollUs = 0;
+uint32_t SensorBus::polls = 0;
+
+static constexpr spi_host_device_t SENSOR_HOST = SPI2_HOST;
+
+static constexpr size_t maxBurst() {
+    size_t longest = 0;
+    for (const auto& d : Board::SPI_DEVICES) longest = d.length > longest ? d.length : longest;
+    return longest;
+}
+static_assert(maxBurst() <= SensorBus::MAX_FRAME, "SPI burst longer than the frame buffer");
+
+void SensorBus::begin(bool enabled) {
+    if (SENSOR_FAKE) {
+        state.store(State::Fake, std::memory_order_release);
+        return;
+    }
+    if (!enabled) return;
+
+    spi_bus_config_t bus = {};
+    bus.mosi_io_num = Board::SPI_MOSI;
+    bus.miso_io_num = Board::SPI_MISO;
+    bus.sclk_io_num = Board::SPI_SCK;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = MAX_FRAME;
+    if (spi_bus_initialize(SENSOR_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK) {
+        state.store(State::Absent, std::memory_order_release);
+        return;
+    }
+
+    for (size_t d = 0; d < Board::NUM_SPI_DEVICES; d++) {
+        const Board::SpiDeviceConfig& cfg = Board::SPI_DEVICES[d];
+        spi_device_interface_config_t dev = {};
+        dev.address_bits = 8;  // Register address, read bit included
+        dev.mode = cfg.mode;
+        dev.clock_speed_hz = (int)cfg.clockHz;
+        dev.spics_io_num = cfg.cs;
+        dev.queue_size = 2;
+        dev.post_cb = transferDone;
+        if (spi_bus_add_device(SENSOR_HOST, &dev, &devices[d].handle) != ESP_OK) {
+            state.store(State::Absent, std::memory_order_release);
+            return;
+        }
+
+        for (int half = 0; half < 2; half++) {
+            spi_transaction_t& t = devices[d].transactions[half];
+            t = {};
+            t.addr = cfg.readRegister | READ_BIT;
+            t.length = cfg.length * 8;
+            t.rxlength = cfg.length * 8;
+            t.rx_buffer = frames[d][half];
+            t.user = (void*)(uintptr_t)d;
+        }
+    }
+
+    // Soft reset, identify, then gyro and accel at 1 kHz in low-noise mode
+    uint8_t id = 0;
+    writeRegister(IMU_DEVICE, REG_DEVICE_CONFIG, 0x01);
+    delay(2);
+    if (!readRegister(IMU_DEVICE, REG_WHO_AM_I, id) || id != WHO_AM_I) {
+        Serial.printf("IMU not found (WHO_AM_I 0x%02X)\n", id);
+        state.store(State::Absent, std::memory_order_release);
+        return;
+    }
+    writeRegister(IMU_DEVICE, REG_GYRO_CONFIG0, 0x06);
+    writeRegister(IMU_DEVICE, REG_ACCEL_CONFIG0, 0x06);
+    writeRegister(IMU_DEVICE, REG_PWR_MGMT0, 0x0F);
+    delay(1);
+    state.store(State::Running, std::memory_order_release);
+}
+
+bool SensorBus::writeRegister(uint8_t device, uint8_t reg, uint8_t value) {
+    spi_transaction_t t = {};
+    t.addr = reg;
+    t.length = 8;
+    t.flags = SPI_TRANS_USE_TXDATA;
+    t.tx_data[0] = value;
+    return spi_device_polling_transmit(devices[device].handle, &t) == ESP_OK;
+}
+
+bool SensorBus::readRegister(uint8_t device, uint8_t reg, uint8_t& value) {
+    spi_transaction_t t = {};
+    t.addr = reg | READ_BIT;
+    t.length = 8;
+    t.rxlength = 8;
+    t.flags = SPI_TRANS_USE_RXDATA;
+    if (spi_device_polling_transmit(devices[device].handle, &t) != ESP_OK) return false;
+    value = t.rx_data[0];
+    return true;
+}
+
+// Runs in the SPI interrupt on the comms core
+void IRAM_ATTR SensorBus::transferDone(spi_transaction_t* t) {
+    devices[(uintptr_t)t->user].completedUs = esp_timer_get_time();
+}
+
+bool SensorBus::queue(size_t device, int64_t nowUs) {
+    Device& d = devices[device];
+    d.current ^= 1;
+    d.queuedUs = nowUs;
+    if (SENSOR_FAKE) {
+        fakeImu(device, nowUs);
+    } else if (spi_device_queue_trans(d.handle, &d.transactions[d.current], 0) != ESP_OK) {
+        return false;
+    }
+    d.inFlight = true;
+    return true;
+}
+
+void SensorBus::poll() {
+    State s = state.load(std::memory_order_acquire);
+    if (s != State::Running && s != State::Fake) return;
+
+    int64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < Board::NUM_SPI_DEVICES; i++) {
+        Device& d = devices[i];
+        bool completed = false;
+        if (d.inFlight) {
+            spi_transaction_t* done = nullptr;
+            completed = SENSOR_FAKE || spi_device_get_trans_result(d.handle, &done, 0) == ESP_OK;
+            if (!completed) {
+                d.misses++;
+                continue;  // Still on the bus, keep the last sample
+            }
+            d.inFlight = false;
+            d.frames++;
+            d.lastTransferUs = (uint32_t)(d.completedUs - d.queuedUs);
+        }
+
+        // Next burst into the other half, then decode the finished one
+        uint8_t finished = d.current;
+        int64_t completedUs = d.completedUs;
+        queue(i, start);
+        if (completed) {
+            d.published.store(finished + 1u, std::memory_order_release);
+            if (i == IMU_DEVICE) decodeImu(frames[i][finished], completedUs);
+        }
+    }
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (elapsed > maxPollUs) maxPollUs = elapsed;
+    totalPollUs += elapsed;
+    polls++;
+}
+
+static int16_t bigEndian(const uint8_t* p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+void SensorBus::decodeImu(const uint8_t* frame, int64_t completedUs) {
+    // Temperature, accel x y z, gyro x y z
+    float ax = bigEndian(frame + 2) / ACCEL_LSB_PER_G;
+    float ay = bigEndian(frame + 4) / ACCEL_LSB_PER_G;
+    float az = bigEndian(frame + 6) / ACCEL_LSB_PER_G;
+    float gx = bigEndian(frame + 8) / GYRO_LSB_PER_DPS;
+    float gy = bigEndian(frame + 10) / GYRO_LSB_PER_DPS;
+    float gz = bigEndian(frame + 12) / GYRO_LSB_PER_DPS;
+
+    float dt = lastImuUs != 0 ? (completedUs - lastImuUs) * 1e-6f : 0.0f;
+    lastImuUs = completedUs;
+    filter.update(radians(gx), radians(gy), radians(gz), ax, ay, az, dt);
+
+    // Write the slot readers are not on, then flip
+    uint32_t seq = orientationSeq.load(std::memory_order_relaxed) + 1;
+    Orientation& o = orientation[seq & 1];
+    filter.quaternion(o.q);
+    filter.euler(o.rollDeg, o.pitchDeg, o.yawDeg);
+    o.gyroDps[0] = gx;
+    o.gyroDps[1] = gy;
+    o.gyroDps[2] = gz;
+    o.timestampUs = completedUs;
+    orientationSeq.store(seq, std::memory_order_release);
+}
+
+// Synthetic burst with the ICM-42688-P layout, timed as the real transfer would be
+void SensorBus::fakeImu(size_t device, int64_t nowUs) {
+    static constexpr float ROLL_RAD = 10.0f * DEG_TO_RAD;
+    static constexpr float YAW_RATE_DPS = 30.0f;
+    const Board::SpiDeviceConfig& cfg = Board::SPI_DEVICES[device];
+    Device& d = devices[device];
+    uint8_t* frame = frames[device][d.current];
+
+    int16_t values[7] = {
+        0,
+        0, (int16_t)(sinf(ROLL_RAD) * ACCEL_LSB_PER_G), (int16_t)(cosf(ROLL_RAD) * ACCEL_LSB_PER_G),
+        0, (int16_t)(sinf(ROLL_RAD) * YAW_RATE_DPS * GYRO_LSB_PER_DPS),
+        (int16_t)(cosf(ROLL_RAD) * YAW_RATE_DPS * GYRO_LSB_PER_DPS),
+    };
+    for (size_t i = 0; i < 7 && 2 * i + 1 < cfg.length; i++) {
+        frame[2 * i] = (uint8_t)(values[i] >> 8);
+        frame[2 * i + 1] = (uint8_t)values[i];
+    }
+    // Address byte plus burst on the wire, and about 10 us of driver overhead
+    d.completedUs = nowUs + 10 + (int64_t)(cfg.length + 1) * 8 * 1000000 / cfg.clockHz;
+}
+
+bool SensorBus::latest(Orientation& out) {
+    // A copy is good if the writer did not come back round to this slot meanwhile
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint32_t seq = orientationSeq.load(std::memory_order_acquire);
+        if (seq == 0) return false;
+        out = orientation[seq & 1];
+        if (orientationSeq.load(std::memory_order_acquire) - seq < 2) return true;
+    }
+    return false;
+}
+
+// The DMA refills this half two ticks after it was published; copy promptly
+size_t SensorBus::latestFrame(size_t device, uint8_t* out) {
+    if (device >= Board::NUM_SPI_DEVICES) return 0;
+    uint32_t half = devices[device].published.load(std::memory_order_acquire);
+    if (half == 0) return 0;
+    size_t length = Board::SPI_DEVICES[device].length;
+    memcpy(out, frames[device][half - 1], length);
+    return length;
+}
+
+void SensorBus::report(Print& out) {
+    static const char* const STATE_NAMES[] = {"off", "fake", "absent", "ok"};
+    const Device& imu = devices[IMU_DEVICE];
+    Orientation o = {};
+    bool have = latest(o);
+    out.printf("IMU state=%s samples=%u misses=%u xfer_us=%u age_us=%lld poll_us_max=%u "
+               "poll_us_mean=%u roll=%.2f pitch=%.2f yaw=%.2f\n",
+               STATE_NAMES[(int)state.load()], (unsigned)imu.frames, (unsigned)imu.misses,
+               (unsigned)imu.lastTransferUs,
+               have ? (long long)(esp_timer_get_time() - o.timestampUs) : -1LL,
+               (unsigned)maxPollUs, polls ? (unsigned)(totalPollUs / polls) : 0u,
+               o.rollDeg, o.pitchDeg, o.yawDeg);
+}
+
+size_t SensorBus::staticBytes() {
+    return sizeof(devices) + sizeof(frames) + sizeof(filter) + sizeof(orientation);
+}
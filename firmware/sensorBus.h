@@ -0,0 +1,97 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <driver/spi_master.h>
+#include "boardConfig.h"
+#include "mahonyFilter.h"
+
+// Set to 1 to run the pipeline on a synthetic IMU with no bus traffic: a head
+// rolled 10 deg turning at 30 deg/s. Shows poll cost and filter behaviour on
+// a board without the sensor fitted
+#ifndef SENSOR_FAKE
+#define SENSOR_FAKE 0
+#endif
+
+// SPI sensors read by DMA, paced by the control tick. Each tick poll()
+// collects the burst queued on the previous tick, queues the next one into
+// the other half of the device's double buffer, then decodes the finished
+// half while the DMA fills the new one. The control task never waits on the
+// bus: a burst still in flight just counts a miss and the last sample stands.
+// The bus and its interrupt live on the comms core.
+//
+// Device 0 is the head IMU (ICM-42688-P); its samples feed a Mahony filter
+// whose orientation the comms side reads with latest().
+class SensorBus {
+public:
+    static constexpr size_t MAX_FRAME = 32;
+    static constexpr uint8_t IMU_DEVICE = 0;
+    static_assert(Board::NUM_SPI_DEVICES <= 3, "Three chip selects in the pin map");
+
+    enum class State : uint8_t { Off, Fake, Absent, Running };
+
+    struct Orientation {
+        float q[4];
+        float rollDeg, pitchDeg, yawDeg;
+        float gyroDps[3];
+        int64_t timestampUs;  // Burst completion
+    };
+
+    // Comms side, from deferred init; blocking register set-up. Host tests
+    // pass true to run the bus on this board, where SCK and MOSI are an encoder's
+    static void begin(bool enabled = Board::SPI_SENSORS_ENABLED);
+    static bool latest(Orientation& out);
+    // Copy of a device's last burst, returns its length (0 before the first)
+    static size_t latestFrame(size_t device, uint8_t* out);
+
+    // Control task, once per tick
+    static void poll();
+
+    // Format: IMU state=<off|fake|absent|ok> samples=<n> misses=<n> xfer_us=<us>
+    //         age_us=<us> poll_us_max=<us> poll_us_mean=<us> roll=<deg> pitch=<deg> yaw=<deg>
+    static void report(Print& out);
+    static size_t staticBytes();
+
+private:
+    // ICM-42688-P
+    static constexpr uint8_t REG_DEVICE_CONFIG = 0x11;
+    static constexpr uint8_t REG_PWR_MGMT0 = 0x4E;
+    static constexpr uint8_t REG_GYRO_CONFIG0 = 0x4F;
+    static constexpr uint8_t REG_ACCEL_CONFIG0 = 0x50;
+    static constexpr uint8_t REG_WHO_AM_I = 0x75;
+    static constexpr uint8_t WHO_AM_I = 0x47;
+    static constexpr uint8_t READ_BIT = 0x80;
+    static constexpr float ACCEL_LSB_PER_G = 2048.0f;  // +/-16 g
+    static constexpr float GYRO_LSB_PER_DPS = 16.4f;   // +/-2000 deg/s
+
+    struct Device {
+        spi_device_handle_t handle;
+        spi_transaction_t transactions[2];
+        uint8_t current;           // Half being filled by the DMA
+        bool inFlight;
+        int64_t queuedUs;
+        volatile int64_t completedUs;  // Set from the SPI interrupt
+        uint32_t frames;
+        uint32_t misses;
+        uint32_t lastTransferUs;
+        std::atomic<uint32_t> published;  // Half holding the newest complete burst, +1
+    };
+
+    static std::atomic<State> state;
+    static Device devices[Board::NUM_SPI_DEVICES];
+    static uint8_t frames[Board::NUM_SPI_DEVICES][2][MAX_FRAME];  // DMA targets
+
+    static MahonyFilter filter;
+    static Orientation orientation[2];
+    static std::atomic<uint32_t> orientationSeq;
+    static int64_t lastImuUs;
+    static uint32_t maxPollUs;
+    static uint64_t totalPollUs;
+    static uint32_t polls;
+
+    static bool writeRegister(uint8_t device, uint8_t reg, uint8_t value);
+    static bool readRegister(uint8_t device, uint8_t reg, uint8_t& value);
+    static bool queue(size_t device, int64_t nowUs);
+    static void decodeImu(const uint8_t* frame, int64_t completedUs);
+    static void fakeImu(size_t device, int64_t nowUs);
+    static void IRAM_ATTR transferDone(spi_transaction_t* t);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Fixed-size single-producer / single-consumer ring. Lock-free, safe across
+// cores as long as each end is only touched by one task.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // All or nothing, published with one head update so the consumer never
+    // sees part of the batch
+    bool push(const T* items, size_t count) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (count > N - (h - tail.load(std::memory_order_acquire))) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) slots[(h + i) & (N - 1)] = items[i];
+        head.store(h + (uint32_t)count, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: skip to the newest item, returns false when empty
+    bool popLatest(T& item) {
+        bool any = false;
+        while (pop(item)) any = true;
+        return any;
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return N; }
+    uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    T slots[N];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> dropped{0};
+};
@@ -0,0 +1,3 @@
+#include "telemetry.h"
+
+Telemetry usbTelemetry(Serial);
@@ -0,0 +1,247 @@
+#pragma once
+#include <Arduino.h>
+#include "boardConfig.h"
+#include <esp_timer.h>
+#include "controlTask.h"
+
+// Subscription-based binary telemetry. A client picks channels and a
+// decimation per channel; each control tick produces at most one frame
+// holding only the channels that are due, delta-encoded against the last
+// value sent on that channel and packed as zigzag varints.
+//
+// Frame: 0xA5 | varint payload length | payload | sum8(payload)
+// Payload: flags | varint tick | { channel id, zigzag varint value }...
+// flags bit 0 marks a key frame where values are absolute, not deltas.
+//
+// Sized by joint count like ChainKinematics; the firmware's is Telemetry.
+template <size_t N>
+class BasicTelemetry {
+public:
+    enum Kind : uint8_t {
+        CH_POSITION,  // counts
+        CH_VELOCITY,  // 0.1 deg/s
+        CH_OUTPUT,    // 0.1 %
+        CH_ERROR,     // counts, setpoint - input
+        CH_HEALTH,    // fault mask << 8 | thermal load %
+        CH_CURVATURE, // 0.001 1/m
+        CH_CURRENT,   // mA, signed with the drive
+        KIND_COUNT
+    };
+
+    // Channel ids: (joint << 3) | kind, plus global timing channels
+    static constexpr uint8_t TIMING_TICK_US = 0xF0;
+    static constexpr uint8_t TIMING_OVERRUNS = 0xF1;
+    static constexpr uint8_t BODY_COM_X = 0xF2;  // 0.1 mm, head frame
+    static constexpr uint8_t BODY_COM_Y = 0xF3;
+    static constexpr uint8_t channelId(size_t joint, Kind kind) { return (uint8_t)((joint << 3) | kind); }
+
+    static constexpr uint8_t FRAME_SYNC = 0xA5;
+    static constexpr uint8_t FLAG_KEYFRAME = 0x01;
+    static constexpr uint16_t KEYFRAME_INTERVAL = 50;  // Frames between absolute refreshes
+    static constexpr size_t MAX_SUBSCRIPTIONS = N * KIND_COUNT + 4;
+    static_assert(N <= 30, "Channel ids reserve 0xF0 and up");
+
+    explicit BasicTelemetry(Print& out) : out(out) {}
+
+    bool subscribe(uint8_t channel, uint8_t decimation);
+    void unsubscribeAll();
+    bool active() const { return subscriptionCount > 0; }
+
+    // Called once per control state frame, in order
+    void publish(const BasicControlState<N>& state);
+
+    // Format: TLM subs=<n> frames=<n> bytes=<n> enc_us_max=<us>
+    void report(Print& report) const;
+
+    // Legacy tab-separated line for the tuning GUI: setpoint, input, output, kp, ki, kd per joint
+    static void printText(Print& out, const BasicControlState<N>& state);
+
+    // Parses a channel letter set ("pvoehkict") for a joint; returns subscriptions added
+    int subscribeLetters(int joint, const char* letters, uint8_t decimation);
+
+private:
+    struct Subscription {
+        uint8_t channel;
+        uint8_t decimation;
+        uint8_t countdown;
+        int32_t last;
+    };
+
+    Print& out;
+    Subscription subs[MAX_SUBSCRIPTIONS];
+    size_t subscriptionCount = 0;
+    uint16_t framesSinceKey = KEYFRAME_INTERVAL;  // First frame is a key frame
+    uint32_t frameCount = 0;
+    uint32_t byteCount = 0;
+    uint32_t maxEncodeUs = 0;
+
+    // Worst case per entry: id + 5-byte varint
+    uint8_t frame[16 + MAX_SUBSCRIPTIONS * 6];
+
+    static int32_t sample(const BasicControlState<N>& state, uint8_t channel);
+    static size_t putVarint(uint8_t* p, uint32_t v);
+    static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+};
+
+template <size_t N>
+bool BasicTelemetry<N>::subscribe(uint8_t channel, uint8_t decimation) {
+    bool valid = (channel >= TIMING_TICK_US && channel <= BODY_COM_Y) ||
+                 ((channel >> 3) < N && (channel & 7) < KIND_COUNT);
+    if (!valid || decimation == 0) {
+        return false;
+    }
+
+    framesSinceKey = KEYFRAME_INTERVAL;  // New layout, resync the client
+    for (size_t i = 0; i < subscriptionCount; i++) {
+        if (subs[i].channel == channel) {
+            subs[i].decimation = decimation;
+            subs[i].countdown = 0;
+            return true;
+        }
+    }
+    if (subscriptionCount >= MAX_SUBSCRIPTIONS) {
+        return false;
+    }
+    subs[subscriptionCount++] = {channel, decimation, 0, 0};
+    return true;
+}
+
+template <size_t N>
+void BasicTelemetry<N>::unsubscribeAll() {
+    subscriptionCount = 0;
+    framesSinceKey = KEYFRAME_INTERVAL;
+}
+
+template <size_t N>
+int BasicTelemetry<N>::subscribeLetters(int joint, const char* letters, uint8_t decimation) {
+    int added = 0;
+    size_t first = joint > 0 ? joint - 1 : 0;
+    size_t last = joint > 0 ? joint : N;
+    if (first >= N) return 0;
+
+    for (const char* c = letters; *c; c++) {
+        if (*c == 't') {
+            added += subscribe(TIMING_TICK_US, decimation);
+            added += subscribe(TIMING_OVERRUNS, decimation);
+            continue;
+        }
+        if (*c == 'c') {
+            added += subscribe(BODY_COM_X, decimation);
+            added += subscribe(BODY_COM_Y, decimation);
+            continue;
+        }
+        const char* kinds = "pvoehki";  // Same order as Kind
+        const char* k = strchr(kinds, *c);
+        if (!k) continue;
+        for (size_t j = first; j < last && j < N; j++) {
+            added += subscribe(channelId(j, (Kind)(k - kinds)), decimation);
+        }
+    }
+    return added;
+}
+
+template <size_t N>
+size_t BasicTelemetry<N>::putVarint(uint8_t* p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+template <size_t N>
+int32_t BasicTelemetry<N>::sample(const BasicControlState<N>& state, uint8_t channel) {
+    if (channel == TIMING_TICK_US) return (int32_t)ControlTask::stats().maxTickUs;
+    if (channel == TIMING_OVERRUNS) return (int32_t)ControlTask::stats().overruns;
+    if (channel == BODY_COM_X) return lroundf(state.comXMm * 10.0f);
+    if (channel == BODY_COM_Y) return lroundf(state.comYMm * 10.0f);
+
+    const JointState& j = state.joints[channel >> 3];
+    switch (channel & 7) {
+        case CH_POSITION: return lroundf(j.input);
+        case CH_VELOCITY: return lroundf(j.velocityDeg * 10.0f);
+        case CH_OUTPUT:   return lroundf(j.output * 10.0f);
+        case CH_ERROR:    return lroundf(j.setpoint - j.input);
+        case CH_HEALTH:   return ((int32_t)j.faults << 8) | (int32_t)constrain(j.thermalLoad * 100.0f, 0.0f, 255.0f);
+        case CH_CURVATURE: return lroundf(j.curvature * 1000.0f);
+        case CH_CURRENT:  return lroundf(j.currentA * 1000.0f);
+        default:       return 0;
+    }
+}
+
+template <size_t N>
+void BasicTelemetry<N>::publish(const BasicControlState<N>& state) {
+    if (subscriptionCount == 0) return;
+    int64_t start = esp_timer_get_time();
+
+    bool key = framesSinceKey >= KEYFRAME_INTERVAL;
+
+    // Payload goes after a reserved header: sync + up to 3 length bytes
+    uint8_t* payload = frame + 4;
+    size_t n = 0;
+    payload[n++] = key ? FLAG_KEYFRAME : 0;
+    n += putVarint(payload + n, state.tick);
+    size_t headerBytes = n;
+
+    for (size_t i = 0; i < subscriptionCount; i++) {
+        Subscription& s = subs[i];
+        bool due = (s.countdown == 0);
+        s.countdown = due ? s.decimation - 1 : s.countdown - 1;
+        if (!due && !key) continue;
+
+        int32_t value = sample(state, s.channel);
+        int32_t encoded = key ? value : value - s.last;
+        s.last = value;
+
+        payload[n++] = s.channel;
+        n += putVarint(payload + n, zigzag(encoded));
+    }
+
+    if (n == headerBytes) return;  // Nothing due this tick
+
+    uint8_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += payload[i];
+    payload[n++] = sum;
+
+    // Right-align the length varint against the payload
+    uint8_t len[3];
+    size_t lenBytes = putVarint(len, (uint32_t)(n - 1));
+    uint8_t* begin = payload - lenBytes - 1;
+    begin[0] = FRAME_SYNC;
+    memcpy(begin + 1, len, lenBytes);
+
+    size_t total = (payload + n) - begin;
+    out.write(begin, total);
+
+    framesSinceKey = key ? 1 : framesSinceKey + 1;
+    frameCount++;
+    byteCount += total;
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (elapsed > maxEncodeUs) maxEncodeUs = elapsed;
+}
+
+template <size_t N>
+void BasicTelemetry<N>::printText(Print& out, const BasicControlState<N>& state) {
+    for (size_t j = 0; j < N; j++) {
+        const JointState& m = state.joints[j];
+        out.print(m.setpoint); out.print("\t");
+        out.print(m.input);    out.print("\t");
+        out.print(m.output);   out.print("\t");
+        out.print(m.kp);       out.print("\t");
+        out.print(m.ki);       out.print("\t");
+        out.print(m.kd);
+        out.print(j + 1 < N ? "\t" : "\n");
+    }
+}
+
+template <size_t N>
+void BasicTelemetry<N>::report(Print& report) const {
+    report.printf("TLM subs=%u frames=%u bytes=%u enc_us_max=%u\n",
+                  (unsigned)subscriptionCount, (unsigned)frameCount,
+                  (unsigned)byteCount, (unsigned)maxEncodeUs);
+}
+
+using Telemetry = BasicTelemetry<Board::NUM_JOINTS>;
+extern Telemetry usbTelemetry;
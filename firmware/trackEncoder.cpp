@@ -1,47 +1,51 @@
-#include "TrackEncoder.h"
-
-TrackEncoder::TrackEncoder(uint8_t pinA1, uint8_t pinB1, uint8_t pinA2, uint8_t pinB2, const char *nvsNamespace, float pulsesPerRev) 
-    : pulsesPerRev(pulsesPerRev){
-    // Initialize preferences for NVS
-    if (!preferences.begin(nvsNamespace, false)) {
-        Serial.println("Failed to initialize NVS");
-        while (1);
+#include "trackEncoder.h"
+#include "memoryGuard.h"
+
+TrackEncoder::TrackEncoder(const char *nvsNamespace) {
+    // Without NVS the joints still run, from zero counts and without persistence
+    nvsOk = preferences.begin(nvsNamespace, false);
+    if (!nvsOk) {
+        Serial.println("NVS unavailable, encoder counts start at zero and are not saved");
     } else {
         Serial.println("NVS initialized");
     }
 
-    // Retrieve saved encoder counts
-    encoder1Count = preferences.getLong("encoder1", 0);
-    encoder2Count = preferences.getLong("encoder2", 0);
-
-    // Initialize encoders
+    // Initialize encoders and restore their saved counts
     ESP32Encoder::useInternalWeakPullResistors = puType::up; // Use internal pull-ups
-    encoder1.attachFullQuad(pinA1, pinB1);
-    encoder2.attachFullQuad(pinA2, pinB2);
+    for (size_t i = 0; i < NUM_ENCODERS; i++) {
+        char key[12];
+        nvsKey(i, key);
+        savedCounts[i] = nvsOk ? preferences.getLong(key, 0) : 0;
 
-    // Set the encoder counts from stored values
-    encoder1.setCount(encoder1Count);
-    encoder2.setCount(encoder2Count);
+        encoders[i].attachFullQuad(Board::ENCODERS[i].pinA, Board::ENCODERS[i].pinB);
+        encoders[i].setCount(savedCounts[i]);
+    }
 
     // Create a queue for sending encoder counts between ISR and task
-    encoderQueue = xQueueCreate(10, sizeof(int64_t) * 2);
+    encoderQueue = xQueueCreateStatic(QUEUE_LENGTH, sizeof(int64_t) * NUM_ENCODERS,
+                                      queueStorage, &queueBuffer);
 }
 
 TrackEncoder::~TrackEncoder() {
-    preferences.end(); // Close preferences when the object is destroyed
+    if (nvsOk) preferences.end(); // Close preferences when the object is destroyed
 }
 
 void TrackEncoder::begin(uint32_t timerIntervalMs) {
+    // Nothing to save into
+    if (!nvsOk) return;
+
     // Start the save task on the second CPU
-    xTaskCreatePinnedToCore(
+    saveTaskHandle = xTaskCreateStaticPinnedToCore(
         saveTask,               // Task function
         "SaveEncoderTask",      // Task name
-        4096,                   // Stack size
+        SAVE_STACK_SIZE,        // Stack size
         this,                   // Parameter to pass to the task
         1,                      // Priority
-        &saveTaskHandle,        // Task handle
+        saveTaskStack,          // Stack buffer
+        &saveTaskBuffer,        // Task control block
         0                       // CPU core (1 = second CPU)
     );
+    MemoryGuard::registerTask("SaveEncoderTask", saveTaskHandle, SAVE_STACK_SIZE);
 
     // Calculate the timer frequency and configure the timer
     const uint32_t baseFrequency = 80000000; // 80 MHz (ESP32 APB clock)
@@ -56,42 +60,47 @@ void TrackEncoder::begin(uint32_t timerIntervalMs) {
     timerStart(timer);
 }
 
-int64_t TrackEncoder::getEncoder1Count() {
-    return encoder1.getCount();
-}
-
-int64_t TrackEncoder::getEncoder2Count() {
-    return encoder2.getCount();
+void TrackEncoder::setGlitchFilter(uint16_t filter) {
+    // ESP32Encoder clamps to the PCNT range and disables the filter on 0
+    for (auto &encoder : encoders) {
+        encoder.setFilter(filter);
+    }
 }
 
-void TrackEncoder::resetCounts() {
-    encoder1Count = 0;
-    encoder2Count = 0;
-
-    encoder1.setCount(0);
-    encoder2.setCount(0);
-
-    preferences.putLong("encoder1", 0);
-    preferences.putLong("encoder2", 0);
-
-    Serial.println("Encoder counts reset to zero in NVS and memory");
+TrackEncoder::Snapshot IRAM_ATTR TrackEncoder::snapshot() {
+    Snapshot snap;
+    // Safe variant so the same latch serves tasks and the timer ISR. With
+    // interrupts masked the PCNT overflow ISR cannot run mid-latch; getCount()
+    // itself credits an overflow whose interrupt is still pending
+    portENTER_CRITICAL_SAFE(&snapshotMux);
+    snap.timestampUs = esp_timer_get_time();
+    for (size_t i = 0; i < NUM_ENCODERS; i++) {
+        snap.counts[i] = encoders[i].getCount();
+    }
+    snap.sequence = ++snapshotSequence;
+    portEXIT_CRITICAL_SAFE(&snapshotMux);
+    return snap;
 }
 
-// New methods
-float TrackEncoder::getEncoder1Angle() {
-    return (static_cast<float>(getEncoder1Count() % PULSES_PER_REV) / PULSES_PER_REV) * 360.0;
+int64_t TrackEncoder::getCount(size_t channel) {
+    return encoders[channel].getCount();
 }
 
-float TrackEncoder::getEncoder2Angle() {
-    return (static_cast<float>(getEncoder2Count() % PULSES_PER_REV) / PULSES_PER_REV) * 360.0;
+// NVS keys keep the original "encoder1", "encoder2" naming
+void TrackEncoder::nvsKey(size_t channel, char (&key)[12]) {
+    snprintf(key, sizeof(key), "encoder%u", (unsigned)(channel + 1));
 }
 
-int32_t TrackEncoder::getEncoder1Revolutions() {
-    return static_cast<int32_t>(getEncoder1Count() / PULSES_PER_REV);
-}
+void TrackEncoder::resetCounts() {
+    for (size_t i = 0; i < NUM_ENCODERS; i++) {
+        char key[12];
+        nvsKey(i, key);
+        savedCounts[i] = 0;
+        encoders[i].setCount(0);
+        if (nvsOk) preferences.putLong(key, 0);
+    }
 
-int32_t TrackEncoder::getEncoder2Revolutions() {
-    return static_cast<int32_t>(getEncoder2Count() / PULSES_PER_REV);
+    Serial.println("Encoder counts reset to zero in NVS and memory");
 }
 
 void TrackEncoder::sendToPlotter() {
@@ -105,26 +114,30 @@ void TrackEncoder::sendToPlotter() {
     // Serial.printf("%lld\t%.2f\t%lld\t%.2f\n", 
     //               getEncoder1Count(), getEncoder1Angle(), 
     //               getEncoder2Count(), getEncoder2Angle());
-    Serial.printf("%lld\t%lld\n", getEncoder1Count(),getEncoder2Count());
+    Snapshot snap = snapshot();
+    Serial.printf("%lld\t%lld\n", (long long)snap.counts[0], (long long)snap.counts[1]);
 }
 
 
 // ISR for the timer
 void IRAM_ATTR TrackEncoder::timerISR(void *arg) {
     auto *instance = static_cast<TrackEncoder *>(arg);
-    int64_t counts[2] = {instance->encoder1.getCount(), instance->encoder2.getCount()};
-    xQueueSendFromISR(instance->encoderQueue, &counts, NULL);
+    Snapshot snap = instance->snapshot();
+    xQueueSendFromISR(instance->encoderQueue, snap.counts, NULL);
 }
 
 // Task to save encoder counts to NVS
 void TrackEncoder::saveTask(void *parameter) {
     auto *instance = static_cast<TrackEncoder *>(parameter);
-    int64_t counts[2];
+    int64_t counts[NUM_ENCODERS];
 
     while (true) {
         if (xQueueReceive(instance->encoderQueue, &counts, portMAX_DELAY)) {
-            instance->preferences.putLong("encoder1", counts[0]);
-            instance->preferences.putLong("encoder2", counts[1]);
+            for (size_t i = 0; i < NUM_ENCODERS; i++) {
+                char key[12];
+                nvsKey(i, key);
+                instance->preferences.putLong(key, counts[i]);
+            }
         }
         vTaskDelay(pdMS_TO_TICKS(10));
     }
@@ -5,42 +5,83 @@
 #include <Preferences.h>
 #include <Arduino.h>
 #include <esp32-hal-timer.h>
+#include <esp_timer.h>
+#include "boardConfig.h"
 
 class TrackEncoder {
 public:
-     TrackEncoder(uint8_t pinA1, uint8_t pinB1, uint8_t pinA2, uint8_t pinB2, const char *nvsNamespace, float pulsesPerRev);
+    static constexpr size_t NUM_ENCODERS = Board::NUM_ENCODERS;
+
+    // All channels latched together, so multi-joint state shares one instant
+    struct Snapshot {
+        int64_t counts[NUM_ENCODERS];
+        int64_t timestampUs;  // esp_timer time of the latch
+        uint32_t sequence;    // Increments on every snapshot
+    };
+
+    // Channels and resolutions come from Board::ENCODERS
+    explicit TrackEncoder(const char *nvsNamespace);
     ~TrackEncoder();
 
     void begin(uint32_t timerIntervalMs);
-    int64_t getEncoder1Count();
-    int64_t getEncoder2Count();
+    void setGlitchFilter(uint16_t filter);  // PCNT glitch filter, 0 disables
+    Snapshot snapshot();
+    int64_t getCount(size_t channel);
+    int64_t getEncoder1Count() { return getCount(0); }
+    int64_t getEncoder2Count() { return getCount(1); }
     void resetCounts();
-    
-    // New methods
-    float getEncoder1Angle();
-    float getEncoder2Angle();
-    int32_t getEncoder1Revolutions();
-    int32_t getEncoder2Revolutions();
+    bool persistent() const { return nvsOk; }  // False when NVS failed to open
+
+    // Output-side angle within the current turn and whole turns, per channel
+    template <size_t CH> float getAngle();
+    template <size_t CH> int32_t getRevolutions();
+    float getEncoder1Angle() { return getAngle<0>(); }
+    float getEncoder2Angle() { return getAngle<1>(); }
+    int32_t getEncoder1Revolutions() { return getRevolutions<0>(); }
+    int32_t getEncoder2Revolutions() { return getRevolutions<1>(); }
     void sendToPlotter();
 
 
 private:
-    float pulsesPerRev;
-    ESP32Encoder encoder1, encoder2;
+    ESP32Encoder encoders[NUM_ENCODERS];
+    portMUX_TYPE snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+    volatile uint32_t snapshotSequence = 0;
     Preferences preferences;
+    bool nvsOk = false;
 
     hw_timer_t *timer = nullptr;
     TaskHandle_t saveTaskHandle;
     QueueHandle_t encoderQueue;
 
-    volatile int64_t encoder1Count = 0;
-    volatile int64_t encoder2Count = 0;
+    // Statically allocated save task and ISR queue
+    static constexpr uint32_t SAVE_STACK_SIZE = 4096;
+    static constexpr UBaseType_t QUEUE_LENGTH = 10;
+    StackType_t saveTaskStack[SAVE_STACK_SIZE];
+    StaticTask_t saveTaskBuffer;
+    uint8_t queueStorage[QUEUE_LENGTH * sizeof(int64_t) * NUM_ENCODERS];
+    StaticQueue_t queueBuffer;
 
-    static constexpr int PULSES_PER_REV = 8344; // Calculated as 7 PPR * 4 (quadrature) * 298 (gear ratio)
+    volatile int64_t savedCounts[NUM_ENCODERS] = {};
 
+    static void nvsKey(size_t channel, char (&key)[12]);
     static void IRAM_ATTR timerISR(void *arg);
     static void saveTask(void *parameter);
     bool headerPrinted = false; // Flag to ensure header is printed only once
 };
 
+template <size_t CH>
+float TrackEncoder::getAngle() {
+    static_assert(CH < NUM_ENCODERS, "Encoder channel out of range");
+    constexpr int64_t countsPerRev = Board::channelCountsPerRev(CH);
+    constexpr float degPerCount = 360.0f / countsPerRev;
+    return static_cast<float>(getCount(CH) % countsPerRev) * degPerCount;
+}
+
+template <size_t CH>
+int32_t TrackEncoder::getRevolutions() {
+    static_assert(CH < NUM_ENCODERS, "Encoder channel out of range");
+    constexpr int64_t countsPerRev = Board::channelCountsPerRev(CH);
+    return static_cast<int32_t>(getCount(CH) / countsPerRev);
+}
+
 #endif // TRACK_ENCODER_H
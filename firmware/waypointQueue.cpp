@@ -0,0 +1,150 @@
+#include "waypointQueue.h"
+
+static_assert((WaypointQueue::CAPACITY & (WaypointQueue::CAPACITY - 1)) == 0,
+              "WaypointQueue capacity must be a power of two");
+
+// Signed distance between two wrapping millisecond stamps
+static inline int32_t msDiff(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b);
+}
+
+WaypointQueue::PushResult WaypointQueue::push(const Waypoint& wp) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    if (h - t >= CAPACITY) {
+        return PushResult::Full;
+    }
+
+    // Equal or falling times make a zero-length segment. A drained queue or a
+    // clear starts a new stream, which may begin anywhere
+    uint32_t epoch = clearRequests.load(std::memory_order_acquire);
+    if (h != t && epoch == pushEpoch && msDiff(wp.timeMs, lastPushedMs) <= 0) {
+        return PushResult::OutOfOrder;
+    }
+    buffer[h & (CAPACITY - 1)] = wp;
+    head.store(h + 1, std::memory_order_release);
+    lastPushedMs = wp.timeMs;
+    pushEpoch = epoch;
+    return PushResult::Ok;
+}
+
+void WaypointQueue::requestClear() {
+    // Both cores may clear; keep whichever snapshot of head is later
+    uint32_t h = head.load(std::memory_order_acquire);
+    uint32_t seen = clearTo.load(std::memory_order_relaxed);
+    while (msDiff(h, seen) > 0
+           && !clearTo.compare_exchange_weak(seen, h, std::memory_order_relaxed)) {
+    }
+    clearRequests.fetch_add(1, std::memory_order_release);
+}
+
+uint32_t WaypointQueue::depth() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+uint32_t WaypointQueue::pending() const {
+    uint32_t h = head.load(std::memory_order_acquire);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    uint32_t to = clearTo.load(std::memory_order_acquire);
+    if (msDiff(to, t) > 0) t = to;
+    return h - t;
+}
+
+const WaypointQueue::Waypoint& WaypointQueue::peek(uint32_t index) const {
+    return buffer[(tail.load(std::memory_order_relaxed) + index) & (CAPACITY - 1)];
+}
+
+void WaypointQueue::pop() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void WaypointQueue::anchor(uint32_t nowMs, float currentDeg) {
+    // Map the next queued point to now + lead, start the segment from where we are
+    offsetMs = static_cast<int32_t>(nowMs + leadMs - peek(0).timeMs);
+    from = {nowMs - offsetMs, currentDeg};
+    prev = from;
+    starved = false;
+}
+
+bool WaypointQueue::sample(uint32_t nowMs, float currentDeg, float& degrees) {
+    // Drop only what was queued when the clear was asked for, a stream pushed
+    // right after it survives
+    uint32_t requests = clearRequests.load(std::memory_order_acquire);
+    if (requests != clearsSeen) {
+        clearsSeen = requests;
+        uint32_t to = clearTo.load(std::memory_order_relaxed);
+        if (msDiff(to, tail.load(std::memory_order_relaxed)) > 0) {
+            tail.store(to, std::memory_order_release);
+        }
+        running.store(false, std::memory_order_relaxed);
+        starved = false;
+    }
+
+    uint32_t available = depth();
+    if (!running.load(std::memory_order_relaxed)) {
+        if (available == 0) return false;
+        anchor(nowMs, currentDeg);
+        running.store(true, std::memory_order_relaxed);
+    }
+
+    uint32_t streamNow = nowMs - offsetMs;
+    bool extrapolate = underrunMode.load(std::memory_order_relaxed) == UnderrunMode::Extrapolate;
+
+    // Points arriving after an underrun that are already late get re-anchored
+    // instead of being skipped, so a link stall never turns into a jump
+    if (starved && available > 0) {
+        if (msDiff(peek(0).timeMs, streamNow) <= 0) {
+            anchor(nowMs, currentDeg);
+            streamNow = nowMs - offsetMs;
+        }
+        starved = false;
+    }
+
+    // Consume every point whose time has passed
+    while (available > 0 && msDiff(peek(0).timeMs, streamNow) <= 0) {
+        prev = from;
+        from = peek(0);
+        pop();
+        available--;
+    }
+
+    if (available == 0) {
+        if (!starved) {
+            starved = true;
+            underrunCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (extrapolate && msDiff(from.timeMs, prev.timeMs) > 0) {
+            float slope = (from.degrees - prev.degrees) / msDiff(from.timeMs, prev.timeMs);
+            int32_t dt = min(msDiff(streamNow, from.timeMs), (int32_t)MAX_EXTRAPOLATE_MS);
+            degrees = from.degrees + slope * dt;
+        } else {
+            degrees = from.degrees;
+        }
+        return true;
+    }
+
+    // Cubic Hermite on [from, to] with Catmull-Rom tangents (deg/ms)
+    const Waypoint& to = peek(0);
+    float h = static_cast<float>(msDiff(to.timeMs, from.timeMs));
+    float s = msDiff(streamNow, from.timeMs) / h;
+
+    float m0 = (msDiff(from.timeMs, prev.timeMs) > 0)
+        ? (to.degrees - prev.degrees) / msDiff(to.timeMs, prev.timeMs)
+        : (to.degrees - from.degrees) / h;
+    float m1;
+    if (available > 1) {
+        const Waypoint& next = peek(1);
+        m1 = (next.degrees - from.degrees) / msDiff(next.timeMs, from.timeMs);
+    } else {
+        // Last queued point: ease in when holding, keep the chord slope when extrapolating
+        m1 = extrapolate ? (to.degrees - from.degrees) / h : 0.0f;
+    }
+
+    float s2 = s * s;
+    float s3 = s2 * s;
+    degrees = (2 * s3 - 3 * s2 + 1) * from.degrees
+            + (s3 - 2 * s2 + s) * h * m0
+            + (-2 * s3 + 3 * s2) * to.degrees
+            + (s3 - s2) * h * m1;
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// Per-joint trajectory buffer. The comms side pushes timestamped (ms, deg)
+// points in batches, the control tick samples a smooth setpoint between them
+// with cubic Hermite interpolation. Single producer / single consumer, no locks.
+// Stream times must increase strictly; a stream may restart from any time
+// once the queue has drained or after a clear.
+class WaypointQueue {
+public:
+    static constexpr uint32_t CAPACITY = 32;      // Must be a power of two
+    static constexpr uint32_t DEFAULT_LEAD_MS = 100;
+    static constexpr uint32_t MAX_EXTRAPOLATE_MS = 200;
+
+    enum class UnderrunMode : uint8_t { Hold, Extrapolate };
+
+    struct Waypoint {
+        uint32_t timeMs;  // Sender stream time
+        float degrees;
+    };
+
+    enum class PushResult : uint8_t { Ok, Full, OutOfOrder };
+
+    // Producer side (comms)
+    PushResult push(const Waypoint& wp);
+
+    // Either side: drops the points queued so far, points pushed after the
+    // request start a new stream
+    void requestClear();
+
+    // Either side
+    uint32_t depth() const;
+    uint32_t pending() const;  // Points a sample would still play, net of a clear not yet taken
+    uint32_t freeSlots() const { return CAPACITY - depth(); }
+    uint32_t underruns() const { return underrunCount.load(std::memory_order_relaxed); }
+    bool active() const { return running.load(std::memory_order_relaxed); }
+
+    // Consumer side (control tick). Returns false when no trajectory is running,
+    // in which case the caller keeps its current setpoint.
+    bool sample(uint32_t nowMs, float currentDeg, float& degrees);
+
+    std::atomic<UnderrunMode> underrunMode{UnderrunMode::Hold};  // Set by comms, read by the tick
+    uint32_t leadMs = DEFAULT_LEAD_MS;  // Latency budget added when a stream (re)starts
+
+private:
+    Waypoint buffer[CAPACITY];
+    std::atomic<uint32_t> head{0};  // Written by producer
+    std::atomic<uint32_t> tail{0};  // Written by consumer
+    std::atomic<uint32_t> clearTo{0};        // head at the latest clear request
+    std::atomic<uint32_t> clearRequests{0};  // Bumped after clearTo is written
+    std::atomic<bool> running{false};
+    std::atomic<uint32_t> underrunCount{0};
+
+    // Producer-only state
+    uint32_t lastPushedMs = 0;
+    uint32_t pushEpoch = 0;  // clearRequests when lastPushedMs was pushed
+
+    // Consumer-only state, times are in stream time
+    uint32_t clearsSeen = 0;
+    Waypoint prev{0, 0.0f};   // Point before the current segment start
+    Waypoint from{0, 0.0f};   // Current segment start
+    int32_t offsetMs = 0;     // local = stream + offset
+    bool starved = false;
+
+    const Waypoint& peek(uint32_t index) const;
+    void pop();
+    void anchor(uint32_t nowMs, float currentDeg);
+};
@@ -0,0 +1,143 @@
+#include "QuickPID.h"
+#include <Arduino.h>
+
+QuickPID::QuickPID(float* Input, float* Output, float* Setpoint, float Kp, float Ki, float Kd, pMode pMode,
+                   dMode dMode, iAwMode iAwMode, Action Action) {
+    myOutput = Output;
+    myInput = Input;
+    mySetpoint = Setpoint;
+    mode = Control::manual;
+
+    QuickPID::SetOutputLimits(0, 255);
+    sampleTimeUs = 100000;
+    QuickPID::SetControllerDirection(Action);
+    QuickPID::SetTunings(Kp, Ki, Kd, pMode, dMode, iAwMode);
+
+    lastTime = micros() - sampleTimeUs;
+}
+
+QuickPID::QuickPID(float* Input, float* Output, float* Setpoint, float Kp, float Ki, float Kd, Action Action)
+    : QuickPID(Input, Output, Setpoint, Kp, Ki, Kd, pMode::pOnError, dMode::dOnMeas, iAwMode::iAwCondition,
+               Action) {}
+
+QuickPID::QuickPID(float* Input, float* Output, float* Setpoint)
+    : QuickPID(Input, Output, Setpoint, 0, 0, 0, pMode::pOnError, dMode::dOnMeas, iAwMode::iAwCondition,
+               Action::direct) {}
+
+QuickPID::QuickPID() {}
+
+bool QuickPID::Compute() {
+    if (mode == Control::manual) return false;
+    uint32_t now = micros();
+    uint32_t timeChange = now - lastTime;
+    if (mode == Control::timer || timeChange >= sampleTimeUs) {
+        float input = *myInput;
+        float dInput = input - lastInput;
+        if (action == Action::reverse) dInput = -dInput;
+
+        error = *mySetpoint - input;
+        if (action == Action::reverse) error = -error;
+        float dError = error - lastError;
+
+        float peTerm = kp * error;
+        float pmTerm = kp * dInput;
+        if (pmode == pMode::pOnError) pmTerm = 0;
+        else if (pmode == pMode::pOnMeas) peTerm = 0;
+        else {  // pOnErrorMeas
+            peTerm *= 0.5f;
+            pmTerm *= 0.5f;
+        }
+
+        pTerm = peTerm - pmTerm;
+        iTerm = ki * error;
+        if (dmode == dMode::dOnError) dTerm = kd * dError;
+        else dTerm = -kd * dInput;  // dOnMeas
+
+        // Condition anti-windup (default)
+        if (iawmode == iAwMode::iAwCondition) {
+            bool aw = false;
+            float iTermOut = (peTerm - pmTerm) + ki * (iTerm + error);
+            if (iTermOut > outMax && dError > 0) aw = true;
+            else if (iTermOut < outMin && dError < 0) aw = true;
+            if (aw && ki) iTerm = constrain(iTermOut, -outMax, outMax);
+        }
+
+        // By default, clamp output sum
+        outputSum += iTerm;
+        if (iawmode == iAwMode::iAwOff) outputSum -= pmTerm;
+        else outputSum = constrain(outputSum - pmTerm, outMin, outMax);
+
+        *myOutput = constrain(outputSum + peTerm + dTerm, outMin, outMax);
+
+        lastError = error;
+        lastInput = input;
+        lastTime = now;
+        return true;
+    }
+    return false;
+}
+
+void QuickPID::SetTunings(float Kp, float Ki, float Kd, pMode pMode, dMode dMode, iAwMode iAwMode) {
+    if (Kp < 0 || Ki < 0 || Kd < 0 || !sampleTimeUs) return;
+    if (Ki == 0) outputSum = 0;
+    pmode = pMode;
+    dmode = dMode;
+    iawmode = iAwMode;
+    dispKp = Kp;
+    dispKi = Ki;
+    dispKd = Kd;
+    float SampleTimeSec = (float)sampleTimeUs / 1000000;
+    kp = Kp;
+    ki = Ki * SampleTimeSec;
+    kd = Kd / SampleTimeSec;
+}
+
+void QuickPID::SetTunings(float Kp, float Ki, float Kd) { SetTunings(Kp, Ki, Kd, pmode, dmode, iawmode); }
+
+void QuickPID::SetSampleTimeUs(uint32_t NewSampleTimeUs) {
+    if (NewSampleTimeUs > 0) {
+        float ratio = (float)NewSampleTimeUs / (float)sampleTimeUs;
+        ki *= ratio;
+        kd /= ratio;
+        sampleTimeUs = NewSampleTimeUs;
+    }
+}
+
+void QuickPID::SetOutputLimits(float Min, float Max) {
+    if (Min >= Max) return;
+    outMin = Min;
+    outMax = Max;
+
+    if (mode != Control::manual) {
+        *myOutput = constrain(*myOutput, outMin, outMax);
+        outputSum = constrain(outputSum, outMin, outMax);
+    }
+}
+
+void QuickPID::SetMode(Control Mode) {
+    if (mode == Control::manual && Mode != Control::manual) {  // just went from manual to automatic, timer or toggle
+        QuickPID::Initialize();
+    }
+    if (Mode == Control::toggle) {
+        mode = (mode == Control::manual) ? Control::automatic : Control::manual;
+    } else {
+        mode = Mode;
+    }
+}
+
+void QuickPID::Initialize() {
+    outputSum = *myOutput;
+    lastInput = *myInput;
+    outputSum = constrain(outputSum, outMin, outMax);
+}
+
+void QuickPID::SetControllerDirection(Action Action) { action = Action; }
+
+void QuickPID::Reset() {
+    lastTime = micros() - sampleTimeUs;
+    lastInput = 0;
+    outputSum = 0;
+    pTerm = 0;
+    iTerm = 0;
+    dTerm = 0;
+}
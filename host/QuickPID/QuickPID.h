@@ -0,0 +1,67 @@
+#pragma once
+// Host build of the QuickPID 3.1 interface the firmware uses, with the same
+// arithmetic as the library's Compute() so simulations and replays match the
+// target. Configure with -DQUICKPID_DIR=<path to the library's src> to compile
+// the real library instead.
+#include <stdint.h>
+
+class QuickPID {
+public:
+    enum class Control : uint8_t { manual, automatic, timer, toggle };
+    enum class Action : uint8_t { direct, reverse };
+    enum class pMode : uint8_t { pOnError, pOnMeas, pOnErrorMeas };
+    enum class dMode : uint8_t { dOnError, dOnMeas };
+    enum class iAwMode : uint8_t { iAwCondition, iAwClamp, iAwOff };
+
+    QuickPID(float* Input, float* Output, float* Setpoint, float Kp, float Ki, float Kd, pMode pMode, dMode dMode,
+             iAwMode iAwMode, Action Action);
+    QuickPID(float* Input, float* Output, float* Setpoint, float Kp, float Ki, float Kd, Action Action);
+    QuickPID(float* Input, float* Output, float* Setpoint);
+    QuickPID();
+
+    void SetMode(Control Mode);
+    void SetMode(uint8_t Mode) { SetMode((Control)Mode); }
+    bool Compute();
+    void SetOutputLimits(float Min, float Max);
+    void SetTunings(float Kp, float Ki, float Kd);
+    void SetTunings(float Kp, float Ki, float Kd, pMode pMode, dMode dMode, iAwMode iAwMode);
+    void SetControllerDirection(Action Action);
+    void SetSampleTimeUs(uint32_t NewSampleTimeUs);
+    void SetProportionalMode(pMode pMode) { pmode = pMode; }
+    void SetDerivativeMode(dMode dMode) { dmode = dMode; }
+    void SetAntiWindupMode(iAwMode iAwMode) { iawmode = iAwMode; }
+    void SetOutputSum(float sum) { outputSum = sum; }
+    void Initialize();
+    void Reset();
+
+    float GetKp() { return dispKp; }
+    float GetKi() { return dispKi; }
+    float GetKd() { return dispKd; }
+    float GetPterm() { return pTerm; }
+    float GetIterm() { return iTerm; }
+    float GetDterm() { return dTerm; }
+    float GetOutputSum() { return outputSum; }
+    uint8_t GetMode() { return (uint8_t)mode; }
+    uint8_t GetDirection() { return (uint8_t)action; }
+    uint8_t GetPmode() { return (uint8_t)pmode; }
+    uint8_t GetDmode() { return (uint8_t)dmode; }
+    uint8_t GetAwMode() { return (uint8_t)iawmode; }
+
+private:
+    float dispKp = 0, dispKi = 0, dispKd = 0;
+    float pTerm = 0, iTerm = 0, dTerm = 0;
+    float kp = 0, ki = 0, kd = 0;
+
+    float* myInput = nullptr;
+    float* myOutput = nullptr;
+    float* mySetpoint = nullptr;
+
+    Control mode = Control::manual;
+    Action action = Action::direct;
+    pMode pmode = pMode::pOnError;
+    dMode dmode = dMode::dOnMeas;
+    iAwMode iawmode = iAwMode::iAwCondition;
+
+    uint32_t sampleTimeUs = 0, lastTime = 0;
+    float outputSum = 0, outMin = 0, outMax = 0, error = 0, lastError = 0, lastInput = 0;
+};
@@ -0,0 +1,412 @@
+// Host benchmarks of the per-tick firmware paths on the simulated HAL. The
+// inputs are fixed and the clock is simulated, so runs differ only by the
+// host CPU. On-target cycle counts still come from the `bench` command.
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "controlTask.h"
+#include "telemetry.h"
+#include "kinematics.h"
+#include "pidBatch.h"
+#include "eventLog.h"
+#include "paramStore.h"
+#include "bleCom.h"
+#include "latencyTrace.h"
+#include "sensorBus.h"
+
+// One brought-up controller shared by every case, as on the device
+static Sim::Rig& rig() {
+    static Sim::Rig instance;
+    return instance;
+}
+
+template <size_t N = Board::NUM_JOINTS>
+static BasicControlState<N> sampleState(uint32_t tick) {
+    BasicControlState<N> s = {};
+    s.tick = tick;
+    s.comXMm = 97.5f;
+    s.comYMm = -12.25f;
+    for (size_t j = 0; j < N; j++) {
+        s.joints[j] = {1000.0f, 990.0f + (tick & 15), -37.5f, 1.32f, 10.28f, 0.1f, 12.5f, 0.2f, 3.1f, 0.4f, 0};
+    }
+    return s;
+}
+
+// MotorPID::update with controlMotor and the supervisor, what the tick runs per joint
+static void BM_MotorUpdate(benchmark::State& state) {
+    rig();
+    MotorPID& m = motors[0];
+    m.setSetpointDeg(20.0f);
+    for (auto _ : state) {
+        Host::advanceUs(Board::CONTROL_PERIOD_US);
+        TrackEncoder::Snapshot snap = trackEncoder->snapshot();
+        m.update(snap, false);
+    }
+    m.setSetpointDeg(0.0f);
+}
+BENCHMARK(BM_MotorUpdate);
+
+// MotorPID::compute: filters, velocity, schedule and updatePID without hardware
+static void BM_MotorCompute(benchmark::State& state) {
+    rig();
+    MotorPID& m = motors[0];
+    TrackEncoder::Snapshot snap = trackEncoder->snapshot();
+    for (auto _ : state) {
+        snap.timestampUs += Board::CONTROL_PERIOD_US;
+        snap.counts[m.config().encoderIndex] ^= 3;
+        benchmark::DoNotOptimize(m.compute(snap, false));
+    }
+}
+BENCHMARK(BM_MotorCompute);
+
+// The same through the LQR with a coupled row, against BM_MotorCompute's PID
+static void BM_MotorComputeLqr(benchmark::State& state) {
+    rig();
+    MotorPID& m = motors[0];
+    rig().command("lqr1=6.5191,0.16504,11.662");
+    rig().command("lqrx1,2=0.5,0.02,1");
+    rig().command("ctl1=lqr");
+    rig().step();
+    TrackEncoder::Snapshot snap = trackEncoder->snapshot();
+    for (auto _ : state) {
+        snap.timestampUs += Board::CONTROL_PERIOD_US;
+        snap.counts[m.config().encoderIndex] ^= 3;
+        m.latchPeers();
+        benchmark::DoNotOptimize(m.compute(snap, false));
+    }
+    if (m.controller() != MotorPID::Controller::Lqr) state.SkipWithError("LQR not selected");
+    rig().command("ctl1=pid");
+    rig().step();
+    rig().replies();
+}
+BENCHMARK(BM_MotorComputeLqr);
+
+// The same with a 4x4 error/velocity gain schedule looked up and blended each tick
+static void BM_MotorComputeScheduled(benchmark::State& state) {
+    rig();
+    MotorPID& m = motors[0];
+    rig().command("gs1=e,0,5,4,v,0,50,4");
+    for (int p = 0; p < 16; p += 4) {
+        char line[96];
+        snprintf(line, sizeof(line), "gsp1=%d,1,8,0.1,1.1,8,0.1,1.2,8,0.1,1.3,8,0.1", p);
+        rig().command(line);
+    }
+    rig().command("gsc1");
+    TrackEncoder::Snapshot snap = trackEncoder->snapshot();
+    for (auto _ : state) {
+        snap.timestampUs += Board::CONTROL_PERIOD_US;
+        snap.counts[m.config().encoderIndex] ^= 3;
+        benchmark::DoNotOptimize(m.compute(snap, false));
+    }
+    if (!m.scheduleActive()) state.SkipWithError("gain schedule not committed");
+    m.disableSchedule();
+    rig().replies();
+}
+BENCHMARK(BM_MotorComputeScheduled);
+
+// updatePID's cost alone: one QuickPID::Compute in timer mode
+static void BM_QuickPidCompute(benchmark::State& state) {
+    float input = 0, output = 0, setpoint = 500;
+    QuickPID pid(&input, &output, &setpoint, 1.32f, 10.28f, 0.1f, QuickPID::pMode::pOnError,
+                 QuickPID::dMode::dOnMeas, QuickPID::iAwMode::iAwClamp, QuickPID::Action::direct);
+    pid.SetOutputLimits(-100, 100);
+    pid.SetSampleTimeUs(Board::CONTROL_PERIOD_US);
+    pid.SetMode(QuickPID::Control::timer);
+    uint32_t n = 0;
+    for (auto _ : state) {
+        input = (float)(n++ & 1023);
+        pid.Compute();
+        benchmark::DoNotOptimize(output);
+    }
+}
+BENCHMARK(BM_QuickPidCompute);
+
+// Eight joints: one QuickPID each against the batched kernel
+static void BM_PidBatch8(benchmark::State& state) {
+    PidBatch<8> batch;
+    for (size_t i = 0; i < 8; i++) {
+        batch.setTunings(i, 1.32f, 10.28f, 0.1f, Board::CONTROL_PERIOD_US);
+        batch.setpoint[i] = 500.0f + i;
+    }
+    uint32_t n = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < 8; i++) batch.input[i] = (float)((n + i) & 1023);
+        n++;
+        batch.compute();
+        benchmark::DoNotOptimize(batch.output);
+    }
+}
+BENCHMARK(BM_PidBatch8);
+
+// Full control tick: commands, idle, both joints, kinematics, state push
+static void BM_ControlTick(benchmark::State& state) {
+    rig();
+    ControlState drained;
+    for (auto _ : state) {
+        Host::advanceUs(Board::CONTROL_PERIOD_US);
+        ControlTask::tick();
+        state.PauseTiming();
+        while (ControlTask::nextState(drained)) {}
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_ControlTick);
+
+static void BM_EncoderSnapshot(benchmark::State& state) {
+    rig();
+    for (auto _ : state) benchmark::DoNotOptimize(trackEncoder->snapshot());
+}
+BENCHMARK(BM_EncoderSnapshot);
+
+static void BM_EncoderAngleAndTurns(benchmark::State& state) {
+    rig();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(trackEncoder->getEncoder1Count());
+        benchmark::DoNotOptimize(trackEncoder->getEncoder1Angle());
+        benchmark::DoNotOptimize(trackEncoder->getEncoder1Revolutions());
+    }
+}
+BENCHMARK(BM_EncoderAngleAndTurns);
+
+// One BLE line through the parser into the command ring; the ring is drained outside the timing
+static void BM_BleParseSetpoint(benchmark::State& state) {
+    rig();
+    HostStream* ble = Host::ble();
+    uint32_t n = 0;
+    for (auto _ : state) {
+        ble->feed("tar1=12.5\n");
+        BLECom::update();
+        if (++n % 16 == 0) {
+            state.PauseTiming();
+            ble->take();
+            Host::advanceUs(Board::CONTROL_PERIOD_US);
+            ControlTask::tick();
+            state.ResumeTiming();
+        }
+    }
+}
+BENCHMARK(BM_BleParseSetpoint);
+
+// The traced command path on the BLE stand-in, on the host clock: bytes in,
+// parse, ring, apply and motor write with no wait for the tick. The device
+// adds up to one control period of queueing on top. The LatencyTrace
+// percentiles come out as counters, the command-path regression numbers.
+static void BM_CommandPipeline(benchmark::State& state) {
+    rig();
+    HostStream* ble = Host::ble();
+    LatencyTrace::reset();
+    Host::useRealClock(true);
+    ControlState drained;
+    uint32_t n = 0;
+    for (auto _ : state) {
+        ble->feed((++n & 1) ? "tar1=12.5\n" : "tar1=12.0\n");
+        BLECom::update();
+        ControlTask::tick();
+        state.PauseTiming();
+        ble->take();
+        while (ControlTask::nextState(drained)) {}
+        state.ResumeTiming();
+    }
+    Host::useRealClock(false);
+    if (LatencyTrace::count(LatencyTrace::TOTAL) == 0) state.SkipWithError("no command reached a motor write");
+    state.counters["total_p50_us"] = LatencyTrace::percentileUs(LatencyTrace::TOTAL, 500);
+    state.counters["total_p99_us"] = LatencyTrace::percentileUs(LatencyTrace::TOTAL, 990);
+    state.counters["parse_p99_us"] = LatencyTrace::percentileUs(LatencyTrace::PARSE, 990);
+    state.counters["actuate_p99_us"] = LatencyTrace::percentileUs(LatencyTrace::ACTUATE, 990);
+}
+BENCHMARK(BM_CommandPipeline);
+
+// Telemetry: the legacy text block against binary frames with all joint channels
+static void BM_TelemetryText(benchmark::State& state) {
+    HostStream out;
+    ControlState s = sampleState(0);
+    for (auto _ : state) {
+        Telemetry::printText(out, s);
+        out.take();
+    }
+}
+BENCHMARK(BM_TelemetryText);
+
+// Frames for bodies of N joints, with the bytes per frame against the text line for the same state
+template <size_t N>
+static void BM_TelemetryBinary(benchmark::State& state) {
+    rig();
+    HostStream out;
+    BasicTelemetry<N> telemetry(out);
+    telemetry.subscribeLetters(0, "pvoehki", 1);
+    uint32_t tick = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        telemetry.publish(sampleState<N>(tick++));
+        bytes += out.take().size();
+    }
+    state.SetBytesProcessed((int64_t)bytes);
+
+    BasicTelemetry<N>::printText(out, sampleState<N>(0));
+    state.counters["frame_bytes"] = tick ? (double)bytes / tick : 0.0;
+    state.counters["text_bytes"] = (double)out.take().size();
+}
+BENCHMARK_TEMPLATE(BM_TelemetryBinary, 2);
+BENCHMARK_TEMPLATE(BM_TelemetryBinary, 8);
+BENCHMARK_TEMPLATE(BM_TelemetryBinary, 16);
+
+// NVS writes are a map insert here, so this times ParamStore's own blob and CRC work
+static void BM_ParamStoreSave(benchmark::State& state) {
+    rig();
+    uint32_t n = 0;
+    for (auto _ : state) {
+        ParamStore::noteGains(0, 1.0f + (n++ & 7), 10.0f, 0.1f);
+        Host::advanceUs(10000000);
+        ParamStore::service();
+    }
+}
+BENCHMARK(BM_ParamStoreSave);
+
+static void BM_WaypointSample(benchmark::State& state) {
+    WaypointQueue queue;
+    uint32_t pushed = 0, nowMs = 0;
+    float deg = 0.0f;
+    for (auto _ : state) {
+        state.PauseTiming();
+        while (queue.freeSlots() > 0) {
+            queue.push({pushed * 20, 10.0f * sinf(pushed * 0.1f)});
+            pushed++;
+        }
+        state.ResumeTiming();
+        queue.sample(nowMs, deg, deg);
+        nowMs += 10;
+    }
+}
+BENCHMARK(BM_WaypointSample);
+
+static void BM_SpscRingPushPop(benchmark::State& state) {
+    static SpscRing<ControlCommand, 32> ring;
+    ControlCommand cmd = {ControlCommand::Type::SetpointDeg, 0, {1.0f}};
+    for (auto _ : state) {
+        ring.push(cmd);
+        ring.pop(cmd);
+        benchmark::DoNotOptimize(cmd);
+    }
+}
+BENCHMARK(BM_SpscRingPushPop);
+
+static int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Push on one thread to pop on another, as comms hands commands to control.
+// One item in flight at a time, so this is the hand-off and not queueing.
+// Percentiles come out as counters; on a single-core host they measure the
+// scheduler rather than the ring
+static void BM_SpscRingLatency(benchmark::State& state) {
+    static SpscRing<int64_t, ControlTask::COMMAND_SLOTS> ring;
+    std::vector<int64_t> latencyNs;
+    latencyNs.reserve(1 << 20);
+    std::atomic<uint64_t> received{0};
+    std::atomic<bool> running{true};
+    std::thread consumer([&] {
+        int64_t sentNs;
+        while (running.load(std::memory_order_relaxed)) {
+            if (!ring.pop(sentNs)) {
+                std::this_thread::yield();
+                continue;
+            }
+            latencyNs.push_back(steadyNs() - sentNs);
+            received.fetch_add(1, std::memory_order_release);
+        }
+    });
+
+    uint64_t sent = 0;
+    for (auto _ : state) {
+        ring.push(steadyNs());
+        sent++;
+        while (received.load(std::memory_order_acquire) < sent) std::this_thread::yield();
+    }
+    running.store(false, std::memory_order_relaxed);
+    consumer.join();
+
+    if (latencyNs.empty()) return;
+    std::sort(latencyNs.begin(), latencyNs.end());
+    auto percentile = [&](double p) {
+        return (double)latencyNs[std::min(latencyNs.size() - 1, (size_t)(p * latencyNs.size()))];
+    };
+    state.counters["p50_ns"] = percentile(0.5);
+    state.counters["p99_ns"] = percentile(0.99);
+    state.counters["p999_ns"] = percentile(0.999);
+    state.counters["max_ns"] = (double)latencyNs.back();
+}
+BENCHMARK(BM_SpscRingLatency)->UseRealTime();
+
+// Bodies of N joints, the sizes the on-target bench command times
+template <size_t N>
+static void BM_Kinematics(benchmark::State& state) {
+    SinCosTable::init();
+    ChainKinematics<N> chain(Board::SEGMENT_LENGTH_MM);
+    float joints[N];
+    for (size_t j = 0; j < N; j++) joints[j] = (j & 1 ? -10.0f : 10.0f) * (float)(j % 8 + 1);
+    for (auto _ : state) {
+        joints[0] += 0.01f;
+        chain.update(joints);
+        benchmark::DoNotOptimize(chain.shape().comXMm);
+    }
+}
+BENCHMARK_TEMPLATE(BM_Kinematics, 8);
+BENCHMARK_TEMPLATE(BM_Kinematics, 16);
+BENCHMARK_TEMPLATE(BM_Kinematics, 32);
+
+// One to MotorPID::FILTER_SECTIONS sections, all in use
+template <size_t N>
+static void BM_BiquadChain(benchmark::State& state) {
+    BiquadChain<N> chain;
+    for (size_t i = 0; i < N; i++) chain.set(i, Biquad::LOWPASS, 5.0f + i, 0.707f, 100.0f, 0.0f);
+    float x = 0.0f;
+    for (auto _ : state) {
+        x = chain.process(x + 1.0f);
+        benchmark::DoNotOptimize(x);
+    }
+}
+BENCHMARK_TEMPLATE(BM_BiquadChain, 1);
+BENCHMARK_TEMPLATE(BM_BiquadChain, 2);
+BENCHMARK_TEMPLATE(BM_BiquadChain, 3);
+BENCHMARK_TEMPLATE(BM_BiquadChain, 4);
+
+static void BM_EventLogAppend(benchmark::State& state) {
+    rig();
+    for (auto _ : state) EventLog::log(EventLog::OVERRUN, EventLog::NO_JOINT, 0, 1234);
+}
+BENCHMARK(BM_EventLogAppend);
+
+// SensorBus::poll with the IMU fitted: collect the last burst, queue the next,
+// decode it and update the orientation filter. Registered last, so the ticks
+// timed above run without the bus
+static void BM_SensorBusPoll(benchmark::State& state) {
+    rig();
+    // Once: every begin() adds the devices to the bus again
+    static bool fitted = [] {
+        Host::SpiRegisters& imu = Host::spiDevice(SensorBus::IMU_DEVICE);
+        imu.regs[0x75] = 0x47;  // WHO_AM_I
+        imu.regs[0x23] = 0x08;  // Accel z at 1 g, 2048 LSB
+        imu.transferUs = 25;
+        SensorBus::begin(true);
+        HostStream out;
+        SensorBus::report(out);
+        return out.take().find("state=ok") != std::string::npos;
+    }();
+    if (!fitted) {
+        state.SkipWithError("IMU not running");
+        return;
+    }
+    for (auto _ : state) {
+        Host::advanceUs(Board::CONTROL_PERIOD_US);
+        SensorBus::poll();
+    }
+}
+BENCHMARK(BM_SensorBusPoll);
+
+BENCHMARK_MAIN();
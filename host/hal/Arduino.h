@@ -0,0 +1,168 @@
+#pragma once
+// Host stand-in for the Arduino-ESP32 core: the subset of Arduino.h the
+// firmware uses, backed by the simulated clock, pins and streams in hostHal.h.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <deque>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define DEC 10
+#define HEX 16
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+// Same definitions as the ESP32 core, which pulls min, max and abs from std
+using std::abs;
+using std::max;
+using std::min;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+
+bool setCpuFrequencyMhz(uint32_t mhz);
+uint32_t getCpuFrequencyMhz();
+
+inline bool isPrintable(int c) { return isprint(c) != 0; }
+
+void esp_rom_printf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+class String {
+public:
+    String(const char* text = "") : text(text ? text : "") {}
+    unsigned length() const { return (unsigned)text.size(); }
+    const char* c_str() const { return text.c_str(); }
+
+private:
+    std::string text;
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC) { return print((long long)value, base); }
+    size_t print(unsigned long value, int base = DEC) { return print((unsigned long long)value, base); }
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+};
+
+// Captures everything written and replays queued input, for USB and BLE alike
+class HostStream : public Stream {
+public:
+    using Print::write;
+    size_t write(uint8_t c) override {
+        output.push_back((char)c);
+        return 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        output.append((const char*)buffer, size);
+        return size;
+    }
+    int available() override { return (int)input.size(); }
+    int read() override {
+        if (input.empty()) return -1;
+        int c = (uint8_t)input.front();
+        input.pop_front();
+        return c;
+    }
+    int peek() override { return input.empty() ? -1 : (uint8_t)input.front(); }
+    void flush() {}
+    int availableForWrite() { return 4096; }
+
+    // Test side
+    void feed(const std::string& text) { input.insert(input.end(), text.begin(), text.end()); }
+    std::string take() {
+        std::string text;
+        text.swap(output);
+        return text;
+    }
+    const std::string& written() const { return output; }
+
+private:
+    std::string output;
+    std::deque<char> input;
+};
+
+class HWCDC : public HostStream {
+public:
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+};
+
+extern HWCDC Serial;
+
+class EspClass {
+public:
+    uint32_t getCycleCount();  // From the host's monotonic clock at 240 MHz
+    uint32_t getCpuFreqMHz() { return getCpuFrequencyMhz(); }
+    uint32_t getFreeHeap() { return 200 * 1024; }
+    void restart() {}
+};
+
+extern EspClass ESP;
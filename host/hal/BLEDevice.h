@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+#include "esp_gap_ble_api.h"
+
+typedef int esp_gatts_cb_event_t;
+typedef uint8_t esp_gatt_if_t;
+enum { ESP_GATTS_CONNECT_EVT = 14, ESP_GATTS_DISCONNECT_EVT = 15 };
+
+typedef union {
+    struct {
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+    } connect;
+    struct {
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+        int reason;
+    } disconnect;
+} esp_ble_gatts_cb_param_t;
+
+typedef void (*gatts_handler_t)(esp_gatts_cb_event_t, esp_gatt_if_t, esp_ble_gatts_cb_param_t*);
+
+class BLEDevice {
+public:
+    static void init(String) {}
+    static void setCustomGattsHandler(gatts_handler_t handler) { gattsHandler = handler; }
+    static gatts_handler_t gattsHandler;  // Host side: raise connect/disconnect events
+};
@@ -0,0 +1,21 @@
+#pragma once
+// Host BLE serial: a HostStream that registers itself on begin(), so tests
+// reach the command parser with Host::ble()->feed() and read replies back.
+#include <Arduino.h>
+
+namespace Host {
+void registerBle(HostStream* stream);
+void advanceUs(int64_t us);
+extern int64_t bleInitUs;
+}
+
+template <class Buffer>
+class BLESerial : public HostStream {
+public:
+    void begin(const char*) {
+        Host::advanceUs(Host::bleInitUs);
+        Host::registerBle(this);
+    }
+    void begin(String name) { begin(name.c_str()); }
+    bool connected() { return true; }
+};
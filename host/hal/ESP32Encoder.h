@@ -0,0 +1,45 @@
+#pragma once
+// Host model of the ESP32Encoder library over a 16-bit PCNT unit: the raw
+// counter wraps back to zero at +-LIMIT and the overflow ISR adds the limit
+// to the 64-bit accumulator, exactly as the library does on target.
+// getCount() is accumulator + raw, plus the limit of an overflow whose
+// interrupt is still pending, as the library checks the PCNT status.
+// Tests turn the shaft with hostMove().
+#include <stdint.h>
+
+enum puType { UP, DOWN, NONE, up = UP, down = DOWN, none = NONE };
+
+class ESP32Encoder {
+public:
+    static constexpr int16_t LIMIT = 32766;
+    static puType useInternalWeakPullResistors;
+
+    ESP32Encoder();
+    ~ESP32Encoder();
+
+    void attachFullQuad(int a, int b);
+    void setCount(int64_t value);
+    int64_t getCount() const { return accumulator + pending + raw; }
+    int64_t clearCount();
+    void setFilter(uint16_t value) { filter = value; }
+
+    // Host side
+    static ESP32Encoder* forPin(int a);  // The encoder attached with pin A = a
+    void hostMove(int64_t counts);       // Quadrature edges, wrapping through the ISR
+    int16_t hostRaw() const { return raw; }
+    int64_t hostAccumulator() const { return accumulator; }
+    uint16_t hostFilter() const { return filter; }
+    uint32_t hostOverflows() const { return overflows; }
+    // While masked, an overflow latches its interrupt instead of running the
+    // ISR, as with interrupts off on the reading core; unmasking runs it
+    void hostMaskInterrupt(bool masked);
+
+private:
+    int pinA = -1;
+    int16_t raw = 0;
+    int64_t accumulator = 0;
+    uint16_t filter = 0;
+    uint32_t overflows = 0;
+    int64_t pending = 0;  // Limit of the overflow awaiting its ISR, 0 if none
+    bool masked = false;
+};
@@ -0,0 +1,29 @@
+#pragma once
+// Host model of the H-bridge driver. Speeds are uint8_t percent like the
+// real library, so a fractional drive truncates on the way in here too.
+#include <stdint.h>
+
+class ESP32MotorControl {
+public:
+    enum Direction : int8_t { STOPPED = 0, FORWARD = 1, REVERSE = -1 };
+
+    void attachMotors(uint8_t a0, uint8_t a1, uint8_t b0, uint8_t b1);
+    void attachMotor(uint8_t a0, uint8_t a1);
+    void motorForward(uint8_t motor, uint8_t speed);
+    void motorReverse(uint8_t motor, uint8_t speed);
+    void motorFullForward(uint8_t motor) { motorForward(motor, 100); }
+    void motorFullReverse(uint8_t motor) { motorReverse(motor, 100); }
+    void motorStop(uint8_t motor);
+    void motorsStop();
+
+    // Host side: signed percent last commanded, -100..100
+    int hostDrive(uint8_t motor) const;
+    uint32_t hostStops(uint8_t motor) const;
+
+    static constexpr int MAX_MOTORS = 2;
+
+private:
+    Direction direction[MAX_MOTORS] = {};
+    uint8_t speed[MAX_MOTORS] = {};
+    uint32_t stops[MAX_MOTORS] = {};
+};
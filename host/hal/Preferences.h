@@ -0,0 +1,31 @@
+#pragma once
+// Host NVS: every Preferences instance reads and writes one in-memory store
+// (Host::nvs()), so values survive "reboots" within a test. Host::nvsFailOpen
+// and Host::nvsFailWrites inject the flash errors the firmware must tolerate.
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false);
+    void end() { open = false; }
+
+    size_t putLong(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    int32_t getLong(const char* key, int32_t defaultValue = 0);
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t putBytes(const char* key, const void* value, size_t length);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+    size_t getBytesLength(const char* key);
+    bool isKey(const char* key);
+    bool remove(const char* key);
+    bool clear();
+
+private:
+    std::string path(const char* key) const { return space + "/" + key; }
+
+    std::string space;
+    bool open = false;
+    bool readOnly = false;
+};
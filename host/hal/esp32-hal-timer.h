@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+
+// Timers never fire on their own; Host::fireTimers() runs every started alarm's handler once
+struct hw_timer_t;
+hw_timer_t* timerBegin(uint32_t frequency);
+void timerAttachInterruptArg(hw_timer_t* timer, void (*handler)(void*), void* arg);
+void timerAlarm(hw_timer_t* timer, uint64_t alarmValue, bool autoreload, uint64_t reloadCount);
+void timerStart(hw_timer_t* timer);
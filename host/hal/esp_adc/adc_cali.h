@@ -0,0 +1,7 @@
+#pragma once
+#include "esp_adc/adc_continuous.h"
+
+typedef struct adc_cali_scheme_t* adc_cali_handle_t;
+
+// Host calibration is the ideal 12-bit, 3.1 V full-scale line
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int* voltage);
@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// Same polynomial and conditioning as the ROM routine: esp_crc32_le(0, ...) equals zlib's crc32
+uint32_t esp_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
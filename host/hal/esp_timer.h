@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// Simulated microsecond clock, see Host::setTimeUs()
+int64_t esp_timer_get_time();
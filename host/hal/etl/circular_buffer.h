@@ -0,0 +1,8 @@
+#pragma once
+#include <stddef.h>
+
+namespace etl {
+// Only named as BLESerial's buffer type; the host stream keeps its own queue
+template <class T, size_t N>
+class circular_buffer {};
+}
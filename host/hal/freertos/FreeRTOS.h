@@ -0,0 +1,66 @@
+#pragma once
+// Host stand-in for the FreeRTOS types and calls the firmware uses. Nothing
+// is scheduled: task functions are never started (tests step the control
+// tick themselves), queues are plain rings that never block, and critical
+// sections are no-ops on the single host thread that owns the firmware.
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint8_t StackType_t;  // Stack depth is in bytes on the ESP32 port
+
+struct StaticTask_t {
+    const char* name;
+};
+typedef StaticTask_t* TaskHandle_t;
+
+struct StaticQueue_t {
+    uint8_t* storage;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+typedef StaticQueue_t* QueueHandle_t;
+
+struct portMUX_TYPE {
+    uint32_t owner;
+};
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux))
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define NULL_TASK ((TaskHandle_t) nullptr)
+
+typedef void (*TaskFunction_t)(void*);
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t code, const char* name, uint32_t stackDepth,
+                                           void* parameter, UBaseType_t priority, StackType_t* stack,
+                                           StaticTask_t* buffer, BaseType_t core);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TickType_t xTaskGetTickCount();
+BaseType_t xTaskDelayUntil(TickType_t* previousWake, TickType_t increment);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t* storage, StaticQueue_t* buffer);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
@@ -0,0 +1,649 @@
+#include "hostHal.h"
+#include <BLEDevice.h>
+#include <BLESerial.h>
+#include <ESP32Encoder.h>
+#include <ESP32MotorControl.h>
+#include <Preferences.h>
+#include <driver/spi_master.h>
+#include <esp32-hal-timer.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_crc.h>
+#include <esp_heap_caps.h>
+#include <esp_partition.h>
+#include <chrono>
+#include <deque>
+
+HWCDC Serial;
+EspClass ESP;
+puType ESP32Encoder::useInternalWeakPullResistors = UP;
+gatts_handler_t BLEDevice::gattsHandler = nullptr;
+
+// A transaction the host SPI master has queued, finished at doneUs
+struct SpiTransfer {
+    spi_transaction_t* trans;
+    int64_t doneUs;
+};
+
+struct spi_device_t {
+    size_t index;  // Into Host::spiDevice()
+    int queueSize;
+    transaction_cb_t postCb;
+    std::deque<SpiTransfer> queue;
+};
+
+namespace {
+
+constexpr int64_t BOOT_US = 1000000;
+constexpr int NUM_PINS = 64;
+
+struct HardwareTimer {
+    void (*handler)(void*) = nullptr;
+    void* arg = nullptr;
+    bool started = false;
+};
+
+struct Partition {
+    esp_partition_t info;
+    std::vector<uint8_t> image;
+};
+
+struct State {
+    int64_t timeUs = BOOT_US;
+    bool realClock = false;
+    int64_t realBaseUs = 0;  // timeUs minus the host clock while realClock
+    int8_t levels[NUM_PINS];
+    int8_t modes[NUM_PINS];
+    uint32_t cpuMhz = 240;
+    TaskHandle_t currentTask = nullptr;
+    esp_reset_reason_t resetReason = ESP_RST_POWERON;
+    std::deque<HardwareTimer> timers;
+    std::map<std::string, std::vector<uint8_t>> nvs;
+    std::deque<Partition> partitions;
+    std::deque<uint32_t> adc;
+    std::deque<spi_device_t> spiDevices;
+    std::deque<Host::SpiRegisters> spiRegisters;
+    HostStream* ble = nullptr;
+
+    State() {
+        memset(levels, -1, sizeof(levels));
+        memset(modes, -1, sizeof(modes));
+    }
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+int64_t steadyUs() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+// The simulated clock, or the host's own one after useRealClock(true)
+int64_t clockUs() {
+    State& s = state();
+    if (s.realClock) s.timeUs = s.realBaseUs + steadyUs();
+    return s.timeUs;
+}
+
+std::vector<ESP32Encoder*>& encoders() {
+    static std::vector<ESP32Encoder*> list;
+    return list;
+}
+
+}  // namespace
+
+namespace Host {
+
+bool nvsFailOpen = false;
+bool nvsFailWrites = false;
+int64_t nvsOpenUs = 0;
+int64_t bleInitUs = 0;
+
+void reset() {
+    state() = State();
+    nvsFailOpen = false;
+    nvsFailWrites = false;
+    nvsOpenUs = 0;
+    bleInitUs = 0;
+    Serial.take();
+    while (Serial.read() >= 0) {}
+}
+
+int64_t nowUs() { return clockUs(); }
+void setTimeUs(int64_t us) { state().timeUs = us; }
+void advanceUs(int64_t us) { state().timeUs += us; }
+
+void useRealClock(bool real) {
+    State& s = state();
+    if (real && !s.realClock) s.realBaseUs = s.timeUs - steadyUs();
+    s.realClock = real;
+}
+
+int pinLevel(uint8_t pin) { return pin < NUM_PINS ? state().levels[pin] : -1; }
+int pinModeOf(uint8_t pin) { return pin < NUM_PINS ? state().modes[pin] : -1; }
+
+void setCurrentTask(TaskHandle_t task) { state().currentTask = task; }
+void setResetReason(esp_reset_reason_t reason) { state().resetReason = reason; }
+
+void fireTimers() {
+    for (auto& t : state().timers) {
+        if (t.started && t.handler) t.handler(t.arg);
+    }
+}
+
+std::map<std::string, std::vector<uint8_t>>& nvs() { return state().nvs; }
+
+void addPartition(const char* label, uint8_t type, uint8_t subtype, const std::vector<uint8_t>& image) {
+    Partition p = {};
+    p.info.type = (esp_partition_type_t)type;
+    p.info.subtype = subtype;
+    p.info.address = 0x300000 + 0x10000 * (uint32_t)state().partitions.size();
+    p.info.size = (uint32_t)image.size();
+    snprintf(p.info.label, sizeof(p.info.label), "%s", label);
+    p.image = image;
+    state().partitions.push_back(p);
+}
+
+void adcPush(uint8_t channel, uint16_t raw) {
+    adc_digi_output_data_t d = {};
+    d.type2.channel = channel;
+    d.type2.data = raw & 0xFFF;
+    d.type2.unit = ADC_UNIT_1;
+    state().adc.push_back(d.val);
+}
+
+size_t adcPending() { return state().adc.size(); }
+
+SpiRegisters& spiDevice(size_t index) {
+    auto& regs = state().spiRegisters;
+    if (regs.size() <= index) regs.resize(index + 1);
+    return regs[index];
+}
+
+HostStream* ble() { return state().ble; }
+void registerBle(HostStream* stream) { state().ble = stream; }
+
+}  // namespace Host
+
+// Clock
+
+int64_t esp_timer_get_time() { return clockUs(); }
+uint32_t micros() { return (uint32_t)clockUs(); }
+uint32_t millis() { return (uint32_t)(clockUs() / 1000); }
+void delay(uint32_t ms) { state().timeUs += (int64_t)ms * 1000; }
+void delayMicroseconds(uint32_t us) { state().timeUs += us; }
+
+uint32_t EspClass::getCycleCount() {
+    // Real time here, not the simulated clock: Bench times the host CPU
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() * 240 / 1000);
+}
+
+// Pins and CPU
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < NUM_PINS) state().modes[pin] = (int8_t)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (pin < NUM_PINS) state().levels[pin] = level ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) { return pin < NUM_PINS && state().levels[pin] == HIGH ? HIGH : LOW; }
+
+bool setCpuFrequencyMhz(uint32_t mhz) {
+    if (mhz != 80 && mhz != 160 && mhz != 240) return false;
+    state().cpuMhz = mhz;
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz() { return state().cpuMhz; }
+
+esp_reset_reason_t esp_reset_reason() { return state().resetReason; }
+
+void esp_rom_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+// Print / Stream
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t)length < sizeof(buffer)) return write((const uint8_t*)buffer, length);
+    std::string large(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&large[0], large.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)large.data(), length);
+}
+
+size_t Print::print(long long value, int base) {
+    char buffer[32];
+    if (base == HEX) snprintf(buffer, sizeof(buffer), "%llx", (unsigned long long)value);
+    else snprintf(buffer, sizeof(buffer), "%lld", value);
+    return write(buffer);
+}
+
+size_t Print::print(unsigned long long value, int base) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%llx" : "%llu", value);
+    return write(buffer);
+}
+
+size_t Print::print(double value, int digits) {
+    char buffer[64];
+    if (std::isnan(value)) return write("nan");
+    if (std::isinf(value)) return write("inf");
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+        int c = read();
+        if (c < 0) break;
+        buffer[n++] = (char)c;
+    }
+    return n;
+}
+
+// FreeRTOS
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t, const char* name, uint32_t, void*, UBaseType_t,
+                                           StackType_t*, StaticTask_t* buffer, BaseType_t) {
+    buffer->name = name;
+    return buffer;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return state().currentTask; }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 1024; }
+TickType_t xTaskGetTickCount() { return (TickType_t)(state().timeUs / 1000 / portTICK_PERIOD_MS); }
+
+BaseType_t xTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    *previousWake += increment;
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks) { state().timeUs += (int64_t)ticks * portTICK_PERIOD_MS * 1000; }
+void vTaskDelete(TaskHandle_t) {}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t* storage, StaticQueue_t* buffer) {
+    *buffer = {storage, length, itemSize, 0, 0};
+    return buffer;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t) {
+    if (q->count == q->length) return pdFAIL;
+    memcpy(q->storage + ((q->head + q->count) % q->length) * q->itemSize, item, q->itemSize);
+    q->count++;
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t) {
+    if (q->count == 0) return pdFAIL;
+    memcpy(item, q->storage + q->head * q->itemSize, q->itemSize);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    return pdPASS;
+}
+
+// Hardware timer
+
+struct hw_timer_t {
+    size_t index;
+};
+
+hw_timer_t* timerBegin(uint32_t) {
+    static std::deque<hw_timer_t> handles;
+    state().timers.emplace_back();
+    handles.push_back({state().timers.size() - 1});
+    return &handles.back();
+}
+
+void timerAttachInterruptArg(hw_timer_t* timer, void (*handler)(void*), void* arg) {
+    if (timer->index >= state().timers.size()) return;
+    state().timers[timer->index].handler = handler;
+    state().timers[timer->index].arg = arg;
+}
+
+void timerAlarm(hw_timer_t*, uint64_t, bool, uint64_t) {}
+
+void timerStart(hw_timer_t* timer) {
+    if (timer->index < state().timers.size()) state().timers[timer->index].started = true;
+}
+
+// NVS
+
+bool Preferences::begin(const char* name, bool readOnlyMode) {
+    Host::advanceUs(Host::nvsOpenUs);
+    if (Host::nvsFailOpen) return false;
+    space = name;
+    readOnly = readOnlyMode;
+    open = true;
+    return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!open || readOnly || Host::nvsFailWrites) return 0;
+    const uint8_t* bytes = (const uint8_t*)value;
+    state().nvs[path(key)] = std::vector<uint8_t>(bytes, bytes + length);
+    return length;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    auto it = state().nvs.find(path(key));
+    if (!open || it == state().nvs.end() || it->second.size() > maxLength) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    auto it = state().nvs.find(path(key));
+    return open && it != state().nvs.end() ? it->second.size() : 0;
+}
+
+int32_t Preferences::getLong(const char* key, int32_t defaultValue) {
+    int32_t value;
+    return getBytesLength(key) == sizeof(value) && getBytes(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value;
+    return getBytesLength(key) == sizeof(value) && getBytes(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+bool Preferences::isKey(const char* key) { return open && state().nvs.count(path(key)) != 0; }
+
+bool Preferences::remove(const char* key) {
+    if (!open || readOnly) return false;
+    return state().nvs.erase(path(key)) != 0;
+}
+
+bool Preferences::clear() {
+    if (!open || readOnly) return false;
+    std::string prefix = space + "/";
+    for (auto it = state().nvs.begin(); it != state().nvs.end();) {
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? state().nvs.erase(it) : std::next(it);
+    }
+    return true;
+}
+
+// Encoder
+
+ESP32Encoder::ESP32Encoder() { encoders().push_back(this); }
+
+ESP32Encoder::~ESP32Encoder() {
+    auto& list = encoders();
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+void ESP32Encoder::attachFullQuad(int a, int) {
+    pinA = a;
+    raw = 0;
+}
+
+void ESP32Encoder::setCount(int64_t value) {
+    accumulator = value;
+    raw = 0;
+    pending = 0;
+}
+
+int64_t ESP32Encoder::clearCount() {
+    accumulator = 0;
+    raw = 0;
+    pending = 0;
+    return 0;
+}
+
+void ESP32Encoder::hostMaskInterrupt(bool mask) {
+    masked = mask;
+    if (!masked) {
+        accumulator += pending;
+        pending = 0;
+    }
+}
+
+ESP32Encoder* ESP32Encoder::forPin(int a) {
+    for (auto* e : encoders()) {
+        if (e->pinA == a) return e;
+    }
+    return nullptr;
+}
+
+void ESP32Encoder::hostMove(int64_t counts) {
+    // The unit counts edge by edge; on reaching a limit it resets to zero and
+    // the overflow interrupt credits the limit to the accumulator
+    while (counts != 0) {
+        int step = counts > 0 ? 1 : -1;
+        int64_t room = step > 0 ? LIMIT - raw : raw + LIMIT;
+        int64_t moved = std::min<int64_t>(room, counts > 0 ? counts : -counts);
+        raw = (int16_t)(raw + step * moved);
+        counts -= step * moved;
+        if (raw == LIMIT || raw == -LIMIT) {
+            if (masked) {
+                pending += raw;
+            } else {
+                accumulator += raw;
+            }
+            raw = 0;
+            overflows++;
+        }
+    }
+}
+
+// Motor driver
+
+void ESP32MotorControl::attachMotors(uint8_t, uint8_t, uint8_t, uint8_t) { motorsStop(); }
+void ESP32MotorControl::attachMotor(uint8_t, uint8_t) { motorStop(0); }
+
+void ESP32MotorControl::motorForward(uint8_t motor, uint8_t value) {
+    if (motor >= MAX_MOTORS) return;
+    direction[motor] = FORWARD;
+    speed[motor] = value > 100 ? 100 : value;
+}
+
+void ESP32MotorControl::motorReverse(uint8_t motor, uint8_t value) {
+    if (motor >= MAX_MOTORS) return;
+    direction[motor] = REVERSE;
+    speed[motor] = value > 100 ? 100 : value;
+}
+
+void ESP32MotorControl::motorStop(uint8_t motor) {
+    if (motor >= MAX_MOTORS) return;
+    direction[motor] = STOPPED;
+    speed[motor] = 0;
+    stops[motor]++;
+}
+
+void ESP32MotorControl::motorsStop() {
+    for (uint8_t m = 0; m < MAX_MOTORS; m++) motorStop(m);
+}
+
+int ESP32MotorControl::hostDrive(uint8_t motor) const {
+    return motor < MAX_MOTORS ? direction[motor] * (int)speed[motor] : 0;
+}
+
+uint32_t ESP32MotorControl::hostStops(uint8_t motor) const { return motor < MAX_MOTORS ? stops[motor] : 0; }
+
+// BLE
+
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t*) { return ESP_OK; }
+
+// CRC, heap, partitions
+
+uint32_t esp_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+size_t heap_caps_get_free_size(uint32_t) { return 200 * 1024; }
+size_t heap_caps_get_minimum_free_size(uint32_t) { return 180 * 1024; }
+void* heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+void heap_caps_free(void* ptr) { free(ptr); }
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    for (auto& p : state().partitions) {
+        if (p.info.type == type && p.info.subtype == subtype && (!label || strcmp(label, p.info.label) == 0)) {
+            return &p.info;
+        }
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t, const void** out, esp_partition_mmap_handle_t* handle) {
+    for (auto& p : state().partitions) {
+        if (&p.info != partition) continue;
+        if (offset > p.image.size() || size > p.image.size() - offset) return ESP_ERR_INVALID_ARG;
+        *out = p.image.data() + offset;
+        *handle = partition->address;
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t) {}
+
+// SPI: the address byte carries the register and the read bit
+
+static constexpr uint8_t SPI_READ = 0x80;
+
+static void spiTransfer(spi_device_t* device, spi_transaction_t* trans) {
+    Host::SpiRegisters& regs = Host::spiDevice(device->index);
+    uint8_t reg = (uint8_t)(trans->addr & 0x7F);
+    if (trans->addr & SPI_READ) {
+        uint8_t* rx = trans->flags & SPI_TRANS_USE_RXDATA ? trans->rx_data : (uint8_t*)trans->rx_buffer;
+        size_t length = (trans->rxlength ? trans->rxlength : trans->length) / 8;
+        for (size_t i = 0; i < length; i++) rx[i] = regs.regs[(reg + i) % sizeof(regs.regs)];
+    } else {
+        const uint8_t* tx = trans->flags & SPI_TRANS_USE_TXDATA ? trans->tx_data : (const uint8_t*)trans->tx_buffer;
+        for (size_t i = 0; i < trans->length / 8; i++) {
+            uint8_t at = (uint8_t)((reg + i) % sizeof(regs.regs));
+            regs.regs[at] = tx[i];
+            regs.writes.push_back({at, tx[i]});
+        }
+    }
+}
+
+// The driver calls post_cb from its interrupt when the transfer ends
+static void spiComplete(spi_device_t* device, spi_transaction_t* trans, int64_t doneUs) {
+    spiTransfer(device, trans);
+    if (!device->postCb) return;
+    State& s = state();
+    int64_t now = s.timeUs;
+    if (!s.realClock) s.timeUs = doneUs;
+    device->postCb(trans);
+    if (!s.realClock) s.timeUs = now;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t*, int) { return ESP_OK; }
+
+esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle) {
+    auto& devices = state().spiDevices;
+    devices.push_back({devices.size(), config->queue_size, config->post_cb, {}});
+    *handle = &devices.back();
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans, uint32_t) {
+    if ((int)handle->queue.size() >= handle->queueSize) return ESP_ERR_TIMEOUT;
+    handle->queue.push_back({trans, clockUs() + Host::spiDevice(handle->index).transferUs});
+    Host::spiDevice(handle->index).queued++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans, uint32_t) {
+    if (handle->queue.empty() || handle->queue.front().doneUs > clockUs()) return ESP_ERR_TIMEOUT;
+    SpiTransfer done = handle->queue.front();
+    handle->queue.pop_front();
+    spiComplete(handle, done.trans, done.doneUs);
+    *trans = done.trans;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans) {
+    spiComplete(handle, trans, clockUs());
+    return ESP_OK;
+}
+
+// ADC
+
+struct adc_continuous_ctx_t {
+    bool started;
+};
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t*, adc_continuous_handle_t* handle) {
+    static adc_continuous_ctx_t context;
+    context.started = false;
+    *handle = &context;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t, const adc_continuous_config_t*) { return ESP_OK; }
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t, const adc_continuous_evt_cbs_t*, void*) {
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle) {
+    handle->started = true;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle, uint8_t* buf, uint32_t length, uint32_t* outLength,
+                              uint32_t) {
+    auto& queue = state().adc;
+    if (!handle->started || queue.empty()) return ESP_ERR_TIMEOUT;
+    uint32_t n = 0;
+    while (!queue.empty() && n + SOC_ADC_DIGI_RESULT_BYTES <= length) {
+        memcpy(buf + n, &queue.front(), SOC_ADC_DIGI_RESULT_BYTES);
+        queue.pop_front();
+        n += SOC_ADC_DIGI_RESULT_BYTES;
+    }
+    *outLength = n;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_io_to_channel(int io, adc_unit_t* unit, adc_channel_t* channel) {
+    // ESP32-S3: GPIO1..10 are ADC1 channels 0..9
+    if (io < 1 || io > 10) return ESP_ERR_INVALID_ARG;
+    *unit = ADC_UNIT_1;
+    *channel = (adc_channel_t)(io - 1);
+    return ESP_OK;
+}
+
+struct adc_cali_scheme_t {
+    int unused;
+};
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t*, adc_cali_handle_t* handle) {
+    static adc_cali_scheme_t scheme;
+    *handle = &scheme;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t, int raw, int* voltage) {
+    *voltage = raw * 3100 / 4095;
+    return ESP_OK;
+}
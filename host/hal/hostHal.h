@@ -0,0 +1,67 @@
+#pragma once
+// Test-side controls for the simulated HAL. Time only moves when a test moves
+// it, so every run of the firmware on the host is reproducible.
+#include <Arduino.h>
+#include <esp_system.h>
+#include <vector>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace Host {
+
+// Back to power-on: clock, pins, NVS, partitions, ADC queue, streams and timers
+void reset();
+
+// Clock shared by esp_timer_get_time(), micros() and millis(); starts at 1 s
+int64_t nowUs();
+void setTimeUs(int64_t us);
+void advanceUs(int64_t us);
+// Follow the host's monotonic clock from the present time on, for tools that
+// time firmware code (replay); set and advance only apply while simulated
+void useRealClock(bool real);
+
+int pinLevel(uint8_t pin);  // -1 until written
+int pinModeOf(uint8_t pin);
+
+// Task handle returned by xTaskGetCurrentTaskHandle(); nullptr is the Arduino loop
+void setCurrentTask(TaskHandle_t task);
+
+void setResetReason(esp_reset_reason_t reason);
+
+// Runs every started hardware timer's handler once, as if its alarm fired
+void fireTimers();
+
+// NVS contents as "namespace/key" -> bytes
+std::map<std::string, std::vector<uint8_t>>& nvs();
+extern bool nvsFailOpen;    // Preferences::begin() fails
+extern bool nvsFailWrites;  // put*() write nothing
+
+// Simulated time the slow start-up calls take, for boot timing
+extern int64_t nvsOpenUs;  // Each Preferences::begin()
+extern int64_t bleInitUs;  // BLESerial::begin(), the BLE stack coming up
+
+// Data partition served by esp_partition_find_first()/esp_partition_mmap()
+void addPartition(const char* label, uint8_t type, uint8_t subtype, const std::vector<uint8_t>& image);
+
+// Conversion result for adc_continuous_read()
+void adcPush(uint8_t channel, uint16_t raw);
+size_t adcPending();
+
+// Peripheral behind the index-th SPI device the firmware added: a register
+// file that transfers read and write from their address up. A queued
+// transaction completes transferUs after it was queued; its post_cb runs,
+// with the clock at that time, once the firmware collects the result.
+struct SpiRegisters {
+    uint8_t regs[128] = {};
+    int64_t transferUs = 0;
+    std::vector<std::pair<uint8_t, uint8_t>> writes;  // Register, value
+    uint32_t queued = 0;
+};
+SpiRegisters& spiDevice(size_t index);
+
+// The BLE serial the firmware began, nullptr before BLECom::begin()
+HostStream* ble();
+void registerBle(HostStream* stream);
+
+}  // namespace Host
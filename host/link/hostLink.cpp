@@ -0,0 +1,273 @@
+#include "hostLink.h"
+#include <string.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+
+namespace HostLink {
+
+SampleBuffer::SampleBuffer(size_t columns, size_t capacity)
+    : data(columns * capacity), width(columns), capacity(capacity) {}
+
+void SampleBuffer::push(const double* row) {
+    memcpy(&data[(written % capacity) * width], row, width * sizeof(double));
+    written++;
+    if (written - taken > capacity) {
+        dropped += written - taken - capacity;
+        taken = written - capacity;
+    }
+}
+
+size_t SampleBuffer::take(double* out, size_t maxRows) {
+    size_t n = std::min(pending(), maxRows);
+    size_t start = (size_t)(taken % capacity);
+    size_t first = std::min(n, capacity - start);  // Up to the end of the ring, then from its start
+    memcpy(out, &data[start * width], first * width * sizeof(double));
+    memcpy(out + first * width, &data[0], (n - first) * width * sizeof(double));
+    taken += n;
+    return n;
+}
+
+TextDecoder::TextDecoder(size_t columns) : columns(columns), row(columns + 1) {}
+
+void TextDecoder::feed(const char* data, size_t length, double now, SampleBuffer& rows,
+                       std::vector<std::string>& lines) {
+    pending.append(data, length);
+    size_t start = 0;
+    for (size_t end; (end = pending.find('\n', start)) != std::string::npos; start = end + 1) {
+        line(pending.data() + start, pending.data() + end, now, rows, lines);
+    }
+    pending.erase(0, start);
+    if (pending.size() > MAX_LINE) pending.erase(0, pending.size() - MAX_LINE);
+}
+
+// from_chars, not strtod: a GUI toolkit may have set a locale with decimal commas
+void TextDecoder::line(const char* begin, const char* end, double now, SampleBuffer& rows,
+                       std::vector<std::string>& lines) {
+    while (end > begin && end[-1] == '\r') end--;
+    if (begin == end) return;
+    if ((size_t)std::count(begin, end, '\t') != columns - 1) {
+        lines.emplace_back(begin, end);
+        return;
+    }
+
+    row[0] = now;
+    const char* field = begin;
+    for (size_t c = 1; c <= columns; c++) {
+        const char* stop = c < columns ? (const char*)memchr(field, '\t', end - field) : end;
+        while (field < stop && *field == ' ') field++;
+        auto parsed = std::from_chars(field, stop, row[c]);
+        const char* rest = parsed.ptr;
+        while (rest < stop && *rest == ' ') rest++;
+        if (parsed.ec != std::errc() || rest != stop) {
+            corrupt++;  // e.g. "ovf" from Print or line noise, dropped as the GUI always did
+            return;
+        }
+        field = stop + 1;
+    }
+    rows.push(row.data());
+}
+
+FrameDecoder::FrameDecoder(const uint8_t* channels, size_t count) : state(2 + count) {
+    std::fill(std::begin(column), std::end(column), -1);
+    for (size_t i = 0; i < count; i++) column[channels[i]] = (int)(2 + i);
+}
+
+void FrameDecoder::feed(const uint8_t* data, size_t length, double now, SampleBuffer& rows, std::string& text) {
+    pending.append((const char*)data, length);
+    const uint8_t* p = (const uint8_t*)pending.data();
+    size_t n = pending.size(), pos = 0;
+    while (pos < n) {
+        const uint8_t* sync = (const uint8_t*)memchr(p + pos, FRAME_SYNC, n - pos);
+        if (!sync) {
+            text.append((const char*)p + pos, n - pos);
+            pos = n;
+            break;
+        }
+        size_t at = sync - p;
+        text.append((const char*)p + pos, at - pos);
+        long used = frame(p + at, n - at, now, rows);
+        if (used == 0) {
+            pos = at;  // Frame continues in the next chunk
+            break;
+        }
+        if (used < 0) {
+            errors++;
+            pos = at + 1;
+        } else {
+            pos = at + used;
+        }
+    }
+    pending.erase(0, pos);
+}
+
+static bool varint(const uint8_t* p, size_t end, size_t& i, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (i >= end) return false;
+        uint8_t b = p[i++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+long FrameDecoder::frame(const uint8_t* data, size_t length, double now, SampleBuffer& rows) {
+    size_t i = 1;
+    uint32_t size = 0;
+    for (int shift = 0;; shift += 7) {
+        if (i >= length) return 0;
+        if (shift > 21) return -1;
+        uint8_t b = data[i++];
+        size |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    if (size < 2 || size > MAX_LINE) return -1;  // Flags and a tick at the least
+    if (i + size + 1 > length) return 0;
+
+    const uint8_t* payload = data + i;
+    uint8_t sum = 0;
+    for (size_t k = 0; k < size; k++) sum += payload[k];
+    if (sum != payload[size]) return -1;
+
+    bool key = payload[0] & FLAG_KEYFRAME;
+    size_t j = 1;
+    uint32_t tick;
+    if (!varint(payload, size, j, tick)) return -1;
+    while (j < size) {
+        uint8_t channel = payload[j++];
+        uint32_t raw;
+        if (!varint(payload, size, j, raw)) return -1;
+        int32_t delta = (int32_t)(raw >> 1) ^ -(int32_t)(raw & 1);
+        int32_t value = key ? delta : (int32_t)((uint32_t)last[channel] + (uint32_t)delta);
+        last[channel] = value;
+        if (column[channel] >= 0) state[column[channel]] = value;
+    }
+    state[0] = now;
+    state[1] = tick;
+    rows.push(state.data());
+    frames++;
+    return (long)(i + size + 1);
+}
+
+Link::Link(size_t textColumns, const uint8_t* channels, size_t channelCount, size_t capacity)
+    : textDecoder(textColumns), frameDecoder(channels, channelCount),
+      text(textColumns + 1, capacity), frames(channelCount + 2, capacity) {}
+
+void Link::feed(const uint8_t* data, size_t length, double now) {
+    std::lock_guard<std::mutex> guard(lock);
+    bytes += length;
+    const char* plain = (const char*)data;
+    size_t plainLength = length;
+    if (frameDecoder.midFrame() || memchr(data, FRAME_SYNC, length)) {
+        between.clear();
+        frameDecoder.feed(data, length, now, frames, between);
+        plain = between.data();
+        plainLength = between.size();
+    }
+
+    decodedLines.clear();
+    textDecoder.feed(plain, plainLength, now, text, decodedLines);
+    bool answered = false;
+    for (std::string& line : decodedLines) {
+        if (line.compare(0, 2, "OK") == 0 || line.compare(0, 3, "ERR") == 0) {
+            if (replies.size() >= MAX_LINES) replies.pop_front();
+            replies.push_back(std::move(line));
+            answered = true;
+        } else {
+            if (lines.size() >= MAX_LINES) lines.pop_front();
+            lines.emplace_back(now, std::move(line));
+        }
+    }
+    if (answered) replied.notify_all();
+}
+
+size_t Link::take(Stream stream, double* out, size_t maxRows) {
+    std::lock_guard<std::mutex> guard(lock);
+    return (stream == TEXT ? text : frames).take(out, maxRows);
+}
+
+size_t Link::pending(Stream stream) {
+    std::lock_guard<std::mutex> guard(lock);
+    return (stream == TEXT ? text : frames).pending();
+}
+
+bool Link::nextLine(std::string& line, double& time) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (lines.empty()) return false;
+    time = lines.front().first;
+    line = std::move(lines.front().second);
+    lines.pop_front();
+    return true;
+}
+
+bool Link::waitReply(std::string& reply, double timeoutS) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (!replied.wait_for(guard, std::chrono::duration<double>(timeoutS), [this] { return !replies.empty(); })) {
+        return false;
+    }
+    reply = std::move(replies.front());
+    replies.pop_front();
+    return true;
+}
+
+void Link::clearReplies() {
+    std::lock_guard<std::mutex> guard(lock);
+    replies.clear();
+}
+
+Link::Stats Link::stats() {
+    std::lock_guard<std::mutex> guard(lock);
+    return {bytes, text.written, frameDecoder.frames, frameDecoder.errors, textDecoder.corrupt,
+            text.dropped + frames.dropped};
+}
+
+}  // namespace HostLink
+
+using HostLink::Link;
+
+static long copyOut(const std::string& text, char* out, size_t capacity) {
+    if (capacity == 0) return 0;
+    size_t n = std::min(text.size(), capacity - 1);
+    memcpy(out, text.data(), n);
+    out[n] = '\0';
+    return (long)n;
+}
+
+void* hl_open(size_t text_columns, const uint8_t* channels, size_t channel_count, size_t capacity) {
+    if (text_columns == 0 || capacity == 0) return nullptr;
+    try {
+        return new Link(text_columns, channels, channel_count, capacity);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void hl_close(void* link) { delete (Link*)link; }
+
+void hl_feed(void* link, const uint8_t* data, size_t length, double now) { ((Link*)link)->feed(data, length, now); }
+
+size_t hl_columns(void* link, int stream) { return ((Link*)link)->columns((Link::Stream)stream); }
+
+size_t hl_pending(void* link, int stream) { return ((Link*)link)->pending((Link::Stream)stream); }
+
+size_t hl_take(void* link, int stream, double* out, size_t max_rows) {
+    return ((Link*)link)->take((Link::Stream)stream, out, max_rows);
+}
+
+long hl_next_line(void* link, char* out, size_t capacity, double* time) {
+    std::string line;
+    return ((Link*)link)->nextLine(line, *time) ? copyOut(line, out, capacity) : -1;
+}
+
+long hl_wait_reply(void* link, double timeout_s, char* out, size_t capacity) {
+    std::string reply;
+    return ((Link*)link)->waitReply(reply, timeout_s) ? copyOut(reply, out, capacity) : -1;
+}
+
+void hl_clear_replies(void* link) { ((Link*)link)->clearReplies(); }
+
+void hl_get_stats(void* link, hl_stats* out) {
+    Link::Stats s = ((Link*)link)->stats();
+    *out = {s.bytes, s.textRows, s.frames, s.frameErrors, s.corruptLines, s.dropped};
+}
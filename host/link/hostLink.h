@@ -0,0 +1,150 @@
+#pragma once
+// Host end of the controller's USB and BLE links: decodes whatever bytes
+// a transport delivered in one call, text telemetry lines and binary
+// Telemetry frames alike, into rings of double rows whose first column is
+// the host arrival time. Every other line is kept for the caller, with
+// OK/ERR replies in a queue of their own so a command can wait for its ack.
+//
+// Plain C++ with no firmware or HAL headers, built as a shared library;
+// tools/host_link.py binds the C functions at the bottom through ctypes,
+// which releases the GIL for each call.
+#include <stdint.h>
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HostLink {
+
+constexpr size_t TEXT_COLUMNS = 12;  // Telemetry::printText: setpoint, input, output, kp, ki, kd per joint
+constexpr uint8_t FRAME_SYNC = 0xA5;
+constexpr uint8_t FLAG_KEYFRAME = 0x01;
+constexpr size_t MAX_LINE = 4096;    // Longer runs without a newline are line noise
+
+// Fixed ring of rows; take() copies out the rows added since the last take,
+// oldest first. A reader that falls a whole ring behind loses the oldest rows.
+class SampleBuffer {
+public:
+    SampleBuffer(size_t columns, size_t capacity);
+
+    void push(const double* row);
+    size_t take(double* out, size_t maxRows);
+    size_t pending() const { return (size_t)(written - taken); }
+    size_t columns() const { return width; }
+
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+
+private:
+    std::vector<double> data;
+    size_t width, capacity;
+    uint64_t taken = 0;
+};
+
+// Tab separated lines with exactly `columns` numeric fields become rows;
+// other complete, non-empty lines are handed back as text
+class TextDecoder {
+public:
+    explicit TextDecoder(size_t columns = TEXT_COLUMNS);
+
+    void feed(const char* data, size_t length, double now, SampleBuffer& rows, std::vector<std::string>& lines);
+
+    uint64_t corrupt = 0;  // Right number of fields, but one would not parse
+
+private:
+    size_t columns;
+    std::string pending;
+    std::vector<double> row;
+
+    void line(const char* begin, const char* end, double now, SampleBuffer& rows, std::vector<std::string>& lines);
+};
+
+// Telemetry frames (firmware/telemetry.h) to rows of time, tick and the
+// listed channels, each carried forward until the next frame updates it.
+// Bytes between frames are appended to text for the TextDecoder.
+class FrameDecoder {
+public:
+    FrameDecoder(const uint8_t* channels, size_t count);
+
+    void feed(const uint8_t* data, size_t length, double now, SampleBuffer& rows, std::string& text);
+    bool midFrame() const { return !pending.empty(); }
+
+    uint64_t frames = 0;
+    uint64_t errors = 0;  // Bad length or checksum; the decoder resyncs on the next sync byte
+
+private:
+    int column[256];
+    int32_t last[256] = {};
+    std::vector<double> state;
+    std::string pending;
+
+    // Bytes the frame at data[0] takes, 0 if it continues past length, -1 if it is not a frame
+    long frame(const uint8_t* data, size_t length, double now, SampleBuffer& rows);
+};
+
+class Link {
+public:
+    enum Stream { TEXT, FRAMES };
+
+    Link(size_t textColumns, const uint8_t* channels, size_t channelCount, size_t capacity);
+
+    // Reader side: one transport read, however it splits lines and frames
+    void feed(const uint8_t* data, size_t length, double now);
+
+    size_t take(Stream stream, double* out, size_t maxRows);
+    size_t pending(Stream stream);
+    size_t columns(Stream stream) const { return (stream == TEXT ? text : frames).columns(); }
+    bool nextLine(std::string& line, double& time);       // Neither telemetry nor a reply
+    bool waitReply(std::string& reply, double timeoutS);  // Oldest OK/ERR, waiting up to timeoutS
+    void clearReplies();
+
+    struct Stats {
+        uint64_t bytes, textRows, frames, frameErrors, corruptLines, dropped;
+    };
+    Stats stats();
+
+private:
+    static constexpr size_t MAX_LINES = 1000;
+
+    std::mutex lock;
+    std::condition_variable replied;
+    TextDecoder textDecoder;
+    FrameDecoder frameDecoder;
+    SampleBuffer text, frames;
+    std::deque<std::pair<double, std::string>> lines;
+    std::deque<std::string> replies;
+    std::vector<std::string> decodedLines;
+    std::string between;
+    uint64_t bytes = 0;
+    uint64_t linesDropped = 0;
+};
+
+}  // namespace HostLink
+
+// C interface for the Python binding; the link handle is opaque.
+// Line and reply calls return the length copied, or -1 when there is none.
+#if defined(_WIN32)
+#define HOST_LINK_API __declspec(dllexport)
+#else
+#define HOST_LINK_API __attribute__((visibility("default")))
+#endif
+
+extern "C" {
+struct hl_stats {
+    uint64_t bytes, text_rows, frames, frame_errors, corrupt_lines, dropped;
+};
+
+HOST_LINK_API void* hl_open(size_t text_columns, const uint8_t* channels, size_t channel_count, size_t capacity);
+HOST_LINK_API void hl_close(void* link);
+HOST_LINK_API void hl_feed(void* link, const uint8_t* data, size_t length, double now);
+HOST_LINK_API size_t hl_columns(void* link, int stream);
+HOST_LINK_API size_t hl_pending(void* link, int stream);
+HOST_LINK_API size_t hl_take(void* link, int stream, double* out, size_t max_rows);
+HOST_LINK_API long hl_next_line(void* link, char* out, size_t capacity, double* time);
+HOST_LINK_API long hl_wait_reply(void* link, double timeout_s, char* out, size_t capacity);
+HOST_LINK_API void hl_clear_replies(void* link);
+HOST_LINK_API void hl_get_stats(void* link, hl_stats* out);
+}
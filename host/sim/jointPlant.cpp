@@ -0,0 +1,48 @@
+#include "jointPlant.h"
+#include <math.h>
+
+namespace Sim {
+
+void JointPlant::step(float drivePct, bool powered, double dtS) {
+    if (jammed) {
+        velocityDegS = 0.0;
+        return;
+    }
+    float drive = powered ? (leadsReversed ? -drivePct : drivePct) : 0.0f;
+    drive -= loadPct;
+    if (!geared()) {
+        advance(drive, dtS);
+        outputDeg = positionDeg;
+        return;
+    }
+
+    int substeps = (int)ceil(dtS / GEAR_STEP_S);
+    double h = dtS / substeps;
+    for (int i = 0; i < substeps; i++) {
+        advance(drive - (float)linkPct(), h);
+
+        // The output moves only as far as keeps the spring at its friction
+        double twist = positionDeg - outputDeg;
+        double held = params.backlashDeg * 0.5 + params.outputFrictionPct / params.stiffnessPctPerDeg;
+        if (fabs(twist) > held) outputDeg += twist - copysign(held, twist);
+    }
+}
+
+// Spring torque on the motor once the twist has crossed the gap
+double JointPlant::linkPct() const {
+    double twist = positionDeg - outputDeg;
+    double slack = fabs(twist) - params.backlashDeg * 0.5;
+    return slack > 0.0 ? copysign(params.stiffnessPctPerDeg * slack, twist) : 0.0;
+}
+
+void JointPlant::advance(float drive, double dtS) {
+    float effective = fabsf(drive) > params.frictionPct ? drive - copysignf(params.frictionPct, drive) : 0.0f;
+    double target = params.degPerSecPerPct * effective;
+
+    // Constant input over the step, so the lag integrates exactly
+    double decay = exp(-dtS / params.tauS);
+    positionDeg += target * dtS + (velocityDegS - target) * params.tauS * (1.0 - decay);
+    velocityDegS = target + (velocityDegS - target) * decay;
+}
+
+}  // namespace Sim
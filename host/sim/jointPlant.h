@@ -0,0 +1,45 @@
+#pragma once
+// Geared DC joint for host simulations: first-order velocity lag on the
+// driver percent with Coulomb friction, the model tools/lqr_design.py and
+// tools/gain_sweep.py fit. Faults are switched on by the scenario.
+//
+// positionDeg is the motor side the encoder reads. With a gearbox gap or
+// output friction set, the output shaft sits behind a gap and a spring as
+// in tools/backlash_sim.py: massless, held by its friction until the wind-up
+// past the gap breaks it free, and the motor carries the spring's torque.
+#include <stdint.h>
+
+namespace Sim {
+
+struct JointPlant {
+    struct Params {
+        float tauS = 0.03f;             // Velocity time constant
+        float degPerSecPerPct = 6.0f;   // Steady speed per % drive
+        float frictionPct = 3.0f;       // Drive lost to Coulomb friction
+        float backlashDeg = 0.0f;       // Gearbox gap, 0 and no output friction keeps it rigid
+        float stiffnessPctPerDeg = 40.0f;  // Drive taken up per deg of wind-up past the gap
+        float outputFrictionPct = 0.0f;    // Coulomb friction on the output shaft
+    };
+
+    Params params;
+    double positionDeg = 0.0;
+    double velocityDegS = 0.0;
+    double outputDeg = 0.0;          // Output shaft, follows positionDeg when rigid
+
+    // Faults
+    bool jammed = false;             // Output shaft blocked
+    bool leadsReversed = false;      // Motor wired backwards
+    float loadPct = 0.0f;            // Constant back-driving load, signed
+
+    // Advance by dtS with a constant signed drive; unpowered coasts down
+    void step(float drivePct, bool powered, double dtS);
+
+private:
+    static constexpr double GEAR_STEP_S = 0.0005;  // The spring is stiff next to the 10 ms tick
+
+    bool geared() const { return params.backlashDeg > 0.0f || params.outputFrictionPct > 0.0f; }
+    double linkPct() const;
+    void advance(float drive, double dtS);
+};
+
+}  // namespace Sim
@@ -0,0 +1,88 @@
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "controlTask.h"
+#include "paramStore.h"
+#include "eventLog.h"
+#include "bleCom.h"
+#include <ESP32Encoder.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace Sim {
+
+Rig::Rig(JointPlant::Params params) {
+    Host::reset();
+    EventLog::begin();
+    ControlTask::boot(true, Board::ENCODER_GLITCH_FILTER);
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const MotorPID::Config& cfg = motors[j].config();
+        encoder[j] = ESP32Encoder::forPin(Board::ENCODERS[cfg.encoderIndex].pinA);
+        emittedCounts[j] = encoder[j]->getCount();
+        plant[j].params = params;
+        plant[j].positionDeg = plant[j].outputDeg = emittedCounts[j] * (double)cfg.degPerCount;
+    }
+    BLECom::init();
+    replies();
+}
+
+void Rig::step() {
+    const double dtS = Board::CONTROL_PERIOD_US * 1e-6;
+    bool powered = Host::pinLevel(Board::SLEEP_PIN) == HIGH;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        const MotorPID::Config& cfg = motors[j].config();
+        // The driver sees the joint frame flipped for inverted wiring
+        int drive = motorControl.hostDrive(cfg.motorNum);
+        plant[j].step(cfg.inverted ? -drive : drive, powered, dtS);
+
+        int64_t counts = llround(plant[j].positionDeg * cfg.countsPerDeg);
+        if (!encoderDisconnected[j]) {
+            encoder[j]->hostMove(counts - emittedCounts[j]);
+            emittedCounts[j] = counts;
+        }
+    }
+    Host::advanceUs(Board::CONTROL_PERIOD_US);
+    ControlTask::tick();
+}
+
+void Rig::run(uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += Board::CONTROL_PERIOD_US / 1000) step();
+}
+
+void Rig::command(const char* line) {
+    Host::ble()->feed(std::string(line) + "\n");
+    BLECom::update();
+}
+
+std::string Rig::replies() { return Host::ble()->take(); }
+
+void Rig::setGains(size_t joint, float kp, float ki, float kd) {
+    ControlTask::send({ControlCommand::Type::Gains, (uint8_t)joint, {kp, ki, kd}});
+}
+
+float Rig::measuredDeg(size_t joint) const {
+    const MotorPID::Config& cfg = motors[joint].config();
+    return (float)(encoder[joint]->getCount() * (double)cfg.degPerCount);
+}
+
+double isolated(const std::function<double()>& scenario) {
+    int fds[2];
+    if (pipe(fds) != 0) return NAN;
+    fflush(nullptr);
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        double result = scenario();
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+    double result = NAN;
+    if (child < 0 || read(fds[0], &result, sizeof(result)) != sizeof(result)) result = NAN;
+    close(fds[0]);
+    int status = 0;
+    if (child > 0) waitpid(child, &status, 0);
+    return result;
+}
+
+}  // namespace Sim
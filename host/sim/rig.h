@@ -0,0 +1,42 @@
+#pragma once
+// The firmware brought up as setup() does, with a JointPlant on each joint
+// closing the loop through the fake driver and encoders. step() is one
+// control period: plant, encoders, clock, then ControlTask::tick().
+//
+// The firmware keeps its state in statics, so a process holds one Rig.
+// isolated() runs a scenario in a child process for tests that compare runs.
+#include "jointPlant.h"
+#include "boardConfig.h"
+#include <Arduino.h>
+#include <functional>
+
+class ESP32Encoder;
+
+namespace Sim {
+
+class Rig {
+public:
+    explicit Rig(JointPlant::Params params = {});
+
+    void step();
+    void run(uint32_t ms);  // step() for ms worth of control periods
+
+    // Comms side, as BLE would deliver it
+    void command(const char* line);
+    std::string replies();
+    void setGains(size_t joint, float kp, float ki, float kd);  // As the tuning table sends them
+
+    // Joint angle the encoder reports and the plant's true angle
+    float measuredDeg(size_t joint) const;
+    JointPlant plant[Board::NUM_JOINTS];
+    bool encoderDisconnected[Board::NUM_JOINTS] = {};
+
+private:
+    ESP32Encoder* encoder[Board::NUM_JOINTS];
+    int64_t emittedCounts[Board::NUM_JOINTS];
+};
+
+// Runs scenario in a forked child and returns its result; NaN if the child failed
+double isolated(const std::function<double()>& scenario);
+
+}  // namespace Sim
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+
+// Steps until the calibration ends or ms pass, tracking the widest excursion
+static void runSweep(Sim::Rig& rig, uint32_t ms, float& lowDeg, float& highDeg) {
+    for (uint32_t t = 0; t < ms && motors[0].backlash.calibrating(); t += Board::CONTROL_PERIOD_US / 1000) {
+        rig.step();
+        lowDeg = min(lowDeg, rig.measuredDeg(0));
+        highDeg = max(highDeg, rig.measuredDeg(0));
+    }
+}
+
+TEST(BacklashComp, SweepInsideTheLimitsRuns) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.command("lim1=-20,20");
+    rig.command("bklc1=8,20");
+    EXPECT_NE(rig.replies().find("OK bklc1"), std::string::npos);
+    rig.step();
+    EXPECT_TRUE(motors[0].backlash.calibrating());
+
+    float low = 0.0f, high = 0.0f;
+    runSweep(rig, 5000, low, high);
+    EXPECT_FALSE(motors[0].backlash.calibrating());
+    EXPECT_TRUE(motors[0].backlash.takeReport());
+    EXPECT_GT(high, 6.0f);
+    EXPECT_LT(low, -6.0f);
+    EXPECT_FALSE(supervisor.tripped());
+}
+
+TEST(BacklashComp, SweepPastTheLimitIsRefusedWithAReport) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.command("lim1=-20,20");
+    rig.command("tar1=15");
+    rig.run(1000);
+    rig.replies();
+
+    rig.command("bklc1=10,20");  // 15 + 10 is past the 20 deg limit
+    rig.step();
+    EXPECT_FALSE(motors[0].backlash.calibrating());
+    EXPECT_TRUE(motors[0].backlash.takeReport());
+    EXPECT_FALSE(motors[0].backlash.result().ok);
+    rig.run(500);
+    EXPECT_LT(rig.measuredDeg(0), 20.5f);
+}
+
+TEST(BacklashComp, AmplitudeWiderThanTheRangeIsRejected) {
+    Sim::Rig rig;
+    rig.command("lim1=-20,20");
+    rig.step();  // The control task applies the limits
+    rig.replies();
+    rig.command("bklc1=21,20");
+    EXPECT_EQ(rig.replies(), "ERR: Sweep wider than the joint range\r\n");
+    rig.step();
+    EXPECT_FALSE(motors[0].backlash.calibrating());
+}
+
+TEST(BacklashComp, NarrowedLimitsEndTheSweep) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.command("bklc1=10,20");
+    rig.run(200);
+    ASSERT_TRUE(motors[0].backlash.calibrating());
+
+    rig.command("lim1=-5,5");
+    rig.step();
+    EXPECT_FALSE(motors[0].backlash.calibrating());
+    EXPECT_TRUE(motors[0].backlash.takeReport());
+    EXPECT_FALSE(motors[0].backlash.result().ok);
+    rig.run(1000);
+    EXPECT_NEAR(rig.measuredDeg(0), 0.0f, 0.5f);  // Back on the reference it swept around
+}
+
+// tools/backlash_sim.py's default gearbox: a 1.5 deg gap, a stiff stage and
+// enough output friction for the sweep to see the engagement
+static Sim::JointPlant::Params gearbox() {
+    Sim::JointPlant::Params p;
+    p.backlashDeg = 1.5f;
+    p.stiffnessPctPerDeg = 40.0f;
+    p.outputFrictionPct = 6.0f;
+    return p;
+}
+
+// Width the bklc sweep finds, on the gains the sweeps above use
+static float calibratedWidth() {
+    Sim::Rig rig(gearbox());
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.command("bklc1=10,5");
+    rig.step();
+    float low = 0.0f, high = 0.0f;
+    runSweep(rig, 20000, low, high);
+    EXPECT_TRUE(motors[0].backlash.takeReport());
+    EXPECT_TRUE(motors[0].backlash.result().ok);
+    EXPECT_FALSE(supervisor.tripped());
+    return motors[0].backlash.result().widthDeg;
+}
+
+// Output-side RMS error on a 20 deg 0.2 Hz sine sent every tick, after the first 2 s
+static double sineError(float widthDeg) {
+    Sim::Rig rig(gearbox());
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    char line[32];
+    snprintf(line, sizeof(line), "bkl1=%.3f,0", widthDeg);
+    rig.command(line);
+    rig.run(500);
+    const double periodS = Board::CONTROL_PERIOD_US * 1e-6;
+    double sumSq = 0.0;
+    size_t count = 0;
+    for (int tick = 0; tick * periodS < 15.0; tick++) {
+        double t = tick * periodS;
+        double reference = 20.0 * sin(2 * M_PI * 0.2 * t);
+        snprintf(line, sizeof(line), "tar1=%.3f", reference);
+        rig.command(line);
+        rig.replies();
+        rig.step();
+        if (t < 2.0) continue;
+        double e = rig.plant[0].outputDeg - reference;
+        sumSq += e * e;
+        count++;
+    }
+    EXPECT_FALSE(supervisor.tripped());
+    return sqrt(sumSq / count);
+}
+
+// The sweep sees the gap plus the wind-up to break the output free on each side
+TEST(BacklashComp, CalibrationFindsTheGearboxGap) {
+    Sim::JointPlant::Params p = gearbox();
+    float lostMotion = p.backlashDeg + 2.0f * p.outputFrictionPct / p.stiffnessPctPerDeg;
+    float width = calibratedWidth();
+    RecordProperty("width_deg", std::to_string(width));
+    EXPECT_GT(width, p.backlashDeg);
+    EXPECT_NEAR(width, lostMotion, 0.25f);
+}
+
+TEST(BacklashComp, CompensationLowersOutputErrorOnAReversingSine) {
+    double width = Sim::isolated([] { return (double)calibratedWidth(); });
+    ASSERT_FALSE(std::isnan(width));
+    double bare = Sim::isolated([] { return sineError(0.0f); });
+    double compensated = Sim::isolated([width] { return sineError((float)width); });
+    RecordProperty("bare_rms_deg", std::to_string(bare));
+    RecordProperty("compensated_rms_deg", std::to_string(compensated));
+    ASSERT_FALSE(std::isnan(bare) || std::isnan(compensated));
+    EXPECT_LT(compensated, bare * 0.7);
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "biquad.h"
+
+static constexpr float SAMPLE_HZ = 100.0f;
+
+// Steady-state amplitude of the response to a unit sine at hz
+static float gainAt(Biquad section, float hz) {
+    float peak = 0.0f;
+    for (int n = 0; n < 4000; n++) {
+        float y = section.process(sinf(2.0f * (float)M_PI * hz * n / SAMPLE_HZ));
+        if (n >= 3000) peak = std::max(peak, fabsf(y));
+    }
+    return peak;
+}
+
+TEST(Biquad, LowpassPassesDcAndCutsAboveTheCorner) {
+    Biquad lp;
+    ASSERT_TRUE(lp.design(Biquad::LOWPASS, 5.0f, 0.707f, SAMPLE_HZ));
+    EXPECT_NEAR(lp.dcGain(), 1.0f, 1e-5f);
+    EXPECT_NEAR(gainAt(lp, 5.0f), 0.707f, 0.02f);
+    EXPECT_LT(gainAt(lp, 25.0f), 0.05f);
+}
+
+TEST(Biquad, NotchNullsItsCentre) {
+    Biquad notch;
+    ASSERT_TRUE(notch.design(Biquad::NOTCH, 12.0f, 2.0f, SAMPLE_HZ));
+    EXPECT_NEAR(notch.dcGain(), 1.0f, 1e-5f);
+    EXPECT_LT(gainAt(notch, 12.0f), 0.01f);
+    EXPECT_GT(gainAt(notch, 2.0f), 0.95f);
+}
+
+TEST(Biquad, LeadLagHasUnityDcAndRatioAtHighFrequency) {
+    Biquad lead;
+    ASSERT_TRUE(lead.design(Biquad::LEAD_LAG, 2.0f, 8.0f, SAMPLE_HZ));
+    EXPECT_NEAR(lead.dcGain(), 1.0f, 1e-5f);
+    EXPECT_EQ(lead.b2, 0.0f);
+    EXPECT_EQ(lead.a2, 0.0f);
+    // At Nyquist a first-order section's gain is the ratio of the prewarped corners
+    float kz = tanf((float)M_PI * 2.0f / SAMPLE_HZ), kp = tanf((float)M_PI * 8.0f / SAMPLE_HZ);
+    EXPECT_NEAR((lead.b0 - lead.b1) / (1.0f - lead.a1), kp / kz, 1e-4f);
+    EXPECT_GT(kp / kz, 1.0f);
+}
+
+TEST(Biquad, RejectsFrequenciesAndQOutOfRange) {
+    Biquad section;
+    section.design(Biquad::LOWPASS, 5.0f, 0.7f, SAMPLE_HZ);
+    Biquad before = section;
+    EXPECT_FALSE(section.design(Biquad::LOWPASS, 50.0f, 0.7f, SAMPLE_HZ));
+    EXPECT_FALSE(section.design(Biquad::LOWPASS, 0.0f, 0.7f, SAMPLE_HZ));
+    EXPECT_FALSE(section.design(Biquad::NOTCH, 10.0f, 0.01f, SAMPLE_HZ));
+    EXPECT_FALSE(section.design(Biquad::LEAD_LAG, 10.0f, 60.0f, SAMPLE_HZ));
+    EXPECT_EQ(section.b0, before.b0);
+    EXPECT_EQ(section.a1, before.a1);
+}
+
+TEST(BiquadChain, ChangingASectionDoesNotKick) {
+    BiquadChain<4> chain;
+    for (int n = 0; n < 100; n++) chain.process(42.0f);
+    ASSERT_TRUE(chain.set(0, Biquad::LOWPASS, 5.0f, 0.707f, SAMPLE_HZ, 42.0f));
+    ASSERT_TRUE(chain.set(1, Biquad::NOTCH, 20.0f, 1.0f, SAMPLE_HZ, 42.0f));
+    EXPECT_EQ(chain.size(), 2u);
+    for (int n = 0; n < 20; n++) EXPECT_NEAR(chain.process(42.0f), 42.0f, 1e-3f);
+
+    EXPECT_FALSE(chain.set(3, Biquad::LOWPASS, 5.0f, 0.707f, SAMPLE_HZ, 42.0f));  // No gaps
+    ASSERT_TRUE(chain.set(0, Biquad::OFF, 0, 0, SAMPLE_HZ, 42.0f));
+    EXPECT_EQ(chain.size(), 0u);
+    EXPECT_EQ(chain.process(7.0f), 7.0f);
+}
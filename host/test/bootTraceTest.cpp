@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "hostHal.h"
+#include "bootTrace.h"
+#include "controlTask.h"
+#include "jointSupervisor.h"
+#include "eventLog.h"
+#include "bleCom.h"
+
+static constexpr int64_t NVS_OPEN_US = 20000;  // A slow flash, per namespace opened
+
+// setup() and the comms task's deferred BLE bring-up with the given delays.
+// The control task's first tick runs as soon as the task exists, on its own
+// core; on the host it runs there and then
+static std::string boot(int64_t nvsUs, int64_t bleUs, bool nvsFails = false) {
+    Host::reset();
+    Host::nvsFailOpen = nvsFails;
+    Host::nvsOpenUs = nvsUs;
+    Host::bleInitUs = bleUs;
+    EventLog::begin();
+    ControlTask::boot(Board::RESET_COUNT_ON_BOOT, Board::ENCODER_GLITCH_FILTER);
+    ControlTask::tick();
+
+    BootTrace::begin(BootTrace::BLE);
+    BLECom::init();
+    BootTrace::end(BootTrace::BLE);
+    BootTrace::markReady();
+
+    HostStream out;
+    BootTrace::report(out);
+    return out.take();
+}
+
+static long long field(const std::string& text, const std::string& name) {
+    size_t at = text.find(name + "=");
+    return at == std::string::npos ? -1 : strtoll(text.c_str() + at + name.size() + 1, nullptr, 10);
+}
+
+static long long phaseEnd(const std::string& text, const char* phase) {
+    std::string line = text.substr(text.find(std::string("BOOT ") + phase + " "));
+    return field(line, "start_us") + field(line, "dur_us");
+}
+
+TEST(BootTrace, FirstTickWaitsForTheCriticalPathOnly) {
+    constexpr int64_t BLE_US = 800000;
+    std::string text = boot(NVS_OPEN_US, BLE_US);
+    long long firstTick = field(text, "first_tick_us");
+    long long ready = field(text, "ready_us");
+    printf("%s", text.c_str());
+
+    // Holding starts right after the task is created. Until then only two
+    // NVS opens cost time, the encoder counts and the saved profile; the BLE
+    // stack moves ready, never the first tick
+    EXPECT_EQ(firstTick, phaseEnd(text, "control_start"));
+    EXPECT_EQ(firstTick, 1000000 + 2 * NVS_OPEN_US);
+    EXPECT_EQ(ready - firstTick, BLE_US);
+    EXPECT_NE(text.find("nvs=ok"), std::string::npos);
+}
+
+TEST(BootTrace, NvsFailureStillStartsTheLoop) {
+    std::string text = boot(NVS_OPEN_US, 0, true);
+    EXPECT_NE(text.find("nvs=fail"), std::string::npos);
+    EXPECT_GT(field(text, "first_tick_us"), 0);
+
+    for (int i = 0; i < 100; i++) {
+        Host::advanceUs(Board::CONTROL_PERIOD_US);
+        ControlTask::tick();
+    }
+    EXPECT_EQ(ControlTask::stats().ticks, 101u);
+    EXPECT_FALSE(supervisor.tripped());
+    EXPECT_EQ(Host::pinLevel(Board::SLEEP_PIN), HIGH);
+}
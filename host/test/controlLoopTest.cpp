@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+
+TEST(ControlLoop, BootsHoldingTheRestoredPosition) {
+    Sim::Rig rig;
+    EXPECT_EQ(Host::pinLevel(Board::SLEEP_PIN), HIGH);
+    rig.run(200);
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        EXPECT_NEAR(rig.measuredDeg(j), 0.0f, 0.2f);
+        EXPECT_EQ(motorControl.hostDrive(motors[j].config().motorNum), 0);
+    }
+    EXPECT_FALSE(supervisor.tripped());
+}
+
+TEST(ControlLoop, SettlesOnAStepCommand) {
+    Sim::Rig rig;
+    rig.command("tar1=30");
+    EXPECT_NE(rig.replies().find("OK tar1=30.00"), std::string::npos);
+    rig.run(2000);
+    EXPECT_NEAR(rig.measuredDeg(0), 30.0f, 0.5f);
+    EXPECT_NEAR(rig.plant[0].positionDeg, 30.0, 0.5);
+    EXPECT_NEAR(rig.measuredDeg(1), 0.0f, 0.5f);
+    EXPECT_FALSE(supervisor.tripped());
+}
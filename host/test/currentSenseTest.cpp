@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+#include "currentSense.h"
+
+static constexpr uint32_t START_BIN[] = {4, 13};  // On-time start per joint
+static constexpr float FULL_AMPS = 1.5f;          // At 100 % drive
+static constexpr float OFFSET_RAW = 40.0f;
+
+// One control period of shunt samples as the DMA delivers them, interleaved
+// by joint: the on-time starts at START_BIN and carries current in
+// proportion to the drive the bridge is applying
+static void shuntPeriod() {
+    bool powered = Host::pinLevel(Board::SLEEP_PIN) == HIGH;
+    constexpr uint32_t periods = Board::PWM_FREQUENCY_HZ * Board::CONTROL_PERIOD_US / 1000000;
+    for (uint32_t n = 0; n < periods * CurrentSense::BINS; n++) {
+        uint32_t bin = n % CurrentSense::BINS;
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            float drive = powered ? fabsf(motors[j].appliedDrive()) : 0.0f;
+            uint32_t onBins = (uint32_t)(drive * 0.01f * CurrentSense::BINS + 0.5f);
+            float raw = OFFSET_RAW;
+            if ((bin + CurrentSense::BINS - START_BIN[j]) % CurrentSense::BINS < onBins) {
+                raw += FULL_AMPS * drive * 0.01f * Board::CURRENT_SENSE_MV_PER_A * (4095.0f / 3100.0f);
+            }
+            Host::adcPush(Board::CURRENT_SENSE_PINS[j] - 1, (uint16_t)lroundf(raw));
+        }
+    }
+}
+
+static void run(Sim::Rig& rig, uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += Board::CONTROL_PERIOD_US / 1000) {
+        shuntPeriod();
+        rig.step();
+    }
+}
+
+static float reported(Sim::Rig& rig, const char* field) {
+    rig.replies();
+    CurrentSense::report(*Host::ble());
+    std::string text = rig.replies();
+    size_t at = text.find(field);
+    return at == std::string::npos ? NAN : strtof(text.c_str() + at + strlen(field), nullptr);
+}
+
+TEST(CurrentSense, LocksOntoTheOnTimeAndReadsTheCurrent) {
+    Sim::Rig rig;
+    CurrentSense::begin(true);
+    run(rig, 1000);  // Offset learnt while holding
+    EXPECT_EQ(Host::adcPending(), 0u);
+    EXPECT_NEAR(reported(rig, "zero1="), OFFSET_RAW, 1.0f);
+
+    // Proportional only against a blocked shaft: a steady drive of about 46 %
+    rig.setGains(0, 1.0f, 0.0f, 0.0f);
+    rig.plant[0].jammed = true;
+    rig.command("tar1=-2");
+    run(rig, 500);
+    float drive = motors[0].appliedDrive();
+    ASSERT_LT(drive, -30.0f);
+    EXPECT_NEAR(CurrentSense::amps(0), FULL_AMPS * drive * 0.01f, 0.02f);
+    EXPECT_NEAR(CurrentSense::amps(1), 0.0f, 0.01f);
+
+    uint32_t onBins = (uint32_t)(fabsf(drive) * 0.01f * CurrentSense::BINS + 0.5f);
+    EXPECT_EQ(reported(rig, "on1="), onBins);
+    EXPECT_NEAR(reported(rig, "lock1="), (START_BIN[0] + onBins / 2) % CurrentSense::BINS, 1.0f);
+    EXPECT_FALSE(supervisor.tripped());
+}
+
+TEST(CurrentSense, OffsetHoldsWhileTheBinsDecayAfterAStop) {
+    Sim::Rig rig;
+    CurrentSense::begin(true);
+    run(rig, 1000);
+    EXPECT_NEAR(reported(rig, "zero1="), OFFSET_RAW, 1.0f);
+
+    // Stalled at full drive until the supervisor cuts the bridge
+    rig.plant[0].jammed = true;
+    rig.command("tar1=30");
+    uint32_t ms = 0;
+    for (; ms < 2000 && !supervisor.tripped(); ms += 10) run(rig, 10);
+    ASSERT_TRUE(supervisor.tripped());
+    EXPECT_GT(fabsf(CurrentSense::amps(0)), 1.0f);
+
+    // Learning from the decaying bins would pull the zero up by hundreds of counts
+    float highest = 0.0f;
+    for (int i = 0; i < 100; i++) {
+        run(rig, 10);
+        highest = max(highest, reported(rig, "zero1="));
+    }
+    EXPECT_NEAR(highest, OFFSET_RAW, 3.0f);
+    EXPECT_NEAR(CurrentSense::amps(0), 0.0f, 0.02f);
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "hostHal.h"
+#include "eventLog.h"
+
+static std::string report() {
+    HostStream out;
+    EventLog::report(out);
+    return out.take();
+}
+
+static size_t countOf(const std::string& text, const std::string& what) {
+    size_t n = 0;
+    for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) n++;
+    return n;
+}
+
+TEST(EventLog, KeepsTheNewestEventsInOrder) {
+    Host::reset();
+    EventLog::begin();  // Power-on: logs BOOT as seq 1
+    for (uint32_t i = 0; i < 300; i++) EventLog::log(EventLog::OVERRUN, EventLog::NO_JOINT, 0, i);
+
+    std::string text = report();
+    EXPECT_EQ(text.rfind("LOG boots=1 events=128 lost=0 this_boot=1\n", 0), 0u) << text;
+    // Oldest kept is seq 174 (value 172), newest seq 301
+    size_t oldest = text.find("EVT seq=174 ");
+    ASSERT_NE(oldest, std::string::npos);
+    EXPECT_NE(text.find("value=172", oldest), std::string::npos);
+    EXPECT_GT(text.find("EVT seq=301 "), oldest);
+    EXPECT_EQ(text.find("EVT seq=173 "), std::string::npos);
+}
+
+TEST(EventLog, CommandFloodLeavesTheFaultHistory) {
+    Host::reset();
+    EventLog::begin();
+    EventLog::log(EventLog::FAULT, 1, 0x04);
+    for (uint32_t i = 0; i < 50 * 60; i++) EventLog::log(EventLog::COMMAND, 0, 0, 120);  // A minute at 50 Hz
+
+    std::string text = report();
+    EXPECT_NE(text.find("type=fault j=2 arg=4"), std::string::npos) << text;
+    EXPECT_NE(text.find("CMDLOG events=32 lost=0"), std::string::npos);
+    EXPECT_EQ(countOf(text, "type=command"), EventLog::COMMAND_CAPACITY);
+}
+
+TEST(EventLog, SurvivesASoftwareResetButNotPowerOn) {
+    Host::reset();
+    EventLog::begin();
+    EventLog::log(EventLog::FAULT, 0, 0x01);
+    EventLog::log(EventLog::COMMAND, 0, 2, 50);
+
+    Host::setResetReason(ESP_RST_PANIC);
+    EventLog::begin();
+    std::string text = report();
+    EXPECT_EQ(text.rfind("LOG boots=2 events=3 lost=0 this_boot=3\n", 0), 0u) << text;
+    EXPECT_NE(text.find("type=fault j=1 arg=1"), std::string::npos);
+    EXPECT_NE(text.find("CMDLOG events=1 lost=0 this_boot=2"), std::string::npos);
+    EXPECT_NE(text.find("EVT seq=3 tick=0 type=boot j=0 arg=" + std::to_string(ESP_RST_PANIC)), std::string::npos);
+
+    Host::setResetReason(ESP_RST_POWERON);
+    EventLog::begin();
+    text = report();
+    EXPECT_EQ(text.rfind("LOG boots=1 events=1 lost=0 this_boot=1\n", 0), 0u) << text;
+    EXPECT_NE(text.find("CMDLOG events=0"), std::string::npos);
+}
+
+TEST(EventLog, ClearHidesWhatCameBefore) {
+    Host::reset();
+    EventLog::begin();
+    EventLog::log(EventLog::IDLE);
+    EventLog::log(EventLog::COMMAND, 0, 1, 10);
+    EventLog::clear();
+    EventLog::log(EventLog::WAKE);
+
+    std::string text = report();
+    EXPECT_NE(text.find("LOG boots=1 events=1 "), std::string::npos) << text;
+    EXPECT_EQ(text.find("type=idle"), std::string::npos);
+    EXPECT_NE(text.find("type=wake"), std::string::npos);
+    EXPECT_NE(text.find("CMDLOG events=0"), std::string::npos);
+}
+
+// Two tasks logging at once: every slot ends up whole, stamped with its own
+// sequence, and each producer's events keep their order
+TEST(EventLog, ConcurrentProducersNeverTearASlot) {
+    constexpr size_t N = 64;
+    static volatile EventLog::Event slots[N];
+    std::atomic<uint32_t> counter{0};
+    constexpr uint32_t PER_PRODUCER = 200000;
+
+    auto producer = [&](uint8_t id) {
+        for (uint32_t i = 1; i <= PER_PRODUCER; i++) {
+            EventLog::append(slots, N, counter, EventLog::COMMAND, id, (uint16_t)(i * 7), i);
+        }
+    };
+    std::thread a(producer, 0), b(producer, 1);
+    a.join();
+    b.join();
+
+    ASSERT_EQ(counter.load(), 2 * PER_PRODUCER);
+    uint32_t lastValue[2] = {};
+    for (uint32_t seq = counter.load() - N + 1; seq <= counter.load(); seq++) {
+        const volatile EventLog::Event& e = slots[seq & (N - 1)];
+        ASSERT_EQ(e.seq, seq);
+        ASSERT_LT(e.joint, 2);
+        EXPECT_EQ(e.arg, (uint16_t)(e.value * 7));
+        EXPECT_GT(e.value, lastValue[e.joint]);
+        lastValue[e.joint] = e.value;
+    }
+}
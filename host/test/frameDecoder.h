@@ -0,0 +1,62 @@
+#pragma once
+// Reference decoder for Telemetry frames, written from the format comment in
+// telemetry.h rather than from the encoder, so the two can check each other.
+#include <stdint.h>
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+
+struct DecodedFrame {
+    bool key;
+    uint32_t tick;
+    std::map<uint8_t, int32_t> values;  // Absolute, deltas already applied
+};
+
+class FrameDecoder {
+public:
+    // Every complete frame in bytes; false on a bad checksum or a delta before any key frame
+    bool decode(const std::string& bytes, std::vector<DecodedFrame>& frames) {
+        size_t i = 0;
+        while (i < bytes.size()) {
+            if ((uint8_t)bytes[i++] != 0xA5) return false;
+            uint32_t length = varint(bytes, i);
+            if (i + length + 1 > bytes.size()) return false;
+            const uint8_t* p = (const uint8_t*)bytes.data() + i;
+            uint8_t sum = 0;
+            for (size_t k = 0; k < length; k++) sum += p[k];
+            if (sum != p[length]) return false;
+
+            size_t end = i + length;
+            DecodedFrame f;
+            f.key = (bytes[i++] & 0x01) != 0;
+            f.tick = varint(bytes, i);
+            if (f.key) haveKey = true;
+            if (!haveKey) return false;
+            while (i < end) {
+                uint8_t channel = (uint8_t)bytes[i++];
+                uint32_t z = varint(bytes, i);
+                int32_t v = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+                last[channel] = f.key ? v : last[channel] + v;
+                f.values[channel] = last[channel];
+            }
+            i = end + 1;
+            frames.push_back(f);
+        }
+        return true;
+    }
+
+private:
+    static uint32_t varint(const std::string& bytes, size_t& i) {
+        uint32_t v = 0;
+        for (int shift = 0; i < bytes.size() && shift < 35; shift += 7) {
+            uint8_t b = (uint8_t)bytes[i++];
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return v;
+    }
+
+    std::map<uint8_t, int32_t> last;
+    bool haveKey = false;
+};
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "motorConfig.h"
+
+static void uploadTable(Sim::Rig& rig) {
+    rig.command("gs1=e,0,10,2");
+    rig.command("gsp1=0,0.5,2,0.01,1,4,0.02");
+}
+
+TEST(GainSchedule, InterpolatesBetweenBreakpoints) {
+    GainSchedule table;
+    GainSchedule::Axis x, y;
+    x.key = GainSchedule::Key::Error;
+    x.invStep = 0.1f;
+    x.count = 2;
+    ASSERT_TRUE(table.configure(x, y));
+    ASSERT_TRUE(table.setPoint(0, {0.5f, 2.0f, 0.01f}));
+    EXPECT_FALSE(table.complete());
+    ASSERT_TRUE(table.setPoint(1, {1.0f, 4.0f, 0.02f}));
+    ASSERT_TRUE(table.complete());
+
+    GainSchedule::Gains mid = table.lookup(5.0f, 0.0f);
+    EXPECT_NEAR(mid.kp, 0.75f, 1e-6f);
+    EXPECT_NEAR(mid.ki, 3.0f, 1e-6f);
+    EXPECT_NEAR(table.lookup(-3.0f, 0.0f).kp, 0.5f, 1e-6f);  // Clamped to the table
+    EXPECT_NEAR(table.lookup(30.0f, 0.0f).kp, 1.0f, 1e-6f);
+}
+
+TEST(GainSchedule, StagingIsReadOnlyUntilTheControlTickAcknowledgesTheSwap) {
+    Sim::Rig rig;
+    uploadTable(rig);
+    rig.command("gsc1");
+    EXPECT_NE(rig.replies().find("OK gsc1"), std::string::npos);
+    EXPECT_FALSE(motors[0].stagingWritable());
+
+    // The table just swapped out may still be under the control core's lookup
+    rig.command("gs1=v,0,50,2");
+    rig.command("gsp1=0,9,9,9");
+    rig.command("gsc1");
+    std::string replies = rig.replies();
+    EXPECT_EQ(replies, "ERR: Gain table swap pending\r\nERR: Gain table swap pending\r\nERR: Gain table swap pending\r\n");
+
+    rig.step();
+    EXPECT_TRUE(motors[0].stagingWritable());
+    uploadTable(rig);
+    rig.command("gsc1");
+    EXPECT_NE(rig.replies().find("OK gsc1"), std::string::npos);
+}
+
+TEST(GainSchedule, CommittedTableDrivesTheGains) {
+    Sim::Rig rig;
+    uploadTable(rig);
+    rig.command("gsc1");
+    rig.run(1000);  // Holding still: error near 0, so the first breakpoint
+    EXPECT_NEAR(motors[0].Kp, 0.5f, 0.02f);
+    EXPECT_NEAR(motors[0].Ki, 2.0f, 0.05f);
+    EXPECT_TRUE(motors[0].scheduleActive());
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "telemetry.h"
+#include "hostLink.h"
+
+static ControlState stateAt(uint32_t tick) {
+    ControlState s = {};
+    s.tick = tick;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        s.joints[j].setpoint = 834.4f + j;
+        s.joints[j].input = 300.0f * sinf(tick * 0.37f + j) + (tick % 7 == 0 ? 70000.0f : 0.0f);
+        s.joints[j].output = -37.55f + tick * 0.25f;
+        s.joints[j].velocityDeg = (float)tick * (j ? -1.5f : 1.5f);
+        s.joints[j].kp = 1.32f;
+        s.joints[j].ki = 10.28f;
+        s.joints[j].kd = 0.1f;
+    }
+    return s;
+}
+
+// The USB stream as the firmware writes it: binary frames with the tuning
+// table's text lines and command replies in between
+static std::string usbStream(uint32_t ticks, Telemetry& telemetry, HostStream& out) {
+    for (uint32_t t = 0; t < ticks; t++) {
+        ControlState s = stateAt(t);
+        telemetry.publish(s);
+        Telemetry::printText(out, s);
+        if (t == ticks / 2) out.println("OK tsub=usb,0,pvo,1");
+        if (t == ticks / 3) out.println("LAT n=3 p50_us=12");
+    }
+    return out.take();
+}
+
+static std::vector<uint8_t> channels() {
+    std::vector<uint8_t> ids;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        for (Telemetry::Kind kind : {Telemetry::CH_POSITION, Telemetry::CH_VELOCITY, Telemetry::CH_OUTPUT}) {
+            ids.push_back(Telemetry::channelId(j, kind));
+        }
+    }
+    return ids;
+}
+
+TEST(HostLink, RealTelemetryRoundTripsInAnyChunking) {
+    constexpr uint32_t TICKS = 160;  // Past three key frames
+    std::vector<uint8_t> ids = channels();
+    for (size_t chunk : {(size_t)1, (size_t)7, (size_t)64, (size_t)4096}) {
+        HostStream out;
+        Telemetry telemetry(out);
+        ASSERT_EQ(telemetry.subscribeLetters(0, "pvo", 1), (int)ids.size());
+        std::string bytes = usbStream(TICKS, telemetry, out);
+
+        HostLink::Link link(HostLink::TEXT_COLUMNS, ids.data(), ids.size(), 1024);
+        for (size_t at = 0; at < bytes.size(); at += chunk) {
+            link.feed((const uint8_t*)bytes.data() + at, std::min(chunk, bytes.size() - at), at * 1e-6);
+        }
+
+        std::vector<double> frames(TICKS * link.columns(HostLink::Link::FRAMES));
+        ASSERT_EQ(link.take(HostLink::Link::FRAMES, frames.data(), TICKS), TICKS) << chunk;
+        std::vector<double> text(TICKS * link.columns(HostLink::Link::TEXT));
+        ASSERT_EQ(link.take(HostLink::Link::TEXT, text.data(), TICKS), TICKS) << chunk;
+        for (uint32_t t = 0; t < TICKS; t++) {
+            ControlState s = stateAt(t);
+            const double* f = &frames[t * (2 + ids.size())];
+            const double* row = &text[t * (1 + HostLink::TEXT_COLUMNS)];
+            ASSERT_EQ(f[1], t);
+            for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+                EXPECT_EQ(f[2 + 3 * j], lroundf(s.joints[j].input)) << t;
+                EXPECT_EQ(f[3 + 3 * j], lroundf(s.joints[j].velocityDeg * 10.0f)) << t;
+                EXPECT_EQ(f[4 + 3 * j], lroundf(s.joints[j].output * 10.0f)) << t;
+                EXPECT_NEAR(row[1 + 6 * j], s.joints[j].setpoint, 0.006) << t;
+                EXPECT_NEAR(row[2 + 6 * j], s.joints[j].input, 0.006) << t;
+                EXPECT_NEAR(row[3 + 6 * j], s.joints[j].output, 0.006) << t;
+                EXPECT_NEAR(row[6 + 6 * j], 0.1, 1e-9) << t;
+            }
+        }
+
+        std::string reply, line;
+        double when;
+        EXPECT_TRUE(link.waitReply(reply, 0.0));
+        EXPECT_EQ(reply, "OK tsub=usb,0,pvo,1");
+        ASSERT_TRUE(link.nextLine(line, when));
+        EXPECT_EQ(line, "LAT n=3 p50_us=12");
+        EXPECT_FALSE(link.nextLine(line, when));
+
+        HostLink::Link::Stats stats = link.stats();
+        EXPECT_EQ(stats.frameErrors, 0u);
+        EXPECT_EQ(stats.corruptLines, 0u);
+        EXPECT_EQ(stats.bytes, bytes.size());
+    }
+}
+
+TEST(HostLink, BadChecksumCostsOneFrameAndTheNextKeyFrameResyncs) {
+    std::vector<uint8_t> ids = channels();
+    HostStream out;
+    Telemetry telemetry(out);
+    telemetry.subscribeLetters(0, "pvo", 1);
+    std::vector<size_t> starts;
+    for (uint32_t t = 0; t < Telemetry::KEYFRAME_INTERVAL + 5; t++) {
+        starts.push_back(out.written().size());
+        telemetry.publish(stateAt(t));
+    }
+    std::string bytes = out.take();
+    bytes[starts[11] - 1] ^= 0x5A;  // Checksum of frame 10
+
+    HostLink::Link link(HostLink::TEXT_COLUMNS, ids.data(), ids.size(), 1024);
+    link.feed((const uint8_t*)bytes.data(), bytes.size(), 0.0);
+    EXPECT_EQ(link.stats().frameErrors, 1u);
+    std::vector<double> frames(starts.size() * (2 + ids.size()));
+    size_t n = link.take(HostLink::Link::FRAMES, frames.data(), starts.size());
+    ASSERT_EQ(n, starts.size() - 1);
+
+    const double* key = &frames[(n - 5) * (2 + ids.size())];
+    EXPECT_EQ(key[1], Telemetry::KEYFRAME_INTERVAL);
+    EXPECT_EQ(key[2], lroundf(stateAt(Telemetry::KEYFRAME_INTERVAL).joints[0].input));
+}
+
+TEST(HostLink, MalformedTextIsCountedNotDecoded) {
+    HostLink::Link link(HostLink::TEXT_COLUMNS, nullptr, 0, 16);
+    std::string text = "1\t2\t3\t4\t5\t6\t7\t8\t9\t10\t11\tovf\n1\t2\t3\t4\t5\t6\t7\t8\t9\t10\t11\t12\r\nERR: bad\r\n";
+    link.feed((const uint8_t*)text.data(), text.size(), 2.5);
+    EXPECT_EQ(link.stats().corruptLines, 1u);
+    double row[1 + HostLink::TEXT_COLUMNS];
+    ASSERT_EQ(link.take(HostLink::Link::TEXT, row, 4), 1u);
+    EXPECT_EQ(row[0], 2.5);
+    EXPECT_EQ(row[12], 12.0);
+
+    std::string reply;
+    EXPECT_TRUE(link.waitReply(reply, 0.0));
+    EXPECT_EQ(reply, "ERR: bad");
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(link.waitReply(reply, 0.05));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(45));
+}
+
+TEST(HostLink, SlowReaderLosesTheOldestRows) {
+    HostLink::SampleBuffer ring(2, 4);
+    for (int i = 0; i < 6; i++) {
+        double row[2] = {(double)i, (double)-i};
+        ring.push(row);
+    }
+    EXPECT_EQ(ring.dropped, 2u);
+    double out[8];
+    ASSERT_EQ(ring.take(out, 8), 4u);
+    for (int i = 0; i < 4; i++) EXPECT_EQ(out[2 * i], i + 2);
+    EXPECT_EQ(ring.take(out, 8), 0u);
+}
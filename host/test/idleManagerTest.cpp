@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "idleManager.h"
+#include "jointSupervisor.h"
+
+static constexpr uint32_t DWELL_TICKS = IdleManager::DWELL_MS * 1000 / Board::CONTROL_PERIOD_US;
+
+// The rig boots holding where it is, so it counts as settled from the first tick
+static void park(Sim::Rig& rig) {
+    for (uint32_t i = 0; i < DWELL_TICKS && !IdleManager::idle(); i++) rig.step();
+    ASSERT_TRUE(IdleManager::idle());
+}
+
+static bool driven(size_t joint) {
+    return Host::pinLevel(Board::SLEEP_PIN) == HIGH && motorControl.hostDrive(motors[joint].config().motorNum) != 0;
+}
+
+TEST(IdleManager, ParksAfterTheDwellWithTheDriverAsleep) {
+    Sim::Rig rig;
+    for (uint32_t i = 0; i + 1 < DWELL_TICKS; i++) rig.step();
+    EXPECT_FALSE(IdleManager::idle());
+    EXPECT_EQ(Host::pinLevel(Board::SLEEP_PIN), HIGH);
+
+    rig.step();
+    EXPECT_TRUE(IdleManager::idle());
+    EXPECT_EQ(Host::pinLevel(Board::SLEEP_PIN), LOW);
+    EXPECT_EQ(motorControl.hostDrive(motors[0].config().motorNum), 0);
+}
+
+TEST(IdleManager, CommandWakesTheDriverInTheSameTick) {
+    Sim::Rig rig;
+    park(rig);
+    rig.command("tar1=10");
+    rig.step();
+    EXPECT_FALSE(IdleManager::idle());
+    EXPECT_TRUE(driven(0));
+}
+
+TEST(IdleManager, PushPastTheWakeErrorWakesInTheSameTick) {
+    Sim::Rig rig;
+    park(rig);
+    const MotorPID::Config& cfg = motors[0].config();
+
+    // Inside the wake band it stays parked
+    rig.plant[0].positionDeg += (IdleManager::WAKE_ERROR_COUNTS - 1) * cfg.degPerCount;
+    rig.step();
+    rig.step();
+    EXPECT_TRUE(IdleManager::idle());
+
+    rig.plant[0].positionDeg += 2 * cfg.degPerCount;
+    rig.step();
+    EXPECT_FALSE(IdleManager::idle());
+    EXPECT_TRUE(driven(0));
+}
+
+TEST(IdleManager, NeverParksWhileTripped) {
+    Sim::Rig rig;
+    rig.plant[0].jammed = true;
+    rig.command("tar1=30");
+    for (int i = 0; i < 300 && !supervisor.tripped(); i++) rig.step();
+    ASSERT_TRUE(supervisor.tripped());
+
+    // Freed and on target, so every joint is settled, but the trip holds it awake
+    rig.plant[0].jammed = false;
+    rig.plant[0].positionDeg = 30.0;
+    rig.run(2 * IdleManager::DWELL_MS);
+    EXPECT_LE(fabsf(motors[0].errorCounts()), BRAKING_THRESHOLD);
+    EXPECT_FALSE(IdleManager::idle());
+}
+
+TEST(IdleManager, ServiceKeepsTheFullClockThroughTheGrace) {
+    Sim::Rig rig;
+    park(rig);
+    IdleManager::service();
+    EXPECT_EQ(getCpuFrequencyMhz(), IdleManager::IDLE_CPU_MHZ);
+
+    // A query never reaches the control task, so the joints stay parked
+    rig.command("idle");
+    EXPECT_EQ(getCpuFrequencyMhz(), IdleManager::ACTIVE_CPU_MHZ);
+    Host::advanceUs(IdleManager::ACTIVITY_GRACE_MS * 1000);
+    IdleManager::service();
+    EXPECT_TRUE(IdleManager::idle());
+    EXPECT_EQ(getCpuFrequencyMhz(), IdleManager::ACTIVE_CPU_MHZ);
+
+    Host::advanceUs(1000);
+    IdleManager::service();
+    EXPECT_EQ(getCpuFrequencyMhz(), IdleManager::IDLE_CPU_MHZ);
+}
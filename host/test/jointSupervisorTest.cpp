@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+
+// Runs until the supervisor trips or ms pass, returns the elapsed ms
+static uint32_t runUntilTrip(Sim::Rig& rig, uint32_t ms) {
+    uint32_t elapsed = 0;
+    for (; elapsed < ms && !supervisor.tripped(); elapsed += Board::CONTROL_PERIOD_US / 1000) rig.step();
+    return elapsed;
+}
+
+static void expectSafeTorqueOff() {
+    EXPECT_EQ(Host::pinLevel(Board::SLEEP_PIN), LOW);
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        EXPECT_EQ(motorControl.hostDrive(motors[j].config().motorNum), 0);
+    }
+}
+
+TEST(JointSupervisor, JammedJointTripsStall) {
+    Sim::Rig rig;
+    rig.plant[0].jammed = true;
+    rig.command("tar1=30");
+    uint32_t ms = runUntilTrip(rig, 3000);
+    EXPECT_EQ(supervisor.faults(0), JointSupervisor::STALL);
+    EXPECT_GE(ms, 500u);
+    EXPECT_LT(ms, 1000u);
+    expectSafeTorqueOff();
+}
+
+TEST(JointSupervisor, ReversedLeadsTripRunaway) {
+    Sim::Rig rig;
+    rig.plant[0].leadsReversed = true;
+    rig.command("tar1=20");
+    EXPECT_LT(runUntilTrip(rig, 2000), 2000u);
+    EXPECT_EQ(supervisor.faults(0), JointSupervisor::RUNAWAY);
+    expectSafeTorqueOff();
+}
+
+TEST(JointSupervisor, SustainedLoadTripsThermalAndRefusesToClearWhileHot) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.plant[0].loadPct = 70.0f;  // Held against, below the stall drive
+    uint32_t ms = runUntilTrip(rig, 30000);
+    EXPECT_EQ(supervisor.faults(0), JointSupervisor::THERMAL);
+    // Load plus friction is 73 % drive: (0.73^2 - 0.4^2) per second into a limit of 4
+    EXPECT_NEAR(ms / 1000.0, 4.0 / (0.73 * 0.73 - 0.16), 0.5);
+    expectSafeTorqueOff();
+
+    EXPECT_FALSE(supervisor.clear());
+    rig.run(20000);  // Cools at the continuous rating
+    EXPECT_TRUE(supervisor.clear());
+    EXPECT_EQ(Host::pinLevel(Board::SLEEP_PIN), HIGH);
+}
+
+TEST(JointSupervisor, FrozenEncoderTripsEncoder) {
+    Sim::Rig rig;
+    supervisor.limits.stallDrive = 101.0f;  // Frozen counts also read as a stall; isolate the encoder check
+    rig.encoderDisconnected[0] = true;
+    rig.command("tar1=30");
+    uint32_t ms = runUntilTrip(rig, 3000);
+    EXPECT_EQ(supervisor.faults(0), JointSupervisor::ENCODER);
+    EXPECT_LT(ms, 1500u);
+    expectSafeTorqueOff();
+}
+
+TEST(JointSupervisor, PositionCheckUsesTheLiveLimits) {
+    Sim::Rig rig;
+    rig.command("lim1=-20,20");
+    rig.run(50);
+    EXPECT_FALSE(supervisor.tripped());
+
+    // Knocked past the runtime limit plus margin, still inside the board's range
+    rig.plant[0].positionDeg = 40.0;
+    rig.step();
+    rig.step();
+    EXPECT_TRUE(supervisor.tripped());
+    EXPECT_EQ(supervisor.faults(0), JointSupervisor::LIMIT);
+    EXPECT_GT(Board::JOINTS[0].maxDeg + supervisor.limits.limitMarginDeg, 40.0f);
+}
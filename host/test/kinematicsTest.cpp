@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "kinematics.h"
+
+TEST(SinCosTable, MatchesLibmWithinTheDocumentedError) {
+    SinCosTable::init();
+    double worst = 0.0;
+    for (int i = -7200; i <= 7200; i++) {
+        float deg = i * 0.1f + 0.0137f;
+        float s, c;
+        SinCosTable::lookup(SinCosTable::phaseFromDeg(deg), s, c);
+        double rad = (double)deg * M_PI / 180.0;
+        worst = std::max({worst, std::fabs(s - std::sin(rad)), std::fabs(c - std::cos(rad))});
+    }
+    EXPECT_LT(worst, 5e-6);
+}
+
+TEST(ChainKinematics, StraightChainLiesOnTheAxis) {
+    SinCosTable::init();
+    ChainKinematics<4> chain(65.0f);
+    float joints[4] = {};
+    chain.update(joints);
+    const auto& shape = chain.shape();
+    for (size_t k = 0; k < 5; k++) {
+        EXPECT_NEAR(shape.xMm[k], 65.0f * k, 1e-3f);
+        EXPECT_NEAR(shape.yMm[k], 0.0f, 1e-3f);
+    }
+    EXPECT_NEAR(shape.comXMm, 65.0f * 5 / 2, 1e-3f);
+    EXPECT_NEAR(shape.comYMm, 0.0f, 1e-3f);
+}
+
+TEST(ChainKinematics, BentChainMatchesDoublePrecision) {
+    SinCosTable::init();
+    const float lengthMm = 65.0f;
+    const float joints[3] = {30.0f, -75.5f, 190.0f};
+    ChainKinematics<3> chain(lengthMm);
+    chain.update(joints);
+    const auto& shape = chain.shape();
+
+    double heading = 0.0, x = 0.0, y = 0.0, comX = 0.0, comY = 0.0;
+    for (size_t k = 0; k < 4; k++) {
+        if (k > 0) heading += joints[k - 1] * M_PI / 180.0;
+        EXPECT_NEAR(shape.xMm[k], x, 1e-3);
+        EXPECT_NEAR(shape.yMm[k], y, 1e-3);
+        double dx = std::cos(heading) * lengthMm, dy = std::sin(heading) * lengthMm;
+        comX += x + dx / 2;
+        comY += y + dy / 2;
+        x += dx;
+        y += dy;
+    }
+    EXPECT_NEAR(shape.comXMm, comX / 4, 1e-3);
+    EXPECT_NEAR(shape.comYMm, comY / 4, 1e-3);
+    EXPECT_NEAR(shape.headingDeg[3], 144.5f, 1e-3f);  // Wrapped into +-180
+    EXPECT_NEAR(shape.curvature[0], 30.0 * M_PI / 180.0 * 1000.0 / lengthMm, 1e-3);
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "bleCom.h"
+#include "latencyTrace.h"
+
+TEST(LatencyTrace, StagesFollowTheCommandThroughTheLoop) {
+    Sim::Rig rig;
+    LatencyTrace::reset();
+    HostStream* ble = Host::ble();
+
+    // The line arrives in two BLE writes 700 us apart
+    ble->feed("tar1=");
+    BLECom::update();
+    Host::advanceUs(700);
+    ble->feed("5\n");
+    BLECom::update();
+    Host::advanceUs(2000);
+    rig.step();  // Ticks one period later
+
+    // With a single sample every percentile is that sample
+    EXPECT_EQ(LatencyTrace::count(LatencyTrace::PARSE), 1u);
+    EXPECT_EQ(LatencyTrace::percentileUs(LatencyTrace::PARSE, 500), 700u);
+    EXPECT_EQ(LatencyTrace::percentileUs(LatencyTrace::QUEUE, 500), 2000u + Board::CONTROL_PERIOD_US);
+    EXPECT_EQ(LatencyTrace::percentileUs(LatencyTrace::ACTUATE, 500), 0u);
+    EXPECT_EQ(LatencyTrace::percentileUs(LatencyTrace::TOTAL, 500), 2700u + Board::CONTROL_PERIOD_US);
+}
+
+TEST(LatencyTrace, PercentilesStayWithinABucket) {
+    Sim::Rig rig;
+    LatencyTrace::reset();
+    for (uint32_t i = 1; i <= 100; i++) {
+        rig.command(i & 1 ? "tar1=1" : "tar1=2");
+        Host::advanceUs(i * 100);
+        rig.step();
+    }
+    // Queue times are 10.1 ms to 20 ms in 0.1 ms steps; buckets are 1/8 octave
+    uint32_t p50 = LatencyTrace::percentileUs(LatencyTrace::QUEUE, 500);
+    uint32_t p99 = LatencyTrace::percentileUs(LatencyTrace::QUEUE, 990);
+    EXPECT_GE(p50, 15000u);
+    EXPECT_LE(p50, 15000u * 9 / 8);
+    EXPECT_GE(p99, 19900u);
+    EXPECT_LE(p99, 20000u);  // Capped at the true max
+
+    // A stats reset lands with the next applied command
+    LatencyTrace::reset();
+    rig.command("tar1=3");
+    rig.step();
+    EXPECT_EQ(LatencyTrace::count(LatencyTrace::QUEUE), 1u);
+}
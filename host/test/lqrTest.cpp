@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+
+static_assert(Board::NUM_JOINTS == 2, "Group helpers below are written for two joints");
+
+static constexpr float OWN[3] = {3.0f, 0.1f, 10.0f};
+static constexpr float COUPLED[3] = {1.0f, 0.05f, 2.0f};
+
+// A group of joints coupled to each other, apart from the live motors[]
+static void initGroup(MotorPID (&group)[2], bool coupled) {
+    group[0].init(motorConfigFor<0>(), group);
+    group[1].init(motorConfigFor<1>(), group);
+    for (size_t j = 0; j < 2; j++) {
+        memcpy(group[j].lqrGains[j], OWN, sizeof(OWN));
+        if (coupled) memcpy(group[j].lqrGains[1 - j], COUPLED, sizeof(COUPLED));
+        group[j].setController(MotorPID::Controller::Lqr);
+    }
+    group[0].setSetpointDeg(15.0f);
+    group[1].setSetpointDeg(-10.0f);
+}
+
+static TrackEncoder::Snapshot snapshotAt(MotorPID (&group)[2], int n) {
+    TrackEncoder::Snapshot snap = {};
+    snap.timestampUs = 1000000 + (int64_t)n * Board::CONTROL_PERIOD_US;
+    for (size_t j = 0; j < 2; j++) {
+        const MotorPID::Config& cfg = group[j].config();
+        snap.counts[cfg.encoderIndex] = lroundf(8.0f * sinf(n * 0.05f + j) * cfg.countsPerDeg);
+    }
+    return snap;
+}
+
+TEST(Lqr, CoupledRowsDoNotDependOnUpdateOrder) {
+    static MotorPID forward[2], reverse[2];
+    initGroup(forward, true);
+    initGroup(reverse, true);
+    for (int n = 0; n < 300; n++) {
+        TrackEncoder::Snapshot snap = snapshotAt(forward, n);
+        for (auto& m : forward) m.latchPeers();
+        for (auto& m : reverse) m.latchPeers();
+        forward[0].compute(snap, false);
+        forward[1].compute(snap, false);
+        reverse[1].compute(snap, false);
+        reverse[0].compute(snap, false);
+        ASSERT_EQ(forward[0].Output, reverse[0].Output) << n;
+        ASSERT_EQ(forward[1].Output, reverse[1].Output) << n;
+    }
+    EXPECT_NE(forward[0].lqrState().integralDeg, 0.0f);
+}
+
+// A peer on its PID keeps no LQR state, so the rows on it drop out
+TEST(Lqr, PeerOnPidDoesNotCouple) {
+    static MotorPID coupled[2], alone[2];
+    initGroup(coupled, true);
+    initGroup(alone, false);
+    coupled[1].setController(MotorPID::Controller::Pid);
+    alone[1].setController(MotorPID::Controller::Pid);
+    for (int n = 0; n < 300; n++) {
+        TrackEncoder::Snapshot snap = snapshotAt(coupled, n);
+        for (auto* group : {&coupled, &alone}) {
+            for (auto& m : *group) m.latchPeers();
+            for (auto& m : *group) m.compute(snap, false);
+        }
+        ASSERT_EQ(coupled[0].Output, alone[0].Output) << n;
+    }
+}
+
+// tools/lqr_design.py design for the nominal plant (tau 30 ms, 6 deg/s per %)
+static constexpr const char* DESIGNED_LQR = "lqr1=6.5191,0.16504,11.662";
+
+// Output-side RMS error of joint 1 on the rig, the firmware's default PID
+// gains against the designed LQR: a 30 deg step, or a 20 deg 0.5 Hz sine
+// sent as a target every tick
+static double trackingError(bool lqr, bool sine) {
+    Sim::Rig rig;
+    if (lqr) {
+        rig.command(DESIGNED_LQR);
+        rig.command("ctl1=lqr");
+    }
+    rig.run(500);
+    const double periodS = Board::CONTROL_PERIOD_US * 1e-6;
+    auto reference = [sine](double t) { return sine ? 20.0 * sin(M_PI * t) : 30.0; };
+
+    double sumSq = 0.0;
+    size_t count = 0;
+    for (int tick = 0; tick * periodS < 4.0; tick++) {
+        char line[32];
+        snprintf(line, sizeof(line), "tar1=%.3f", reference(tick * periodS));
+        if (sine || tick == 0) rig.command(line);
+        rig.replies();
+        rig.step();
+        double e = rig.plant[0].positionDeg - reference(tick * periodS);
+        sumSq += e * e;
+        count++;
+    }
+    EXPECT_FALSE(supervisor.tripped());
+    EXPECT_EQ(motors[0].controller(), lqr ? MotorPID::Controller::Lqr : MotorPID::Controller::Pid);
+    return sqrt(sumSq / count);
+}
+
+TEST(Lqr, TracksNoWorseThanThePidOnTheRig) {
+    for (bool sine : {false, true}) {
+        double pid = Sim::isolated([sine] { return trackingError(false, sine); });
+        double lqr = Sim::isolated([sine] { return trackingError(true, sine); });
+        RecordProperty(sine ? "sine_pid_rms_deg" : "step_pid_rms_deg", std::to_string(pid));
+        RecordProperty(sine ? "sine_lqr_rms_deg" : "step_lqr_rms_deg", std::to_string(lqr));
+        printf("%s rms: pid %.3f deg, lqr %.3f deg\n", sine ? "sine" : "step", pid, lqr);
+        ASSERT_FALSE(std::isnan(pid) || std::isnan(lqr));
+        EXPECT_LE(lqr, pid);
+    }
+}
+
+// The report comes from the comms side's copy and agrees with the joints once applied
+TEST(Lqr, ReportShowsWhatWasQueued) {
+    Sim::Rig rig;
+    rig.command("lqr1=6.5,0.165,11.5");
+    rig.command("lqrx1,2=0.5,0.02,1");
+    rig.command("ctl1=lqr");
+    rig.replies();
+    rig.command("lqr");
+    std::string report = rig.replies();
+    EXPECT_NE(report.find("LQR j1 mode=lqr k1=6.5,0.165,11.5 k2=0.5,0.02,1"), std::string::npos) << report;
+    EXPECT_NE(report.find("LQR j2 mode=pid k1=0,0,0 k2=0,0,0"), std::string::npos) << report;
+
+    rig.step();
+    EXPECT_EQ(motors[0].controller(), MotorPID::Controller::Lqr);
+    EXPECT_EQ(motors[0].lqrGains[0][0], 6.5f);
+    EXPECT_EQ(motors[0].lqrGains[1][2], 1.0f);
+}
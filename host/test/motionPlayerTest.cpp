@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "motionLibrary.h"
+#include "motionPlayer.h"
+#include <esp_crc.h>
+
+// Image as tools/motion_encode.py writes it, one primitive on every joint
+struct Frame {
+    uint16_t timeMs;
+    uint8_t interp;
+    float deg;
+};
+
+static std::vector<uint8_t> image(uint16_t id, const std::vector<Frame>& frames, uint8_t flags = 0,
+                                  uint32_t offset = 0) {
+    using ML = MotionLibrary;
+    const uint8_t joints = Board::NUM_JOINTS;
+    const size_t stride = sizeof(ML::Keyframe) + 2 * joints;
+    const uint32_t dataAt = sizeof(ML::Header) + sizeof(ML::Entry);
+
+    std::vector<uint8_t> out(dataAt + frames.size() * stride);
+    ML::Entry entry = {id, joints, flags, offset ? offset : dataAt, (uint16_t)frames.size(), 0};
+    memcpy(&out[sizeof(ML::Header)], &entry, sizeof(entry));
+    for (size_t k = 0; k < frames.size(); k++) {
+        uint8_t* f = &out[dataAt + k * stride];
+        memcpy(f, &frames[k].timeMs, 2);
+        f[2] = frames[k].interp;
+        for (size_t j = 0; j < joints; j++) {
+            int16_t centi = (int16_t)lroundf(frames[k].deg * 100);
+            memcpy(f + sizeof(ML::Keyframe) + 2 * j, &centi, 2);
+        }
+    }
+    ML::Header header = {ML::MAGIC, ML::VERSION, 1, 0,
+                         esp_crc32_le(0, &out[sizeof(ML::Header)], out.size() - sizeof(ML::Header))};
+    memcpy(&out[0], &header, sizeof(header));
+    return out;
+}
+
+static bool load(const std::vector<uint8_t>& img) {
+    Host::addPartition("motion", ESP_PARTITION_TYPE_DATA, MotionLibrary::PARTITION_SUBTYPE, img);
+    return MotionLibrary::begin();
+}
+
+static const std::vector<Frame> RAMP = {{0, MotionLibrary::LINEAR, 0.0f}, {1000, MotionLibrary::LINEAR, 20.0f}};
+
+TEST(MotionPlayer, PlaysKeyframesIntoTheSetpoints) {
+    Sim::Rig rig;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) rig.setGains(j, 0.8f, 4.0f, 0.02f);
+    ASSERT_TRUE(load(image(1, RAMP)));
+    rig.command("play 1 0");
+    EXPECT_EQ(rig.replies(), "OK play 1 0\n");
+
+    rig.step();
+    EXPECT_TRUE(MotionPlayer::active());
+    rig.run(490);  // 50 ticks in, halfway up the ramp
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) EXPECT_NEAR(motors[j].getSetpointDeg(), 10.0f, 0.3f);
+
+    rig.run(600);
+    EXPECT_FALSE(MotionPlayer::active());
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        EXPECT_NEAR(motors[j].getSetpointDeg(), 20.0f, 0.05f);
+        EXPECT_NEAR(rig.measuredDeg(j), 20.0f, 1.0f);
+    }
+}
+
+TEST(MotionPlayer, BlendStartsFromTheHeldPose) {
+    Sim::Rig rig;
+    ASSERT_TRUE(load(image(1, {{0, MotionLibrary::STEP, 30.0f}, {500, MotionLibrary::STEP, 30.0f}})));
+    rig.command("play 1 200");
+    rig.step();
+    float first = motors[0].getSetpointDeg();
+    EXPECT_NEAR(first, 0.0f, 0.1f);
+
+    // Smoothstep over 200 ms, never a jump larger than its steepest slope
+    float last = first, largest = 0.0f;
+    for (int i = 0; i < 25; i++) {
+        rig.step();
+        largest = max(largest, motors[0].getSetpointDeg() - last);
+        last = motors[0].getSetpointDeg();
+    }
+    EXPECT_NEAR(last, 30.0f, 0.05f);
+    EXPECT_LT(largest, 30.0f * 1.5f * 10 / 200 + 0.1f);
+}
+
+TEST(MotionPlayer, WaypointsTakeOverFromPlayback) {
+    Sim::Rig rig;
+    ASSERT_TRUE(load(image(1, RAMP, MotionLibrary::FLAG_LOOP)));
+    rig.command("play 1 0");
+    rig.run(300);
+    ASSERT_TRUE(MotionPlayer::active());
+    float held = motors[0].getSetpointDeg();
+
+    rig.command("wp1=0,-5,100,-5,5000,-5");
+    rig.step();
+    EXPECT_FALSE(MotionPlayer::active());
+    rig.run(500);
+    EXPECT_NEAR(motors[0].getSetpointDeg(), -5.0f, 0.05f);
+    EXPECT_NE(motors[0].getSetpointDeg(), held);
+
+    rig.replies();
+    rig.command("play");
+    EXPECT_EQ(rig.replies().rfind("PLAY id=none", 0), 0u);
+}
+
+TEST(MotionLibrary, RejectsAWrappingOffset) {
+    Sim::Rig rig;
+    EXPECT_FALSE(load(image(1, RAMP, 0, 0xFFFFFFF0u)));
+    EXPECT_FALSE(MotionLibrary::loaded());
+}
+
+TEST(MotionLibrary, RejectsKeyframesNotStartingAtZero) {
+    Sim::Rig rig;
+    EXPECT_FALSE(load(image(1, {{100, MotionLibrary::LINEAR, 0.0f}, {1000, MotionLibrary::LINEAR, 20.0f}})));
+}
+
+TEST(MotionLibrary, RejectsTimesThatDoNotRise) {
+    Sim::Rig rig;
+    EXPECT_FALSE(load(image(1, {{0, MotionLibrary::LINEAR, 0.0f}, {500, MotionLibrary::LINEAR, 5.0f},
+                                {500, MotionLibrary::LINEAR, 20.0f}})));
+}
+
+TEST(MotionLibrary, ReportsAValidImage) {
+    Sim::Rig rig;
+    ASSERT_TRUE(load(image(7, RAMP, MotionLibrary::FLAG_LOOP)));
+    rig.command("play");
+    std::string text = rig.replies();
+    EXPECT_NE(text.find("PRIM id=7 joints=2 keyframes=2 ms=1000 loop=1"), std::string::npos) << text;
+}
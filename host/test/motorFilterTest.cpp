@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+
+static constexpr float SAMPLE_HZ = 1e6f / Board::CONTROL_PERIOD_US;
+
+// D on measurement as the PID applies it, from a derivative-path output in deg/s
+static float dTerm(float derivativeDeg) {
+    return -motors[0].Kd * derivativeDeg * motors[0].config().countsPerDeg;
+}
+
+TEST(MotorFilter, EmptyDerivativeChainKeepsTheRawDTerm) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.0f, 0.0f, 0.05f);
+    rig.plant[0].loadPct = 30.0f;  // Back-driven, so only the D term pushes back
+    for (int i = 0; i < 50; i++) {
+        rig.step();
+        MotorPID::Checkpoint cp = motors[0].checkpoint();
+        ASSERT_NEAR(motors[0].Output, constrain(dTerm(cp.rawVelocityDeg), -100.0f, 100.0f), 1e-3f) << i;
+    }
+    EXPECT_GT(fabsf(motors[0].Output), 1.0f);
+}
+
+TEST(MotorFilter, DerivativeLowpassShapesTheDTerm) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.0f, 0.0f, 0.05f);
+    rig.run(100);
+    rig.command("flt1=d,0,lp,2,0.707");
+    rig.step();
+
+    BiquadChain<MotorPID::FILTER_SECTIONS> expected;
+    ASSERT_TRUE(expected.set(0, Biquad::LOWPASS, 2.0f, 0.707f, SAMPLE_HZ, motors[0].checkpoint().rawVelocityDeg));
+    rig.plant[0].loadPct = 30.0f;
+    float largestGap = 0.0f;
+    for (int i = 0; i < 50; i++) {
+        rig.step();
+        MotorPID::Checkpoint cp = motors[0].checkpoint();
+        float derivative = expected.process(cp.rawVelocityDeg);
+        ASSERT_NEAR(motors[0].Output, dTerm(derivative), 1e-3f) << i;
+        largestGap = max(largestGap, fabsf(dTerm(cp.rawVelocityDeg) - motors[0].Output));
+    }
+    EXPECT_GT(largestGap, 1.0f);  // The filtered term lags the raw one through the transient
+}
+
+// A lead on the output overshoots a step past the clamp while the PID's own
+// output is well inside it; the integral must not wind up over those ticks
+TEST(MotorFilter, IntegralHoldsWhileTheFilteredOutputIsClamped) {
+    Sim::Rig rig;
+    rig.setGains(0, 1.0f, 2.0f, 0.0f);
+    rig.plant[0].jammed = true;
+    rig.command("flt1=o,0,ll,1,20");
+    rig.run(100);
+    float held = motors[0].checkpoint().outputSum;
+
+    rig.command("tar1=2");
+    int clamped = 0;
+    for (int i = 0; i < 10; i++) {
+        rig.step();
+        if (motors[0].Output < 100.0f) break;
+        clamped++;
+        EXPECT_EQ(motors[0].checkpoint().outputSum, held) << i;
+    }
+    EXPECT_GT(clamped, 1);
+
+    // Once the lead has settled the integral takes over again
+    rig.run(500);
+    EXPECT_GT(motors[0].checkpoint().outputSum, held + 5.0f);
+    EXPECT_FALSE(supervisor.tripped());
+}
+
+// flt reports from the comms side's copy; it must match what the control task runs
+TEST(MotorFilter, ReportMatchesTheLiveChains) {
+    Sim::Rig rig;
+    rig.command("flt1=m,0,lp,30,0.707");
+    rig.command("flt1=m,1,notch,12.5,4");
+    rig.command("flt1=d,0,lp,20,0.707");
+    rig.command("flt2=o,0,ll,2,8");
+    rig.command("flt1=m,1,off");
+    rig.step();
+    rig.replies();
+    rig.command("flt");
+    std::string report = rig.replies();
+
+    static const char pathNames[] = "mdo";
+    size_t sections = 0;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        for (size_t p = 0; p < MotorPID::FILTER_PATHS; p++) {
+            const auto& chain = motors[j].filters[p];
+            for (size_t i = 0; i < chain.size(); i++) {
+                const Biquad& b = chain.section(i);
+                char line[160];
+                snprintf(line, sizeof(line), "FLT j=%u path=%c sec=%u type=", (unsigned)(j + 1), pathNames[p],
+                         (unsigned)i);
+                size_t at = report.find(line);
+                ASSERT_NE(at, std::string::npos) << line << "\n" << report;
+                snprintf(line, sizeof(line), "b=%.9g,%.9g,%.9g a=%.9g,%.9g\n", b.b0, b.b1, b.b2, b.a1, b.a2);
+                EXPECT_EQ(report.compare(report.find(" b=", at) + 1, strlen(line), line), 0) << line;
+                sections++;
+            }
+        }
+    }
+    EXPECT_EQ(sections, 3u);
+    EXPECT_EQ(std::count(report.begin(), report.end(), '\n'), 3);
+}
@@ -0,0 +1,104 @@
+// Fails if the control tick touches the heap. Its own executable: malloc and
+// operator new are interposed here and count while a tick is running.
+#include <gtest/gtest.h>
+#include <new>
+#include "rig.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+static bool counting = false;
+static size_t allocations = 0;
+
+extern "C" void* malloc(size_t size) {
+    if (counting) allocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    if (counting) allocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    if (counting) allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+void* operator new(size_t size) {
+    if (counting) allocations++;
+    void* p = __libc_malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// Ticks for ms and returns the allocations made inside them
+static size_t ticksAllocate(Sim::Rig& rig, uint32_t ms) {
+    size_t before = allocations;
+    for (uint32_t t = 0; t < ms; t += Board::CONTROL_PERIOD_US / 1000) {
+        counting = true;
+        rig.step();
+        counting = false;
+    }
+    return allocations - before;
+}
+
+TEST(NoAllocation, CountsAllocationsInsideATick) {
+    Sim::Rig rig;
+    counting = true;
+    void* p = malloc(16);
+    counting = false;
+    free(p);
+    EXPECT_EQ(allocations, 1u);
+}
+
+TEST(NoAllocation, ControlTickNeverTouchesTheHeap) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.setGains(1, 0.8f, 4.0f, 0.02f);
+    EXPECT_EQ(ticksAllocate(rig, 500), 0u) << "holding";
+
+    rig.command("tar1=30");
+    EXPECT_EQ(ticksAllocate(rig, 1000), 0u) << "step";
+
+    rig.command("rec=start");
+    rig.command("wp1=0,30,200,20,400,0,600,-20,800,0");
+    EXPECT_EQ(ticksAllocate(rig, 1200), 0u) << "waypoints, recording";
+    rig.command("rec=stop");
+
+    rig.command("flt1=m,0,notch,12.5,4");
+    rig.command("flt1=d,0,lp,30,0.707");
+    rig.command("flt1=o,0,lp,40,0.707");
+    rig.command("gs1=e,0,10,2");
+    rig.command("gsp1=0,0.5,2,0.01,1,4,0.02");
+    rig.command("gsc1");
+    rig.command("tar1=10");
+    EXPECT_EQ(ticksAllocate(rig, 1000), 0u) << "filters, gain schedule";
+
+    rig.command("lqr1=4,0.12,20");
+    rig.command("ctl1=lqr");
+    rig.command("tar1=-10");
+    EXPECT_EQ(ticksAllocate(rig, 1000), 0u) << "lqr";
+    rig.command("ctl1=pid");
+
+    rig.command("bkl1=0.5,0");
+    rig.command("bklc1=2,20");
+    EXPECT_EQ(ticksAllocate(rig, 1000), 0u) << "backlash calibration";
+
+    rig.plant[0].jammed = true;
+    rig.command("tar1=40");
+    EXPECT_EQ(ticksAllocate(rig, 2000), 0u) << "fault trip";
+    EXPECT_TRUE(supervisor.tripped());
+    EXPECT_EQ(ticksAllocate(rig, 5000), 0u) << "idle";
+    std::string replies = rig.replies();
+    EXPECT_EQ(replies.find("ERR"), std::string::npos) << replies;
+}
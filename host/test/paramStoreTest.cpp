@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "motorConfig.h"
+#include "controlTask.h"
+#include "paramStore.h"
+
+// Profile 1 as a copy of the defaults with its own gains and limits on every joint
+static void makeSecondProfile(Sim::Rig& rig) {
+    ASSERT_TRUE(ParamStore::copyActive(1, "soft"));
+    ASSERT_TRUE(ParamStore::select(1));
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        ParamStore::noteGains(j, 0.5f, 2.0f, 0.01f);
+        ParamStore::noteLimits(j, -10.0f, 10.0f);
+    }
+    rig.step();
+    ASSERT_TRUE(ParamStore::select(0));
+    rig.step();
+}
+
+TEST(ParamStore, SwitchIsRefusedWholeWhenTheRingIsShort) {
+    Sim::Rig rig;
+    makeSecondProfile(rig);
+    uint32_t generation = ParamStore::generation();
+
+    // One slot short of the 3 commands per joint a switch needs
+    size_t filler = 32 - 3 * Board::NUM_JOINTS + 1;
+    for (size_t i = 0; i < filler; i++) {
+        ASSERT_TRUE(ControlTask::send({ControlCommand::Type::SupplyVolts, 0, {12.0f}}));
+    }
+    EXPECT_FALSE(ParamStore::select(1));
+    EXPECT_EQ(ParamStore::generation(), generation);
+    EXPECT_STREQ(ParamStore::active().name, "default");
+    rig.step();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        EXPECT_NE(motors[j].Kp, 0.5f);
+        EXPECT_NE(motors[j].config().maxDeg, 10.0f);
+    }
+
+    // With room, every joint changes on the same tick
+    EXPECT_TRUE(ParamStore::select(1));
+    rig.step();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        EXPECT_EQ(motors[j].Kp, 0.5f);
+        EXPECT_EQ(motors[j].config().minDeg, -10.0f);
+        EXPECT_EQ(motors[j].config().maxDeg, 10.0f);
+    }
+}
+
+TEST(ParamStore, BlobSurvivesARebootUnderOneKey) {
+    Sim::Rig rig;
+    makeSecondProfile(rig);
+    ParamStore::select(1);
+    ParamStore::flush();
+    ParamStore::service();
+    EXPECT_EQ(Host::nvs().count("params/blob"), 1u);
+    for (const auto& entry : Host::nvs()) {
+        EXPECT_TRUE(entry.first.rfind("params/", 0) != 0 || entry.first == "params/blob") << entry.first;
+    }
+
+    motors[0].Kp = 9.0f;
+    ParamStore::begin();
+    EXPECT_STREQ(ParamStore::active().name, "soft");
+    EXPECT_EQ(motors[0].Kp, 0.5f);
+    ParamStore::report(*Host::ble());
+    EXPECT_NE(rig.replies().find("source=nvs rejected=0"), std::string::npos);
+}
+
+TEST(ParamStore, FailedWriteKeepsThePreviousBlob) {
+    Sim::Rig rig;
+    ParamStore::flush();
+    ParamStore::noteGains(0, 0.7f, 3.0f, 0.0f);
+    ParamStore::service();
+    std::vector<uint8_t> saved = Host::nvs()["params/blob"];
+
+    Host::nvsFailWrites = true;
+    ParamStore::noteGains(0, 0.9f, 3.0f, 0.0f);
+    ParamStore::flush();
+    ParamStore::service();
+    EXPECT_EQ(Host::nvs()["params/blob"], saved);
+
+    Host::nvsFailWrites = false;
+    ParamStore::begin();
+    EXPECT_EQ(ParamStore::active().joints[0].kp, 0.7f);
+}
+
+TEST(ParamStore, OldSlotsAndForeignBlobsFallBackToDefaults) {
+    Sim::Rig rig;
+    Host::nvs()["params/blobA"] = std::vector<uint8_t>(64, 0xA5);
+    Host::nvs()["params/blob"] = std::vector<uint8_t>(16, 0x5A);
+    ParamStore::begin();
+    EXPECT_EQ(Host::nvs().count("params/blobA"), 0u);
+    ParamStore::report(*Host::ble());
+    std::string line = rig.replies();
+    EXPECT_NE(line.find("source=defaults rejected=2"), std::string::npos) << line;
+}
+
+TEST(ParamStore, FilterChainsFollowTheProfile) {
+    Sim::Rig rig;
+    makeSecondProfile(rig);
+    ASSERT_TRUE(ParamStore::select(1));
+    rig.step();
+    rig.command("flt1=d,0,lp,20,0.707");
+    rig.command("flt1=o,0,notch,12,2");
+    rig.command("flt1=o,1,lp,30,0.707");
+    rig.command("flt2=m,0,lp,25,0.707");
+    rig.step();
+    ASSERT_EQ(motors[0].filters[(int)MotorPID::FilterPath::Output].size(), 2u);
+
+    // Back to the defaults: every chain empties in the same batch
+    ASSERT_TRUE(ParamStore::select(0));
+    rig.step();
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        for (size_t p = 0; p < MotorPID::FILTER_PATHS; p++) EXPECT_EQ(motors[j].filters[p].size(), 0u);
+    }
+
+    ASSERT_TRUE(ParamStore::select(1));
+    rig.step();
+    const auto& output = motors[0].filters[(int)MotorPID::FilterPath::Output];
+    ASSERT_EQ(output.size(), 2u);
+    EXPECT_EQ(output.spec(0).type, Biquad::NOTCH);
+    EXPECT_EQ(output.spec(1).f1, 30.0f);
+    EXPECT_EQ(motors[0].filters[(int)MotorPID::FilterPath::Derivative].size(), 1u);
+    EXPECT_EQ(motors[1].filters[(int)MotorPID::FilterPath::Measurement].size(), 1u);
+
+    // Dropping a section is kept too, and the chains come back after a reboot
+    rig.command("flt1=o,1,off");
+    ParamStore::flush();
+    ParamStore::service();
+    for (size_t p = 0; p < MotorPID::FILTER_PATHS; p++) motors[0].filters[p].clear();
+    ParamStore::begin();
+    EXPECT_EQ(output.size(), 1u);
+    EXPECT_EQ(output.spec(0).f1, 12.0f);
+    EXPECT_EQ(motors[0].filters[(int)MotorPID::FilterPath::Derivative].spec(0).f1, 20.0f);
+}
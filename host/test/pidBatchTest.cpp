@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "QuickPID.h"
+#include "pidBatch.h"
+#include "boardConfig.h"
+
+// Eight lanes with their own gains against eight QuickPIDs set up as
+// MotorPID does, on inputs that drive some lanes into the clamp
+TEST(PidBatch, LanesMatchQuickPid) {
+    constexpr size_t LANES = 8;
+    PidBatch<LANES> batch;
+    float input[LANES] = {}, output[LANES] = {}, setpoint[LANES] = {};
+    std::vector<QuickPID> reference;
+    for (size_t i = 0; i < LANES; i++) {
+        float kp = 0.2f + 0.3f * i, ki = 1.0f * i, kd = 0.01f * (i % 3);
+        reference.emplace_back(&input[i], &output[i], &setpoint[i], kp, ki, kd, QuickPID::pMode::pOnError,
+                               QuickPID::dMode::dOnMeas, QuickPID::iAwMode::iAwClamp, QuickPID::Action::direct);
+        reference[i].SetOutputLimits(-100, 100);
+        reference[i].SetSampleTimeUs(Board::CONTROL_PERIOD_US);
+        reference[i].SetMode(QuickPID::Control::timer);
+        batch.setTunings(i, kp, ki, kd, Board::CONTROL_PERIOD_US);
+    }
+    batch.setOutputLimits(-100, 100);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> noise(-20.0f, 20.0f);
+    float worst = 0.0f;
+    bool clamped = false;
+    for (int n = 0; n < 2000; n++) {
+        for (size_t i = 0; i < LANES; i++) {
+            setpoint[i] = batch.setpoint[i] = (n / 400) % 2 ? 600.0f : -300.0f;
+            input[i] = batch.input[i] = 150.0f * sinf(n * 0.01f * (i + 1)) + noise(rng);
+            reference[i].Compute();
+        }
+        batch.compute();
+        for (size_t i = 0; i < LANES; i++) {
+            worst = fmaxf(worst, fabsf(batch.output[i] - output[i]));
+            clamped |= fabsf(output[i]) == 100.0f;
+        }
+    }
+    EXPECT_TRUE(clamped);
+    EXPECT_LT(worst, 1e-3f);  // Fused multiply-adds may move the last bits
+}
+
+TEST(PidBatch, InitializeIsBumpless) {
+    PidBatch<4> batch;
+    batch.setTunings(0, 1.0f, 5.0f, 0.1f, Board::CONTROL_PERIOD_US);
+    batch.output[0] = 250.0f;  // Outside the limits: the integral starts at the clamp
+    batch.input[0] = 40.0f;
+    batch.initialize(0);
+    EXPECT_EQ(batch.outputSum(0), 100.0f);
+
+    batch.setpoint[0] = 40.0f;
+    batch.compute();
+    EXPECT_EQ(batch.output[0], 100.0f);  // No error and no motion: held, no derivative kick
+}
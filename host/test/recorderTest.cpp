@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "rig.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+#include "recorder.h"
+
+// Replays the log on the spare controllers and returns the REPLAY line
+static std::string replay(Sim::Rig& rig) {
+    rig.replies();
+    rig.command("rec=replay");
+    while (Recorder::mode() == Recorder::Mode::Replaying) Recorder::service();
+    std::string out = rig.replies();
+    size_t at = out.find("REPLAY ");
+    return at == std::string::npos ? out : out.substr(at, out.find('\n', at) - at);
+}
+
+static void expectExact(const std::string& line, uint32_t minTicks) {
+    unsigned ticks = 0;
+    ASSERT_EQ(sscanf(line.c_str(), "REPLAY ticks=%u", &ticks), 1) << line;
+    EXPECT_GE(ticks, minTicks) << line;
+    EXPECT_NE(line.find("first_div=-1 div1=0.0 div2=0.0"), std::string::npos) << line;
+    EXPECT_EQ(line.find("corrupt"), std::string::npos) << line;
+}
+
+TEST(Recorder, ReplaysAPidRunExactly) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.run(100);
+    rig.command("rec=start");
+    rig.command("tar1=30");
+    rig.command("tar2=-15");
+    rig.run(1500);
+    rig.command("kp1=1.0");  // Whatever the tuning table sends mid-run
+    rig.command("wp1=0,30,300,10,600,20");
+    rig.run(1000);
+    rig.command("rec=stop");
+    rig.step();
+    expectExact(replay(rig), 240);
+}
+
+TEST(Recorder, ReplaysFiltersLqrIdleAndATripExactly) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);
+    rig.setGains(1, 0.8f, 4.0f, 0.02f);
+    // Chains already primed when recording starts go into the header
+    rig.command("flt1=m,0,lp,30,0.707");
+    rig.command("flt1=d,0,notch,12.5,4");
+    rig.command("flt1=o,0,ll,2,8");
+    rig.command("lqr2=4,0.12,20");
+    rig.command("ctl2=lqr");
+    rig.run(200);
+
+    rig.command("rec=start");
+    rig.command("tar1=20");
+    rig.command("tar2=10");
+    rig.run(800);
+    rig.command("flt2=o,0,lp,20,0.707");  // Changes during the recording replay as commands
+    rig.command("ctl1=lqr");
+    rig.command("lqr1=3,0.1,10");
+    rig.command("lqrx1,2=0.5,0.02,1");  // Coupled to joint 2's LQR state
+    rig.run(500);
+    rig.command("ctl1=pid");
+    rig.command("tar1=0");
+    rig.run(3000);  // Settles and parks
+
+    rig.plant[0].jammed = true;
+    rig.command("tar1=40");
+    rig.run(1500);
+    EXPECT_TRUE(supervisor.tripped());
+    rig.command("rec=stop");
+    rig.step();
+
+    std::string replies = rig.replies();
+    EXPECT_EQ(replies.find("ERR"), std::string::npos) << replies;
+    expectExact(replay(rig), 550);
+}
+
+TEST(Recorder, RejectsALogFromAnotherVersion) {
+    Sim::Rig rig;
+    rig.command("rec=start");
+    rig.run(200);
+    rig.command("rec=stop");
+    rig.step();
+    rig.command("rec=dump");
+    ASSERT_EQ(Recorder::mode(), Recorder::Mode::Dumping);
+    while (Recorder::mode() == Recorder::Mode::Dumping) Recorder::service();
+    std::string dump = Serial.take();
+    size_t first = dump.find("REC 0000 ");
+    ASSERT_NE(first, std::string::npos);
+    EXPECT_EQ(dump.substr(first + 9, 10), "52504C5902");  // "RPLY", version 2
+
+    rig.command("rec=clear");
+    rig.command("recl=52504C5901020000");
+    rig.replies();
+    rig.command("rec=replay");
+    EXPECT_NE(rig.replies().find("ERR"), std::string::npos);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "hostHal.h"
+#include "sensorBus.h"
+
+// ICM-42688-P registers the burst covers: temperature, accel x y z, gyro x y z
+static constexpr uint8_t TEMP_DATA1 = 0x1D, ACCEL_DATA_X1 = 0x1F, GYRO_DATA_X1 = 0x25;
+static constexpr uint8_t WHO_AM_I = 0x75;
+static constexpr float ACCEL_LSB_PER_G = 2048.0f, GYRO_LSB_PER_DPS = 16.4f;
+static constexpr int64_t BURST_US = 25;  // 15 bytes at 8 MHz and the driver's overhead
+
+static void put(Host::SpiRegisters& imu, uint8_t reg, float value) {
+    int16_t raw = (int16_t)lroundf(value);
+    imu.regs[reg] = (uint8_t)(raw >> 8);
+    imu.regs[reg + 1] = (uint8_t)raw;
+}
+
+// A head at rest, rolled by rollDeg, turning at yawDps about its own z
+static void pose(Host::SpiRegisters& imu, float rollDeg, float yawDps) {
+    float roll = rollDeg * DEG_TO_RAD;
+    put(imu, ACCEL_DATA_X1, 0.0f);
+    put(imu, ACCEL_DATA_X1 + 2, sinf(roll) * ACCEL_LSB_PER_G);
+    put(imu, ACCEL_DATA_X1 + 4, cosf(roll) * ACCEL_LSB_PER_G);
+    put(imu, GYRO_DATA_X1, 0.0f);
+    put(imu, GYRO_DATA_X1 + 2, 0.0f);
+    put(imu, GYRO_DATA_X1 + 4, yawDps * GYRO_LSB_PER_DPS);
+}
+
+static Host::SpiRegisters& fittedImu(int64_t transferUs) {
+    Host::reset();
+    Host::SpiRegisters& imu = Host::spiDevice(SensorBus::IMU_DEVICE);
+    imu.regs[WHO_AM_I] = 0x47;
+    imu.transferUs = transferUs;
+    return imu;
+}
+
+static void ticks(int n) {
+    for (int i = 0; i < n; i++) {
+        Host::advanceUs(Board::CONTROL_PERIOD_US);
+        SensorBus::poll();
+    }
+}
+
+static long reported(const char* field) {
+    HostStream out;
+    SensorBus::report(out);
+    std::string text = out.take();
+    size_t at = text.find(field);
+    return at == std::string::npos ? -1 : strtol(text.c_str() + at + strlen(field), nullptr, 10);
+}
+
+TEST(SensorBus, IdentifiesAndConfiguresTheImu) {
+    Host::SpiRegisters& imu = fittedImu(BURST_US);
+    SensorBus::begin(true);
+    HostStream out;
+    SensorBus::report(out);
+    EXPECT_NE(out.take().find("state=ok"), std::string::npos);
+
+    std::vector<std::pair<uint8_t, uint8_t>> expected = {{0x11, 0x01}, {0x4F, 0x06}, {0x50, 0x06}, {0x4E, 0x0F}};
+    EXPECT_EQ(imu.writes, expected);  // Soft reset, gyro and accel at 1 kHz, both on
+    EXPECT_EQ(imu.queued, 0u);        // Bursts start with the control tick
+}
+
+TEST(SensorBus, WrongIdentityLeavesTheBusAbsent) {
+    Host::SpiRegisters& imu = fittedImu(BURST_US);
+    imu.regs[WHO_AM_I] = 0x00;
+    SensorBus::begin(true);
+    ticks(10);
+    HostStream out;
+    SensorBus::report(out);
+    EXPECT_NE(out.take().find("state=absent"), std::string::npos);
+    EXPECT_EQ(imu.queued, 0u);
+    SensorBus::Orientation o;
+    EXPECT_FALSE(SensorBus::latest(o));
+}
+
+TEST(SensorBus, OrientationFollowsTheBurstOneTickBehind) {
+    Host::SpiRegisters& imu = fittedImu(BURST_US);
+    pose(imu, 20.0f, 0.0f);
+    SensorBus::begin(true);
+    ticks(200);
+
+    SensorBus::Orientation o;
+    ASSERT_TRUE(SensorBus::latest(o));
+    EXPECT_NEAR(o.rollDeg, 20.0f, 0.1f);
+    EXPECT_NEAR(o.pitchDeg, 0.0f, 0.1f);
+    // Sampled at the end of the burst queued on the previous tick
+    EXPECT_EQ(o.timestampUs, Host::nowUs() - Board::CONTROL_PERIOD_US + BURST_US);
+    EXPECT_EQ(reported("samples="), 199);
+    EXPECT_EQ(reported("misses="), 0);
+    EXPECT_EQ(reported("xfer_us="), BURST_US);
+    EXPECT_EQ(reported("age_us="), Board::CONTROL_PERIOD_US - BURST_US);
+
+    // New register contents land in the half being filled; the published
+    // half keeps the old burst until the next tick collects the new one
+    uint8_t frame[SensorBus::MAX_FRAME];
+    pose(imu, 20.0f, 90.0f);
+    Host::advanceUs(BURST_US);
+    ASSERT_EQ(SensorBus::latestFrame(SensorBus::IMU_DEVICE, frame), 14u);
+    EXPECT_EQ(frame[GYRO_DATA_X1 + 4 - TEMP_DATA1], 0);
+    ticks(1);
+    SensorBus::latestFrame(SensorBus::IMU_DEVICE, frame);
+    EXPECT_EQ(0, memcmp(frame, &imu.regs[TEMP_DATA1], 14));
+    ASSERT_TRUE(SensorBus::latest(o));
+    EXPECT_NEAR(o.gyroDps[2], 90.0f, 0.1f);
+}
+
+TEST(SensorBus, SlowBurstIsAMissNotAWait) {
+    Host::SpiRegisters& imu = fittedImu(Board::CONTROL_PERIOD_US * 3 / 2);
+    pose(imu, -15.0f, 0.0f);
+    SensorBus::begin(true);
+    ticks(100);
+    // Every other tick finds the burst still on the bus and keeps the last sample
+    EXPECT_EQ(reported("samples="), 49);
+    EXPECT_EQ(reported("misses="), 50);
+    EXPECT_EQ(reported("xfer_us="), Board::CONTROL_PERIOD_US * 3 / 2);
+    EXPECT_EQ(imu.queued, 50u);
+
+    SensorBus::Orientation before, after;
+    ASSERT_TRUE(SensorBus::latest(before));
+    EXPECT_NEAR(before.rollDeg, -15.0f, 0.1f);
+    ticks(1);
+    ASSERT_TRUE(SensorBus::latest(after));
+    EXPECT_NE(after.timestampUs, before.timestampUs);
+    ticks(1);
+    ASSERT_TRUE(SensorBus::latest(before));
+    EXPECT_EQ(before.timestampUs, after.timestampUs);
+}
+
+// A burst that fits the period is collected on every tick; the cost of a poll is BM_SensorBusPoll
+TEST(SensorBus, BurstInsideThePeriodNeverMisses) {
+    Host::SpiRegisters& imu = fittedImu(BURST_US);
+    pose(imu, 10.0f, 30.0f);
+    SensorBus::begin(true);
+    ticks(20000);
+    EXPECT_EQ(reported("misses="), 0);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "spscRing.h"
+
+TEST(SpscRing, KeepsOrderAndCountsDrops) {
+    SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++) EXPECT_TRUE(ring.push(i));
+    EXPECT_FALSE(ring.push(99));
+    EXPECT_EQ(ring.droppedCount(), 1u);
+    EXPECT_EQ(ring.size(), 4u);
+
+    int v;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(ring.pop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(ring.pop(v));
+}
+
+TEST(SpscRing, WrapsAroundTheSlots) {
+    SpscRing<int, 4> ring;
+    int v;
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(ring.push(i));
+        ASSERT_TRUE(ring.push(i + 1));
+        ASSERT_TRUE(ring.pop(v));
+        EXPECT_EQ(v, i);
+        ASSERT_TRUE(ring.pop(v));
+        EXPECT_EQ(v, i + 1);
+    }
+    EXPECT_EQ(ring.size(), 0u);
+    EXPECT_EQ(ring.droppedCount(), 0u);
+}
+
+TEST(SpscRing, PopLatestSkipsToNewest) {
+    SpscRing<int, 8> ring;
+    int v = -1;
+    EXPECT_FALSE(ring.popLatest(v));
+    for (int i = 0; i < 5; i++) ring.push(i);
+    EXPECT_TRUE(ring.popLatest(v));
+    EXPECT_EQ(v, 4);
+    EXPECT_EQ(ring.size(), 0u);
+}
+
+// One producer and one consumer thread, as comms and control use it
+TEST(SpscRing, TwoThreadsSeeEveryItemInOrder) {
+    static SpscRing<uint32_t, 32> ring;
+    constexpr uint32_t COUNT = 50000;
+    std::thread producer([] {
+        for (uint32_t i = 0; i < COUNT;) {
+            if (ring.push(i)) i++;
+            else std::this_thread::yield();
+        }
+    });
+    uint32_t expected = 0;
+    while (expected < COUNT) {
+        uint32_t v;
+        if (ring.pop(v)) {
+            ASSERT_EQ(v, expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_EQ(ring.size(), 0u);
+}
+
+TEST(SpscRing, BatchPushIsAllOrNothing) {
+    SpscRing<int, 8> ring;
+    const int batch[] = {1, 2, 3, 4, 5};
+    for (int i = 0; i < 4; i++) ring.push(0);
+    EXPECT_FALSE(ring.push(batch, 5));  // Four free
+    EXPECT_EQ(ring.size(), 4u);
+    EXPECT_EQ(ring.droppedCount(), 1u);
+
+    int v;
+    ring.pop(v);
+    EXPECT_TRUE(ring.push(batch, 5));  // Crosses the end of the slots
+    EXPECT_EQ(ring.size(), 8u);
+    for (int i = 0; i < 3; i++) ring.pop(v);
+    for (int expected : batch) {
+        ASSERT_TRUE(ring.pop(v));
+        EXPECT_EQ(v, expected);
+    }
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "telemetry.h"
+#include "frameDecoder.h"
+
+static ControlState stateAt(uint32_t tick, float position) {
+    ControlState s = {};
+    s.tick = tick;
+    s.comXMm = 97.5f + tick * 0.1f;
+    s.comYMm = -12.25f;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+        s.joints[j].input = position * (j + 1);
+        s.joints[j].setpoint = 1000.0f;
+        s.joints[j].output = -37.55f;
+        s.joints[j].velocityDeg = position * 0.5f;
+        s.joints[j].thermalLoad = 0.25f;
+        s.joints[j].faults = 0x3;
+    }
+    return s;
+}
+
+TEST(Telemetry, FramesRoundTripThroughDeltasAndZigzag) {
+    HostStream out;
+    Telemetry telemetry(out);
+    ASSERT_EQ(telemetry.subscribeLetters(0, "pvoe", 1), (int)(4 * Board::NUM_JOINTS));
+    ASSERT_TRUE(telemetry.subscribe(Telemetry::channelId(0, Telemetry::CH_HEALTH), 1));
+
+    // Positions that swing across zero and past single-byte varints
+    const float positions[] = {0.0f, 5.0f, -70.0f, 300000.0f, -1.0f, 64.0f, -65.0f};
+    for (uint32_t t = 0; t < 7; t++) telemetry.publish(stateAt(t, positions[t]));
+
+    std::vector<DecodedFrame> frames;
+    FrameDecoder decoder;
+    ASSERT_TRUE(decoder.decode(out.take(), frames));
+    ASSERT_EQ(frames.size(), 7u);
+    EXPECT_TRUE(frames[0].key);
+    EXPECT_FALSE(frames[1].key);
+    for (uint32_t t = 0; t < 7; t++) {
+        ControlState s = stateAt(t, positions[t]);
+        EXPECT_EQ(frames[t].tick, t);
+        for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+            EXPECT_EQ(frames[t].values[Telemetry::channelId(j, Telemetry::CH_POSITION)], lroundf(s.joints[j].input));
+            EXPECT_EQ(frames[t].values[Telemetry::channelId(j, Telemetry::CH_VELOCITY)],
+                      lroundf(s.joints[j].velocityDeg * 10.0f));
+            EXPECT_EQ(frames[t].values[Telemetry::channelId(j, Telemetry::CH_OUTPUT)], -376);
+            EXPECT_EQ(frames[t].values[Telemetry::channelId(j, Telemetry::CH_ERROR)],
+                      lroundf(s.joints[j].setpoint - s.joints[j].input));
+        }
+        EXPECT_EQ(frames[t].values[Telemetry::channelId(0, Telemetry::CH_HEALTH)], (3 << 8) | 25);
+    }
+}
+
+TEST(Telemetry, DecimationAndKeyFrames) {
+    HostStream out;
+    Telemetry telemetry(out);
+    ASSERT_TRUE(telemetry.subscribe(Telemetry::channelId(0, Telemetry::CH_POSITION), 1));
+    ASSERT_TRUE(telemetry.subscribe(Telemetry::channelId(0, Telemetry::CH_OUTPUT), 5));
+
+    const uint32_t ticks = Telemetry::KEYFRAME_INTERVAL * 2 + 3;
+    for (uint32_t t = 0; t < ticks; t++) telemetry.publish(stateAt(t, (float)t));
+
+    std::vector<DecodedFrame> frames;
+    FrameDecoder decoder;
+    ASSERT_TRUE(decoder.decode(out.take(), frames));
+    ASSERT_EQ(frames.size(), ticks);
+    uint8_t output = Telemetry::channelId(0, Telemetry::CH_OUTPUT);
+    for (uint32_t t = 0; t < ticks; t++) {
+        EXPECT_EQ(frames[t].key, t % Telemetry::KEYFRAME_INTERVAL == 0) << t;
+        // Key frames carry every channel, otherwise output every fifth tick
+        EXPECT_EQ(frames[t].values.count(output) == 1, frames[t].key || t % 5 == 0) << t;
+        EXPECT_EQ(frames[t].values[Telemetry::channelId(0, Telemetry::CH_POSITION)], (int32_t)t);
+    }
+}
+
+TEST(Telemetry, RejectsUnknownChannelsAndZeroDecimation) {
+    HostStream out;
+    Telemetry telemetry(out);
+    EXPECT_FALSE(telemetry.subscribe(Telemetry::channelId(Board::NUM_JOINTS, Telemetry::CH_POSITION), 1));
+    EXPECT_FALSE(telemetry.subscribe(Telemetry::channelId(0, Telemetry::KIND_COUNT), 1));
+    EXPECT_FALSE(telemetry.subscribe(Telemetry::channelId(0, Telemetry::CH_POSITION), 0));
+    EXPECT_FALSE(telemetry.active());
+    telemetry.publish(stateAt(0, 1.0f));
+    EXPECT_TRUE(out.written().empty());
+}
+
+TEST(Telemetry, TextLineHasSixColumnsPerJoint) {
+    HostStream out;
+    Telemetry::printText(out, stateAt(0, 2.0f));
+    std::string line = out.take();
+    ASSERT_EQ(line.back(), '\n');
+    EXPECT_EQ(std::count(line.begin(), line.end(), '\t'), (long)(6 * Board::NUM_JOINTS - 1));
+}
+
+TEST(Telemetry, CentreOfMassLetterStreamsBothAxes) {
+    HostStream out;
+    Telemetry telemetry(out);
+    EXPECT_EQ(telemetry.subscribeLetters(0, "c", 1), 2);
+    EXPECT_FALSE(telemetry.subscribe(Telemetry::BODY_COM_Y + 1, 1));
+
+    telemetry.publish(stateAt(3, 0.0f));
+    std::vector<DecodedFrame> frames;
+    FrameDecoder decoder;
+    ASSERT_TRUE(decoder.decode(out.take(), frames));
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].values.size(), 2u);
+    EXPECT_EQ(frames[0].values[Telemetry::BODY_COM_X], 978);  // 97.8 mm in 0.1 mm
+    EXPECT_EQ(frames[0].values[Telemetry::BODY_COM_Y], -123);
+}
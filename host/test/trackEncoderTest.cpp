@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "hostHal.h"
+#include "trackEncoder.h"
+
+// The encoder on the host is the PCNT model in hal/ESP32Encoder.h
+static ESP32Encoder* unit(size_t channel) { return ESP32Encoder::forPin(Board::ENCODERS[channel].pinA); }
+
+TEST(TrackEncoder, CountsThroughPcntWrapsBothWays) {
+    Host::reset();
+    TrackEncoder encoders("encTest");
+    unit(0)->hostMove(100000);
+    EXPECT_EQ(encoders.getCount(0), 100000);
+    unit(0)->hostMove(-250000);
+    EXPECT_EQ(encoders.getCount(0), -150000);
+    EXPECT_GE(unit(0)->hostOverflows(), 7u);
+}
+
+TEST(TrackEncoder, SnapshotCreditsAnOverflowWhoseInterruptIsPending) {
+    Host::reset();
+    TrackEncoder encoders("encTest");
+    unit(0)->hostMove(ESP32Encoder::LIMIT - 5);
+
+    // The unit wraps while interrupts are off on the reading core
+    unit(0)->hostMaskInterrupt(true);
+    unit(0)->hostMove(10);
+    EXPECT_EQ(unit(0)->hostRaw(), 5);
+    EXPECT_EQ(encoders.snapshot().counts[0], ESP32Encoder::LIMIT + 5);
+
+    unit(0)->hostMaskInterrupt(false);
+    EXPECT_EQ(unit(0)->hostAccumulator(), ESP32Encoder::LIMIT);
+    EXPECT_EQ(encoders.snapshot().counts[0], ESP32Encoder::LIMIT + 5);
+}
+
+TEST(TrackEncoder, SnapshotLatchesEveryChannelWithOneTimestamp) {
+    Host::reset();
+    TrackEncoder encoders("encTest");
+    for (size_t i = 0; i < TrackEncoder::NUM_ENCODERS; i++) unit(i)->hostMove(1000 * (int64_t)(i + 1));
+    Host::setTimeUs(5000000);
+
+    TrackEncoder::Snapshot first = encoders.snapshot();
+    for (size_t i = 0; i < TrackEncoder::NUM_ENCODERS; i++) EXPECT_EQ(first.counts[i], 1000 * (int64_t)(i + 1));
+    EXPECT_EQ(first.timestampUs, 5000000);
+
+    Host::advanceUs(10000);
+    TrackEncoder::Snapshot second = encoders.snapshot();
+    EXPECT_EQ(second.sequence, first.sequence + 1);
+    EXPECT_EQ(second.timestampUs, 5010000);
+}
+
+TEST(TrackEncoder, GlitchFilterReachesEveryUnit) {
+    Host::reset();
+    TrackEncoder encoders("encTest");
+    encoders.setGlitchFilter(250);
+    for (size_t i = 0; i < TrackEncoder::NUM_ENCODERS; i++) EXPECT_EQ(unit(i)->hostFilter(), 250);
+    encoders.setGlitchFilter(0);
+    for (size_t i = 0; i < TrackEncoder::NUM_ENCODERS; i++) EXPECT_EQ(unit(i)->hostFilter(), 0);
+}
+
+TEST(TrackEncoder, RestoresSavedCountsAndResetClearsThem) {
+    Host::reset();
+    {
+        Preferences saved;
+        saved.begin("encTest", false);
+        saved.putLong("encoder1", 1234);
+        saved.putLong("encoder2", -5678);
+        saved.end();
+    }
+    TrackEncoder encoders("encTest");
+    EXPECT_TRUE(encoders.persistent());
+    EXPECT_EQ(encoders.getCount(0), 1234);
+    EXPECT_EQ(encoders.getCount(1), -5678);
+
+    encoders.resetCounts();
+    EXPECT_EQ(encoders.getCount(0), 0);
+    EXPECT_EQ(encoders.getCount(1), 0);
+    Preferences saved;
+    saved.begin("encTest", true);
+    EXPECT_EQ(saved.getLong("encoder1", -1), 0);
+    EXPECT_EQ(saved.getLong("encoder2", -1), 0);
+}
+
+TEST(TrackEncoder, RunsFromZeroWithoutNvs) {
+    Host::reset();
+    Host::nvs()["encTest/encoder1"] = {0xd2, 0x04, 0x00, 0x00};
+    Host::nvsFailOpen = true;
+    TrackEncoder encoders("encTest");
+    EXPECT_FALSE(encoders.persistent());
+    EXPECT_EQ(encoders.getCount(0), 0);
+    unit(0)->hostMove(-40000);
+    EXPECT_EQ(encoders.getCount(0), -40000);
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "waypointQueue.h"
+#include "rig.h"
+#include "motorConfig.h"
+#include "jointSupervisor.h"
+
+using PushResult = WaypointQueue::PushResult;
+
+TEST(WaypointQueue, PassesThroughEveryPointAfterTheLead) {
+    WaypointQueue q;
+    const float points[] = {0.0f, 10.0f, -5.0f, 20.0f, 20.0f};
+    for (uint32_t i = 0; i < 5; i++) ASSERT_EQ(q.push({i * 100, points[i]}), PushResult::Ok);
+
+    float deg = 0.0f;
+    const uint32_t start = 5000;  // Local time of the first sample
+    for (uint32_t now = start; now <= start + q.leadMs + 400; now += 10) {
+        ASSERT_TRUE(q.sample(now, deg, deg));
+        ASSERT_TRUE(std::isfinite(deg));
+        uint32_t streamMs = now - start - q.leadMs;
+        if (now >= start + q.leadMs && streamMs % 100 == 0) {
+            EXPECT_NEAR(deg, points[streamMs / 100], 1e-4f) << now;
+        }
+    }
+    EXPECT_EQ(q.depth(), 0u);
+}
+
+TEST(WaypointQueue, RejectsTimesThatDoNotIncrease) {
+    WaypointQueue q;
+    EXPECT_EQ(q.push({100, 1.0f}), PushResult::Ok);
+    EXPECT_EQ(q.push({100, 2.0f}), PushResult::OutOfOrder);
+    EXPECT_EQ(q.push({50, 2.0f}), PushResult::OutOfOrder);
+    EXPECT_EQ(q.push({101, 2.0f}), PushResult::Ok);
+    EXPECT_EQ(q.depth(), 2u);
+
+    // Stream times wrap like millis()
+    WaypointQueue wrapping;
+    EXPECT_EQ(wrapping.push({0xFFFFFFF0u, 0.0f}), PushResult::Ok);
+    EXPECT_EQ(wrapping.push({0x10u, 0.0f}), PushResult::Ok);
+}
+
+TEST(WaypointQueue, FullQueueReportsFull) {
+    WaypointQueue q;
+    for (uint32_t i = 0; i < WaypointQueue::CAPACITY; i++) ASSERT_EQ(q.push({i, 0.0f}), PushResult::Ok);
+    EXPECT_EQ(q.push({1000, 0.0f}), PushResult::Full);
+    EXPECT_EQ(q.freeSlots(), 0u);
+}
+
+TEST(WaypointQueue, ANewStreamMayRestartAfterDrainingOrAClear) {
+    WaypointQueue q;
+    float deg = 0.0f;
+    ASSERT_EQ(q.push({1000, 5.0f}), PushResult::Ok);
+    for (uint32_t now = 0; now < 300; now += 10) q.sample(now, deg, deg);
+    ASSERT_EQ(q.depth(), 0u);
+    EXPECT_EQ(q.push({0, 6.0f}), PushResult::Ok);  // Drained: starts over
+    EXPECT_EQ(q.push({0, 7.0f}), PushResult::OutOfOrder);
+
+    q.requestClear();
+    EXPECT_EQ(q.push({0, 8.0f}), PushResult::Ok);  // Cleared: starts over
+    EXPECT_EQ(q.push({20, 8.0f}), PushResult::Ok);
+}
+
+TEST(WaypointQueue, ClearKeepsPointsPushedAfterTheRequest) {
+    WaypointQueue q;
+    float deg = 0.0f;
+    for (uint32_t i = 0; i < 4; i++) q.push({i * 100, 1.0f});
+    q.sample(0, deg, deg);
+
+    // wpc1 and the next wp1 batch both land before the control tick
+    q.requestClear();
+    q.push({0, 30.0f});
+    q.push({100, 30.0f});
+    EXPECT_EQ(q.depth(), 6u);
+
+    ASSERT_TRUE(q.sample(10, deg, deg));
+    EXPECT_EQ(q.depth(), 2u);
+    for (uint32_t now = 20; now < 400; now += 10) ASSERT_TRUE(q.sample(now, deg, deg));
+    EXPECT_NEAR(deg, 30.0f, 1e-4f);
+}
+
+TEST(WaypointQueue, ClearWithNothingNewStopsTheStream) {
+    WaypointQueue q;
+    float deg = 0.0f;
+    q.push({0, 1.0f});
+    q.push({100, 2.0f});
+    q.sample(0, deg, deg);
+    q.requestClear();
+    EXPECT_FALSE(q.sample(10, deg, deg));
+    EXPECT_FALSE(q.active());
+    EXPECT_EQ(q.depth(), 0u);
+}
+
+TEST(WaypointQueue, UnderrunHoldsOrExtrapolatesForALimitedTime) {
+    for (auto mode : {WaypointQueue::UnderrunMode::Hold, WaypointQueue::UnderrunMode::Extrapolate}) {
+        WaypointQueue q;
+        q.underrunMode.store(mode, std::memory_order_relaxed);
+        q.push({0, 0.0f});
+        q.push({100, 10.0f});  // 0.1 deg/ms
+        float deg = 0.0f;
+        for (uint32_t now = 0; now <= 1000; now += 10) ASSERT_TRUE(q.sample(now, deg, deg));
+        EXPECT_EQ(q.underruns(), 1u);
+        float expected = mode == WaypointQueue::UnderrunMode::Hold ? 10.0f : 10.0f + 0.1f * WaypointQueue::MAX_EXTRAPOLATE_MS;
+        EXPECT_NEAR(deg, expected, 1e-3f);
+    }
+}
+
+TEST(WaypointQueue, ExtrapolationStopsAtTheJointLimits) {
+    Sim::Rig rig;
+    rig.command("lim1=-20,20");
+    rig.command("wpm1=1");
+    rig.command("wp1=0,0,100,10,200,19");
+    rig.replies();
+    for (int i = 0; i < 80; i++) {
+        rig.step();
+        ASSERT_LE(motors[0].getSetpointDeg(), 20.0f);
+    }
+    EXPECT_EQ(motors[0].getSetpointDeg(), 20.0f);
+}
+
+TEST(WaypointQueue, BleRejectsOutOfOrderBatches) {
+    Sim::Rig rig;
+    rig.command("wp1=0,1,100,2,100,3,200,4");
+    std::string reply = rig.replies();
+    EXPECT_NE(reply.find("ERR: Waypoint time not increasing"), std::string::npos) << reply;
+    EXPECT_NE(reply.find("WP1 n=2 q=2"), std::string::npos) << reply;
+}
+
+// Root-mean-square tracking error of joint 1 over a 0.5 Hz, 20 deg sine, sent
+// at 20 Hz either as timestamped waypoints or as plain tar steps. The stream
+// runs leadMs behind the sender, so it is scored against the delayed reference
+static double gaitTrackingError(bool waypoints) {
+    Sim::Rig rig;
+    rig.setGains(0, 0.8f, 4.0f, 0.02f);  // Settles the nominal plant without chatter
+    const double periodS = Board::CONTROL_PERIOD_US * 1e-6;
+    const uint32_t sendEveryTicks = 5, sendAheadMs = 200, runMs = 6000;
+    const double delayMs = waypoints ? WaypointQueue::DEFAULT_LEAD_MS : 0.0;
+    auto reference = [](double ms) { return ms < 0 ? 0.0 : 20.0 * sin(2 * M_PI * 0.5 * ms / 1000.0); };
+
+    double sumSq = 0.0;
+    size_t count = 0;
+    uint32_t sentMs = 0;
+    for (uint32_t tick = 0; tick * periodS * 1000 < runMs; tick++) {
+        uint32_t nowMs = (uint32_t)(tick * periodS * 1000);
+        char line[64];
+        if (waypoints) {
+            // Stream ahead of time, as a host buffering a gait would
+            while (sentMs <= nowMs + sendAheadMs) {
+                snprintf(line, sizeof(line), "wp1=%u,%.3f", sentMs, reference(sentMs));
+                rig.command(line);
+                sentMs += sendEveryTicks * 10;
+            }
+        } else if (tick % sendEveryTicks == 0) {
+            snprintf(line, sizeof(line), "tar1=%.3f", reference(nowMs));
+            rig.command(line);
+        }
+        rig.replies();
+        rig.step();
+        if (nowMs >= 1000) {  // Past the start-up transient
+            double e = rig.plant[0].positionDeg - reference(nowMs - delayMs);
+            sumSq += e * e;
+            count++;
+        }
+    }
+    EXPECT_FALSE(supervisor.tripped());
+    return sqrt(sumSq / count);
+}
+
+TEST(WaypointQueue, StreamTracksAGaitBetterThanStepCommands) {
+    double streamed = Sim::isolated([] { return gaitTrackingError(true); });
+    double stepped = Sim::isolated([] { return gaitTrackingError(false); });
+    RecordProperty("streamed_rms_deg", std::to_string(streamed));
+    RecordProperty("stepped_rms_deg", std::to_string(stepped));
+    printf("gait tracking rms: waypoints %.3f deg, tar steps %.3f deg\n", streamed, stepped);
+    EXPECT_LT(streamed, stepped);
+}
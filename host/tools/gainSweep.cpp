@@ -0,0 +1,160 @@
+// Closed-loop gain sweep through the firmware's own MotorPID::compute() and
+// appliedDrive() against Sim::JointPlant, spread over a thread pool. The
+// Pareto fronts and the report are tools/gain_sweep.py; this is its engine.
+//
+//   gain_sweep [--threads n] [--band deg] < tasks.txt > metrics.csv
+//
+// Input lines are "plant <tau s> <deg/s per %> <friction %>" and
+// "gains <kp> <ki> <kd>"; every gain set runs on every plant, through a
+// 30 deg step and a 20 deg 0.5 Hz gait sine. Output is one CSV row per
+// gain set and plant: whether the step settled, the time it took into the
+// band (the whole run when it did not), overshoot in % of the step, drive
+// energy over both cases (sum of (drive / 100)^2 dt, full-drive seconds)
+// and the gait's RMS tracking error. A SWEEP line on stderr gives the wall
+// time.
+//
+// Each simulation builds its own MotorPID. compute() only touches that
+// instance and reads the host clock, which nothing advances here, so the
+// workers share nothing mutable; the firmware's motors[], supervisor and
+// control task are never started.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "motorConfig.h"
+#include "jointPlant.h"
+
+static constexpr double PERIOD_S = Board::CONTROL_PERIOD_US * 1e-6;
+static constexpr float STEP_DEG = 30.0f, STEP_AT_S = 0.1f, STEP_S = 2.0f;
+static constexpr float GAIT_DEG = 20.0f, GAIT_HZ = 0.5f, GAIT_S = 4.0f;
+
+struct Gains {
+    float kp, ki, kd;
+};
+
+struct Metrics {
+    bool settled;
+    float settleS, overshootPct, energy, gaitRmsDeg;
+};
+
+// One case: reference(t) in deg per tick, position and applied drive out
+template <typename Reference>
+static void simulate(const Gains& gains, const Sim::JointPlant::Params& params, float seconds,
+                     Reference reference, std::vector<float>& position, std::vector<float>& drive) {
+    auto motor = std::make_unique<MotorPID>();
+    motor->Kp = gains.kp;
+    motor->Ki = gains.ki;
+    motor->Kd = gains.kd;
+    motor->init(motorConfigFor<0>());
+    const MotorPID::Config& cfg = motor->config();
+
+    Sim::JointPlant plant;
+    plant.params = params;
+    TrackEncoder::Snapshot snap = {};
+    size_t ticks = (size_t)lroundf(seconds / (float)PERIOD_S);
+    position.resize(ticks);
+    drive.resize(ticks);
+    for (size_t n = 0; n < ticks; n++) {
+        snap.counts[cfg.encoderIndex] = llround(plant.positionDeg * cfg.countsPerDeg);
+        snap.timestampUs += Board::CONTROL_PERIOD_US;
+        motor->setSetpointDeg(reference(n * PERIOD_S));
+        motor->compute(snap, false);
+        drive[n] = motor->appliedDrive();
+        plant.step(drive[n], true, PERIOD_S);
+        position[n] = (float)plant.positionDeg;
+    }
+}
+
+static Metrics evaluate(const Gains& gains, const Sim::JointPlant::Params& plant, float band) {
+    std::vector<float> position, drive;
+    Metrics m = {false, STEP_S - STEP_AT_S, 0.0f, 0.0f, 0.0f};
+
+    simulate(gains, plant, STEP_S, [](double t) { return t >= STEP_AT_S ? STEP_DEG : 0.0f; }, position, drive);
+    size_t first = (size_t)lround(STEP_AT_S / PERIOD_S);
+    if (fabsf(position.back() - STEP_DEG) <= band) {
+        m.settled = true;
+        size_t n = position.size();
+        while (n > first && fabsf(position[n - 1] - STEP_DEG) <= band) n--;
+        m.settleS = (float)(std::min(n, position.size() - 1) * PERIOD_S) - STEP_AT_S;
+    }
+    float peak = 0.0f;
+    for (size_t n = 0; n < position.size(); n++) {
+        peak = fmaxf(peak, position[n]);
+        m.energy += (drive[n] * 0.01f) * (drive[n] * 0.01f) * (float)PERIOD_S;
+    }
+    m.overshootPct = fmaxf(peak - STEP_DEG, 0.0f) / STEP_DEG * 100.0f;
+
+    auto gait = [](double t) { return GAIT_DEG * (float)sin(2.0 * M_PI * GAIT_HZ * t); };
+    simulate(gains, plant, GAIT_S, gait, position, drive);
+    double squared = 0.0;
+    for (size_t n = 0; n < position.size(); n++) {
+        double error = position[n] - gait(n * PERIOD_S);
+        squared += error * error;
+        m.energy += (drive[n] * 0.01f) * (drive[n] * 0.01f) * (float)PERIOD_S;
+    }
+    m.gaitRmsDeg = (float)sqrt(squared / position.size());
+    return m;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    float band = 0.5f;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--band") == 0 && i + 1 < argc) {
+            band = strtof(argv[++i], nullptr);
+        } else {
+            fprintf(stderr, "usage: %s [--threads n] [--band deg] < tasks.txt\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Gains> grid;
+    std::vector<Sim::JointPlant::Params> plants;
+    char kind[8];
+    float a, b, c;
+    while (scanf("%7s %f %f %f", kind, &a, &b, &c) == 4) {
+        if (strcmp(kind, "gains") == 0) {
+            grid.push_back({a, b, c});
+        } else if (strcmp(kind, "plant") == 0) {
+            plants.push_back({a, b, c});
+        }
+    }
+    if (grid.empty() || plants.empty()) {
+        fprintf(stderr, "no gains or no plants on stdin\n");
+        return 1;
+    }
+
+    // Workers take the next (gain set, plant) pair as they free up, so slow,
+    // oscillating sets never hold a core's share of the queue behind them
+    size_t tasks = grid.size() * plants.size();
+    std::vector<Metrics> results(tasks);
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < tasks;) {
+            results[i] = evaluate(grid[i / plants.size()], plants[i % plants.size()], band);
+        }
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("gain,plant,settled,settle_s,overshoot_pct,energy,gait_rms_deg\n");
+    for (size_t i = 0; i < tasks; i++) {
+        const Metrics& m = results[i];
+        printf("%zu,%zu,%d,%.9g,%.9g,%.9g,%.9g\n", i / plants.size(), i % plants.size(), m.settled ? 1 : 0,
+               m.settleS, m.overshootPct, m.energy, m.gaitRmsDeg);
+    }
+    fprintf(stderr, "SWEEP gain_sets=%zu plants=%zu sims=%zu threads=%u seconds=%.6f\n", grid.size(),
+            plants.size(), tasks * 2, threads, seconds);
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Duty cycle through the firmware on Sim::Rig, for tools/idle_energy.py. The
+// idle policy is the firmware's own: the control task parks and wakes, the
+// comms loop's IdleManager::service() runs every tick, and the counts come
+// back from IdleManager::stats().
+//
+//   idle_energy < segments.txt > ticks.csv
+//
+// Input lines are "move <s>" and "rest <s>". A move streams a 20 deg 0.5 Hz
+// gait sine to every joint as one target per tick, as a host would; a rest
+// sends nothing and leaves the joints holding the last target. The joints
+// run the gains the rig tests use, which track the gait without saturating.
+// Output is a header and one row: ticks parked, ticks active, wakes and
+// simulated seconds.
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "rig.h"
+#include "hostHal.h"
+#include "idleManager.h"
+#include "jointSupervisor.h"
+
+static constexpr double PERIOD_S = Board::CONTROL_PERIOD_US * 1e-6;
+static constexpr float GAIT_DEG = 20.0f, GAIT_HZ = 0.5f;
+
+int main() {
+    Sim::Rig rig;
+    for (size_t j = 0; j < Board::NUM_JOINTS; j++) rig.setGains(j, 0.8f, 4.0f, 0.02f);
+    char kind[8];
+    double seconds, simulated = 0.0;
+    while (scanf("%7s %lf", kind, &seconds) == 2) {
+        bool moving = strcmp(kind, "move") == 0;
+        if (!moving && strcmp(kind, "rest") != 0) {
+            fprintf(stderr, "unknown segment %s\n", kind);
+            return 2;
+        }
+        long ticks = lround(seconds / PERIOD_S);
+        for (long n = 0; n < ticks; n++) {
+            if (moving) {
+                float deg = GAIT_DEG * (float)sin(2.0 * M_PI * GAIT_HZ * n * PERIOD_S);
+                for (size_t j = 0; j < Board::NUM_JOINTS; j++) {
+                    char line[24];
+                    snprintf(line, sizeof(line), "tar%u=%.3f", (unsigned)(j + 1), deg);
+                    rig.command(line);
+                }
+                rig.replies();
+            }
+            rig.step();
+            IdleManager::service();
+        }
+        simulated += ticks * PERIOD_S;
+        if (supervisor.tripped()) {
+            HostStream out;
+            supervisor.report(out);
+            fprintf(stderr, "tripped after %.1f s: %s", simulated, out.take().c_str());
+            return 1;
+        }
+    }
+
+    IdleManager::Stats stats = IdleManager::stats();
+    printf("idle_ticks,active_ticks,wakes,seconds\n");
+    printf("%u,%u,%u,%.2f\n", (unsigned)stats.idleTicks, (unsigned)stats.activeTicks, (unsigned)stats.wakes,
+           simulated);
+    return 0;
+}
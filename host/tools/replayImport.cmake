@@ -0,0 +1,12 @@
+# tools/save.csv -> replay_log.py import -> firmware_replay; the import has no
+# integral state, so only a clean, complete replay is checked, not divergence
+execute_process(COMMAND ${PYTHON} ${TOOLS}/replay_log.py import ${TOOLS}/save.csv -o ${WORK}/save.rec
+                RESULT_VARIABLE status)
+if(status)
+    message(FATAL_ERROR "replay_log.py import failed")
+endif()
+execute_process(COMMAND ${REPLAY} ${WORK}/save.rec OUTPUT_VARIABLE out RESULT_VARIABLE status)
+message("${out}")
+if(status OR NOT out MATCHES "REPLAY ticks=[1-9][0-9]* " OR out MATCHES "corrupt")
+    message(FATAL_ERROR "replay failed")
+endif()
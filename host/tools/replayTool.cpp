@@ -0,0 +1,64 @@
+// Replays a flight recorder log through the firmware's own MotorPID on the
+// host, the same Recorder::startReplay path the device runs on rec=replay.
+//
+//   firmware_replay run.rec|capture.txt
+//
+// Takes a raw log (tools/replay_log.py import) or a USB capture of rec=dump,
+// and prints the REPLAY line with per-tick timing from the host clock.
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "hostHal.h"
+#include "recorder.h"
+
+class StdoutPrint : public Print {
+public:
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+};
+
+// Raw bytes, or the REC <offset> <hex> lines of a dump; empty on a gap
+static std::vector<uint8_t> readLog(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (raw.compare(0, 4, "RPLY") == 0) return std::vector<uint8_t>(raw.begin(), raw.end());
+
+    std::vector<uint8_t> data;
+    std::istringstream lines(raw);
+    std::string line;
+    while (std::getline(lines, line)) {
+        unsigned offset;
+        char hex[256];
+        if (sscanf(line.c_str(), "REC %4x %255[0-9A-Fa-f]", &offset, hex) != 2) continue;
+        if (offset != data.size()) return {};
+        for (size_t i = 0; hex[i] && hex[i + 1]; i += 2) {
+            unsigned byte;
+            sscanf(hex + i, "%2x", &byte);
+            data.push_back((uint8_t)byte);
+        }
+    }
+    return data;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s run.rec|capture.txt\n", argv[0]);
+        return 2;
+    }
+    std::vector<uint8_t> log = readLog(argv[1]);
+    if (log.empty()) {
+        fprintf(stderr, "%s: no recorder log found\n", argv[1]);
+        return 1;
+    }
+
+    Host::reset();
+    Host::useRealClock(true);
+    StdoutPrint out;
+    if (!Recorder::load(log.data(), log.size())) {
+        fprintf(stderr, "log is larger than the recorder's %u bytes\n", (unsigned)Recorder::LOG_BYTES);
+        return 1;
+    }
+    if (!Recorder::startReplay(out)) return 1;
+    while (Recorder::mode() == Recorder::Mode::Replaying) Recorder::service();
+    return 0;
+}
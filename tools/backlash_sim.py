@@ -0,0 +1,243 @@
+"""Backlash compensation check against a geared joint with a gap and a compliant stage.
+
+Mirrors firmware/backlashComp.cpp and the PID in MotorPID (P on error, D on
+measurement, clamped integral, braking band) at the 10 ms control rate, on a
+plant simulated at 0.5 ms:
+
+  motor (inertia, viscous + Coulomb friction) -- gap w -- spring k -- load (inertia, Coulomb friction, gravity)
+
+  python backlash_sim.py [--width 1.5] [--stiffness 40] [--plot]
+
+Reports the output-side tracking error on a reversing sine with and without
+compensation, and the width found by the calibration sweep against the true one.
+The sweep measures the gap plus the wind-up at the loaded drive level, which
+is what a friction-loaded joint needs. On a gravity-loaded joint the output
+rests on one side of the gap whatever the direction, so direction-based
+compensation helps little there (try --gravity 20 --friction 2).
+"""
+import math
+import argparse
+import numpy as np
+
+COUNTS_PER_DEG = 298 * 28 / 360.0
+PERIOD_S = 0.01
+PLANT_DT = 0.0005
+BRAKING_THRESHOLD = 2  # counts
+
+
+class Plant:
+    def __init__(self, width, stiffness, load_friction, gravity):
+        self.width = width                  # deg, output side
+        self.stiffness = stiffness          # % drive equivalent per deg of wind-up
+        self.load_friction = load_friction  # % drive equivalent, Coulomb
+        self.gravity = gravity              # % drive equivalent
+        self.motor = self.motor_vel = 0.0
+        self.load = self.load_vel = 0.0
+
+    def link_torque(self):
+        twist = self.motor - self.load
+        slack = abs(twist) - self.width / 2
+        return math.copysign(self.stiffness * slack, twist) if slack > 0 else 0.0
+
+    def step(self, drive, dt):
+        link = self.link_torque()
+        # Motor: drive torque in % units, viscous and Coulomb friction
+        friction = 3.0 * math.copysign(1.0, self.motor_vel) if abs(self.motor_vel) > 1e-3 else 0.0
+        motor_acc = (drive - 0.05 * self.motor_vel - friction - link) * 40.0
+        # Load: Coulomb friction holds it until the link torque breaks it free
+        gravity = self.gravity * math.cos(math.radians(self.load))
+        net = link - gravity
+        if abs(self.load_vel) < 1e-3 and abs(net) <= self.load_friction:
+            self.load_vel, load_acc = 0.0, 0.0
+        else:
+            load_acc = (net - 0.2 * self.load_vel - math.copysign(self.load_friction, self.load_vel or net)) * 10.0
+        self.motor_vel += motor_acc * dt
+        self.load_vel += load_acc * dt
+        self.motor += self.motor_vel * dt
+        self.load += self.load_vel * dt
+
+    def encoder_counts(self):
+        return round(self.motor * COUNTS_PER_DEG)
+
+
+class Pid:
+    """QuickPID pOnError / dOnMeas / iAwClamp in timer mode, limits +/-100."""
+
+    def __init__(self, kp=1.32, ki=10.28, kd=0.10):
+        self.kp, self.ki, self.kd = kp, ki * PERIOD_S, kd / PERIOD_S
+        self.output_sum = 0.0
+        self.last_input = None
+
+    def compute(self, setpoint, measured):
+        if self.last_input is None:
+            self.last_input = measured
+        error = setpoint - measured
+        d_input = measured - self.last_input
+        self.last_input = measured
+        self.output_sum = min(100.0, max(-100.0, self.output_sum + self.ki * error))
+        return min(100.0, max(-100.0, self.output_sum + self.kp * error - self.kd * d_input))
+
+
+class BacklashComp:
+    """Port of BacklashComp::apply and the calibration sweep."""
+
+    def __init__(self, width=0.0, compliance=0.0, deadband=0.05, slew=90.0, max_deflection=2.0):
+        self.width, self.compliance = width, compliance
+        self.deadband, self.slew, self.max_deflection = deadband, slew, max_deflection
+        self.direction, self.peak, self.tracking = 0, 0.0, False
+        self.offset = self.filtered_drive = 0.0
+        self.phase = None
+
+    def apply(self, reference, drive, dt):
+        if self.width <= 0 and self.compliance == 0:
+            return reference
+        self.track(reference)
+        target = self.direction * self.width * 0.5
+        step = self.slew * dt
+        self.offset += min(step, max(-step, target - self.offset))
+        self.filtered_drive += (drive - self.filtered_drive) * dt / (0.2 + dt)
+        deflection = min(self.max_deflection, max(-self.max_deflection, self.compliance * self.filtered_drive))
+        return reference + self.offset + deflection
+
+    def track(self, ref):
+        if not self.tracking:
+            self.peak, self.tracking = ref, True
+        if self.direction == 0:
+            if abs(ref - self.peak) > self.deadband:
+                self.direction, self.peak = (1 if ref > self.peak else -1), ref
+        elif self.direction > 0:
+            if ref > self.peak:
+                self.peak = ref
+            elif ref < self.peak - self.deadband:
+                self.direction, self.peak = -1, ref
+        else:
+            if ref < self.peak:
+                self.peak = ref
+            elif ref > self.peak + self.deadband:
+                self.direction, self.peak = 1, ref
+
+    def calibrate(self, origin, amplitude, speed):
+        self.origin, self.amplitude, self.speed = origin, amplitude, speed
+        self.sweep, self.loaded, self.gaps = origin, [], [None, None]
+        self.phase, self.engaged, self.cal_drive = "out", False, 0.0
+
+    def calibration_step(self, position, drive, dt):
+        step = self.speed * dt
+        self.cal_drive += (drive - self.cal_drive) * dt / (0.1 + dt)
+        drive = self.cal_drive
+        if self.phase == "out":
+            self.sweep = min(self.sweep + step, self.origin + self.amplitude)
+            if self.sweep > self.origin + self.amplitude / 2:
+                self.loaded.append(abs(drive))
+            if self.sweep >= self.origin + self.amplitude:
+                self.reverse(position, "back")
+        elif self.phase == "back":
+            self.sweep = max(self.sweep - step, self.origin - self.amplitude)
+            if not self.engaged:
+                self.reversal = max(self.reversal, position)  # Overshoot past the turn
+            if not self.engaged and drive <= -self.engage_drive:
+                self.gaps[0], self.engaged = self.reversal - position, True
+            if self.sweep < self.origin:
+                self.loaded.append(abs(drive))
+            if self.sweep <= self.origin - self.amplitude:
+                if not self.engaged:
+                    self.phase = "failed"
+                else:
+                    self.reverse(position, "return")
+        elif self.phase == "return":
+            self.sweep = min(self.sweep + step, self.origin)
+            if not self.engaged:
+                self.reversal = min(self.reversal, position)
+            if not self.engaged and drive >= self.engage_drive:
+                self.gaps[1], self.engaged = position - self.reversal, True
+            if self.sweep >= self.origin:
+                self.phase = "done" if self.engaged else "failed"
+        return self.sweep
+
+    def reverse(self, position, phase):
+        loaded = sum(self.loaded) / len(self.loaded) if self.loaded else 0.0
+        self.engage_drive = max(5.0, loaded * 0.5)
+        self.reversal, self.loaded, self.engaged, self.phase = position, [], False, phase
+
+
+def run(plant, comp, reference, duration, calibrate=None):
+    pid = Pid()
+    drive = output = 0.0
+    log = []
+    substeps = int(round(PERIOD_S / PLANT_DT))
+    if calibrate:
+        comp.calibrate(*calibrate)
+    for n in range(int(duration / PERIOD_S)):
+        t = n * PERIOD_S
+        counts = plant.encoder_counts()
+        if calibrate:
+            target = comp.calibration_step(counts / COUNTS_PER_DEG, output, PERIOD_S)
+            if comp.phase in ("done", "failed"):
+                break
+        else:
+            target = reference(t)
+        setpoint = comp.apply(target, output, PERIOD_S) * COUNTS_PER_DEG
+        output = pid.compute(setpoint, counts)
+        drive = 0.0 if abs(setpoint - counts) <= BRAKING_THRESHOLD else output
+        for _ in range(substeps):
+            plant.step(drive, PLANT_DT)
+        log.append((t, target, plant.motor, plant.load, output))
+    return np.array(log)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--width", type=float, default=1.5, help="true backlash, deg")
+    parser.add_argument("--stiffness", type=float, default=40.0, help="%% drive per deg of wind-up")
+    parser.add_argument("--friction", type=float, default=6.0, help="load Coulomb friction, %% drive")
+    parser.add_argument("--gravity", type=float, default=0.0, help="%% drive to hold the load level")
+    parser.add_argument("--compliance", type=float, default=0.0, help="deg per %% drive, added as a case")
+    parser.add_argument("--plot", action="store_true")
+    args = parser.parse_args()
+
+    def sine(t):
+        return 20.0 * math.sin(2 * math.pi * 0.2 * t)
+
+    # Calibration sweep on the bare plant
+    plant = Plant(args.width, args.stiffness, args.friction, args.gravity)
+    cal = BacklashComp()
+    sweep = run(plant, cal, None, 60.0, calibrate=(0.0, 10.0, 5.0))
+    gaps = [g for g in cal.gaps if g is not None]
+    estimate = sum(gaps) / len(gaps) if cal.phase == "done" else float("nan")
+
+    calibrated = estimate if estimate == estimate else 0.0
+    cases = [
+        ("none", BacklashComp()),
+        ("true width", BacklashComp(width=args.width)),
+        ("calibrated", BacklashComp(width=calibrated)),
+    ]
+    if args.compliance:
+        cases.append(("calibrated + compliance", BacklashComp(width=calibrated, compliance=args.compliance)))
+
+    print(f"calibration: {cal.phase}, gaps {['%.3f' % g for g in gaps]}, "
+          f"width {estimate:.3f} deg (true {args.width:.3f})")
+    print(f"{'compensation':<26}{'rms err':>10}{'max err':>10}   output-side, deg, after 2 s")
+    results = {}
+    for name, comp in cases:
+        log = run(Plant(args.width, args.stiffness, args.friction, args.gravity), comp, sine, 15.0)
+        err = log[200:, 1] - log[200:, 3]
+        results[name] = log
+        print(f"{name:<26}{np.sqrt(np.mean(err ** 2)):>10.3f}{np.max(np.abs(err)):>10.3f}")
+
+    if args.plot:
+        import matplotlib.pyplot as plt
+        fig, (a, b) = plt.subplots(2, 1, sharex=False, figsize=(10, 7))
+        for name, log in results.items():
+            a.plot(log[:, 0], log[:, 1] - log[:, 3], label=name)
+        a.set_ylabel("reference - output (deg)")
+        a.legend()
+        b.plot(sweep[:, 0], sweep[:, 2], label="motor")
+        b.plot(sweep[:, 0], sweep[:, 3], label="output")
+        b.set_xlabel("t (s)")
+        b.set_ylabel("calibration sweep (deg)")
+        b.legend()
+        plt.show()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,94 @@
+"""Runs the on-device microbenchmarks over BLE and tracks them over time.
+
+  python bench_capture.py --address <BLE addr> [--history bench_history.jsonl] [--threshold 0.10]
+
+Sends `bench`, stores the JSON result with a timestamp and git revision, and
+compares each case's median cycles with the previous run. Exits non-zero
+when any case got slower than the threshold, so it can gate a release.
+"""
+import sys
+import json
+import asyncio
+import argparse
+import subprocess
+from datetime import datetime
+
+from bleak import BleakClient
+
+# BLESerial exposes the Nordic UART service
+UART_RX = "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
+UART_TX = "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
+
+
+async def capture(args):
+    done = asyncio.get_running_loop().create_future()
+    pending = ""
+
+    def on_notify(_, payload):
+        nonlocal pending
+        pending += payload.decode(errors="replace")
+        while "\n" in pending:
+            line, pending = pending.split("\n", 1)
+            line = line.strip()
+            if line.startswith('{"bench"') and not done.done():
+                done.set_result(json.loads(line))
+
+    async with BleakClient(args.address) as client:
+        await client.start_notify(args.tx, on_notify)
+        await client.write_gatt_char(args.rx, b"bench\n", response=True)
+        return await asyncio.wait_for(done, timeout=args.timeout)
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "--short", "HEAD"], text=True).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--address", required=True)
+    parser.add_argument("--history", default="bench_history.jsonl")
+    parser.add_argument("--threshold", type=float, default=0.10, help="allowed slowdown, 0.10 = 10%%")
+    parser.add_argument("--rx", default=UART_RX)
+    parser.add_argument("--tx", default=UART_TX)
+    parser.add_argument("--timeout", type=float, default=30.0)
+    args = parser.parse_args()
+
+    result = asyncio.run(capture(args))
+    result["time"] = datetime.now().isoformat(timespec="seconds")
+    result["rev"] = git_revision()
+
+    previous = None
+    try:
+        with open(args.history) as f:
+            lines = [l for l in f if l.strip()]
+            previous = json.loads(lines[-1]) if lines else None
+    except FileNotFoundError:
+        pass
+
+    with open(args.history, "a") as f:
+        f.write(json.dumps(result) + "\n")
+
+    before = {r["name"]: r for r in previous["results"]} if previous else {}
+    regressions = 0
+    print(f"{'case':<22}{'cycles':>10}{'ns':>10}{'change':>10}")
+    for r in result["results"]:
+        change = ""
+        old = before.get(r["name"])
+        if old and old["cycles_median"]:
+            ratio = r["cycles_median"] / old["cycles_median"] - 1.0
+            change = f"{ratio * 100:+.1f}%"
+            if ratio > args.threshold:
+                change += " !"
+                regressions += 1
+        print(f"{r['name']:<22}{r['cycles_median']:>10}{r['ns_median']:>10}{change:>10}")
+
+    if regressions:
+        print(f"{regressions} case(s) slower than {args.threshold * 100:.0f}% vs {previous['rev']}")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,98 @@
+"""Time to first control tick, old serial setup() against the staged boot.
+
+Models each startup phase of firmware/firmware.ino as a fixed delay and
+walks both orders: the old one ran everything, BLE included, before the
+control task started; the staged one starts control right after the PIDs and
+the saved profile and leaves BLE and bookkeeping to the comms task on the other core. Delays
+default to typical ESP32-S3 figures and can be overridden, or taken from
+the BOOT lines of a USB capture (or the `boot` command's reply).
+
+  python boot_timeline.py [--capture boot.txt] [--delay ble=900 --delay encoders=40]
+                          [--nvs-fail]
+"""
+import argparse
+
+# Typical phase durations in ms; keep names in step with firmware/bootTrace.h
+DEFAULT_MS = {
+    "rom": 320.0,            # ROM and second stage bootloader, before setup()
+    "encoders": 18.0,        # NVS open and count restore dominate
+    "motors": 0.4,
+    "pids": 0.2,
+    "params": 1.5,           # Two blob reads and their CRCs
+    "control_start": 0.1,
+    "first_tick": 0.15,
+    "ble": 620.0,            # Controller and Bluedroid bring-up
+    "services": 25.0,        # Memory report over USB at 115200 baud
+}
+SERIAL_ORDER = ["encoders", "motors", "pids", "ble", "control_start", "first_tick"]
+STAGED_ORDER = ["encoders", "motors", "pids", "params", "control_start", "first_tick"]
+DEFERRED = ["ble", "services"]
+
+
+def from_capture(path):
+    """Phase durations in ms from BOOT lines: BOOT <phase> start_us=<us> dur_us=<us>."""
+    delays = {}
+    first_tick_us = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) < 2 or parts[0] != "BOOT":
+                continue
+            fields = dict(p.split("=", 1) for p in parts[1:] if "=" in p)
+            if "first_tick_us" in fields:
+                first_tick_us = int(fields["first_tick_us"])
+            elif "dur_us" in fields:
+                delays[parts[1]] = int(fields["dur_us"]) / 1000.0
+                if parts[1] == "encoders":
+                    delays["rom"] = int(fields["start_us"]) / 1000.0
+    return delays, first_tick_us
+
+
+def timelines(delays, nvs_fail):
+    """(serial, staged) ms from reset to the end of the first control tick, and staged ready time."""
+    rom = delays["rom"]
+    serial = float("inf") if nvs_fail else rom + sum(delays[p] for p in SERIAL_ORDER)
+    staged = rom + sum(delays[p] for p in STAGED_ORDER)
+
+    # Deferred work starts once the comms task exists, right after control_start
+    comms_start = rom + sum(delays[p] for p in STAGED_ORDER[:-1])
+    ready = comms_start + sum(delays[p] for p in DEFERRED)
+    return serial, staged, ready
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--capture", help="USB capture holding BOOT lines")
+    parser.add_argument("--delay", action="append", default=[], metavar="PHASE=MS",
+                        help="Override one phase, e.g. ble=1500 to simulate a slow radio")
+    parser.add_argument("--nvs-fail", action="store_true",
+                        help="NVS fails to open: the old setup() hung, the staged boot starts from zero counts")
+    args = parser.parse_args()
+
+    delays = dict(DEFAULT_MS)
+    if args.capture:
+        measured, first_tick_us = from_capture(args.capture)
+        delays.update(measured)
+        if first_tick_us is not None:
+            print(f"measured first tick: {first_tick_us / 1000.0:.1f} ms")
+    for item in args.delay:
+        name, ms = item.split("=", 1)
+        if name not in DEFAULT_MS:
+            parser.error(f"unknown phase {name}, expected one of {', '.join(DEFAULT_MS)}")
+        delays[name] = float(ms)
+
+    print(f"{'phase':<14}{'ms':>9}")
+    for name, ms in delays.items():
+        print(f"{name:<14}{ms:>9.2f}")
+
+    serial, staged, ready = timelines(delays, args.nvs_fail)
+    print()
+    print(f"first control tick, serial setup: {'never (hung on NVS)' if serial == float('inf') else f'{serial:.1f} ms'}")
+    print(f"first control tick, staged boot:  {staged:.1f} ms")
+    print(f"BLE and services ready:           {ready:.1f} ms")
+    if serial != float("inf"):
+        print(f"joints held {serial - staged:.1f} ms sooner")
+
+
+if __name__ == "__main__":
+    main()
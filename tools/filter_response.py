@@ -0,0 +1,145 @@
+"""Biquad chains for the firmware's flt command: design, response and a check of the device's coefficients.
+
+  design notch:12.5:4 lp:30:0.707 [ll:2:8] [--freqs 1,5,10,12.5,20,40]
+  check  capture.txt [--freqs ...]
+
+Sections are type:f1:q, or ll:f1:f2 for a lead-lag with its zero at f1 and
+pole at f2. design prints the flt<j>= commands, coefficients and the chain's
+gain and phase at the control rate (100 Hz, so everything must stay under
+50 Hz). check reads the FLT lines of a `flt` reply, redesigns every section
+in double precision the way Biquad::design does, reports the largest
+coefficient difference and prints each chain's response from the device's
+own coefficients. Per-section CPU cost is biquad_section / biquad_chain_4 in
+the firmware's `bench` output.
+"""
+import math
+import argparse
+import numpy as np
+
+SAMPLE_HZ = 100.0
+TYPES = {"lp": 1, "notch": 2, "ll": 3}
+DEFAULT_FREQS = "0.5,1,2,5,8,10,12.5,15,20,25,30,40,49"
+
+
+def design(kind, f1, f2q, fs=SAMPLE_HZ):
+    """(b0, b1, b2, a1, a2) as Biquad::design computes them."""
+    nyquist = fs / 2
+    if not 0 < f1 < nyquist:
+        raise ValueError(f"{f1} Hz is not below Nyquist ({nyquist} Hz)")
+    if kind == "ll":
+        if not 0 < f2q < nyquist:
+            raise ValueError(f"{f2q} Hz is not below Nyquist ({nyquist} Hz)")
+        kz, kp = math.tan(math.pi * f1 / fs), math.tan(math.pi * f2q / fs)
+        norm = 1 / (1 + kp)
+        return ((1 / kz + 1) * kp * norm, (1 - 1 / kz) * kp * norm, 0.0, (kp - 1) * norm, 0.0)
+
+    if not 0.05 < f2q < 50:
+        raise ValueError(f"q {f2q} out of range")
+    w = 2 * math.pi * f1 / fs
+    cw, alpha = math.cos(w), math.sin(w) / (2 * f2q)
+    norm = 1 / (1 + alpha)
+    if kind == "lp":
+        b = ((1 - cw) / 2 * norm, (1 - cw) * norm, (1 - cw) / 2 * norm)
+    elif kind == "notch":
+        b = (norm, -2 * cw * norm, norm)
+    else:
+        raise ValueError(f"unknown section type {kind}")
+    return (*b, -2 * cw * norm, (1 - alpha) * norm)
+
+
+def response(sections, freqs, fs=SAMPLE_HZ):
+    """Complex gain of the cascade at each frequency."""
+    z = np.exp(-1j * 2 * np.pi * np.asarray(freqs) / fs)
+    h = np.ones_like(z)
+    for b0, b1, b2, a1, a2 in sections:
+        h *= (b0 + b1 * z + b2 * z * z) / (1 + a1 * z + a2 * z * z)
+    return h
+
+
+def stable(section):
+    _, _, _, a1, a2 = section
+    return all(abs(p) < 1 for p in np.roots([1, a1, a2]))
+
+
+def print_response(sections, freqs):
+    h = response(sections, freqs)
+    print(f"{'Hz':>7}{'gain dB':>10}{'phase deg':>11}")
+    for f, g in zip(freqs, h):
+        print(f"{f:>7.2f}{20 * math.log10(max(abs(g), 1e-12)):>10.2f}{math.degrees(np.angle(g)):>11.1f}")
+
+
+def parse_spec(text):
+    kind, f1, f2q = text.split(":")
+    if kind not in TYPES:
+        raise SystemExit(f"section type must be one of {', '.join(TYPES)}")
+    return kind, float(f1), float(f2q)
+
+
+def cmd_design(args):
+    freqs = [float(f) for f in args.freqs.split(",")]
+    sections = []
+    for i, text in enumerate(args.sections):
+        kind, f1, f2q = parse_spec(text)
+        coeffs = design(kind, f1, f2q)
+        sections.append(coeffs)
+        print(f"flt{args.joint}={args.path},{i},{kind},{f1:g},{f2q:g}")
+        print("  b=" + ",".join(f"{c:.9g}" for c in coeffs[:3]) + " a=" + ",".join(f"{c:.9g}" for c in coeffs[3:])
+              + ("" if stable(coeffs) else "  UNSTABLE"))
+    print()
+    print_response(sections, freqs)
+
+
+def cmd_check(args):
+    freqs = [float(f) for f in args.freqs.split(",")]
+    chains = {}
+    worst = 0.0
+    with open(args.capture, errors="replace") as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) < 2 or parts[0] != "FLT" or parts[1] == "none":
+                continue
+            fields = dict(p.split("=", 1) for p in parts[1:])
+            b = [float(v) for v in fields["b"].split(",")]
+            a = [float(v) for v in fields["a"].split(",")]
+            device = (*b, *a)
+            expected = design(fields["type"], float(fields["f1"]), float(fields["f2q"]))
+            diff = max(abs(x - y) for x, y in zip(device, expected))
+            worst = max(worst, diff)
+            key = (fields["j"], fields["path"])
+            chains.setdefault(key, []).append(device)
+            print(f"j{fields['j']} {fields['path']}{fields['sec']} {fields['type']:<6}"
+                  f" max coefficient diff {diff:.2e}{'' if stable(device) else '  UNSTABLE'}")
+
+    if not chains:
+        raise SystemExit("no FLT section lines in the capture")
+    for (joint, path), sections in sorted(chains.items()):
+        print(f"\njoint {joint} path {path}")
+        print_response(sections, freqs)
+    print(f"\nlargest coefficient difference {worst:.2e} (float32 rounding is about 1e-7)")
+    if worst > args.tolerance:
+        raise SystemExit("device coefficients disagree with the design")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("design")
+    p.add_argument("sections", nargs="+", metavar="TYPE:F1:Q")
+    p.add_argument("--joint", type=int, default=1)
+    p.add_argument("--path", choices="mdo", default="m", help="Measurement, derivative or output")
+    p.add_argument("--freqs", default=DEFAULT_FREQS)
+    p.set_defaults(func=cmd_design)
+
+    p = sub.add_parser("check")
+    p.add_argument("capture")
+    p.add_argument("--freqs", default=DEFAULT_FREQS)
+    p.add_argument("--tolerance", type=float, default=1e-5)
+    p.set_defaults(func=cmd_check)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
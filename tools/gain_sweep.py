@@ -0,0 +1,198 @@
+"""Monte-Carlo PID gain sweep on the simulated joint, with Pareto fronts.
+
+  sweep [--kp 0.1:1.5:8 --ki 0:4:5 --kd 0:0.05:6] [--samples 32] [--spread 0.3,0.3,0.5] [-o sweep.csv]
+  scale [--kp ... as sweep] [--workers 1,2,4,8]
+
+Every gain set is run on the same --samples plants (time constant, speed gain
+and Coulomb friction drawn around --tau/--gain/--friction by the --spread
+fractions) through a 30 deg step and a 20 deg 0.5 Hz gait sine. The
+simulations run in host/tools/gain_sweep, which steps the firmware's own
+MotorPID::compute() and appliedDrive() against Sim::JointPlant (encoder
+quantisation, friction, braking band) on a pool of threads; this script
+draws the plants, summarises the per-plant metrics and finds the fronts.
+The binary is built with the host CMake project:
+  cmake -S . -B build && cmake --build build --target gain_sweep
+and found under <repo>/*/host/tools/ or at GAIN_SWEEP_BIN.
+
+Objectives, all minimised: settling time into --band of the step, overshoot
+in % of the step and drive energy (sum of (drive / 100)^2 dt over both
+cases, full-drive seconds), each taken as the --stat over the samples. Sets
+that fail to settle on more than --max-unsettled of the plants are left out of
+the front. sweep prints the front with the kp1=/ki1=/kd1= lines the tuning GUI
+sends.
+
+scale runs one sweep at each thread count, reports the speedup it measured
+and checks every count produced the same metrics. The simulations share
+nothing, but how far that turns into speedup depends on the machine, so
+read it from scale rather than assuming it.
+"""
+import os
+import csv
+import glob
+import argparse
+import itertools
+import subprocess
+import numpy as np
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+OBJECTIVES = ("settle_s", "overshoot_pct", "energy")
+METRICS = ("settled", "settle_s", "overshoot_pct", "energy", "gait_rms_deg")  # gain_sweep's columns
+
+
+def find_engine():
+    name = "gain_sweep.exe" if os.name == "nt" else "gain_sweep"
+    candidates = [os.environ["GAIN_SWEEP_BIN"]] if os.environ.get("GAIN_SWEEP_BIN") else []
+    candidates += sorted(glob.glob(os.path.join(HERE, "..", "*", "host", "tools", "**", name), recursive=True))
+    for path in candidates:
+        if os.path.exists(path):
+            return path
+    raise SystemExit(f"{name} not found; build it with cmake -S . -B build && cmake --build build "
+                     "--target gain_sweep, or point GAIN_SWEEP_BIN at it")
+
+
+def run_engine(grid, plants, band, threads):
+    """Metrics per gain set and plant, shape (len(grid), samples) each, and the engine's wall time."""
+    tasks = [f"plant {tau:.9g} {gain:.9g} {friction:.9g}" for tau, gain, friction in zip(*plants)]
+    tasks += [f"gains {kp:.9g} {ki:.9g} {kd:.9g}" for kp, ki, kd in grid]
+    done = subprocess.run([find_engine(), "--threads", str(threads), "--band", str(band)],
+                          input="\n".join(tasks) + "\n", capture_output=True, text=True)
+    if done.returncode:
+        raise SystemExit(f"gain_sweep failed: {done.stderr.strip()}")
+    table = np.loadtxt(done.stdout.splitlines()[1:], delimiter=",", ndmin=2)
+    samples = len(plants[0])
+    results = {name: np.empty((len(grid), samples)) for name in METRICS}
+    for row in table:
+        for k, name in enumerate(METRICS):
+            results[name][int(row[0]), int(row[1])] = row[2 + k]
+    seconds = float(done.stderr.rsplit("seconds=", 1)[1].split()[0])
+    return results, seconds
+
+
+def parse_range(text):
+    """start:stop:count, or a single value."""
+    parts = [float(v) for v in text.split(":")]
+    if len(parts) == 1:
+        return parts
+    return list(np.linspace(parts[0], parts[1], int(parts[2])))
+
+
+def draw_plants(args):
+    rng = np.random.default_rng(args.seed)
+    spread = [float(v) for v in args.spread.split(",")]
+    nominal = (args.tau, args.gain, args.friction)
+    return tuple(v * (1 + s * rng.uniform(-1, 1, args.samples)) for v, s in zip(nominal, spread))
+
+
+def run_sweep(args, threads):
+    grid = list(itertools.product(parse_range(args.kp), parse_range(args.ki), parse_range(args.kd)))
+    results, seconds = run_engine(grid, draw_plants(args), args.band, threads)
+    return grid, results, seconds
+
+
+def summarise(samples, stat):
+    if stat == "mean":
+        return float(np.mean(samples))
+    if stat == "max":
+        return float(np.max(samples))
+    return float(np.percentile(samples, 90))
+
+
+def pareto(points):
+    """Indices of rows no other row beats or equals in every column while beating in one."""
+    points = np.asarray(points)
+    front = []
+    for i, p in enumerate(points):
+        dominated = np.all(points <= p, axis=1) & np.any(points < p, axis=1)
+        if not dominated.any():
+            front.append(i)
+    return front
+
+
+def cmd_sweep(args):
+    grid, results, elapsed = run_sweep(args, args.workers)
+
+    rows = []
+    for i, gains in enumerate(grid):
+        row = {"kp": gains[0], "ki": gains[1], "kd": gains[2]}
+        row.update({name: summarise(results[name][i], args.stat) for name in METRICS[1:]})
+        row["unsettled"] = float(np.mean(results["settled"][i] == 0))
+        rows.append(row)
+    candidates = [i for i, r in enumerate(rows) if r["unsettled"] <= args.max_unsettled]
+    if not candidates:
+        raise SystemExit("no gain set settles often enough; widen the ranges or --max-unsettled")
+    front = [candidates[i] for i in pareto([[rows[i][k] for k in OBJECTIVES] for i in candidates])]
+    for r in rows:
+        r["pareto"] = 0
+    for i in front:
+        rows[i]["pareto"] = 1
+
+    sims = len(grid) * args.samples * 2
+    print(f"{len(grid)} gain sets x {args.samples} plants x 2 cases = {sims} simulations "
+          f"in {elapsed:.1f} s on {args.workers} threads")
+    print(f"\nPareto front ({args.stat} over plants), {len(front)} of {len(rows)}:")
+    print(f"{'kp':>7}{'ki':>8}{'kd':>7}{'settle s':>10}{'over %':>8}{'energy':>8}{'gait rms':>10}{'unsettled':>11}")
+    for i in sorted(front, key=lambda i: rows[i]["settle_s"]):
+        r = rows[i]
+        print(f"{r['kp']:>7.3f}{r['ki']:>8.3f}{r['kd']:>7.3f}{r['settle_s']:>10.2f}{r['overshoot_pct']:>8.2f}"
+              f"{r['energy']:>8.3f}{r['gait_rms_deg']:>10.3f}{r['unsettled']:>11.0%}")
+    best = min(front, key=lambda i: (rows[i]["unsettled"], rows[i]["settle_s"]))
+    r = rows[best]
+    print(f"\nfastest settling: kp1={r['kp']:.4g} ki1={r['ki']:.4g} kd1={r['kd']:.4g}")
+
+    if args.output:
+        with open(args.output, "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+            writer.writeheader()
+            writer.writerows(rows)
+
+
+def cmd_scale(args):
+    counts = [int(v) for v in args.workers.split(",")]
+    print(f"{os.cpu_count()} CPUs")
+    print(f"{'threads':>8}{'seconds':>9}{'speedup':>9}{'efficiency':>12}")
+    base, reference = None, None
+    for threads in counts:
+        _, results, elapsed = run_sweep(args, threads)
+        elapsed = max(elapsed, 1e-6)  # A small grid can finish inside the clock's step
+        if reference is None:
+            reference, base = results, elapsed * counts[0]
+        if any(not np.array_equal(results[name], reference[name]) for name in METRICS):
+            raise SystemExit(f"{threads} threads gave different metrics than {counts[0]}")
+        speedup = base / elapsed
+        print(f"{threads:>8}{elapsed:>9.4f}{speedup:>9.2f}{speedup / threads:>12.0%}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    for name, func in (("sweep", cmd_sweep), ("scale", cmd_scale)):
+        p = sub.add_parser(name)
+        p.add_argument("--kp", default="0.1:1.5:8", help="start:stop:count or one value")
+        p.add_argument("--ki", default="0:4:5")
+        p.add_argument("--kd", default="0:0.05:6")
+        p.add_argument("--samples", type=int, default=32, help="Plants drawn per gain set")
+        p.add_argument("--tau", type=float, default=0.03, help="Nominal velocity time constant, s")
+        p.add_argument("--gain", type=float, default=6.0, help="Nominal speed per drive %%, deg/s")
+        p.add_argument("--friction", type=float, default=3.0, help="Nominal Coulomb friction, %% drive")
+        p.add_argument("--spread", default="0.3,0.3,0.5", help="Uniform +/- fraction for tau, gain, friction")
+        p.add_argument("--band", type=float, default=0.5, help="Settling band, deg")
+        p.add_argument("--seed", type=int, default=1)
+        p.set_defaults(func=func)
+        if name == "sweep":
+            p.add_argument("--workers", type=int, default=os.cpu_count() or 1, help="Engine threads")
+            p.add_argument("--stat", choices=("mean", "p90", "max"), default="p90")
+            p.add_argument("--max-unsettled", type=float, default=0.0,
+                           help="Fraction of plants a front member may fail to settle on")
+            p.add_argument("-o", "--output", help="Every gain set with its metrics, CSV")
+        else:
+            p.add_argument("--workers", default=",".join(
+                str(n) for n in (1, 2, 4, 8, 16, 32) if n <= (os.cpu_count() or 1)),
+                help="Thread counts to time, comma separated")
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,424 @@
+"""Host side of the controller's links: bulk telemetry decoding and commands with acks.
+
+  monitor --port /dev/ttyACM0 [--seconds 10] [--channels 0:pvo,0:t] [-o run.npz]
+  command --address <BLE addr> tar1=30 [bkl ...]
+  bench   [--lines 100000]
+
+Commands with replies, tsub=/tclr= among them, go over BLE: the USB port's
+input is the tuning table, which only takes tar/kp/ki/kd and never answers.
+To decode binary frames on USB, subscribe them first with
+  command --address <BLE addr> tsub=u,0,pvo,1
+then monitor the port with the matching --channels.
+
+A reader thread pulls whatever the transport has (pyserial, a raw file
+descriptor such as a pty, or the BLE UART service through bleak) in one
+read and hands the chunk to the C++ core in host/link (libhost_link, loaded
+through ctypes). The core picks out text telemetry lines and binary frames
+(firmware/telemetry.h), carries every subscribed channel forward, and
+stores rows in fixed rings of float64 whose first column is the host
+arrival time; take() copies everything new out as one contiguous array.
+OK/ERR lines go to the core's reply queue, where command() waits for the
+one that answers it, and other lines to Link.lines. Decoding runs with the
+GIL released, so a GUI thread is not held up by it.
+
+The core is built with the host CMake project:
+  cmake -S . -B build && cmake --build build --target host_link
+and found under <repo>/*/host/link/, next to this file, or at HOST_LINK_LIB.
+
+  from host_link import open_link
+  link = open_link(port="COM6")
+  rows = link.text.take()   # time_s, setpoint1, input1, output1, kp1, ki1, kd1, setpoint2, ...
+
+bench pushes synthetic telemetry through a pseudo-terminal and times the
+line-at-a-time reader of test_serial.py against this one.
+"""
+import os
+import sys
+import glob
+import time
+import ctypes
+import asyncio
+import argparse
+import threading
+import collections
+import numpy as np
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TEXT_COLUMNS = 12          # Telemetry::printText: setpoint, input, output, kp, ki, kd per joint
+KINDS = "pvoehki"          # Telemetry::Kind order
+TIMING_TICK_US, TIMING_OVERRUNS, BODY_COM_X, BODY_COM_Y = 0xF0, 0xF1, 0xF2, 0xF3
+TEXT_STREAM, FRAME_STREAM = 0, 1   # HostLink::Link::Stream
+MAX_LINE = 4096            # HostLink::MAX_LINE
+
+# BLESerial exposes the Nordic UART service
+UART_RX = "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
+UART_TX = "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
+
+
+class LinkError(RuntimeError):
+    pass
+
+
+def channel_ids(joint, letters, joints=2):
+    """Channel ids a tsub=<link>,<joint>,<letters>,<n> subscribes, as Telemetry::subscribeLetters."""
+    ids = []
+    for c in letters:
+        if c == "t":
+            ids += [TIMING_TICK_US, TIMING_OVERRUNS]
+        elif c == "c":
+            ids += [BODY_COM_X, BODY_COM_Y]
+        elif c in KINDS:
+            targets = [joint - 1] if joint > 0 else range(joints)
+            ids += [(j << 3) | KINDS.index(c) for j in targets]
+    return ids
+
+
+def _load_library():
+    """The C++ core from host/link, built with the host CMake project; HOST_LINK_LIB overrides the search."""
+    names = {"win32": "host_link.dll", "darwin": "libhost_link.dylib"}
+    name = names.get(sys.platform, "libhost_link.so")
+    candidates = [os.environ["HOST_LINK_LIB"]] if os.environ.get("HOST_LINK_LIB") else []
+    candidates.append(os.path.join(HERE, name))
+    candidates += sorted(glob.glob(os.path.join(HERE, "..", "*", "host", "link", "**", name), recursive=True))
+    for path in candidates:
+        if os.path.exists(path):
+            break
+    else:
+        raise LinkError(f"{name} not found; build it with cmake -S . -B build && cmake --build build "
+                        "--target host_link, or point HOST_LINK_LIB at it")
+
+    lib = ctypes.CDLL(path)
+    handle, size, rows = ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_double)
+    lib.hl_open.restype = handle
+    lib.hl_open.argtypes = [size, ctypes.POINTER(ctypes.c_uint8), size, size]
+    lib.hl_close.argtypes = [handle]
+    lib.hl_feed.argtypes = [handle, ctypes.c_char_p, size, ctypes.c_double]
+    lib.hl_columns.restype = size
+    lib.hl_columns.argtypes = [handle, ctypes.c_int]
+    lib.hl_pending.restype = size
+    lib.hl_pending.argtypes = [handle, ctypes.c_int]
+    lib.hl_take.restype = size
+    lib.hl_take.argtypes = [handle, ctypes.c_int, rows, size]
+    lib.hl_next_line.restype = ctypes.c_long
+    lib.hl_next_line.argtypes = [handle, ctypes.c_char_p, size, ctypes.POINTER(ctypes.c_double)]
+    lib.hl_wait_reply.restype = ctypes.c_long
+    lib.hl_wait_reply.argtypes = [handle, ctypes.c_double, ctypes.c_char_p, size]
+    lib.hl_clear_replies.argtypes = [handle]
+    lib.hl_get_stats.argtypes = [handle, ctypes.POINTER(Stats)]
+    return lib
+
+
+class Stats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_uint64) for name in
+                ("bytes", "text_rows", "frames", "frame_errors", "corrupt_lines", "dropped")]
+
+
+class Rows:
+    """One of the core's sample rings; take() returns the rows added since the last take, oldest first."""
+
+    def __init__(self, lib, handle, stream):
+        self.lib, self.handle, self.stream = lib, handle, stream
+        self.columns = lib.hl_columns(handle, stream)
+
+    def take(self):
+        out = np.empty((self.lib.hl_pending(self.handle, self.stream), self.columns))
+        got = self.lib.hl_take(self.handle, self.stream, out.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
+                               len(out))
+        return out[:got]
+
+
+class FdTransport:
+    """Raw file descriptor: a pty, or a tty already set up by the caller."""
+
+    def __init__(self, fd):
+        self.fd = fd
+
+    def read(self):
+        return os.read(self.fd, 65536)
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+    def close(self):
+        os.close(self.fd)
+
+
+class SerialTransport:
+    def __init__(self, port, baud=115200):
+        import serial
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+
+    def read(self):
+        return self.ser.read(max(1, self.ser.in_waiting))
+
+    def write(self, data):
+        self.ser.write(data)
+
+    def close(self):
+        self.ser.close()
+
+
+class BleTransport:
+    """The firmware's BLE UART service as a byte stream, bleak running on its own event loop."""
+
+    def __init__(self, address, rx=UART_RX, tx=UART_TX, timeout=10.0):
+        from bleak import BleakClient
+        self.rx = rx
+        self.buffer = bytearray()
+        self.ready = threading.Condition()
+        self.loop = asyncio.new_event_loop()
+        threading.Thread(target=self.loop.run_forever, daemon=True).start()
+        self.client = BleakClient(address)
+        self._run(self.client.connect(), timeout)
+        self._run(self.client.start_notify(tx, self._notify), timeout)
+
+    def _run(self, coro, timeout=5.0):
+        return asyncio.run_coroutine_threadsafe(coro, self.loop).result(timeout)
+
+    def _notify(self, _, payload):
+        with self.ready:
+            self.buffer += payload
+            self.ready.notify()
+
+    def read(self):
+        with self.ready:
+            self.ready.wait_for(lambda: self.buffer, timeout=0.05)
+            data = bytes(self.buffer)
+            self.buffer.clear()
+            return data
+
+    def write(self, data):
+        self._run(self.client.write_gatt_char(self.rx, data, response=True))
+
+    def close(self):
+        self._run(self.client.disconnect())
+        self.loop.call_soon_threadsafe(self.loop.stop)
+
+
+class Link:
+    def __init__(self, transport, channels=(), text_columns=TEXT_COLUMNS, capacity=1 << 16):
+        self.lib = _load_library()
+        ids = (ctypes.c_uint8 * max(1, len(channels)))(*channels)
+        self.handle = self.lib.hl_open(text_columns, ids, len(channels), capacity)
+        if not self.handle:
+            raise LinkError("host_link: could not allocate the sample rings")
+        self.transport = transport
+        self.text = Rows(self.lib, self.handle, TEXT_STREAM)
+        self.frames = Rows(self.lib, self.handle, FRAME_STREAM)
+        self.lines = collections.deque(maxlen=1000)  # (time_s, line) that are neither telemetry nor replies
+        self.line_buffer = ctypes.create_string_buffer(MAX_LINE + 1)
+        self.command_lock = threading.Lock()
+        self.running = True
+        self.thread = threading.Thread(target=self._reader, daemon=True)
+        self.thread.start()
+
+    def _reader(self):
+        # Each read and each core call runs without the GIL; only the line hand-off is Python
+        line_time = ctypes.c_double()
+        while self.running:
+            try:
+                chunk = self.transport.read()
+            except OSError:
+                break
+            if not chunk:
+                continue
+            self.lib.hl_feed(self.handle, chunk, len(chunk), time.time())
+            while True:
+                n = self.lib.hl_next_line(self.handle, self.line_buffer, len(self.line_buffer),
+                                          ctypes.byref(line_time))
+                if n < 0:
+                    break
+                self.lines.append((line_time.value, self.line_buffer.raw[:n].decode(errors="replace")))
+
+    def send(self, text):
+        """Writes a command line without waiting; for the USB tuning table, which does not answer."""
+        self.transport.write((text + "\n").encode())
+
+    def command(self, text, timeout=2.0):
+        """Sends a command line and returns its OK reply; raises LinkError on ERR or timeout."""
+        with self.command_lock:
+            self.lib.hl_clear_replies(self.handle)
+            self.send(text)
+            reply = ctypes.create_string_buffer(MAX_LINE + 1)
+            n = self.lib.hl_wait_reply(self.handle, timeout, reply, len(reply))
+            if n < 0:
+                raise LinkError(f"{text}: no reply in {timeout} s")
+            reply = reply.raw[:n].decode(errors="replace")
+            if reply.startswith("ERR"):
+                raise LinkError(f"{text}: {reply}")
+            return reply
+
+    def stats(self):
+        s = Stats()
+        self.lib.hl_get_stats(self.handle, ctypes.byref(s))
+        return {name: getattr(s, name) for name, _ in Stats._fields_}
+
+    def close(self):
+        self.running = False
+        self.transport.close()
+        self.thread.join(timeout=1.0)
+        if not self.thread.is_alive():
+            self.lib.hl_close(self.handle)
+            self.handle = None
+
+
+def open_link(port=None, address=None, baud=115200, **kwargs):
+    if address:
+        return Link(BleTransport(address), **kwargs)
+    return Link(SerialTransport(port, baud), **kwargs)
+
+
+def parse_channels(spec):
+    ids = []
+    for item in filter(None, (spec or "").split(",")):
+        joint, letters = item.split(":")
+        ids += channel_ids(int(joint), letters)
+    return ids
+
+
+def cmd_monitor(args):
+    channels = parse_channels(args.channels)
+    link = open_link(args.port, args.address, args.baud, channels=channels)
+    text, frames = [], []
+    deadline = time.time() + args.seconds
+    while time.time() < deadline:
+        time.sleep(0.1)
+        text.append(link.text.take())
+        frames.append(link.frames.take())
+    link.close()
+    text, frames = np.concatenate(text), np.concatenate(frames)
+    print(f"{len(text)} text rows, {len(frames)} frames, {link.stats()}")
+    if args.output:
+        np.savez(args.output, text=text, frames=frames, channels=np.array(channels))
+
+
+def cmd_command(args):
+    link = open_link(args.port, args.address, args.baud)
+    try:
+        for text in args.commands:
+            print(link.command(text, args.timeout))
+        time.sleep(0.2)  # Report lines that follow the reply
+        for _, line in link.lines:
+            print(line)
+    finally:
+        link.close()
+
+
+def synthetic_lines(count):
+    """printText lines for two joints, as the firmware formats them (two decimals)."""
+    t = np.arange(count)
+    sp = np.round(834.4 + 0 * t, 2)
+    pos = np.round(834.0 + 20 * np.sin(t / 50), 2)
+    out = np.round(40 * np.cos(t / 30), 2)
+    cols = [sp, pos, out, 1.32 + 0 * t, 10.28 + 0 * t, 0.1 + 0 * t] * 2
+    rows = np.column_stack(cols)
+    text = "".join("\t".join(f"{v:.2f}" for v in row) + "\n" for row in rows)
+    return text.encode(), rows
+
+
+def legacy_reader(path):
+    """SerialWorker.run from test_serial.py before host_link: readline, decode, split, float per field."""
+    import serial
+    ser = serial.Serial(path, 115200, timeout=0.1)  # Opening flushes input, so open before writing
+
+    def read(count):
+        got, checksum = 0, 0.0
+        while got < count:
+            if ser.in_waiting <= 0:
+                continue
+            try:
+                line = ser.readline().decode().strip()
+                if line:
+                    parts = list(map(float, line.split('\t')))
+                    if len(parts) == 12:
+                        got += 1
+                        checksum += parts[1]
+            except Exception:
+                continue
+        ser.close()
+        return checksum
+    return read
+
+
+def link_reader(path):
+    link = Link(FdTransport(os.open(path, os.O_RDONLY | os.O_NOCTTY)))
+
+    def read(count):
+        got, checksum = 0, 0.0
+        while got < count:
+            rows = link.text.take()
+            if not len(rows):
+                time.sleep(0.001)
+            got += len(rows)
+            checksum += rows[:, 2].sum()
+        link.running = False
+        return checksum
+    return read
+
+
+def cmd_bench(args):
+    import tty
+    payload, rows = synthetic_lines(args.lines)
+    expected = rows[:, 1].sum()
+    print(f"{args.lines} lines, {len(payload) / 1e6:.2f} MB through a pty")
+
+    rates, mismatched = {}, []
+    for name, reader in (("readline+split", legacy_reader), ("host_link", link_reader)):
+        master, slave = os.openpty()
+        tty.setraw(slave)
+        read = reader(os.ttyname(slave))
+
+        def pump():
+            view = memoryview(payload)
+            while view:
+                view = view[os.write(master, view[:16384]):]
+
+        writer = threading.Thread(target=pump, daemon=True)
+        start = time.perf_counter()
+        writer.start()
+        checksum = read(args.lines)
+        elapsed = time.perf_counter() - start
+        writer.join()
+        os.close(master)
+        os.close(slave)
+        rates[name] = args.lines / elapsed
+        ok = abs(checksum - expected) < 1e-6 * max(1.0, abs(expected))
+        if not ok:
+            mismatched.append(name)
+        print(f"{name:<16}{rates[name]:>12.0f} lines/s{len(payload) / elapsed / 1e6:>9.2f} MB/s"
+              f"  values {'match' if ok else 'DIFFER'}")
+    print(f"speedup x{rates['host_link'] / rates['readline+split']:.1f}")
+    if mismatched:
+        sys.exit(f"decoded values differ: {', '.join(mismatched)}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    for name, func in (("monitor", cmd_monitor), ("command", cmd_command)):
+        p = sub.add_parser(name)
+        p.add_argument("--port", help="Serial port, e.g. COM6 or /dev/ttyACM0")
+        p.add_argument("--address", help="BLE address; the UART service instead of USB")
+        p.add_argument("--baud", type=int, default=115200)
+        p.set_defaults(func=func)
+        if name == "monitor":
+            p.add_argument("--seconds", type=float, default=10.0)
+            p.add_argument("--channels", help="Binary channels to decode, joint:letters[,...] as in tsub=")
+            p.add_argument("-o", "--output", help="Save rows to .npz")
+        else:
+            p.add_argument("commands", nargs="+")
+            p.add_argument("--timeout", type=float, default=2.0)
+
+    p = sub.add_parser("bench")
+    p.add_argument("--lines", type=int, default=100000)
+    p.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    if args.func is not cmd_bench and not (args.port or args.address):
+        parser.error("--port or --address is required")
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,103 @@
+"""Estimated energy saving of the firmware idle manager over typical duty cycles.
+
+Draws a day of use as random motion bursts separated by rest periods and
+runs it through the firmware on the host rig: host/tools/idle_energy streams
+a gait to the joints during each burst and leaves them holding between, and
+the firmware's own idle manager parks and wakes them. The parked and active
+tick counts it reports weight the logic-side current with and without the
+idle mode. Motor current is the same either way and is left out.
+
+  python idle_energy.py [--battery-mah 2200] [--hours 24] [--seed 1]
+
+The binary is built with the host CMake project:
+  cmake -S . -B build && cmake --build build --target idle_energy
+and found under <repo>/*/host/tools/ or at IDLE_ENERGY_BIN.
+"""
+import os
+import glob
+import random
+import argparse
+import subprocess
+from concurrent.futures import ThreadPoolExecutor
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PERIOD_S = 0.01
+
+# Keep in step with the current budget in firmware/idleManager.h (mA at 3.3 V)
+CPU_ACTIVE_MA = 42.0
+CPU_IDLE_MA = 22.0
+BLE_ACTIVE_MA = 9.0
+BLE_IDLE_MA = 1.5
+DRIVER_AWAKE_MA = 1.7
+IDLE_CONN_INTERVAL_MS = 150
+IDLE_COMMS_DELAY_MS = 10
+
+ACTIVE_MA = CPU_ACTIVE_MA + BLE_ACTIVE_MA + DRIVER_AWAKE_MA
+IDLE_MA = CPU_IDLE_MA + BLE_IDLE_MA
+
+
+def timeline(duty, hours, mean_burst_s, rng):
+    """Alternating (moving, seconds) segments with the requested moving share."""
+    total = hours * 3600.0
+    mean_rest = mean_burst_s * (1.0 - duty) / duty
+    t, segments = 0.0, []
+    while t < total:
+        burst = rng.expovariate(1.0 / mean_burst_s)
+        rest = rng.expovariate(1.0 / mean_rest)
+        segments += [(True, burst), (False, rest)]
+        t += burst + rest
+    return segments
+
+
+def find_engine():
+    name = "idle_energy.exe" if os.name == "nt" else "idle_energy"
+    candidates = [os.environ["IDLE_ENERGY_BIN"]] if os.environ.get("IDLE_ENERGY_BIN") else []
+    candidates += sorted(glob.glob(os.path.join(HERE, "..", "*", "host", "tools", "**", name), recursive=True))
+    for path in candidates:
+        if os.path.exists(path):
+            return path
+    raise SystemExit(f"{name} not found; build it with cmake -S . -B build && cmake --build build "
+                     "--target idle_energy, or point IDLE_ENERGY_BIN at it")
+
+
+def simulate(segments):
+    """Returns (baseline mAh, managed mAh, wakes, idle share, hours simulated)."""
+    lines = [f"{'move' if moving else 'rest'} {seconds:.3f}" for moving, seconds in segments]
+    done = subprocess.run([find_engine()], input="\n".join(lines) + "\n", capture_output=True, text=True)
+    if done.returncode:
+        raise SystemExit(f"idle_energy failed: {done.stderr.strip()}")
+    idle_ticks, active_ticks, wakes, seconds = (float(v) for v in done.stdout.splitlines()[1].split(","))
+    total = idle_ticks + active_ticks
+    baseline = ACTIVE_MA * total * PERIOD_S
+    managed = (ACTIVE_MA * active_ticks + IDLE_MA * idle_ticks) * PERIOD_S
+    return baseline / 3600.0, managed / 3600.0, int(wakes), idle_ticks / total, seconds / 3600.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--battery-mah", type=float, default=2200.0)
+    parser.add_argument("--hours", type=float, default=24.0)
+    parser.add_argument("--burst", type=float, default=8.0, help="mean motion burst, s")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    print(f"logic current: active {ACTIVE_MA:.1f} mA, idle {IDLE_MA:.1f} mA; "
+          f"wake latency <= {IDLE_CONN_INTERVAL_MS + IDLE_COMMS_DELAY_MS} ms")
+    print(f"{'duty':>6}{'idle %':>9}{'base mA':>10}{'idle mA':>10}{'saving':>9}"
+          f"{'runtime h':>12}{'wakes/h':>9}")
+    duties = (0.02, 0.05, 0.10, 0.25, 0.50, 0.90)
+    # The firmware's state is static, so each duty cycle is a rig process of its own
+    timelines = [timeline(duty, args.hours, args.burst, rng) for duty in duties]
+    with ThreadPoolExecutor(os.cpu_count()) as pool:
+        results = list(pool.map(simulate, timelines))
+    for duty, (base, managed, wakes, idle_share, hours) in zip(duties, results):
+        base_ma, managed_ma = base / hours, managed / hours
+        runtime = (args.battery_mah / base_ma, args.battery_mah / managed_ma)
+        print(f"{duty * 100:>5.0f}%{idle_share * 100:>9.1f}{base_ma:>10.1f}{managed_ma:>10.1f}"
+              f"{(1 - managed / base) * 100:>8.1f}%{runtime[0]:>6.0f} -> {runtime[1]:<4.0f}"
+              f"{wakes / hours:>9.0f}")
+
+
+if __name__ == "__main__":
+    main()
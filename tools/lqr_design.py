@@ -0,0 +1,211 @@
+"""LQR gains for the firmware's state feedback mode, and a check against the PID.
+
+  identify step.csv [--column 1]        fit the motor model to a logged step
+  design [--tau 0.03 --gain 6.0] [--q 1,0.0005,4] [--r 0.02] [--joints 1 --coupling 0]
+
+The model is the geared motor as a first-order velocity lag, speed
+gain * drive % with time constant tau, plus position and the integral of
+position error, discretised at the 10 ms control period. design solves the
+discrete Riccati equation, prints the gains as lqr<j>= / lqrx<j>,<i>= BLE
+commands and simulates PID and LQR on the same plant (encoder quantisation,
+Coulomb friction, the firmware's velocity filter and braking band) for a step
+and a sine. identify takes a CSV of time_s, drive_pct, position_deg, e.g.
+decoded from a recorder log, and fits tau and gain by least squares.
+
+CPU cost on the target is in the firmware's `bench` output: lqr_compute
+against pid_compute.
+"""
+import csv
+import math
+import argparse
+import numpy as np
+
+PERIOD_S = 0.01
+PLANT_DT = 0.0005
+COUNTS_PER_DEG = 298 * 28 / 360.0
+BRAKING_THRESHOLD = 2  # counts
+VELOCITY_TAU_S = 0.02
+
+
+def discrete_model(tau, gain, joints=1, coupling=0.0):
+    """(A, B) with state [pos err, vel, integral] per joint and one drive per joint."""
+    a = math.exp(-PERIOD_S / tau)
+    A1 = np.array([[1.0, tau * (1 - a), 0.0],
+                   [0.0, a, 0.0],
+                   [PERIOD_S, 0.0, 1.0]])
+    B1 = np.array([gain * (PERIOD_S - tau * (1 - a)), gain * (1 - a), 0.0])
+    A = np.kron(np.eye(joints), A1)
+    B = np.zeros((3 * joints, joints))
+    for j in range(joints):
+        for i in range(joints):
+            scale = 1.0 if i == j else (coupling if abs(i - j) == 1 else 0.0)
+            B[3 * i:3 * i + 3, j] = B1 * scale
+    return A, B
+
+
+def dlqr(A, B, Q, R, iterations=20000, tol=1e-10):
+    """Gain K for u = -K x from the discrete Riccati equation, by fixed-point iteration."""
+    P = Q.copy()
+    for _ in range(iterations):
+        BtP = B.T @ P
+        K = np.linalg.solve(R + BtP @ B, BtP @ A)
+        P_next = Q + A.T @ P @ (A - B @ K)
+        if np.max(np.abs(P_next - P)) < tol * max(1.0, np.max(np.abs(P))):
+            P = P_next
+            break
+        P = P_next
+    BtP = B.T @ P
+    return np.linalg.solve(R + BtP @ B, BtP @ A)
+
+
+class Plant:
+    def __init__(self, tau, gain, friction):
+        self.tau, self.gain, self.friction = tau, gain, friction
+        self.pos = self.vel = 0.0
+
+    def step(self, drive, dt):
+        # Drive below the Coulomb level does not start a stopped motor
+        effective = drive - math.copysign(self.friction, drive) if abs(drive) > self.friction else 0.0
+        self.vel += (self.gain * effective - self.vel) / self.tau * dt
+        self.pos += self.vel * dt
+
+    def counts(self):
+        return round(self.pos * COUNTS_PER_DEG)
+
+
+class Pid:
+    """QuickPID pOnError / dOnMeas / iAwClamp in timer mode, on counts, limits +/-100."""
+
+    def __init__(self, kp=1.32, ki=10.28, kd=0.10):
+        self.kp, self.ki, self.kd = kp, ki * PERIOD_S, kd / PERIOD_S
+        self.output_sum = 0.0
+        self.last_input = None
+
+    def compute(self, setpoint, measured, velocity):
+        if self.last_input is None:
+            self.last_input = measured
+        error = setpoint - measured
+        d_input = measured - self.last_input
+        self.last_input = measured
+        self.output_sum = min(100.0, max(-100.0, self.output_sum + self.ki * error))
+        return min(100.0, max(-100.0, self.output_sum + self.kp * error - self.kd * d_input))
+
+
+class Lqr:
+    """MotorPID::updateLqr for one joint."""
+
+    def __init__(self, k):
+        self.k = k
+        self.integral = 0.0
+
+    def compute(self, setpoint, measured, velocity):
+        error = (measured - setpoint) / COUNTS_PER_DEG
+        u = -(self.k[0] * error + self.k[1] * velocity + self.k[2] * self.integral)
+        winding_up = (u > 100 and error < 0) or (u < -100 and error > 0)
+        if not winding_up:
+            self.integral += error * PERIOD_S
+        return min(100.0, max(-100.0, u))
+
+
+def simulate(controller, plant, reference, seconds):
+    """RMS and max tracking error in deg, and overshoot past the final reference."""
+    steps = int(seconds / PERIOD_S)
+    substeps = int(PERIOD_S / PLANT_DT)
+    velocity, last_counts = 0.0, plant.counts()
+    errors, peak = [], 0.0
+    for n in range(steps):
+        t = n * PERIOD_S
+        ref = reference(t)
+        counts = plant.counts()
+        raw = (counts - last_counts) / COUNTS_PER_DEG / PERIOD_S
+        velocity += (raw - velocity) * PERIOD_S / (VELOCITY_TAU_S + PERIOD_S)
+        last_counts = counts
+        setpoint = ref * COUNTS_PER_DEG
+        drive = controller.compute(setpoint, counts, velocity)
+        if abs(setpoint - counts) <= BRAKING_THRESHOLD:
+            drive = 0.0
+        for _ in range(substeps):
+            plant.step(drive, PLANT_DT)
+        errors.append(plant.pos - ref)
+        peak = max(peak, plant.pos - ref)
+    errors = np.array(errors)
+    return math.sqrt(np.mean(errors ** 2)), np.max(np.abs(errors[len(errors) // 2:])), peak
+
+
+def cmd_design(args):
+    q = [float(v) for v in args.q.split(",")]
+    A, B = discrete_model(args.tau, args.gain, args.joints, args.coupling)
+    Q = np.kron(np.eye(args.joints), np.diag(q))
+    R = np.eye(args.joints) * args.r
+    K = dlqr(A, B, Q, R)
+
+    poles = np.abs(np.linalg.eigvals(A - B @ K))
+    print(f"closed loop |poles| max {poles.max():.4f}")
+    for j in range(args.joints):
+        for i in range(args.joints):
+            k = K[j, 3 * i:3 * i + 3]
+            if i == j:
+                print(f"lqr{j + 1}={k[0]:.5g},{k[1]:.5g},{k[2]:.5g}")
+            elif np.any(np.abs(k) > 1e-6):
+                print(f"lqrx{j + 1},{i + 1}={k[0]:.5g},{k[1]:.5g},{k[2]:.5g}")
+
+    # Single-joint comparison on the nonlinear plant
+    k = K[0, 0:3]
+    cases = [("step 30 deg", lambda t: 30.0 if t > 0.1 else 0.0, 2.0),
+             ("sine 20 deg 0.5 Hz", lambda t: 20.0 * math.sin(math.pi * t), 6.0)]
+    print()
+    print(f"{'case':<20}{'ctrl':<6}{'rms deg':>9}{'late max':>10}{'overshoot':>11}")
+    for name, reference, seconds in cases:
+        for label, ctrl in (("pid", Pid()), ("lqr", Lqr(k))):
+            rms, late, peak = simulate(ctrl, Plant(args.tau, args.gain, args.friction), reference, seconds)
+            print(f"{name:<20}{label:<6}{rms:>9.3f}{late:>10.3f}{max(peak, 0.0):>11.3f}")
+
+
+def cmd_identify(args):
+    """Least squares on vel[k+1] = a vel[k] + b drive[k] over resampled 10 ms steps."""
+    with open(args.csv) as f:
+        rows = [r for r in csv.reader(f) if r and not r[0].startswith(("#", "time"))]
+    t = np.array([float(r[0]) for r in rows])
+    drive = np.array([float(r[args.column]) for r in rows])
+    pos = np.array([float(r[args.column + 1]) for r in rows])
+
+    grid = np.arange(t[0], t[-1], PERIOD_S)
+    pos = np.interp(grid, t, pos)
+    drive = np.interp(grid, t, drive)
+    vel = np.gradient(pos, PERIOD_S)
+    X = np.column_stack([vel[:-1], drive[:-1]])
+    (a, b), *_ = np.linalg.lstsq(X, vel[1:], rcond=None)
+    if not 0 < a < 1:
+        raise SystemExit(f"fit is not a stable lag (a={a:.4f}); log a cleaner step")
+    tau = -PERIOD_S / math.log(a)
+    gain = b / (1 - a)
+    print(f"tau={tau:.4f} s gain={gain:.4f} deg/s per %")
+    print(f"python lqr_design.py design --tau {tau:.4f} --gain {gain:.4f}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("design")
+    p.add_argument("--tau", type=float, default=0.03, help="Velocity time constant, s")
+    p.add_argument("--gain", type=float, default=6.0, help="Steady speed per drive %%, deg/s")
+    p.add_argument("--friction", type=float, default=3.0, help="Coulomb friction in the simulation, %% drive")
+    p.add_argument("--q", default="1,0.0005,4", help="State weights: position, velocity, integral")
+    p.add_argument("--r", type=float, default=0.02, help="Drive weight")
+    p.add_argument("--joints", type=int, default=1)
+    p.add_argument("--coupling", type=float, default=0.0,
+                   help="Fraction of each drive reaching its neighbours, for coupled gains")
+    p.set_defaults(func=cmd_design)
+
+    p = sub.add_parser("identify")
+    p.add_argument("csv")
+    p.add_argument("--column", type=int, default=1, help="Drive column; position follows it")
+    p.set_defaults(func=cmd_identify)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,250 @@
+"""Motion primitive images for the firmware's flash library.
+
+  encode  moves.json -o motion.bin        JSON -> image, prints the esptool line
+  dump    motion.bin                      image -> primitive table and keyframes
+  preview motion.bin --play 1@0 --play 2@1500[:300] [-o setpoints.csv]
+
+The image layout is documented in firmware/motionLibrary.h and lands in the
+"motion" partition of firmware/partitions.csv. Input JSON:
+
+  {"primitives": [{"id": 1, "loop": false,
+                   "keyframes": [{"t": 0, "deg": [0, 0, 0], "interp": "smooth"}, ...]}]}
+
+interp is step, linear or smooth and shapes the segment to the next
+keyframe. preview runs MotionPlayer's sampling and blending at the 10 ms
+control period from a held pose of zero and writes the setpoints per tick; it
+checks the image the same way the firmware does and fails on a setpoint jump
+larger than --max-step, so it doubles as the playback check before flashing.
+"""
+import sys
+import csv
+import json
+import struct
+import zlib
+import argparse
+
+MAGIC = 0x4D52504D  # "MPRM"
+VERSION = 1
+PARTITION_OFFSET = 0x290000
+PARTITION_SIZE = 0x10000
+PERIOD_MS = 10
+FLAG_LOOP = 0x01
+INTERP = {"step": 0, "linear": 1, "smooth": 2}
+DEFAULT_BLEND_MS = 200
+HEADER = struct.Struct("<IBBHI")
+ENTRY = struct.Struct("<HBBIHH")
+KEYFRAME = struct.Struct("<HBB")
+
+
+def encode(doc):
+    prims = sorted(doc["primitives"], key=lambda p: p["id"])
+    if len({p["id"] for p in prims}) != len(prims):
+        raise ValueError("duplicate primitive id")
+    if len(prims) > 255:
+        raise ValueError("at most 255 primitives")
+
+    index, data = bytearray(), bytearray()
+    offset = HEADER.size + ENTRY.size * len(prims)
+    for p in prims:
+        frames = p["keyframes"]
+        joints = len(frames[0]["deg"])
+        last_t = -1
+        body = bytearray()
+        for k in frames:
+            if len(k["deg"]) != joints:
+                raise ValueError(f"primitive {p['id']}: keyframes differ in joint count")
+            if not last_t < k["t"] <= 0xFFFF or (last_t < 0 and k["t"] != 0):
+                raise ValueError(f"primitive {p['id']}: times must start at 0, rise and stay under 65.5 s")
+            last_t = k["t"]
+            centi = [round(d * 100) for d in k["deg"]]
+            if any(abs(c) > 32767 for c in centi):
+                raise ValueError(f"primitive {p['id']}: angle out of range")
+            body += KEYFRAME.pack(k["t"], INTERP[k.get("interp", "linear")], 0)
+            body += struct.pack(f"<{joints}h", *centi)
+        index += ENTRY.pack(p["id"], joints, FLAG_LOOP if p.get("loop") else 0,
+                            offset + len(data), len(frames), 0)
+        data += body
+
+    rest = bytes(index + data)
+    image = HEADER.pack(MAGIC, VERSION, len(prims), 0, zlib.crc32(rest)) + rest
+    if len(image) > PARTITION_SIZE:
+        raise ValueError(f"image is {len(image)} bytes, partition holds {PARTITION_SIZE}")
+    return image
+
+
+def decode(image):
+    """{id: (loop, [(time_ms, interp, [deg...])])}, validated like MotionLibrary::validate."""
+    magic, version, count, _, crc = HEADER.unpack_from(image, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a version 1 motion image")
+    end = index_end = HEADER.size + ENTRY.size * count
+    prims = {}
+    for i in range(count):
+        pid, joints, flags, offset, keyframes, _ = ENTRY.unpack_from(image, HEADER.size + ENTRY.size * i)
+        size = KEYFRAME.size + 2 * joints
+        if keyframes == 0 or joints == 0 or offset % 2 or offset < index_end \
+                or offset + keyframes * size > len(image):
+            raise ValueError(f"primitive {pid}: bad index entry")
+        frames = []
+        for k in range(keyframes):
+            pos = offset + k * size
+            t, interp, _ = KEYFRAME.unpack_from(image, pos)
+            if (k == 0 and t != 0) or (k > 0 and t <= frames[-1][0]):
+                raise ValueError(f"primitive {pid}: keyframe times must start at 0 and rise")
+            centi = struct.unpack_from(f"<{joints}h", image, pos + KEYFRAME.size)
+            frames.append((t, interp, [c * 0.01 for c in centi]))
+        prims[pid] = (bool(flags & FLAG_LOOP), frames)
+        end = max(end, offset + keyframes * size)
+    if zlib.crc32(image[HEADER.size:end]) != crc:
+        raise ValueError("CRC mismatch")
+    return prims
+
+
+class Track:
+    """MotionPlayer::Track with its advance() and sample()."""
+
+    def __init__(self, prim):
+        self.loop, self.frames = prim
+        self.elapsed = 0
+        self.cursor = 0
+
+    def sample(self, pose):
+        duration = self.frames[-1][0]
+        if self.loop and duration > 0 and self.elapsed >= duration:
+            self.elapsed %= duration
+            self.cursor = 0
+        while self.cursor + 1 < len(self.frames) and self.frames[self.cursor + 1][0] <= self.elapsed:
+            self.cursor += 1
+        t0, interp, a = self.frames[self.cursor]
+        n = min(len(a), len(pose))
+        if self.cursor + 1 >= len(self.frames):
+            pose[:n] = a[:n]
+            return self.elapsed < t0 or self.loop
+        t1, _, b = self.frames[self.cursor + 1]
+        u = 0.0
+        if interp != INTERP["step"] and t1 > t0:
+            u = (self.elapsed - t0) / (t1 - t0)
+            if interp == INTERP["smooth"]:
+                u = u * u * (3 - 2 * u)
+        pose[:n] = [a[j] + u * (b[j] - a[j]) for j in range(n)]
+        return True
+
+
+def preview(prims, plays, joints, seconds):
+    """Setpoint rows per tick for a list of (start_ms, id, blend_ms)."""
+    reference = [0.0] * joints
+    current = previous = None
+    held = list(reference)
+    blend = blend_elapsed = 0
+    pending = sorted(plays)
+    rows = []
+    for tick in range(int(seconds * 1000 / PERIOD_MS)):
+        now = tick * PERIOD_MS
+        while pending and pending[0][0] <= now:
+            _, pid, blend_ms = pending.pop(0)
+            previous = current
+            if previous is None:
+                held = list(reference)
+            current = Track(prims[pid])
+            blend, blend_elapsed = blend_ms, 0
+
+        if current is not None:
+            pose, start = list(reference), list(reference)
+            running = current.sample(pose)
+            if blend_elapsed < blend:
+                if previous is not None:
+                    previous.sample(start)
+                    previous.elapsed += PERIOD_MS
+                else:
+                    start = list(held)
+                w = blend_elapsed / blend
+                w = w * w * (3 - 2 * w)
+                pose = [s + w * (p - s) for s, p in zip(start, pose)]
+                blend_elapsed += PERIOD_MS
+            else:
+                previous = None
+            n = min(len(current.frames[0][2]), joints)
+            reference[:n] = pose[:n]
+            current.elapsed += PERIOD_MS
+            if not running and blend_elapsed >= blend:
+                current = previous = None
+        rows.append((now, list(reference)))
+    return rows
+
+
+def cmd_encode(args):
+    with open(args.json) as f:
+        image = encode(json.load(f))
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print(f"{len(image)} bytes -> {args.output}")
+    print(f"esptool.py --chip esp32s3 write_flash {PARTITION_OFFSET:#x} {args.output}")
+
+
+def cmd_dump(args):
+    with open(args.image, "rb") as f:
+        prims = decode(f.read())
+    for pid, (loop, frames) in sorted(prims.items()):
+        print(f"PRIM id={pid} joints={len(frames[0][2])} keyframes={len(frames)} "
+              f"ms={frames[-1][0]} loop={int(loop)}")
+        if args.verbose:
+            names = {v: k for k, v in INTERP.items()}
+            for t, interp, deg in frames:
+                print(f"  {t:>6} {names.get(interp, interp):<7} " + " ".join(f"{d:8.2f}" for d in deg))
+
+
+def cmd_preview(args):
+    with open(args.image, "rb") as f:
+        prims = decode(f.read())
+    plays = []
+    for item in args.play:
+        spec, _, blend = item.partition(":")
+        pid, _, start = spec.partition("@")
+        if int(pid) not in prims:
+            sys.exit(f"no primitive {pid} in the image")
+        plays.append((int(start or 0), int(pid), int(blend) if blend else DEFAULT_BLEND_MS))
+
+    rows = preview(prims, plays, args.joints, args.seconds)
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.writer(out)
+    writer.writerow(["time_ms"] + [f"setpoint{j + 1}" for j in range(args.joints)])
+    worst = 0.0
+    for i, (t, deg) in enumerate(rows):
+        writer.writerow([t] + [f"{d:.3f}" for d in deg])
+        if i:
+            worst = max(worst, max(abs(a - b) for a, b in zip(deg, rows[i - 1][1])))
+    print(f"{len(rows)} ticks, largest step {worst:.3f} deg/tick", file=sys.stderr)
+    if args.max_step is not None and worst > args.max_step:
+        sys.exit(f"setpoint jumps {worst:.3f} deg in one tick, over {args.max_step}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("encode")
+    p.add_argument("json")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_encode)
+
+    p = sub.add_parser("dump")
+    p.add_argument("image")
+    p.add_argument("-v", "--verbose", action="store_true", help="List the keyframes too")
+    p.set_defaults(func=cmd_dump)
+
+    p = sub.add_parser("preview")
+    p.add_argument("image")
+    p.add_argument("--play", action="append", required=True, metavar="ID@MS[:BLEND]",
+                   help="Start primitive ID at MS with a BLEND ms cross-fade")
+    p.add_argument("--joints", type=int, default=3)
+    p.add_argument("--seconds", type=float, default=5.0)
+    p.add_argument("--max-step", type=float, help="Fail if any setpoint moves more per tick, deg")
+    p.add_argument("-o", "--output")
+    p.set_defaults(func=cmd_preview)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
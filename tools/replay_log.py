@@ -0,0 +1,283 @@
+"""Record/replay logs from the motor controller.
+
+  decode  capture.txt|run.rec [-o ticks.csv]   USB capture of rec=dump (or a raw log) -> CSV
+  import  save.csv -o run.rec                  Tuning GUI recording -> replayable log
+  upload  run.rec --address <BLE addr>         rec=clear, recl=... chunks, rec=replay
+
+The log layout is documented in firmware/recorder.h.
+"""
+import sys
+import csv
+import struct
+import asyncio
+import argparse
+from datetime import datetime
+
+VERSION = 2
+FILTER_PATHS = 3
+TAG_TICK = 0x01
+TAG_COMMAND = 0x02
+FLAG_TRIPPED = 0x80
+PERIOD_US = 10000
+COMMAND_TYPES = ["SetpointDeg", "Gains", "SupplyVolts", "ClearFaults", "Backlash", "BacklashCalibrate", "Limits",
+                 "LqrGains", "Controller", "Play", "Filter"]
+
+# BLESerial exposes the Nordic UART service
+UART_RX = "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
+UART_TX = "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
+CHUNK_BYTES = 60  # recl= plus 120 hex digits fits the 128 character command limit
+
+
+def put_varint(out, v):
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+
+
+def get_varint(data, pos):
+    v = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        v |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return v, pos
+        shift += 7
+
+
+def zigzag(v):
+    return ((v << 1) ^ (v >> 31)) & 0xFFFFFFFF
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def read_log(path):
+    """Raw log bytes from a .rec file or a text capture holding REC lines."""
+    with open(path, "rb") as f:
+        raw = f.read()
+    if raw.startswith(b"RPLY"):
+        return raw
+
+    data = bytearray()
+    for line in raw.decode(errors="replace").splitlines():
+        parts = line.strip().split()
+        if len(parts) == 3 and parts[0] == "REC" and len(parts[1]) == 4:
+            offset = int(parts[1], 16)
+            if offset != len(data):
+                raise ValueError(f"gap in dump at offset {offset:#x}")
+            data += bytes.fromhex(parts[2])
+    return bytes(data)
+
+
+def joint_header(counts, setpoint, gains, joints, output=0.0):
+    """One joint's checkpoint for a log header: PID running, no LQR, no filters."""
+    header = struct.pack("<i9f", counts, float(counts), output, output, 0.0, 0.0, setpoint, *gains)
+    header += bytes([0, 0]) + struct.pack("<3f", 0.0, 0.0, 0.0) + struct.pack(f"<{joints * 3}f", *[0.0] * joints * 3)
+    return header + bytes(FILTER_PATHS)
+
+
+def decode(data):
+    """Yields ('tick', dict) and ('cmd', dict) records in log order."""
+    if data[:4] != b"RPLY" or data[4] != VERSION:
+        raise ValueError(f"not a version {VERSION} recorder log")
+    joints = data[5]
+    pos = 10
+    counts, setpoint, gains = [], [], []
+    for _ in range(joints):
+        c, *values = struct.unpack_from("<i9f", data, pos)
+        pos += 40 + 2 + 12 + joints * 12  # Checkpoint up to the filter chains
+        for _path in range(FILTER_PATHS):
+            pos += 1 + data[pos] * 37
+        counts.append(c)
+        setpoint.append(values[5])
+        gains.append(values[6:9])
+    output = [0] * joints
+    time_us = tick = 0
+
+    while pos < len(data):
+        tag = data[pos]
+        pos += 1
+        if tag == TAG_COMMAND:
+            at, pos = get_varint(data, pos)
+            kind, joint = data[pos], data[pos + 1]
+            values = struct.unpack_from("<3f", data, pos + 2)
+            pos += 14
+            yield "cmd", {"tick": at, "type": COMMAND_TYPES[kind], "joint": joint + 1, "value": values}
+            continue
+        if tag != TAG_TICK:
+            raise ValueError(f"bad record tag {tag:#x} at offset {pos - 1:#x}")
+
+        flags, halted = data[pos], data[pos + 1]
+        dt, pos = get_varint(data, pos + 2)
+        time_us += dt
+        for j in range(joints):
+            dc, pos = get_varint(data, pos)
+            do, pos = get_varint(data, pos)
+            counts[j] += unzigzag(dc)
+            output[j] += unzigzag(do)
+        for j in range(joints):
+            if flags & (1 << j):
+                setpoint[j], = struct.unpack_from("<f", data, pos)
+                pos += 4
+        for j in range(joints):
+            if flags & (1 << (3 + j)):
+                gains[j] = list(struct.unpack_from("<3f", data, pos))
+                pos += 12
+
+        yield "tick", {"tick": tick, "time_ms": time_us / 1000.0, "tripped": bool(flags & FLAG_TRIPPED),
+                       "joints": [(counts[j], output[j] / 10.0, setpoint[j], *gains[j], (halted >> j) & 1)
+                                  for j in range(joints)]}
+        tick += 1
+
+
+def cmd_decode(args):
+    data = read_log(args.log)
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.writer(out)
+    header_written = False
+    ticks = commands = 0
+
+    for kind, rec in decode(data):
+        if kind == "cmd":
+            commands += 1
+            print(f"# tick {rec['tick']}: {rec['type']} joint {rec['joint']} {rec['value']}", file=sys.stderr)
+            continue
+        if not header_written:
+            cols = ["tick", "time_ms", "tripped"]
+            for j in range(len(rec["joints"])):
+                cols += [f"{n}{j + 1}" for n in ("counts", "output", "setpoint", "kp", "ki", "kd", "halted")]
+            writer.writerow(cols)
+            header_written = True
+        row = [rec["tick"], f"{rec['time_ms']:.3f}", int(rec["tripped"])]
+        for joint in rec["joints"]:
+            row += list(joint)
+        writer.writerow(row)
+        ticks += 1
+
+    print(f"{len(data)} bytes, {ticks} ticks, {commands} commands", file=sys.stderr)
+
+
+def cmd_import(args):
+    """Builds a log from the tuning GUI's save.csv (setpoint, input, output, kp, ki, kd per joint).
+
+    Only the PID part can be reproduced: the GUI samples the throttled text
+    telemetry, so there is no integral state and rows may skip ticks. Expect
+    the replay to diverge at the start and wherever rows were dropped.
+    """
+    with open(args.csv) as f:
+        rows = [r for r in csv.reader(f)][1:]
+    rows = [(datetime.fromisoformat(r[0]), [float(x) for x in r[1:]]) for r in rows if len(r) > 1]
+    joints = len(rows[0][1]) // 6
+
+    def joint(values, j):
+        sp, inp, out, kp, ki, kd = values[j * 6:j * 6 + 6]
+        return sp, int(round(inp)), int(round(out * 10)), [kp, ki, kd]
+
+    log = bytearray(b"RPLY")
+    log += struct.pack("<BBI", VERSION, joints, PERIOD_US)
+    last = []
+    for j in range(joints):
+        sp, counts, out, gains = joint(rows[0][1], j)
+        log += joint_header(counts, sp, gains, joints, out / 10.0)
+        last.append([counts, 0, sp, gains])
+
+    previous = rows[0][0]
+    for stamp, values in rows[1:]:
+        dt = max(1, int((stamp - previous).total_seconds() * 1e6))
+        previous = stamp
+        body = bytearray()
+        flags = 0
+        put_varint(body, dt)
+        extra = bytearray()
+        current = [joint(values, j) for j in range(joints)]
+        for j, (sp, counts, out, gains) in enumerate(current):
+            put_varint(body, zigzag(counts - last[j][0]))
+            put_varint(body, zigzag(out - last[j][1]))
+            last[j][0], last[j][1] = counts, out
+        for j, (sp, _, _, _) in enumerate(current):
+            if struct.pack("<f", sp) != struct.pack("<f", last[j][2]):
+                flags |= 1 << j
+                extra += struct.pack("<f", sp)
+                last[j][2] = sp
+        for j, (_, _, _, gains) in enumerate(current):
+            if struct.pack("<3f", *gains) != struct.pack("<3f", *last[j][3]):
+                flags |= 1 << (3 + j)
+                extra += struct.pack("<3f", *gains)
+                last[j][3] = gains
+        log += bytes([TAG_TICK, flags, 0]) + body + extra
+
+    with open(args.output, "wb") as f:
+        f.write(log)
+    print(f"{len(rows) - 1} ticks, {joints} joints, {len(log)} bytes -> {args.output}")
+
+
+async def upload(args):
+    from bleak import BleakClient
+
+    data = read_log(args.log)
+
+    lines = asyncio.Queue()
+    pending = ""
+
+    def on_notify(_, payload):
+        nonlocal pending
+        pending += payload.decode(errors="replace")
+        while "\n" in pending:
+            line, pending = pending.split("\n", 1)
+            lines.put_nowait(line.strip())
+
+    async def command(client, text, expect):
+        await client.write_gatt_char(args.rx, (text + "\n").encode(), response=True)
+        while True:
+            line = await asyncio.wait_for(lines.get(), timeout=args.timeout)
+            if line.startswith("ERR"):
+                raise RuntimeError(f"{text[:16]}: {line}")
+            if line.startswith(expect):
+                return line
+
+    async with BleakClient(args.address) as client:
+        await client.start_notify(args.tx, on_notify)
+        await command(client, "rec=clear", "OK")
+        for i in range(0, len(data), CHUNK_BYTES):
+            await command(client, "recl=" + data[i:i + CHUNK_BYTES].hex().upper(), "OK recl")
+        await command(client, "rec=replay", "OK")
+
+        # The report follows once every tick has been recomputed
+        while True:
+            line = await asyncio.wait_for(lines.get(), timeout=args.timeout * 10)
+            if line.startswith("REPLAY"):
+                print(line)
+                return
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("decode")
+    p.add_argument("log")
+    p.add_argument("-o", "--output")
+    p.set_defaults(func=cmd_decode)
+
+    p = sub.add_parser("import")
+    p.add_argument("csv")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_import)
+
+    p = sub.add_parser("upload")
+    p.add_argument("log")
+    p.add_argument("--address", required=True)
+    p.add_argument("--rx", default=UART_RX)
+    p.add_argument("--tx", default=UART_TX)
+    p.add_argument("--timeout", type=float, default=5.0)
+    p.set_defaults(func=lambda a: asyncio.run(upload(a)))
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
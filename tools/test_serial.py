@@ -1,6 +1,5 @@
 import sys
 import csv
-import serial
 from serial.tools import list_ports
 from functools import partial
 from PyQt5.QtWidgets import (QApplication, QMainWindow, QWidget, QVBoxLayout, 
@@ -11,6 +10,7 @@ from PyQt5.QtGui import QFont
 import pyqtgraph as pg
 import numpy as np
 from datetime import datetime
+from host_link import open_link
 
 # Configuration
 DEFAULT_PORT = 'COM6'
@@ -18,6 +18,10 @@ BUFFER_SIZE = 500
 SEND_DELAY_MS = 500
 SETTLING_THRESHOLD = 6
 DEBUG = False
+# update_data indexes setpoint, position, output, kp, ki, kd for each motor;
+# the link decodes only lines with exactly this many fields, which is what
+# the len(parts) == 12 check here used to enforce
+TELEMETRY_COLUMNS = 12
 
 # Parameter ranges
 PARAM_RANGES = {
@@ -96,36 +100,34 @@ class SerialWorker(QThread):
         super().__init__()
         self.port = port
         self.baud_rate = baud_rate
-        self.ser = None
+        self.link = None
         self.running = False
 
     def run(self):
         self.running = True
         try:
-            self.ser = serial.Serial(self.port, self.baud_rate, timeout=0.1)
+            self.link = open_link(self.port, baud=self.baud_rate, text_columns=TELEMETRY_COLUMNS)
             while self.running:
-                if self.ser.in_waiting > 0:
-                    raw_line = self.ser.readline()
-                    try:
-                        line = raw_line.decode().strip()
-                        if DEBUG:
-                            print(f"Received: {line}")
-                        if line:
-                            parts = list(map(float, line.split('\t')))
-                            if len(parts) == 12:
-                                self.data_received.emit(parts)
-                    except Exception as e:
-                        continue
+                # The link's reader thread decodes in bulk; hand the GUI whatever arrived
+                rows = self.link.text.take()
+                assert rows.shape[1] == TELEMETRY_COLUMNS + 1  # Arrival time, then the fields
+                for row in rows:
+                    self.data_received.emit(row[1:].tolist())
+                if DEBUG:
+                    for _, line in self.link.lines:
+                        print(f"Received: {line}")
+                    self.link.lines.clear()
+                self.msleep(10)
         except Exception as e:
             self.error_occurred.emit(str(e))
         finally:
-            if self.ser and self.ser.is_open:
-                self.ser.close()
+            if self.link:
+                self.link.close()
 
     def send_command(self, command):
-        if self.ser and self.running:
+        if self.link and self.running:
             try:
-                self.ser.write(f"{command}\n".encode())
+                self.link.send(command)
                 if DEBUG:
                     print(f"Sent: {command}")
             except Exception as e: